@@ -61,6 +61,24 @@ static ComponentReflectorList makeComponentReflectors() {
 	return result;
 }
 
+
+using ComponentDependenciesPtr = void (*)(const ConfigNode&, Vector<std::pair<AssetType, String>>&);
+using ComponentDependenciesMap = HashMap<String, ComponentDependenciesPtr>;
+
+static ComponentDependenciesMap makeComponentDependencies() {
+	ComponentDependenciesMap result;
+	result["Transform2D"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<Halley::Vector2f>::collect(node["position"], deps); ConfigNodeAssetDependencies<Halley::Vector2f>::collect(node["scale"], deps); ConfigNodeAssetDependencies<Halley::Angle1f>::collect(node["rotation"], deps); ConfigNodeAssetDependencies<Halley::OptionalLite<int>>::collect(node["subWorld"], deps); };
+	result["Sprite"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<Halley::Sprite>::collect(node["sprite"], deps); ConfigNodeAssetDependencies<int>::collect(node["layer"], deps); ConfigNodeAssetDependencies<Halley::OptionalLite<int>>::collect(node["mask"], deps); };
+	result["TextLabel"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<Halley::TextRenderer>::collect(node["text"], deps); ConfigNodeAssetDependencies<int>::collect(node["layer"], deps); ConfigNodeAssetDependencies<Halley::OptionalLite<int>>::collect(node["mask"], deps); };
+	result["SpriteAnimation"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<Halley::AnimationPlayer>::collect(node["player"], deps); };
+	result["Camera"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<float>::collect(node["zoom"], deps); ConfigNodeAssetDependencies<Halley::String>::collect(node["id"], deps); };
+	result["Particles"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<Halley::Particles>::collect(node["particles"], deps); ConfigNodeAssetDependencies<std::vector<Halley::Sprite>>::collect(node["sprites"], deps); ConfigNodeAssetDependencies<Halley::ResourceReference<Halley::Animation>>::collect(node["animation"], deps); ConfigNodeAssetDependencies<int>::collect(node["layer"], deps); ConfigNodeAssetDependencies<Halley::OptionalLite<int>>::collect(node["mask"], deps); };
+	result["AudioListener"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<float>::collect(node["referenceDistance"], deps); };
+	result["AudioSource"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<Halley::ResourceReference<Halley::AudioEvent>>::collect(node["event"], deps); ConfigNodeAssetDependencies<float>::collect(node["rangeMin"], deps); ConfigNodeAssetDependencies<float>::collect(node["rangeMax"], deps); };
+	result["Script"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { ConfigNodeAssetDependencies<Halley::ScriptGraph>::collect(node["scriptGraph"], deps); };
+	return result;
+}
+
 namespace Halley {
 	std::unique_ptr<System> createSystem(String name) {
 		static SystemFactoryMap factories = makeSystemFactories();
@@ -84,4 +102,12 @@ namespace Halley {
 		static ComponentReflectorList reflectors = makeComponentReflectors();
 		return *reflectors.at(componentId);
 	}
+
+	void getComponentAssetDependencies(const String& name, const ConfigNode& componentData, Vector<std::pair<AssetType, String>>& result) {
+		static ComponentDependenciesMap dependencies = makeComponentDependencies();
+		auto iter = dependencies.find(name);
+		if (iter != dependencies.end() && componentData.getType() == ConfigNodeType::Map) {
+			iter->second(componentData, result);
+		}
+	}
 }
@@ -28,7 +28,13 @@ public:
 
 	void deserialize(const Halley::ConfigNodeSerializationContext& context, const Halley::ConfigNode& node) {
 		using namespace Halley::EntitySerialization;
-		Halley::EntityConfigNodeSerializer<decltype(referenceDistance)>::deserialize(referenceDistance, float{ 500 }, context, node, "referenceDistance", makeMask(Type::Prefab, Type::SaveData));
+		static constexpr std::array<const char*, 1> fieldNames{ "referenceDistance" };
+		const auto fields = Halley::findConfigNodeFields(node, fieldNames);
+		Halley::EntityConfigNodeSerializer<decltype(referenceDistance)>::deserialize(referenceDistance, float{ 500 }, context, node, fields[0], makeMask(Type::Prefab, Type::SaveData));
+	}
+
+	void detachCopy() {
+		Halley::DetachedCopy<decltype(referenceDistance)>::detach(referenceDistance);
 	}
 
 };
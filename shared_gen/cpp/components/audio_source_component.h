@@ -35,9 +35,18 @@ public:
 
 	void deserialize(const Halley::ConfigNodeSerializationContext& context, const Halley::ConfigNode& node) {
 		using namespace Halley::EntitySerialization;
-		Halley::EntityConfigNodeSerializer<decltype(event)>::deserialize(event, Halley::ResourceReference<Halley::AudioEvent>{}, context, node, "event", makeMask(Type::Prefab, Type::SaveData));
-		Halley::EntityConfigNodeSerializer<decltype(rangeMin)>::deserialize(rangeMin, float{ 50 }, context, node, "rangeMin", makeMask(Type::Prefab, Type::SaveData));
-		Halley::EntityConfigNodeSerializer<decltype(rangeMax)>::deserialize(rangeMax, float{ 100 }, context, node, "rangeMax", makeMask(Type::Prefab, Type::SaveData));
+		static constexpr std::array<const char*, 3> fieldNames{ "event", "rangeMax", "rangeMin" };
+		const auto fields = Halley::findConfigNodeFields(node, fieldNames);
+		Halley::EntityConfigNodeSerializer<decltype(event)>::deserialize(event, Halley::ResourceReference<Halley::AudioEvent>{}, context, node, fields[0], makeMask(Type::Prefab, Type::SaveData));
+		Halley::EntityConfigNodeSerializer<decltype(rangeMin)>::deserialize(rangeMin, float{ 50 }, context, node, fields[2], makeMask(Type::Prefab, Type::SaveData));
+		Halley::EntityConfigNodeSerializer<decltype(rangeMax)>::deserialize(rangeMax, float{ 100 }, context, node, fields[1], makeMask(Type::Prefab, Type::SaveData));
+	}
+
+	void detachCopy() {
+		Halley::DetachedCopy<decltype(event)>::detach(event);
+		Halley::DetachedCopy<decltype(rangeMin)>::detach(rangeMin);
+		Halley::DetachedCopy<decltype(rangeMax)>::detach(rangeMax);
+		Halley::DetachedCopy<decltype(playing)>::detach(playing);
 	}
 
 };
@@ -31,8 +31,15 @@ public:
 
 	void deserialize(const Halley::ConfigNodeSerializationContext& context, const Halley::ConfigNode& node) {
 		using namespace Halley::EntitySerialization;
-		Halley::EntityConfigNodeSerializer<decltype(zoom)>::deserialize(zoom, float{ 1 }, context, node, "zoom", makeMask(Type::Prefab, Type::SaveData));
-		Halley::EntityConfigNodeSerializer<decltype(id)>::deserialize(id, Halley::String{}, context, node, "id", makeMask(Type::Prefab, Type::SaveData));
+		static constexpr std::array<const char*, 2> fieldNames{ "id", "zoom" };
+		const auto fields = Halley::findConfigNodeFields(node, fieldNames);
+		Halley::EntityConfigNodeSerializer<decltype(zoom)>::deserialize(zoom, float{ 1 }, context, node, fields[1], makeMask(Type::Prefab, Type::SaveData));
+		Halley::EntityConfigNodeSerializer<decltype(id)>::deserialize(id, Halley::String{}, context, node, fields[0], makeMask(Type::Prefab, Type::SaveData));
+	}
+
+	void detachCopy() {
+		Halley::DetachedCopy<decltype(zoom)>::detach(zoom);
+		Halley::DetachedCopy<decltype(id)>::detach(id);
 	}
 
 };
@@ -40,11 +40,21 @@ public:
 
 	void deserialize(const Halley::ConfigNodeSerializationContext& context, const Halley::ConfigNode& node) {
 		using namespace Halley::EntitySerialization;
-		Halley::EntityConfigNodeSerializer<decltype(particles)>::deserialize(particles, Halley::Particles{}, context, node, "particles", makeMask(Type::Prefab, Type::SaveData));
-		Halley::EntityConfigNodeSerializer<decltype(sprites)>::deserialize(sprites, std::vector<Halley::Sprite>{}, context, node, "sprites", makeMask(Type::Prefab, Type::SaveData));
-		Halley::EntityConfigNodeSerializer<decltype(animation)>::deserialize(animation, Halley::ResourceReference<Halley::Animation>{}, context, node, "animation", makeMask(Type::Prefab, Type::SaveData));
-		Halley::EntityConfigNodeSerializer<decltype(layer)>::deserialize(layer, int{ 0 }, context, node, "layer", makeMask(Type::Prefab, Type::SaveData));
-		Halley::EntityConfigNodeSerializer<decltype(mask)>::deserialize(mask, Halley::OptionalLite<int>{}, context, node, "mask", makeMask(Type::Prefab, Type::SaveData));
+		static constexpr std::array<const char*, 5> fieldNames{ "animation", "layer", "mask", "particles", "sprites" };
+		const auto fields = Halley::findConfigNodeFields(node, fieldNames);
+		Halley::EntityConfigNodeSerializer<decltype(particles)>::deserialize(particles, Halley::Particles{}, context, node, fields[3], makeMask(Type::Prefab, Type::SaveData));
+		Halley::EntityConfigNodeSerializer<decltype(sprites)>::deserialize(sprites, std::vector<Halley::Sprite>{}, context, node, fields[4], makeMask(Type::Prefab, Type::SaveData));
+		Halley::EntityConfigNodeSerializer<decltype(animation)>::deserialize(animation, Halley::ResourceReference<Halley::Animation>{}, context, node, fields[0], makeMask(Type::Prefab, Type::SaveData));
+		Halley::EntityConfigNodeSerializer<decltype(layer)>::deserialize(layer, int{ 0 }, context, node, fields[1], makeMask(Type::Prefab, Type::SaveData));
+		Halley::EntityConfigNodeSerializer<decltype(mask)>::deserialize(mask, Halley::OptionalLite<int>{}, context, node, fields[2], makeMask(Type::Prefab, Type::SaveData));
+	}
+
+	void detachCopy() {
+		Halley::DetachedCopy<decltype(particles)>::detach(particles);
+		Halley::DetachedCopy<decltype(sprites)>::detach(sprites);
+		Halley::DetachedCopy<decltype(animation)>::detach(animation);
+		Halley::DetachedCopy<decltype(layer)>::detach(layer);
+		Halley::DetachedCopy<decltype(mask)>::detach(mask);
 	}
 
 };
@@ -30,8 +30,15 @@ public:
 
 	void deserialize(const Halley::ConfigNodeSerializationContext& context, const Halley::ConfigNode& node) {
 		using namespace Halley::EntitySerialization;
-		Halley::EntityConfigNodeSerializer<decltype(scriptGraph)>::deserialize(scriptGraph, Halley::ScriptGraph{}, context, node, "scriptGraph", makeMask(Type::Prefab));
-		Halley::EntityConfigNodeSerializer<decltype(scriptState)>::deserialize(scriptState, Halley::ScriptState{}, context, node, "scriptState", makeMask(Type::SaveData));
+		static constexpr std::array<const char*, 2> fieldNames{ "scriptGraph", "scriptState" };
+		const auto fields = Halley::findConfigNodeFields(node, fieldNames);
+		Halley::EntityConfigNodeSerializer<decltype(scriptGraph)>::deserialize(scriptGraph, Halley::ScriptGraph{}, context, node, fields[0], makeMask(Type::Prefab));
+		Halley::EntityConfigNodeSerializer<decltype(scriptState)>::deserialize(scriptState, Halley::ScriptState{}, context, node, fields[1], makeMask(Type::SaveData));
+	}
+
+	void detachCopy() {
+		Halley::DetachedCopy<decltype(scriptGraph)>::detach(scriptGraph);
+		Halley::DetachedCopy<decltype(scriptState)>::detach(scriptState);
 	}
 
 };
@@ -25,4 +25,7 @@ public:
 		
 	}
 
+	void detachCopy() {
+	}
+
 };
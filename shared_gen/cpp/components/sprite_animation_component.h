@@ -28,7 +28,13 @@ public:
 
 	void deserialize(const Halley::ConfigNodeSerializationContext& context, const Halley::ConfigNode& node) {
 		using namespace Halley::EntitySerialization;
-		Halley::EntityConfigNodeSerializer<decltype(player)>::deserialize(player, Halley::AnimationPlayer{}, context, node, "player", makeMask(Type::Prefab, Type::SaveData));
+		static constexpr std::array<const char*, 1> fieldNames{ "player" };
+		const auto fields = Halley::findConfigNodeFields(node, fieldNames);
+		Halley::EntityConfigNodeSerializer<decltype(player)>::deserialize(player, Halley::AnimationPlayer{}, context, node, fields[0], makeMask(Type::Prefab, Type::SaveData));
+	}
+
+	void detachCopy() {
+		Halley::DetachedCopy<decltype(player)>::detach(player);
 	}
 
 };
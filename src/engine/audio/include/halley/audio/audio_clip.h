@@ -18,6 +18,8 @@ namespace Halley
 		virtual size_t getLength() const = 0; // in samples
 		virtual size_t getLoopPoint() const { return 0; } // in samples
 		virtual bool isLoaded() const { return true; }
+		virtual bool canSeek() const { return true; } // If false, data must be read in order, regardless of position
+		virtual std::mutex* getReadMutex() const { return nullptr; } // If set, must be held while reading all channels of a block
 	};
 
 	class AudioClip final : public AsyncResource, public IAudioClip
@@ -36,6 +38,7 @@ namespace Halley
 		size_t getLength() const override; // in samples
 		size_t getLoopPoint() const override; // in samples
 		bool isLoaded() const override;
+		std::mutex* getReadMutex() const override;
 
 		static std::shared_ptr<AudioClip> loadResource(ResourceLoader& loader);
 		constexpr static AssetType getAssetType() { return AssetType::AudioClip; }
@@ -53,6 +56,7 @@ namespace Halley
 		mutable std::vector<std::vector<AudioConfig::SampleFormat>> temp1;
 		mutable std::vector<std::vector<AudioConfig::SampleFormat>> samples;
 		mutable std::unique_ptr<VorbisData> vorbisData;
+		mutable std::mutex streamMutex;
 	};
 
 	class StreamingAudioClip final : public IAudioClip
@@ -66,6 +70,7 @@ namespace Halley
 		uint8_t getNumberOfChannels() const override;
 		size_t getLength() const override;
 		size_t getSamplesLeft() const;
+		bool canSeek() const override;
 
 	private:
 		size_t length = 0;
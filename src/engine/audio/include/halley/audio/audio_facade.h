@@ -44,6 +44,9 @@ namespace Halley {
 
 		void setMasterVolume(float volume = 1.0f) override;
 		void setGroupVolume(const String& groupName, float volume = 1.0f) override;
+		void setGroupParent(const String& groupName, const String& parentGroupName) override;
+		void setGroupFilters(const String& groupName, std::vector<AudioFilterConfig> filters) override;
+		void setVoiceBudget(size_t maxVoices, float minAudibleGain = 0.001f) override;
 
 	    void setOutputChannels(std::vector<AudioChannelData> audioChannelData) override;
 	    void setListener(AudioListenerData listener) override;
@@ -3,10 +3,18 @@
 #include "audio_source.h"
 
 namespace Halley {
+	// Second order IIR filter, with coefficients from the Audio EQ Cookbook (R. Bristow-Johnson)
+	// Can either wrap a source, or be used directly on buffers with process()
     class AudioFilterBiquad final : public AudioSource {
     public:
-		AudioFilterBiquad(std::shared_ptr<AudioSource> src);
+		explicit AudioFilterBiquad(std::shared_ptr<AudioSource> src = {});
+
+		// y[n] = a0 * x[n] + a1 * x[n-1] + a2 * x[n-2] - b1 * y[n-1] - b2 * y[n-2]
 		void setParameters(float a0, float a1, float a2, float b1, float b2);
+		void setParameters(const AudioFilterConfig& config, float sampleRate = float(AudioConfig::sampleRate));
+
+		void process(gsl::span<AudioConfig::SampleFormat> samples, size_t channel);
+		void reset();
     	
 	    uint8_t getNumberOfChannels() const override;
 	    bool isReady() const override;
@@ -14,5 +22,17 @@ namespace Halley {
 
     private:
 		std::shared_ptr<AudioSource> src;
+
+		float a0 = 1.0f;
+		float a1 = 0.0f;
+		float a2 = 0.0f;
+		float b1 = 0.0f;
+		float b2 = 0.0f;
+
+		struct State {
+			float z1 = 0.0f;
+			float z2 = 0.0f;
+		};
+		std::array<State, AudioConfig::maxChannels> state;
     };
 }
@@ -6,6 +6,8 @@
 
 namespace Halley
 {
+	class AudioBufferPool;
+
 	using AudioSourceData = std::array<gsl::span<AudioConfig::SampleFormat>, AudioConfig::maxChannels>;
 
 	class AudioSource {
@@ -15,5 +17,9 @@ namespace Halley
 		virtual uint8_t getNumberOfChannels() const = 0;
 		virtual bool isReady() const { return true; }
 		virtual bool getAudioData(size_t numSamples, AudioSourceData& dst) = 0;
+
+		// Moves playback forward without producing any samples, for voices that are too quiet to be mixed
+		// The default implementation reads the data and throws it away, override if the source can do it cheaper
+		virtual bool skipAudioData(size_t numSamples, AudioBufferPool& pool);
 	};
 }
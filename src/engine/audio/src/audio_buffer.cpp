@@ -142,6 +142,7 @@ AudioBuffer& AudioBufferPool::allocBuffer(size_t numSamples)
 
 	constexpr size_t log2NumSamples = 4;
 	const size_t idx = fastLog2Ceil(uint32_t(numSamples)) - log2NumSamples;
+	std::unique_lock<std::mutex> lock(mutex);
 	auto& buffers = buffersTable[idx];
 
 	for (auto& b: buffers) {
@@ -160,6 +161,7 @@ AudioBuffer& AudioBufferPool::allocBuffer(size_t numSamples)
 void AudioBufferPool::returnBuffer(AudioBuffer& buffer)
 {
 	const size_t idx = fastLog2Ceil(uint32_t(buffer.packs.size()));
+	std::unique_lock<std::mutex> lock(mutex);
 	auto& buffers = buffersTable[idx];
 
 	for (auto& b: buffers) {
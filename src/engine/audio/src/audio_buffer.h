@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <mutex>
 #include "halley/core/api/audio_api.h"
 
 namespace Halley
@@ -58,6 +59,7 @@ namespace Halley
 		AudioBufferPool* pool;
 	};
 
+	// Buffers can be taken and returned from several threads at once
 	class AudioBufferPool
 	{
 	public:
@@ -76,6 +78,7 @@ namespace Halley
 		};
 
 		std::array<std::vector<Entry>, 16> buffersTable;
+		std::mutex mutex;
 
 		AudioBuffer& allocBuffer(size_t numSamples);
 	};
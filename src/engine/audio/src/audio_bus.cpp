@@ -0,0 +1,109 @@
+#include "audio_bus.h"
+#include "audio_mixer.h"
+#include "audio_voice.h"
+
+using namespace Halley;
+
+AudioBus::AudioBus(String name)
+	: name(std::move(name))
+{
+}
+
+const String& AudioBus::getName() const
+{
+	return name;
+}
+
+void AudioBus::setGain(float g)
+{
+	gain = g;
+}
+
+float AudioBus::getGain() const
+{
+	return gain;
+}
+
+void AudioBus::setParent(int p)
+{
+	parent = p;
+}
+
+int AudioBus::getParent() const
+{
+	return parent;
+}
+
+void AudioBus::setFilters(gsl::span<const AudioFilterConfig> configs)
+{
+	filters.clear();
+	filters.reserve(configs.size());
+	for (const auto& config: configs) {
+		filters.emplace_back();
+		filters.back().setParameters(config);
+	}
+}
+
+void AudioBus::startMix(size_t numChannels, size_t numSamples, AudioBufferPool& pool)
+{
+	voices.clear();
+	buffers = pool.getBuffers(numChannels, numSamples);
+
+	const size_t numPacks = numSamples / AudioSamplePack::NumSamples;
+	for (auto* buffer: buffers.getBuffers()) {
+		std::fill_n(buffer->packs.begin(), numPacks, AudioSamplePack{});
+	}
+}
+
+void AudioBus::addVoice(AudioVoice& voice)
+{
+	voices.push_back(&voice);
+}
+
+size_t AudioBus::getNumVoices() const
+{
+	return voices.size();
+}
+
+void AudioBus::mixVoices(size_t numSamples, AudioMixer& mixer, AudioBufferPool& pool)
+{
+	for (auto* voice: voices) {
+		voice->mixTo(numSamples, buffers.getBuffers(), mixer, pool);
+	}
+}
+
+void AudioBus::applyFilters(size_t numSamples)
+{
+	if (filters.empty()) {
+		return;
+	}
+
+	auto spans = buffers.getSampleSpans();
+	for (size_t channel = 0; channel < size_t(buffers.getBuffers().size()); ++channel) {
+		for (auto& filter: filters) {
+			filter.process(spans[channel].subspan(0, numSamples), channel);
+		}
+	}
+}
+
+void AudioBus::mixInto(gsl::span<AudioBuffer*> dst, size_t numSamples, AudioMixer& mixer)
+{
+	// Gain is already applied per voice, so buses just get summed
+	const size_t numPacks = numSamples / AudioSamplePack::NumSamples;
+	auto src = buffers.getBuffers();
+	for (size_t channel = 0; channel < size_t(src.size()); ++channel) {
+		const auto srcPacks = gsl::span<const AudioSamplePack>(src[channel]->packs).subspan(0, numPacks);
+		mixer.mixAudio(srcPacks, gsl::span<AudioSamplePack>(dst[channel]->packs).subspan(0, numPacks), 1.0f, 1.0f);
+	}
+}
+
+gsl::span<AudioBuffer*> AudioBus::getBuffers()
+{
+	return buffers.getBuffers();
+}
+
+void AudioBus::endMix()
+{
+	voices.clear();
+	buffers = AudioBuffersRef();
+}
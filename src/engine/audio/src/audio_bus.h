@@ -0,0 +1,45 @@
+#pragma once
+#include "audio_buffer.h"
+#include "audio_filter_biquad.h"
+#include "halley/text/halleystring.h"
+
+namespace Halley {
+	class AudioMixer;
+	class AudioVoice;
+
+	// A submix: voices in the same group are mixed into the bus' own buffers, which are then filtered and mixed into the parent bus
+	class AudioBus {
+	public:
+		explicit AudioBus(String name);
+
+		const String& getName() const;
+
+		void setGain(float gain);
+		float getGain() const;
+
+		void setParent(int parent);
+		int getParent() const;
+
+		void setFilters(gsl::span<const AudioFilterConfig> filters);
+
+		void startMix(size_t numChannels, size_t numSamples, AudioBufferPool& pool);
+		void addVoice(AudioVoice& voice);
+		size_t getNumVoices() const;
+
+		// These are safe to run in parallel with mixVoices() on other buses
+		void mixVoices(size_t numSamples, AudioMixer& mixer, AudioBufferPool& pool);
+
+		void applyFilters(size_t numSamples);
+		void mixInto(gsl::span<AudioBuffer*> dst, size_t numSamples, AudioMixer& mixer);
+		gsl::span<AudioBuffer*> getBuffers();
+		void endMix();
+
+	private:
+		String name;
+		float gain = 1.0f;
+		int parent = -1;
+		std::vector<AudioFilterBiquad> filters;
+		std::vector<AudioVoice*> voices;
+		AudioBuffersRef buffers;
+	};
+}
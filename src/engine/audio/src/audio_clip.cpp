@@ -114,6 +114,12 @@ size_t AudioClip::copyChannelData(size_t channelN, size_t pos, size_t len, gsl::
 	}
 }
 
+std::mutex* AudioClip::getReadMutex() const
+{
+	// Streamed clips share their decoder between all voices playing them
+	return streaming ? &streamMutex : nullptr;
+}
+
 size_t AudioClip::getLength() const
 {
 	Expects(isLoaded());
@@ -214,6 +220,11 @@ size_t StreamingAudioClip::getLength() const
 	return length;
 }
 
+bool StreamingAudioClip::canSeek() const
+{
+	return false;
+}
+
 size_t StreamingAudioClip::getSamplesLeft() const
 {
 	std::unique_lock<std::mutex> lock(mutex);
@@ -12,6 +12,7 @@
 #include "audio_variable_table.h"
 #include "halley/support/profiler.h"
 #include "halley/time/stopwatch.h"
+#include "halley/concurrency/concurrent.h"
 
 using namespace Halley;
 
@@ -267,7 +268,35 @@ void AudioEngine::setMasterGain(float gain)
 
 void AudioEngine::setGroupGain(const String& name, float gain)
 {
-	groupGains[getGroupId(name)] = gain;
+	buses[getGroupId(name)].setGain(gain);
+}
+
+void AudioEngine::setGroupParent(const String& name, const String& parentName)
+{
+	const int id = getGroupId(name);
+	const int parent = parentName.isEmpty() ? -1 : getGroupId(parentName);
+
+	// Refuse to create cycles
+	for (int cur = parent; cur != -1; cur = buses[cur].getParent()) {
+		if (cur == id) {
+			Logger::logError("Can't make audio group \"" + parentName + "\" the parent of \"" + name + "\", as that would create a cycle.");
+			return;
+		}
+	}
+
+	buses[id].setParent(parent);
+	busOrderDirty = true;
+}
+
+void AudioEngine::setGroupFilters(const String& name, std::vector<AudioFilterConfig> filters)
+{
+	buses[getGroupId(name)].setFilters(filters);
+}
+
+void AudioEngine::setVoiceBudget(size_t voices, float gain)
+{
+	maxVoices = voices;
+	minAudibleGain = gain;
 }
 
 void AudioEngine::mixEmitters(size_t numSamples, size_t nChannels, gsl::span<AudioBuffer*> buffers)
@@ -277,18 +306,165 @@ void AudioEngine::mixEmitters(size_t numSamples, size_t nChannels, gsl::span<Aud
 		clearBuffer(buffers[i]->packs);
 	}
 
-	// Mix every emitter
+	updateBusGraph();
+
+	// Update every emitter first, so we know how loud each one is
 	for (auto& e: emitters) {
 		// Start playing if necessary
 		if (!e->isPlaying() && !e->isDone() && e->isReady()) {
 			e->start();
 		}
 
-		// Mix it in!
 		if (e->isPlaying()) {
-			e->update(channels, listener, masterGain * getGroupGain(e->getGroup()));
-			e->mixTo(numSamples, buffers, *mixer, *pool);
+			e->update(channels, listener, getGroupGain(e->getGroup()));
+		}
+	}
+
+	updateVirtualVoices();
+
+	// Sort voices into their buses
+	for (auto& bus: buses) {
+		bus.startMix(nChannels, numSamples, *pool);
+	}
+	for (auto& e: emitters) {
+		if (e->isPlaying()) {
+			if (e->isVirtual()) {
+				e->skip(numSamples, *pool);
+			} else {
+				buses[e->getGroup()].addVoice(*e);
+			}
+		}
+	}
+
+	// Mix it in!
+	mixBuses(numSamples);
+
+	// Children are always before their parents in busMixOrder, so each bus is complete by the time it's filtered and passed on
+	for (const int busId: busMixOrder) {
+		auto& bus = buses[busId];
+		bus.applyFilters(numSamples);
+		const int parent = bus.getParent();
+		bus.mixInto(parent == -1 ? buffers : buses[parent].getBuffers(), numSamples, *mixer);
+	}
+
+	for (auto& bus: buses) {
+		bus.endMix();
+	}
+}
+
+void AudioEngine::updateBusGraph()
+{
+	// Gains multiply down the tree
+	busGains.resize(buses.size());
+	for (size_t i = 0; i < buses.size(); ++i) {
+		float gain = masterGain;
+		for (int cur = int(i); cur != -1; cur = buses[cur].getParent()) {
+			gain *= buses[cur].getGain();
+		}
+		busGains[i] = gain;
+	}
+
+	if (busOrderDirty) {
+		std::vector<int> depth(buses.size(), 0);
+		for (size_t i = 0; i < buses.size(); ++i) {
+			for (int cur = buses[i].getParent(); cur != -1; cur = buses[cur].getParent()) {
+				++depth[i];
+			}
 		}
+
+		busMixOrder.resize(buses.size());
+		for (size_t i = 0; i < buses.size(); ++i) {
+			busMixOrder[i] = int(i);
+		}
+		std::stable_sort(busMixOrder.begin(), busMixOrder.end(), [&] (int a, int b) { return depth[a] > depth[b]; });
+		busOrderDirty = false;
+	}
+}
+
+void AudioEngine::mixBuses(size_t numSamples)
+{
+	// Buses share no voices, so they can be mixed independently
+	// Not worth dispatching to other threads unless there's a fair amount of work
+	constexpr size_t minVoicesForParallelMix = 8;
+
+	activeBuses.clear();
+	size_t nVoices = 0;
+	for (auto& bus: buses) {
+		if (bus.getNumVoices() > 0) {
+			activeBuses.push_back(&bus);
+			nVoices += bus.getNumVoices();
+		}
+	}
+
+	auto& cpu = Executors::getCPU();
+	if (activeBuses.size() <= 1 || nVoices < minVoicesForParallelMix || cpu.threadCount() == 0) {
+		for (auto* bus: activeBuses) {
+			bus->mixVoices(numSamples, *mixer, *pool);
+		}
+		return;
+	}
+
+	busMixErrors.assign(activeBuses.size(), std::exception_ptr());
+	busMixFutures.clear();
+	for (size_t i = 1; i < activeBuses.size(); ++i) {
+		busMixFutures.push_back(Concurrent::execute(cpu, [this, bus = activeBuses[i], &error = busMixErrors[i], numSamples] ()
+		{
+			try {
+				bus->mixVoices(numSamples, *mixer, *pool);
+			} catch (...) {
+				error = std::current_exception();
+			}
+		}));
+	}
+
+	try {
+		activeBuses[0]->mixVoices(numSamples, *mixer, *pool);
+	} catch (...) {
+		busMixErrors[0] = std::current_exception();
+	}
+
+	// Help out instead of blocking, so this can't stall behind a busy pool
+	auto all = Concurrent::whenAll(busMixFutures.begin(), busMixFutures.end());
+	while (!all.isReady()) {
+		if (!cpu.tryRunOne()) {
+			std::this_thread::yield();
+		}
+	}
+	busMixFutures.clear();
+
+	for (auto& e: busMixErrors) {
+		if (e) {
+			std::rethrow_exception(e);
+		}
+	}
+}
+
+void AudioEngine::updateVirtualVoices()
+{
+	// Voices that can't be heard are always virtual, and out of the remaining ones only the most important ones within budget get mixed
+	audibleVoices.clear();
+	for (auto& e: emitters) {
+		if (e->isPlaying()) {
+			if (e->getAudibility() < minAudibleGain) {
+				e->setVirtual(true);
+			} else {
+				audibleVoices.push_back(e.get());
+			}
+		}
+	}
+
+	if (audibleVoices.size() > maxVoices) {
+		std::nth_element(audibleVoices.begin(), audibleVoices.begin() + maxVoices, audibleVoices.end(), [] (const AudioVoice* a, const AudioVoice* b)
+		{
+			if (a->getPriority() != b->getPriority()) {
+				return a->getPriority() > b->getPriority();
+			}
+			return a->getAudibility() > b->getAudibility();
+		});
+	}
+
+	for (size_t i = 0; i < audibleVoices.size(); ++i) {
+		audibleVoices[i]->setVirtual(i >= maxVoices);
 	}
 }
 
@@ -322,13 +498,13 @@ void AudioEngine::clearBuffer(gsl::span<AudioSamplePack> dst)
 
 int AudioEngine::getGroupId(const String& group)
 {
-	const auto iter = std::find(groupNames.begin(), groupNames.end(), group);
-	if (iter != groupNames.end()) {
-		return int(iter - groupNames.begin());
+	const auto iter = std::find_if(buses.begin(), buses.end(), [&] (const AudioBus& bus) { return bus.getName() == group; });
+	if (iter != buses.end()) {
+		return int(iter - buses.begin());
 	} else {
-		groupNames.push_back(group);
-		groupGains.push_back(1.0f);
-		return int(groupNames.size()) - 1;
+		buses.emplace_back(group);
+		busOrderDirty = true;
+		return int(buses.size()) - 1;
 	}
 }
 
@@ -344,5 +520,5 @@ int64_t AudioEngine::getLastTimeElapsed()
 
 float AudioEngine::getGroupGain(uint8_t id) const
 {
-	return groupGains[id];
+	return id < busGains.size() ? busGains[id] : masterGain * buses[id].getGain();
 }
@@ -6,9 +6,11 @@
 #include <vector>
 
 #include "audio_voice.h"
+#include "audio_bus.h"
 #include "halley/audio/resampler.h"
 #include "halley/data_structures/ring_buffer.h"
 #include "halley/maths/random.h"
+#include "halley/concurrency/future.h"
 
 namespace Halley {
 	class AudioMixer;
@@ -45,6 +47,9 @@ namespace Halley {
 
 		void setMasterGain(float gain);
 		void setGroupGain(const String& name, float gain);
+		void setGroupParent(const String& name, const String& parent);
+		void setGroupFilters(const String& name, std::vector<AudioFilterConfig> filters);
+		void setVoiceBudget(size_t maxVoices, float minAudibleGain);
 		int getGroupId(const String& group);
 
     	void setVariable(const String& name, float value);
@@ -72,8 +77,18 @@ namespace Halley {
 		std::vector<AudioVoice*> dummyIdSource;
 
 		float masterGain = 1.0f;
-		std::vector<String> groupNames;
-    	std::vector<float> groupGains;
+		size_t maxVoices = 64;
+		float minAudibleGain = 0.001f;
+		std::vector<AudioVoice*> audibleVoices;
+		std::vector<AudioBus> buses;
+		std::vector<float> busGains;
+		std::vector<int> busMixOrder;
+		bool busOrderDirty = true;
+
+		// Scratch space for mixBuses, kept around so the audio thread doesn't allocate them every callback
+		std::vector<AudioBus*> activeBuses;
+		std::vector<std::exception_ptr> busMixErrors;
+		std::vector<Future<void>> busMixFutures;
 
 		AudioListenerData listener;
 
@@ -83,6 +98,9 @@ namespace Halley {
     	std::vector<uint32_t> finishedSounds;
 
 		void mixEmitters(size_t numSamples, size_t channels, gsl::span<AudioBuffer*> buffers);
+		void updateVirtualVoices();
+		void updateBusGraph();
+		void mixBuses(size_t numSamples);
 	    void removeFinishedEmitters();
 		void clearBuffer(gsl::span<AudioSamplePack> dst);
 		void queueAudioFloat(gsl::span<const float> data);
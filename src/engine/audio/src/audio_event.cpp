@@ -116,6 +116,7 @@ AudioEventActionPlay::AudioEventActionPlay(AudioEvent& event, const ConfigNode&
 	minimumSpace = node["minimumSpace"].asFloat(0.0f);
 	delay = node["delay"].asFloat(0.0f);
 	loop = node["loop"].asBool(false);
+	priority = node["priority"].asInt(0);
 
 	if (node.hasKey("dynamics")) {
 		dynamics = AudioDynamicsConfig(node["dynamics"]);
@@ -150,6 +151,7 @@ bool AudioEventActionPlay::run(AudioEngine& engine, uint32_t id, const AudioPosi
 	}
 
 	auto voice = std::make_unique<AudioVoice>(source, position, curVolume, engine.getGroupId(group));
+	voice->setPriority(priority);
 	if (dynamics) {
 		voice->addBehaviour(std::make_unique<AudioVoiceDynamicsBehaviour>(dynamics.value(), engine));
 	}
@@ -173,6 +175,7 @@ void AudioEventActionPlay::serialize(Serializer& s) const
 	s << minimumSpace;
 	s << loop;
 	s << dynamics;
+	s << priority;
 }
 
 void AudioEventActionPlay::deserialize(Deserializer& s)
@@ -185,6 +188,7 @@ void AudioEventActionPlay::deserialize(Deserializer& s)
 	s >> minimumSpace;
 	s >> loop;
 	s >> dynamics;
+	s >> priority;
 }
 
 void AudioEventActionPlay::loadDependencies(const Resources& resources)
@@ -242,6 +242,27 @@ void AudioFacade::setGroupVolume(const String& groupName, float volume)
 	});
 }
 
+void AudioFacade::setGroupParent(const String& groupName, const String& parentGroupName)
+{
+	enqueue([=] () {
+		engine->setGroupParent(groupName, parentGroupName);
+	});
+}
+
+void AudioFacade::setGroupFilters(const String& groupName, std::vector<AudioFilterConfig> filters)
+{
+	enqueue([=, filters = std::move(filters)] () mutable {
+		engine->setGroupFilters(groupName, std::move(filters));
+	});
+}
+
+void AudioFacade::setVoiceBudget(size_t maxVoices, float minAudibleGain)
+{
+	enqueue([=] () {
+		engine->setVoiceBudget(maxVoices, minAudibleGain);
+	});
+}
+
 void AudioFacade::setOutputChannels(std::vector<AudioChannelData> audioChannelData)
 {
 	enqueue([=, audioChannelData = std::move(audioChannelData)] () mutable
@@ -1,4 +1,6 @@
 #include "audio_filter_biquad.h"
+#include "halley/utils/utils.h"
+#include <cmath>
 
 using namespace Halley;
 
@@ -7,6 +9,78 @@ AudioFilterBiquad::AudioFilterBiquad(std::shared_ptr<AudioSource> src)
 {
 }
 
+void AudioFilterBiquad::setParameters(float a0, float a1, float a2, float b1, float b2)
+{
+	this->a0 = a0;
+	this->a1 = a1;
+	this->a2 = a2;
+	this->b1 = b1;
+	this->b2 = b2;
+}
+
+void AudioFilterBiquad::setParameters(const AudioFilterConfig& config, float sampleRate)
+{
+	const float frequency = clamp(config.frequency, 1.0f, sampleRate * 0.49f);
+	const float w0 = 2.0f * pif() * frequency / sampleRate;
+	const float cosW0 = std::cos(w0);
+	const float alpha = std::sin(w0) / (2.0f * std::max(config.q, 0.01f));
+
+	float n0 = 1;
+	float n1 = 0;
+	float n2 = 0;
+	switch (config.type) {
+	case AudioFilterType::LowPass:
+		n0 = (1.0f - cosW0) * 0.5f;
+		n1 = 1.0f - cosW0;
+		n2 = n0;
+		break;
+	case AudioFilterType::HighPass:
+		n0 = (1.0f + cosW0) * 0.5f;
+		n1 = -(1.0f + cosW0);
+		n2 = n0;
+		break;
+	case AudioFilterType::BandPass:
+		n0 = alpha;
+		n1 = 0.0f;
+		n2 = -alpha;
+		break;
+	case AudioFilterType::Notch:
+		n0 = 1.0f;
+		n1 = -2.0f * cosW0;
+		n2 = 1.0f;
+		break;
+	}
+
+	const float d0 = 1.0f + alpha;
+	const float d1 = -2.0f * cosW0;
+	const float d2 = 1.0f - alpha;
+	setParameters(n0 / d0, n1 / d0, n2 / d0, d1 / d0, d2 / d0);
+}
+
+void AudioFilterBiquad::process(gsl::span<AudioConfig::SampleFormat> samples, size_t channel)
+{
+	// Transposed direct form II
+	auto& s = state.at(channel);
+	float z1 = s.z1;
+	float z2 = s.z2;
+	for (auto& sample: samples) {
+		const float in = sample;
+		const float out = in * a0 + z1;
+		z1 = in * a1 + z2 - b1 * out;
+		z2 = in * a2 - b2 * out;
+		sample = out;
+	}
+
+	// Don't let the state decay into denormals
+	s.z1 = std::abs(z1) < 1e-15f ? 0.0f : z1;
+	s.z2 = std::abs(z2) < 1e-15f ? 0.0f : z2;
+}
+
+void AudioFilterBiquad::reset()
+{
+	state = {};
+}
+
 uint8_t AudioFilterBiquad::getNumberOfChannels() const
 {
 	return src->getNumberOfChannels();
@@ -19,6 +93,9 @@ bool AudioFilterBiquad::isReady() const
 
 bool AudioFilterBiquad::getAudioData(size_t numSamples, AudioSourceData& dst)
 {
-	// TODO
-	return src->getAudioData(numSamples, dst);
+	const bool playing = src->getAudioData(numSamples, dst);
+	for (size_t i = 0; i < getNumberOfChannels(); ++i) {
+		process(dst[i].subspan(0, numSamples), i);
+	}
+	return playing;
 }
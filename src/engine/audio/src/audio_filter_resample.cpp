@@ -69,3 +69,13 @@ bool AudioFilterResample::getAudioData(size_t numSamples, AudioSourceData& dstBu
 
 	return playing;
 }
+
+bool AudioFilterResample::skipAudioData(size_t numSamples, AudioBufferPool& pool)
+{
+	// Leftovers are stale by the time we resume, and the resampler state only affects a few samples, which will be faded in anyway
+	const size_t nLeftOver = std::min(leftoverSamples[0].n, numSamples);
+	for (auto& l: leftoverSamples) {
+		l.n = 0;
+	}
+	return source->skipAudioData((numSamples - nLeftOver) * fromHz / toHz, pool);
+}
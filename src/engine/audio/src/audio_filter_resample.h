@@ -13,6 +13,7 @@ namespace Halley
 		uint8_t getNumberOfChannels() const override;
 		bool isReady() const override;
 		bool getAudioData(size_t numSamples, AudioSourceData& dst) override;
+		bool skipAudioData(size_t numSamples, AudioBufferPool& pool) override;
 
 	private:
 		AudioBufferPool& pool;
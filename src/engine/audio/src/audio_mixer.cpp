@@ -48,11 +48,17 @@ void AudioMixer::interleaveChannels(gsl::span<AudioSamplePack> dstBuffer, gsl::s
 
 void AudioMixer::concatenateChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs)
 {
-	size_t pos = 0;
-	for (size_t i = 0; i < size_t(srcs.size()); ++i) {
-		const size_t nBytes = srcs[i]->packs.size() * sizeof(AudioSamplePack);
-		memcpy(dst.subspan(pos, nBytes).data(), srcs[i]->packs.data(), nBytes);
-		pos += nBytes;
+	if (srcs.empty()) {
+		return;
+	}
+
+	// Source buffers come from the pool and can be larger than what is being output
+	const size_t nChannels = size_t(srcs.size());
+	const size_t packsPerChannel = size_t(dst.size()) / nChannels;
+	for (size_t i = 0; i < nChannels; ++i) {
+		Expects(srcs[i]->packs.size() >= packsPerChannel);
+		const auto channelDst = dst.subspan(i * packsPerChannel, packsPerChannel);
+		std::copy_n(srcs[i]->packs.data(), channelDst.size(), channelDst.data());
 	}
 }
 
@@ -66,73 +72,110 @@ void AudioMixer::compressRange(gsl::span<AudioSamplePack> buffer)
 	}
 }
 
-#ifdef HAS_SSE
+#ifdef HAS_AVX
 
 #ifdef _MSC_VER
-
 #include <intrin.h>
-
 #else
-
 #include <cpuid.h>
-static inline unsigned long long _xgetbv(unsigned int index){
-	unsigned int eax, edx;
-	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
-	return ((unsigned long long)edx << 32) | eax;
-}
-#define _XCR_XFEATURE_ENABLED_MASK 0
-
 #endif
 
+namespace {
+	void getCPUID(int leaf, int subLeaf, unsigned int regs[4])
+	{
+#ifdef _MSC_VER
+		int r[4];
+		__cpuidex(r, leaf, subLeaf);
+		for (int i = 0; i < 4; ++i) {
+			regs[i] = static_cast<unsigned int>(r[i]);
+		}
+#else
+		__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
 #endif
+	}
 
-#ifdef HAS_AVX
-static bool hasAVX()
-{
-#ifndef _MSC_VER
-    // It's crashing on Linux :(
-    return false;
+	unsigned long long getXCR0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
 #endif
+	}
 
-#ifdef HAS_SSE
-	int regs[4];
-	int i = 1;
+	bool hasAVX2()
+	{
+		unsigned int regs[4];
+		getCPUID(0, 0, regs);
+		const unsigned int maxLeaf = regs[0];
+		if (maxLeaf < 7) {
+			return false;
+		}
 
-#ifdef _WIN32
-	__cpuid(regs, i);
-#else
-	asm volatile
-	("cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
-	: "a" (i), "c" (0));
-	// ECX is set to zero for CPUID function 4
-#endif
+		getCPUID(1, 0, regs);
+		const bool fma = (regs[2] & (1 << 12)) != 0;
+		const bool osUsesXSAVE = (regs[2] & (1 << 27)) != 0;
+		const bool avx = (regs[2] & (1 << 28)) != 0;
+		if (!fma || !osUsesXSAVE || !avx) {
+			return false;
+		}
 
-	bool osUsesXSAVE_XRSTORE = regs[2] & (1 << 27) || false;
-	bool cpuAVXSuport = regs[2] & (1 << 28) || false;
+		// The OS must also be saving the YMM registers on context switches
+		if ((getXCR0() & 0x6) != 0x6) {
+			return false;
+		}
 
-	if (osUsesXSAVE_XRSTORE && cpuAVXSuport) {
-		unsigned long long xcrFeatureMask = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
-		return (xcrFeatureMask & 0x6) == 0x6;
-	} else {
-		return false;
+		getCPUID(7, 0, regs);
+		return (regs[1] & (1 << 5)) != 0;
 	}
+}
+
+#endif
+
+AudioMixerISA AudioMixer::getBestISA()
+{
+	static const AudioMixerISA best = [] ()
+	{
+#if defined(HAS_AVX)
+		if (hasAVX2()) {
+			return AudioMixerISA::AVX2;
+		}
+#endif
+#if defined(HAS_SSE)
+		return AudioMixerISA::SSE;
 #else
-	return false;
+		return AudioMixerISA::Scalar;
 #endif
+	}();
+	return best;
+}
+
+bool AudioMixer::isSupported(AudioMixerISA isa)
+{
+	return int(isa) <= int(getBestISA());
 }
-#endif
 
 std::unique_ptr<AudioMixer> AudioMixer::makeMixer()
 {
+	return makeMixer(getBestISA());
+}
+
+std::unique_ptr<AudioMixer> AudioMixer::makeMixer(AudioMixerISA isa)
+{
+	Expects(isSupported(isa));
+
+	switch (isa) {
 #ifdef HAS_AVX
-	if (hasAVX()) {
+	case AudioMixerISA::AVX2:
 		return std::make_unique<AudioMixerAVX>();
-	} else {
+#endif
+#ifdef HAS_SSE
+	case AudioMixerISA::SSE:
 		return std::make_unique<AudioMixerSSE>();
-	}
-#elif HAS_SEE
-	return std::make_unique<AudioMixerSSE>();
-#else
-	return std::make_unique<AudioMixer>();
 #endif
+	default:
+		return std::make_unique<AudioMixer>();
+	}
 }
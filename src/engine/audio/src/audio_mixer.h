@@ -5,10 +5,8 @@
 
 #if defined(_M_X64) || defined(__x86_64__)
 #define HAS_SSE
-#if !defined(__linux__)
 #define HAS_AVX
 #endif
-#endif
 
 #if defined(_M_IX86) || defined(__i386)
 // Might not be available, but do we really care about such old processors?
@@ -17,6 +15,14 @@
 
 namespace Halley
 {
+	// Ordered from least to most capable, each level is a superset of the previous one
+	enum class AudioMixerISA
+	{
+		Scalar,
+		SSE,
+		AVX2 // Also requires FMA
+	};
+
 	class AudioMixer
 	{
 	public:
@@ -26,6 +32,12 @@ namespace Halley
 		virtual void interleaveChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs);
 		virtual void concatenateChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs);
 		virtual void compressRange(gsl::span<AudioSamplePack> buffer);
+
+		// Picks the best implementation for the CPU we're running on, which isn't necessarily the one the engine was compiled for
 		static std::unique_ptr<AudioMixer> makeMixer();
+		static std::unique_ptr<AudioMixer> makeMixer(AudioMixerISA isa);
+
+		static AudioMixerISA getBestISA();
+		static bool isSupported(AudioMixerISA isa);
 	};
 }
@@ -1,61 +1,83 @@
 #include "audio_mixer_avx.h"
 
 #ifdef HAS_AVX
-#include <xmmintrin.h>
-
-#ifdef __clang__
 #include <immintrin.h>
-#endif
 
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
 
+// On GCC and Clang only these functions get compiled for AVX2, rather than the whole file.
+// Building the file with -mavx lets inline functions from headers be emitted with AVX instructions, and the linker can then pick those copies for the rest of the engine.
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define AVX2_TARGET
+#endif
+
 using namespace Halley;
 
-void AudioMixerAVX::mixAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<AudioSamplePack> dstRaw, float gain0, float gain1)
-{
-	gsl::span<const __m256> src(reinterpret_cast<const __m256*>(srcRaw.data()), srcRaw.size() * 2);
-	gsl::span<__m256> dst(reinterpret_cast<__m256*>(dstRaw.data()), dstRaw.size() * 2);
-	const size_t nSamples = size_t(src.size());
-
-	if (gain0 == gain1) {
-		__m256 gain = _mm256_broadcast_ss(&gain0);
-		for (size_t i = 0; i < nSamples; i += 2) {
-			dst[i] = _mm256_add_ps(dst[i], _mm256_mul_ps(src[i], gain));
-			dst[i + 1] = _mm256_add_ps(dst[i + 1], _mm256_mul_ps(src[i + 1], gain));
+namespace {
+	AVX2_TARGET void mixAVX(const float* src, float* dst, size_t nVecs, float gain0, float gain1, float scale)
+	{
+		if (gain0 == gain1) {
+			const __m256 gain = _mm256_set1_ps(gain0);
+			for (size_t i = 0; i < nVecs; i += 2) {
+				_mm256_store_ps(dst + 8 * i, _mm256_fmadd_ps(_mm256_load_ps(src + 8 * i), gain, _mm256_load_ps(dst + 8 * i)));
+				_mm256_store_ps(dst + 8 * i + 8, _mm256_fmadd_ps(_mm256_load_ps(src + 8 * i + 8), gain, _mm256_load_ps(dst + 8 * i + 8)));
+			}
+		} else {
+			const __m256 gainStart = _mm256_set1_ps(gain0);
+			const __m256 gainDelta = _mm256_set1_ps((gain1 - gain0) * scale);
+			const __m256 inc = _mm256_set1_ps(8.0f);
+			__m256 offset = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+			for (size_t i = 0; i < nVecs; ++i) {
+				const __m256 gain = _mm256_fmadd_ps(gainDelta, offset, gainStart);
+				offset = _mm256_add_ps(offset, inc);
+				_mm256_store_ps(dst + 8 * i, _mm256_fmadd_ps(_mm256_load_ps(src + 8 * i), gain, _mm256_load_ps(dst + 8 * i)));
+			}
+		}
+	}
+
+	AVX2_TARGET void interleaveAVX(const float* left, const float* right, float* dst, size_t nSrcVecs)
+	{
+		for (size_t i = 0; i < nSrcVecs; ++i) {
+			const __m256 l = _mm256_load_ps(left + 8 * i);
+			const __m256 r = _mm256_load_ps(right + 8 * i);
+
+			// Unpack works within each 128-bit lane, so the halves need swapping back into order afterwards
+			const __m256 lo = _mm256_unpacklo_ps(l, r);
+			const __m256 hi = _mm256_unpackhi_ps(l, r);
+			_mm256_store_ps(dst + 16 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+			_mm256_store_ps(dst + 16 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
 		}
-	} else {
-		const float sc = 1.0f / (dst.size() * 16);
-		const float gainDiff = gain1 - gain0;
-		const float eight = 8.0f;
-
-		__m256 gain0p = _mm256_broadcast_ss(&gain0);
-		__m256 gain1p = _mm256_broadcast_ss(&gainDiff);
-		__m256 scale = _mm256_broadcast_ss(&sc);
-		__m256 inc = _mm256_broadcast_ss(&eight);
-		__m256 offset = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
-		for (size_t i = 0; i < nSamples; ++i) {
-			__m256 t = _mm256_mul_ps(offset, scale);
-			__m256 gain = _mm256_add_ps(gain0p, _mm256_mul_ps(gain1p, t));
-			offset = _mm256_add_ps(offset, inc);
-			dst[i] = _mm256_add_ps(dst[i], _mm256_mul_ps(src[i], gain));
+	}
+
+	AVX2_TARGET void compressAVX(float* dst, size_t nVecs)
+	{
+		const __m256 minVal = _mm256_set1_ps(-0.99995f);
+		const __m256 maxVal = _mm256_set1_ps(0.99995f);
+		for (size_t i = 0; i < nVecs; ++i) {
+			_mm256_store_ps(dst + 8 * i, _mm256_max_ps(minVal, _mm256_min_ps(_mm256_load_ps(dst + 8 * i), maxVal)));
 		}
 	}
 }
 
-void AudioMixerAVX::compressRange(gsl::span<AudioSamplePack> buffer)
+void AudioMixerAVX::mixAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst, float gain0, float gain1)
 {
-	gsl::span<__m256> dst(reinterpret_cast<__m256*>(buffer.data()), buffer.size() * 2);
-	const size_t nSamples = size_t(dst.size());
+	const float scale = 1.0f / (dst.size() * AudioSamplePack::NumSamples);
+	mixAVX(src.data()->samples.data(), dst.data()->samples.data(), size_t(src.size()) * 2, gain0, gain1, scale);
+}
 
-	float val = 0.99995f;
-	__m256 minVal = { -val, -val, -val, -val, -val, -val, -val, -val };
-	__m256 maxVal = { val, val, val, val, val, val, val, val };
+void AudioMixerAVX::interleaveChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs)
+{
+	Expects(srcs.size() == 2);
+	interleaveAVX(srcs[0]->packs.data()->samples.data(), srcs[1]->packs.data()->samples.data(), dst.data()->samples.data(), size_t(dst.size()));
+}
 
-	for (size_t i = 0; i < nSamples; ++i) {
-		dst[i] = _mm256_max_ps(minVal, _mm256_min_ps(dst[i], maxVal));
-	}
+void AudioMixerAVX::compressRange(gsl::span<AudioSamplePack> buffer)
+{
+	compressAVX(buffer.data()->samples.data(), size_t(buffer.size()) * 2);
 }
 
 #endif
@@ -1,13 +1,15 @@
 #pragma once
-#include "audio_mixer.h"
+#include "audio_mixer_sse.h"
 
 #ifdef HAS_AVX
 namespace Halley
 {
-	class AudioMixerAVX final : public AudioMixer
+	// Requires AVX2 and FMA, only create it if AudioMixer::isSupported(AudioMixerISA::AVX2)
+	class AudioMixerAVX final : public AudioMixerSSE
 	{
 	public:
 		void mixAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst, float gainStart, float gainEnd) override;
+		void interleaveChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs) override;
 		void compressRange(gsl::span<AudioSamplePack> buffer) override;
 	};
 }
@@ -24,7 +24,7 @@ void AudioMixerSSE::mixAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<
 			dst[i + 3] = _mm_add_ps(dst[i + 3], _mm_mul_ps(src[i + 3], gain));
 		}
 	} else {
-		const float sc = 1.0f / (dst.size() * 16);
+		const float sc = 1.0f / (dstRaw.size() * AudioSamplePack::NumSamples);
 		const float gainDiff = gain1 - gain0;
 
 		__m128 gain0p = { gain0, gain0, gain0, gain0 };
@@ -41,6 +41,22 @@ void AudioMixerSSE::mixAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<
 	}
 }
 
+void AudioMixerSSE::interleaveChannels(gsl::span<AudioSamplePack> dstBuffer, gsl::span<AudioBuffer*> srcs)
+{
+	Expects(srcs.size() == 2);
+
+	// Each source pack fills two destination packs
+	const auto* left = reinterpret_cast<const __m128*>(srcs[0]->packs.data());
+	const auto* right = reinterpret_cast<const __m128*>(srcs[1]->packs.data());
+	auto* dst = reinterpret_cast<__m128*>(dstBuffer.data());
+	const size_t nSrc = size_t(dstBuffer.size()) * 2;
+
+	for (size_t i = 0; i < nSrc; ++i) {
+		dst[2 * i] = _mm_unpacklo_ps(left[i], right[i]);
+		dst[2 * i + 1] = _mm_unpackhi_ps(left[i], right[i]);
+	}
+}
+
 void AudioMixerSSE::compressRange(gsl::span<AudioSamplePack> buffer)
 {
 	gsl::span<__m128> dst(reinterpret_cast<__m128*>(buffer.data()), buffer.size() * 4);
@@ -4,10 +4,11 @@
 #ifdef HAS_SSE
 namespace Halley
 {
-	class AudioMixerSSE final : public AudioMixer
+	class AudioMixerSSE : public AudioMixer
 	{
 	public:
 		void mixAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst, float gainStart, float gainEnd) override;
+		void interleaveChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs) override;
 		void compressRange(gsl::span<AudioSamplePack> buffer) override;
 	};
 }
@@ -0,0 +1,11 @@
+#include "audio_source.h"
+#include "audio_buffer.h"
+
+using namespace Halley;
+
+bool AudioSource::skipAudioData(size_t numSamples, AudioBufferPool& pool)
+{
+	auto buffers = pool.getBuffers(getNumberOfChannels(), numSamples);
+	auto spans = buffers.getSampleSpans();
+	return getAudioData(numSamples, spans);
+}
@@ -31,6 +31,11 @@ bool AudioSourceClip::getAudioData(size_t samplesRequested, AudioSourceData& dst
 	}
 	const auto playbackLength = int64_t(clip->getLength());
 
+	std::unique_lock<std::mutex> lock;
+	if (auto* mutex = clip->getReadMutex()) {
+		lock = std::unique_lock<std::mutex>(*mutex);
+	}
+
 	bool isPlaying = true;
 	const uint8_t nChannels = getNumberOfChannels();
 	size_t samplesWritten = 0;
@@ -93,3 +98,41 @@ bool AudioSourceClip::getAudioData(size_t samplesRequested, AudioSourceData& dst
 
 	return isPlaying;
 }
+
+bool AudioSourceClip::skipAudioData(size_t numSamples, AudioBufferPool& pool)
+{
+	Expects(isReady());
+	if (!clip->canSeek()) {
+		return AudioSource::skipAudioData(numSamples, pool);
+	}
+
+	// Same bookkeeping as getAudioData, without touching any samples. Streamed clips will seek when they get read again.
+	const auto playbackLength = int64_t(clip->getLength());
+	auto remaining = int64_t(numSamples);
+
+	if (playbackPos < 0) {
+		const auto delaySamples = std::min(-playbackPos, remaining);
+		playbackPos += delaySamples;
+		remaining -= delaySamples;
+	}
+
+	while (remaining > 0) {
+		if (playbackPos >= playbackLength) {
+			if (!looping) {
+				return false;
+			}
+			playbackPos = int64_t(clip->getLoopPoint());
+			if (playbackPos >= playbackLength) {
+				looping = false;
+				playbackPos = playbackLength;
+				return false;
+			}
+		}
+
+		const auto samplesToSkip = std::min(remaining, playbackLength - playbackPos);
+		playbackPos += samplesToSkip;
+		remaining -= samplesToSkip;
+	}
+
+	return true;
+}
@@ -12,6 +12,8 @@ AudioVoice::AudioVoice(std::shared_ptr<AudioSource> source, AudioPosition source
 	, playing(false)
 	, done(false)
 	, isFirstUpdate(true)
+	, virtualised(false)
+	, fadingOut(false)
 	, baseGain(gain)
 	, userGain(1.0f)
 	, source(std::move(source))
@@ -138,6 +140,62 @@ void AudioVoice::update(gsl::span<const AudioChannelData> channels, const AudioL
 		prevChannelMix = channelMix;
 		isFirstUpdate = false;
 	}
+
+	const size_t nMixes = std::min(size_t(nChannels) * size_t(channels.size()), channelMix.size());
+	audibility = 0.0f;
+	for (size_t i = 0; i < nMixes; ++i) {
+		audibility = std::max(audibility, channelMix[i]);
+	}
+}
+
+void AudioVoice::setVirtual(bool value)
+{
+	if (value) {
+		if (fadingOut) {
+			virtualised = true;
+			fadingOut = false;
+		} else if (!virtualised) {
+			fadingOut = true;
+			channelMix.fill(0.0f);
+		}
+	} else {
+		if (virtualised) {
+			prevChannelMix.fill(0.0f);
+		}
+		virtualised = false;
+		fadingOut = false;
+	}
+}
+
+bool AudioVoice::isVirtual() const
+{
+	return virtualised;
+}
+
+void AudioVoice::skip(size_t numSamples, AudioBufferPool& pool)
+{
+	Expects(virtualised);
+
+	const bool isPlaying = source->skipAudioData(numSamples, pool);
+	advancePlayback(numSamples);
+	if (!isPlaying) {
+		stop();
+	}
+}
+
+float AudioVoice::getAudibility() const
+{
+	return audibility;
+}
+
+void AudioVoice::setPriority(int p)
+{
+	priority = p;
+}
+
+int AudioVoice::getPriority() const
+{
+	return priority;
 }
 
 void AudioVoice::mixTo(size_t numSamples, gsl::span<AudioBuffer*> dst, AudioMixer& mixer, AudioBufferPool& pool)
@@ -35,6 +35,16 @@ namespace Halley {
 
 		void update(gsl::span<const AudioChannelData> channels, const AudioListenerData& listener, float groupGain);
 		void mixTo(size_t numSamples, gsl::span<AudioBuffer*> dst, AudioMixer& mixer, AudioBufferPool& pool);
+
+		// Virtual voices keep their playback position moving, but don't read or mix any data
+		// A voice being virtualised still gets mixed for one more buffer, fading out, and fades back in when it becomes real again
+		void setVirtual(bool virtualised);
+		bool isVirtual() const;
+		void skip(size_t numSamples, AudioBufferPool& pool);
+
+		float getAudibility() const; // Loudest channel gain on the last update
+		void setPriority(int priority);
+		int getPriority() const;
 		
 		void setId(uint32_t id);
 		uint32_t getId() const;
@@ -50,6 +60,10 @@ namespace Halley {
 		bool playing : 1;
 		bool done : 1;
 		bool isFirstUpdate : 1;
+		bool virtualised : 1;
+		bool fadingOut : 1;
+		int priority = 0;
+		float audibility = 0.0f;
     	float baseGain = 1.0f;
 		float dynamicGain = 1.0f;
 		float userGain = 1.0f;
@@ -96,6 +96,41 @@ namespace Halley
 		float gain = 1.0f;
 	};
 
+	enum class AudioFilterType
+	{
+		LowPass,
+		HighPass,
+		BandPass,
+		Notch
+	};
+
+	template <>
+	struct EnumNames<AudioFilterType> {
+		constexpr std::array<const char*, 4> operator()() const {
+			return{{
+				"lowPass",
+				"highPass",
+				"bandPass",
+				"notch"
+			}};
+		}
+	};
+
+	class AudioFilterConfig
+	{
+	public:
+		AudioFilterType type = AudioFilterType::LowPass;
+		float frequency = 1000.0f; // Hz
+		float q = 0.7071f;
+
+		AudioFilterConfig() {}
+		AudioFilterConfig(AudioFilterType type, float frequency, float q = 0.7071f)
+			: type(type)
+			, frequency(frequency)
+			, q(q)
+		{}
+	};
+
 	using AudioCallback = std::function<void()>;
 
 	class IAudioOutput
@@ -179,6 +214,12 @@ namespace Halley
 
 		virtual void setMasterVolume(float gain = 1.0f) = 0;
 		virtual void setGroupVolume(const String& groupName, float gain = 1.0f) = 0;
+		// Groups are submix buses. Each one is mixed separately, goes through its filters, and then into its parent (or the output, if it has none)
+		virtual void setGroupParent(const String& groupName, const String& parentGroupName) = 0;
+		virtual void setGroupFilters(const String& groupName, std::vector<AudioFilterConfig> filters) = 0;
+		// Only up to maxVoices voices are mixed, chosen by priority and then loudness. Voices quieter than minAudibleGain are never mixed.
+		// Voices left out keep playing silently, and are faded back in when they make the cut again.
+		virtual void setVoiceBudget(size_t maxVoices, float minAudibleGain = 0.001f) = 0;
 		virtual void setOutputChannels(std::vector<AudioChannelData> audioChannelData) = 0;
 
 		virtual void setGlobalVariable(const String& variable, float value) = 0;
@@ -18,6 +18,15 @@ namespace Halley
 	class MaterialConstantBuffer;
 	class Material;
 
+	// Vertex data kept in video memory across frames, see Painter::drawRetainedSprites()
+	class RetainedVertexBuffer
+	{
+	public:
+		virtual ~RetainedVertexBuffer() {}
+
+		virtual void update(gsl::span<const gsl::byte> data) = 0;
+	};
+
 	class VideoAPI
 	{
 	public:
@@ -36,6 +45,7 @@ namespace Halley
 		virtual std::unique_ptr<TextureRenderTarget> createTextureRenderTarget() = 0;
 		virtual std::unique_ptr<ScreenRenderTarget> createScreenRenderTarget() = 0;
 		virtual std::unique_ptr<MaterialConstantBuffer> createConstantBuffer() = 0;
+		virtual std::unique_ptr<RetainedVertexBuffer> createRetainedVertexBuffer() { return {}; } // Optional, return null if not supported
 
 		virtual String getShaderLanguage() = 0;
 		virtual bool isColumnMajor() const { return false; }
@@ -6,6 +6,7 @@
 #include "halley/core/graphics/material/material_parameter.h"
 #include <gsl/gsl>
 #include <bitset>
+#include <atomic>
 
 namespace Halley
 {
@@ -56,9 +57,10 @@ namespace Halley
 		Bytes data;
 		Vector<int> addresses;
 		MaterialDataBlockType dataBlockType = MaterialDataBlockType::Local;
-		mutable bool needToUpdateHash = true;
 		int16_t bindPoint = 0;
-		mutable uint64_t hash = 0;
+		// The hash is cached lazily, and may be requested from several threads at once (e.g. RenderGraph's parallel recording)
+		mutable std::atomic<bool> needToUpdateHash = true;
+		mutable std::atomic<uint64_t> hash = 0;
 
 		bool setUniform(size_t offset, ShaderParameterType type, const void* data);
 	};
@@ -117,6 +119,10 @@ namespace Halley
 
 		uint64_t getHash() const;
 
+		// Sorting by this key puts materials that are cheap to switch between next to each other (same shader, then same textures)
+		// Materials that compare equal always have the same key
+		uint64_t getBatchKey() const;
+
 	private:
 		std::shared_ptr<const MaterialDefinition> materialDefinition;
 		
@@ -125,8 +131,10 @@ namespace Halley
 		Vector<MaterialDataBlock> dataBlocks;
 		std::vector<std::shared_ptr<const Texture>> textures;
 
-		mutable uint64_t hashValue = 0;
-		mutable bool needToUpdateHash = true;
+		// See MaterialDataBlock: these caches must be safe to fill from concurrent readers
+		mutable std::atomic<uint64_t> hashValue = 0;
+		mutable std::atomic<uint64_t> batchKeyValue = 0;
+		mutable std::atomic<bool> needToUpdateHash = true;
 		std::optional<uint8_t> stencilReferenceOverride;
 		std::bitset<8> passEnabled;
 
@@ -135,6 +143,7 @@ namespace Halley
 
 		bool setUniform(int blockNumber, size_t offset, ShaderParameterType type, const void* data);
 		uint64_t computeHash() const;
+		uint64_t computeBatchKey(uint64_t hash) const;
 
 		const std::shared_ptr<const Texture>& getFallbackTexture() const;
 	};
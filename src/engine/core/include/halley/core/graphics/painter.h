@@ -16,6 +16,7 @@ namespace Halley
 	class VideoAPI;
 	class MaterialDataBlock;
 	class MaterialConstantBuffer;
+	class RetainedVertexBuffer;
 	class BezierCubic;
 	class BezierQuadratic;
 	class Polygon;
@@ -25,7 +26,10 @@ namespace Halley
 	class MaterialDefinition;
 	class Camera;
 	class RenderContext;
+	class RenderTarget;
 	class Core;
+	class PainterCommandList;
+	class RecordingPainter;
 
 	class Painter
 	{
@@ -70,6 +74,12 @@ namespace Halley
 		// vertPosOffset is the offset, in bytes, from the start of each vertex's data, to a Vector2f which will be filled with the vertex's position in 0-1 space.
 		void drawSprites(const std::shared_ptr<Material>& material, size_t numSprites, const void* vertexData);
 
+		// Same as drawSprites, but for geometry that rarely changes. The painter keeps the expanded vertices (in video memory, if the backend supports it)
+		// under id, and only rebuilds them when version changes, so drawing unchanged sprites doesn't copy any vertex data.
+		// Ids not drawn for a few frames are released. Get ids from allocateRetainedId().
+		void drawRetainedSprites(const std::shared_ptr<Material>& material, uint64_t id, uint64_t version, size_t numSprites, const void* vertexData);
+		static uint64_t allocateRetainedId();
+
 		// Draw one sliced sprite. Slices -> x = left, y = top, z = right, w = bottom, in [0..1] space relative to the texture
 		void drawSlicedSprite(const std::shared_ptr<Material>& material, Vector2f scale, Vector4f slices, const void* vertexData);
 
@@ -94,6 +104,13 @@ namespace Halley
 		// Blit a texture over
 		void blitTexture(const std::shared_ptr<const Texture>& texture);
 
+		// Replays commands recorded by a RecordingPainter, in order, batching them with whatever else is drawn
+		// Must be bound to the same camera and render target that the commands were recorded with
+		void submit(const PainterCommandList& commands);
+
+		// Makes a painter that records commands instead of drawing them, for use from other threads
+		std::unique_ptr<RecordingPainter> makeRecordingPainter() const;
+
 		size_t getNumDrawCalls() const { return nDrawCalls; }
 		size_t getNumVertices() const { return nVertices; }
 		size_t getNumTriangles() const { return nTriangles; }
@@ -114,11 +131,21 @@ namespace Halley
 		virtual void doEndRender() = 0;
 		virtual void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, IndexType* indices, bool standardQuadsOnly) = 0;
 		virtual void drawTriangles(size_t numIndices) = 0;
+		// Only called on backends whose VideoAPI creates retained vertex buffers. Indices are always standard quads.
+		virtual void setRetainedVertices(const MaterialDefinition& material, RetainedVertexBuffer& buffer, size_t numVertices);
 
 		virtual void setViewPort(Rect4i rect) = 0;
 		virtual void setClip(Rect4i clip, bool enable) = 0;
 
 		virtual void onUpdateProjection(Material& material, bool hashChanged) = 0;
+
+		// Called with each batch of vertices that is ready to be drawn. Clip is relative to the viewport.
+		virtual void submitPending(const std::shared_ptr<Material>& material, size_t numVertices, char* vertexData, gsl::span<const IndexType> indices, bool standardQuadsOnly, Rect4i clip);
+		virtual bool isRecording() const { return false; }
+
+		void bind(const Camera& camera, RenderTarget& defaultRenderTarget, bool bindRenderTarget);
+		void unbind(bool bindRenderTarget);
+		void refreshRetainedSpritesCache();
 		void generateQuadIndices(IndexType firstVertex, size_t numQuads, IndexType* target);
 		RenderTarget& getActiveRenderTarget();
 
@@ -134,6 +161,14 @@ namespace Halley
 			std::shared_ptr<MaterialConstantBuffer> buffer;
 			int age = 0;
 		};
+
+		class RetainedSpritesEntry {
+		public:
+			std::unique_ptr<RetainedVertexBuffer> buffer;
+			Vector<char> vertices; // Only used if the backend doesn't support retained buffers
+			uint64_t version = 0;
+			int age = 0;
+		};
 		
 		Resources& resources;
 		VideoAPI& video;
@@ -165,11 +200,14 @@ namespace Halley
 		Vector<IndexType> stdQuadIndexCache;
 		std::optional<Rect4i> curClip;
 		std::optional<Rect4i> pendingClip;
+		Rect4i curClipArea;
 
 		Vector<String> curDebugGroupStack;
 		Vector<String> pendingDebugGroupStack;
 
 		HashMap<uint64_t, ConstantBufferEntry> constantBuffers;
+		HashMap<uint64_t, RetainedSpritesEntry> retainedSprites;
+		Vector<char> retainedScratch;
 
 		void bind(RenderContext& context);
 		void unbind(RenderContext& context);
@@ -181,6 +219,8 @@ namespace Halley
 		void startDrawCall(const std::shared_ptr<Material>& material);
 		void flushPending();
 		void executeDrawPrimitives(Material& material, size_t numVertices, void* vertexData, gsl::span<const IndexType> indices, PrimitiveType primitiveType = PrimitiveType::Triangle);
+		void executeDrawRetained(Material& material, RetainedVertexBuffer& buffer, size_t numVertices);
+		void drawMaterialPasses(Material& material, size_t numVertices, size_t numIndices);
 
 		void makeSpaceForPendingVertices(size_t numBytes);
 		void makeSpaceForPendingIndices(size_t numIndices);
@@ -198,5 +238,7 @@ namespace Halley
 		std::shared_ptr<Material> getSolidPolygonMaterial();
 
 		void refreshConstantBufferCache();
+
+		static void expandSpriteVertices(const MaterialDefinition& material, size_t numSprites, const char* src, char* dst);
 	};
 }
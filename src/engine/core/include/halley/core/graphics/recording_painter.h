@@ -0,0 +1,80 @@
+#pragma once
+#include "painter.h"
+#include "halley/data_structures/vector.h"
+#include "halley/text/halleystring.h"
+
+namespace Halley
+{
+	// Draw commands and their vertex data, as recorded by a RecordingPainter and replayed with Painter::submit()
+	class PainterCommandList
+	{
+		friend class Painter;
+		friend class RecordingPainter;
+
+	public:
+		void clear();
+		bool empty() const;
+		size_t getNumCommands() const;
+
+	private:
+		enum class CommandType : uint8_t {
+			Draw,
+			Clear,
+			PushDebugGroup,
+			PopDebugGroup
+		};
+
+		struct Command {
+			CommandType type;
+			bool standardQuadsOnly = false;
+			std::shared_ptr<Material> material;
+			Rect4i clip;
+			size_t vertexOffset = 0;
+			size_t numVertices = 0;
+			size_t indexOffset = 0;
+			size_t numIndices = 0;
+			std::optional<Colour> colour;
+			std::optional<float> depth;
+			std::optional<uint8_t> stencil;
+			String debugGroup;
+		};
+
+		Vector<Command> commands;
+		Vector<char> vertices;
+		Vector<IndexType> indices;
+	};
+
+	// A painter that doesn't talk to the video backend, and instead stores whatever would have been drawn into a PainterCommandList.
+	// This allows several threads to generate geometry at the same time, e.g. for independent render graph nodes, with the main painter
+	// submitting the results in order afterwards. It must not be used by more than one thread at a time.
+	class RecordingPainter final : public Painter
+	{
+	public:
+		RecordingPainter(VideoAPI& video, Resources& resources);
+
+		void startRecording(const Camera& camera, RenderTarget& defaultRenderTarget, PainterCommandList& commands);
+		void finishRecording();
+
+		void clear(std::optional<Colour> colour, std::optional<float> depth, std::optional<uint8_t> stencil) override;
+		void setMaterialPass(const Material& material, int pass) override;
+		void setMaterialData(const Material& material) override;
+
+	protected:
+		void doStartRender() override;
+		void doEndRender() override;
+		void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, IndexType* indices, bool standardQuadsOnly) override;
+		void drawTriangles(size_t numIndices) override;
+		void setViewPort(Rect4i rect) override;
+		void setClip(Rect4i clip, bool enable) override;
+		void onUpdateProjection(Material& material, bool hashChanged) override;
+
+		void submitPending(const std::shared_ptr<Material>& material, size_t numVertices, char* vertexData, gsl::span<const IndexType> indices, bool standardQuadsOnly, Rect4i clip) override;
+		bool isRecording() const override { return true; }
+
+	private:
+		PainterCommandList* commands = nullptr;
+		Vector<String> debugGroupStack;
+
+		void syncDebugGroups(const Vector<String>& stack);
+	};
+}
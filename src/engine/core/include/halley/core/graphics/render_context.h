@@ -20,6 +20,8 @@ namespace Halley
 			popContext();
 		}
 
+		// Core makes one for the screen every frame, but any painter can render through one outside of the main loop
+		RenderContext(Painter& painter, const Camera& camera, RenderTarget& renderTarget);
 		RenderContext(const RenderContext& context) noexcept;
 		RenderContext(RenderContext&& context) noexcept;
 
@@ -29,6 +31,8 @@ namespace Halley
 
 		RenderTarget& getDefaultRenderTarget() const;
 
+		std::unique_ptr<RecordingPainter> makeRecordingPainter() const;
+
 		void flush();
 
 	private:
@@ -38,7 +42,6 @@ namespace Halley
 
 		RenderContext* restore = nullptr;
 
-		RenderContext(Painter& painter, const Camera& camera, RenderTarget& renderTarget);
 		void setActive();
 		void setInactive();
 		void pushContext();
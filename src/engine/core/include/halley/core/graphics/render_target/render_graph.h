@@ -17,6 +17,8 @@ namespace Halley {
 	class Painter;
 	class Material;
 	class RenderGraphNode;
+	class RecordingPainter;
+	class PainterCommandList;
 	
 	class RenderGraph {
 	public:
@@ -24,6 +26,7 @@ namespace Halley {
 
 		RenderGraph();
 		explicit RenderGraph(std::shared_ptr<const RenderGraphDefinition> graphDefinition);
+		~RenderGraph();
 
 		void update();
 		void render(const RenderContext& rc, VideoAPI& video, std::optional<Vector2i> renderSize = {});
@@ -49,6 +52,12 @@ namespace Halley {
 		bool remapNode(std::string_view outputName, uint8_t outputPin, std::string_view inputName, uint8_t inputPin);
 		void resetGraph();
 
+		// When enabled, paint methods of nodes that don't depend on each other are recorded in parallel, and then submitted in order
+		// Only enable this if every paint method used by this graph is safe to run concurrently with the others
+		// Materials may be shared between nodes and read (hashed, compared, bound) from several recorders at once,
+		// but nothing may modify a material, its uniforms or its textures while the graph is being recorded
+		void setParallelRecording(bool enabled);
+
 	private:
 		enum class VariableType {
 			None,
@@ -86,10 +95,15 @@ namespace Halley {
 		std::shared_ptr<const RenderGraphDefinition> graphDefinition;
 		int lastDefinitionVersion = 0;
 
+		bool parallelRecording = false;
+		std::vector<std::unique_ptr<RecordingPainter>> recorders;
+		std::vector<PainterCommandList> commandLists;
+
 		void addNode(String id, std::unique_ptr<RenderGraphNode> node);
 		RenderGraphNode* getNode(const String& id);
 		RenderGraphNode* tryGetNode(const String& id);
 
 		void loadDefinition(std::shared_ptr<const RenderGraphDefinition> definition);
+		void renderWave(const RenderContext& rc, VideoAPI& video, std::vector<RenderGraphNode*>& renderQueue, size_t start, size_t end);
 	};
 }
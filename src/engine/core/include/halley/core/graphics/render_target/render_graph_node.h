@@ -14,6 +14,8 @@ namespace Halley {
 	class Texture;
 	class RenderGraph;
 	class TextureRenderTarget;
+	class RecordingPainter;
+	class PainterCommandList;
 	
 	class RenderGraphNode {
 		friend class RenderGraph;
@@ -50,6 +52,7 @@ namespace Halley {
 		void prepareDependencyGraph(VideoAPI& video, Vector2i targetSize);
 		void prepareInputPin(InputPin& pin, VideoAPI& video, Vector2i targetSize);
 		void prepareTextures(VideoAPI& video, const RenderContext& rc);
+		void blitInputs(const RenderContext& rc);
 		
 		void render(const RenderGraph& graph, VideoAPI& video, const RenderContext& rc, std::vector<RenderGraphNode*>& renderQueue);
 		void notifyOutputs(std::vector<RenderGraphNode*>& renderQueue);
@@ -64,6 +67,10 @@ namespace Halley {
 		void renderNodeOverlayMethod(const RenderGraph& graph, const RenderContext& rc);
 		void renderNodeImageOutputMethod(const RenderGraph& graph, const RenderContext& rc);
 		void renderNodeBlitTexture(std::shared_ptr<const Texture> texture, const RenderContext& rc);
+
+		bool canRecord(const RenderGraph& graph) const;
+		void record(const RenderGraph& graph, const RenderContext& rc, RecordingPainter& painter, PainterCommandList& commands);
+		void submitRecorded(const RenderGraph& graph, const RenderContext& rc, const PainterCommandList& commands);
 		RenderContext getTargetRenderContext(const RenderContext& rc) const;
 		std::shared_ptr<TextureRenderTarget> getRenderTarget(VideoAPI& video);
 
@@ -136,4 +136,10 @@ namespace Halley
 		ConfigNode serialize(const AnimationPlayer& player, const ConfigNodeSerializationContext& context);
 		AnimationPlayer deserialize(const ConfigNodeSerializationContext& context, const ConfigNode& node);
 	};
+
+	template<>
+	class ConfigNodeAssetDependencies<AnimationPlayer> {
+	public:
+		static void collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result);
+	};
 }
@@ -10,16 +10,6 @@ namespace Halley {
 	class Animation;
 	
 	class Particles {
-		struct Particle {
-			Vector2f pos;
-			Vector2f vel;
-			Angle1f angle;
-			float scale = 1;
-			float time = 0;
-			float ttl = 1;
-			bool alive = true;
-		};
-		
 	public:
 		Particles();
 		Particles(const ConfigNode& node, Resources& resources);
@@ -55,9 +45,26 @@ namespace Halley {
 		bool firstUpdate = true;
 		float spawnRateMultiplier = 1.0f;
 
+		// Particle state is kept as one array per field, so it can be stepped four lanes at a time
+		struct ParticleState {
+			Vector<float> posX;
+			Vector<float> posY;
+			Vector<float> velX;
+			Vector<float> velY;
+			Vector<float> rotation;
+			Vector<float> scale;
+			Vector<float> alpha;
+			Vector<float> time;
+			Vector<float> ttl;
+
+			void resize(size_t size);
+			void move(size_t from, size_t to);
+		};
+
 		std::vector<Sprite> sprites;
-		std::vector<Particle> particles;
+		ParticleState particles;
 		std::vector<AnimationPlayerLite> animationPlayers;
+		Vector<float> scatterAngles;
 		
 		size_t nParticlesAlive = 0;
 		size_t nParticlesVisible = 0;
@@ -92,6 +99,10 @@ namespace Halley {
 		void spawn(size_t n);
 		void initializeParticle(size_t index);
 		void updateParticles(float t);
+		void updateParticleRange(float t, size_t start, size_t end);
+		void integrateVelocities(float t, size_t start, size_t end);
+		void integratePositions(float t, size_t start, size_t end);
+		void writeSprites(size_t start, size_t end);
 
 		Vector2f getSpawnPosition() const;
 	};
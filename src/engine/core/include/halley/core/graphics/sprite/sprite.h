@@ -42,6 +42,10 @@ namespace Halley
 
 	class Sprite
 	{
+		friend class StaticSpriteBatch;
+		friend class Particles;
+		friend class DetachedCopy<Sprite>;
+
 	public:
 		struct RectInfo {
 			Vector2f pivot;
@@ -226,4 +230,16 @@ namespace Halley
 		Sprite deserialize(const ConfigNodeSerializationContext& context, const ConfigNode& node);
 		void deserialize(const ConfigNodeSerializationContext& context, const ConfigNode& node, Sprite& target);
 	};
+
+	template<>
+	class ConfigNodeAssetDependencies<Sprite> {
+	public:
+		static void collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result);
+	};
+
+	template<>
+	class DetachedCopy<Sprite> {
+	public:
+		static void detach(Sprite& sprite);
+	};
 }
@@ -51,12 +51,15 @@ namespace Halley
 		SpritePainterEntry(SpritePainterEntryType type, size_t spriteIdx, size_t count, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
 
 		bool operator<(const SpritePainterEntry& o) const;
+		uint64_t getSortKey() const;
 		SpritePainterEntryType getType() const;
 		gsl::span<const Sprite> getSprites() const;
 		gsl::span<const TextRenderer> getTexts() const;
 		uint32_t getIndex() const;
 		uint32_t getCount() const;
 		int getMask() const;
+		int getLayer() const;
+		float getTieBreaker() const;
 		const std::optional<Rect4f>& getClip() const;
 
 	private:
@@ -86,16 +89,54 @@ namespace Halley
 		
 		void draw(int mask, Painter& painter);
 
+		// Allows sprites on this layer whose tie breakers are at most tolerance apart to be drawn in any order, so that the ones
+		// sharing a material can be batched together. Only use it on layers where such sprites don't overlap (e.g. tiles).
+		// Text and callbacks are never moved, and sprites are never moved across them.
+		void setBatchReordering(int layer, std::optional<float> tieBreakerTolerance);
+
 	private:
+		// Screen space extents of an entry, or of a run of consecutive entries (in draw order) that can be rejected together
+		// Text and callbacks have no known extents, so anything containing them is never culled by bounds
+		struct CullBounds {
+			bool visible = false;
+			bool hasBounds = true;
+			Rect4f bounds;
+
+			void add(const CullBounds& other);
+			bool isInView(Rect4f view) const;
+		};
+
+		struct CullBlock {
+			uint32_t start;
+			uint32_t end;
+			int mask;
+			CullBounds bounds;
+		};
+
 		Vector<SpritePainterEntry> sprites;
 		Vector<Sprite> cachedSprites;
 		Vector<TextRenderer> cachedText;
 		Vector<SpritePainterEntry::Callback> callbacks;
 		bool dirty = false;
 		bool forceCopy = false;
+		HashMap<int, float> batchReorderLayers;
+
+		Vector<uint64_t> sortKeys;
+		Vector<uint32_t> sortOrder;
+		Vector<uint32_t> sortScratch;
+		Vector<SpritePainterEntry> sortedSprites;
+		Vector<CullBounds> entryBounds;
+		Vector<CullBlock> cullBlocks;
 
 		MaterialRecycler materialRecycler;
 
+		void sort();
+		void reorderForBatching();
+		uint64_t getBatchKey(const SpritePainterEntry& entry) const;
+		void buildCullBlocks();
+		CullBounds getBounds(const SpritePainterEntry& entry) const;
+		void draw(const SpritePainterEntry& entry, Painter& painter, Rect4f view) const;
+
 		void draw(gsl::span<const Sprite> sprite, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
 		void draw(gsl::span<const TextRenderer> text, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
 		void draw(const SpritePainterEntry::Callback& callback, Painter& painter, const std::optional<Rect4f>& clip) const;
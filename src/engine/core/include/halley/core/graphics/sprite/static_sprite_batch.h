@@ -0,0 +1,59 @@
+#pragma once
+
+#include "sprite.h"
+#include <halley/data_structures/vector.h>
+
+namespace Halley
+{
+	class Painter;
+
+	// A set of sprites that gets drawn every frame but rarely changes, e.g. tiles and background art.
+	// The vertex data is built once and retained by the Painter (in video memory, if the backend supports it), so drawing an unchanged
+	// batch is one draw call per run of sprites sharing a material, without copying any vertices. Any change rebuilds the whole batch.
+	// Sliced and clipped sprites can't be retained, so they're drawn normally (in order with the rest).
+	class StaticSpriteBatch
+	{
+	public:
+		StaticSpriteBatch() = default;
+		explicit StaticSpriteBatch(Vector<Sprite> sprites);
+
+		// Each batch owns its retained ids, so it can't be shared
+		StaticSpriteBatch(const StaticSpriteBatch& other) = delete;
+		StaticSpriteBatch(StaticSpriteBatch&& other) = default;
+		StaticSpriteBatch& operator=(const StaticSpriteBatch& other) = delete;
+		StaticSpriteBatch& operator=(StaticSpriteBatch&& other) = default;
+
+		void setSprites(Vector<Sprite> sprites);
+		void add(Sprite sprite);
+		void clear();
+
+		size_t size() const;
+		bool empty() const;
+		const Sprite& getSprite(size_t idx) const;
+		Sprite& getMutableSprite(size_t idx); // Assumes the sprite will be changed
+
+		// Only needed if the sprites were changed through anything other than the methods above (e.g. a shared material)
+		void setDirty();
+
+		Rect4f getAABB();
+		void draw(Painter& painter);
+
+	private:
+		struct Run {
+			std::shared_ptr<Material> material;
+			uint32_t start; // Into vertexData if retained, otherwise into sprites
+			uint32_t count;
+			bool retained;
+		};
+
+		Vector<Sprite> sprites;
+		Vector<Run> runs;
+		Vector<SpriteVertexAttrib> vertexData;
+		Vector<uint64_t> retainedIds;
+		Rect4f aabb;
+		uint64_t version = 0;
+		bool dirty = true;
+
+		void rebuild();
+	};
+}
@@ -14,6 +14,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 
 #include "graphics/blend.h"
 #include "graphics/painter.h"
+#include "graphics/recording_painter.h"
 #include "graphics/render_context.h"
 #include "graphics/shader.h"
 #include "graphics/texture.h"
@@ -45,6 +46,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "graphics/sprite/particles.h"
 #include "graphics/sprite/sprite.h"
 #include "graphics/sprite/sprite_painter.h"
+#include "graphics/sprite/static_sprite_batch.h"
 #include "graphics/sprite/sprite_sheet.h"
 
 #include "graphics/window.h"
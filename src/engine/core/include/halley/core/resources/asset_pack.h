@@ -4,6 +4,7 @@
 #include <memory>
 #include <gsl/span>
 #include "halley/resources/resource_data.h"
+#include "asset_pack_index.h"
 
 namespace Halley {
 	enum class AssetType;
@@ -12,6 +13,8 @@ namespace Halley {
 	class AssetDatabase;
 	class ResourceData;
 	class ResourceDataReader;
+	class MemoryMappedFile;
+	class Metadata;
 
 	struct AssetPackHeader {
 		std::array<char, 8> identifier;
@@ -19,7 +22,8 @@ namespace Halley {
 		uint64_t assetDbStartPos;
 		uint64_t dataStartPos;
 
-		void init(size_t assetDbSize);
+		// The index sits between the header and the asset database; packs without one have assetDbStartPos == sizeof(AssetPackHeader)
+		void init(size_t indexSize, size_t assetDbSize);
 	};
 
     class AssetPack {
@@ -28,16 +32,22 @@ namespace Halley {
 		AssetPack(const AssetPack& other) = delete;
 		AssetPack(AssetPack&& other) noexcept;
 		AssetPack(std::unique_ptr<ResourceDataReader> reader, const String& encryptionKey = "", bool preLoad = false);
+		AssetPack(std::unique_ptr<MemoryMappedFile> mapping, const String& encryptionKey = "", bool preLoad = false);
 		~AssetPack();
 
 		AssetPack& operator=(const AssetPack& other) = delete;
 		AssetPack& operator=(AssetPack&& other) noexcept;
 
+		// The asset database (which holds metadata) is only decoded the first time it's requested
 		AssetDatabase& getAssetDatabase();
 		const AssetDatabase& getAssetDatabase() const;
+		const AssetPackIndex& getIndex() const;
 		Bytes& getData();
 		const Bytes& getData() const;
 
+		// Used when building packs. Returns the size stored in the pack, which is smaller than the asset if it was compressed.
+		// Added assets can be read back right away; the index is rebuilt the next time it's needed.
+		size_t addAsset(AssetType type, const String& name, gsl::span<const gsl::byte> assetData, const Metadata& meta, AssetPackCompression compression);
 		Bytes writeOut() const;
 
 		std::unique_ptr<ResourceData> getData(const String& asset, AssetType type, bool stream);
@@ -50,20 +60,40 @@ namespace Halley {
 
 		std::unique_ptr<ResourceDataReader> extractReader();
 
+		bool isMemoryMapped() const;
+
+		static size_t getUncompressedSize(gsl::span<const gsl::byte> stored);
+		static void decompress(AssetPackCompression compression, gsl::span<const gsl::byte> stored, gsl::span<gsl::byte> dst);
+
     private:
-		std::unique_ptr<AssetDatabase> assetDb;
+		mutable std::unique_ptr<AssetDatabase> assetDb;
+		mutable Bytes assetDbData;
+		mutable std::atomic<bool> assetDbLoaded;
+		mutable std::mutex assetDbMutex;
+		mutable AssetPackIndex index;
+		Vector<AssetPackIndex::Source> indexSources;
+		mutable bool indexDirty = false;
+
 		std::unique_ptr<ResourceDataReader> reader;
+		std::unique_ptr<MemoryMappedFile> mapping;
 		std::atomic<bool> hasReader;
 		std::mutex readerMutex;
 		size_t dataOffset = 0;
 		Bytes data;
 		std::array<char, 16> iv;
+
+		void readHeader(const AssetPackHeader& header, gsl::span<const gsl::byte> assetDbBytes);
+		void buildLegacyIndex();
+		gsl::span<const gsl::byte> getStoredData(size_t pos, size_t size, Bytes& tmp);
+		void loadAssetDatabase() const;
+		bool needsDecryption(const String& encryptionKey) const;
     };
 
 
 	class PackDataReader final : public ResourceDataReader {
 	public:
 		PackDataReader(AssetPack& pack, size_t startPos, size_t fileSize);
+		explicit PackDataReader(Bytes decoded);
 
 		size_t size() const override;
 		int read(gsl::span<gsl::byte> dst) override;
@@ -72,10 +102,11 @@ namespace Halley {
 		void close() override;
 
 	private:
-		AssetPack& pack;
-		const size_t startPos;
+		AssetPack* pack = nullptr;
+		const size_t startPos = 0;
 		const size_t fileSize;
 		size_t curPos = 0;
+		Bytes decoded;
 		mutable std::mutex mutex;
 	};
 }
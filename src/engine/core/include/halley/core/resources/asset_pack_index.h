@@ -0,0 +1,96 @@
+#pragma once
+#include "halley/utils/utils.h"
+#include "halley/text/halleystring.h"
+#include "halley/data_structures/vector.h"
+#include "halley/text/enum_names.h"
+#include <gsl/span>
+#include <string_view>
+
+namespace Halley {
+	enum class AssetType;
+	class AssetDatabase;
+
+	enum class AssetPackCompression : uint32_t {
+		None,
+		LZ4,
+		Deflate
+	};
+
+	template <>
+	struct EnumNames<AssetPackCompression> {
+		constexpr std::array<const char*, 3> operator()() const {
+			return{{
+				"none",
+				"lz4",
+				"deflate"
+			}};
+		}
+	};
+
+	// Flat lookup table stored in asset packs, right after the pack header.
+	// Entries are sorted by (type, name hash, name), and the whole thing can be used in place, so resolving an asset
+	// is a binary search with no parsing or allocation.
+	class AssetPackIndex {
+	public:
+		struct Header {
+			std::array<char, 8> identifier;
+			uint32_t version;
+			uint32_t numEntries;
+			uint64_t namesSize;
+		};
+
+		struct Entry {
+			uint64_t nameHash;
+			uint64_t pos;
+			uint64_t size;
+			uint64_t contentHash; // Hash of the uncompressed asset
+			uint32_t nameOffset;
+			uint32_t nameLength;
+			int32_t type;
+			AssetPackCompression compression; // If compressed, the stored data starts with the 8-byte uncompressed size
+
+			bool isCompressed() const { return compression != AssetPackCompression::None; }
+		};
+
+		struct Source {
+			AssetType type;
+			String name;
+			uint64_t pos;
+			uint64_t size;
+			uint64_t contentHash;
+			AssetPackCompression compression = AssetPackCompression::None;
+		};
+
+		constexpr static uint32_t version = 1;
+
+		AssetPackIndex();
+		AssetPackIndex(const AssetPackIndex& other) = delete;
+		AssetPackIndex(AssetPackIndex&& other) noexcept = default;
+
+		AssetPackIndex& operator=(const AssetPackIndex& other) = delete;
+		AssetPackIndex& operator=(AssetPackIndex&& other) noexcept = default;
+
+		// Uses data in place when possible, in which case it must outlive the index
+		void load(gsl::span<const gsl::byte> data);
+		void load(Bytes data);
+
+		const Entry* find(AssetType type, std::string_view name) const;
+		std::string_view getName(const Entry& entry) const;
+		gsl::span<const Entry> getEntries() const;
+		bool isEmpty() const;
+
+		static bool isIndex(gsl::span<const gsl::byte> data);
+		static uint64_t hashName(std::string_view name);
+
+		static Bytes build(Vector<Source> entries);
+		// Builds the index out of the "pos:size" paths in the asset database, hashing contents if the pack data is given
+		static Bytes build(const AssetDatabase& db, gsl::span<const gsl::byte> packData = {});
+
+	private:
+		Bytes ownedData;
+		const Entry* entries = nullptr;
+		const char* names = nullptr;
+		size_t numEntries = 0;
+		size_t namesSize = 0;
+	};
+}
@@ -44,6 +44,7 @@ namespace Halley
 		void unload(const String& assetId);
 		void unloadAll(int minDepth = 0);
 		bool exists(const String& assetId) const;
+		bool isLoaded(const String& assetId) const;
 		void setFallback(const String& assetId);
 
 		void reload(const String& assetId);
@@ -66,7 +67,7 @@ namespace Halley
 		AssetType type;
 		ResourceLoaderFunc resourceLoader;
 		ResourceEnumeratorFunc resourceEnumerator;
-		std::shared_mutex mutex;
+		mutable std::shared_mutex mutex;
 	};
 
 	template <typename T>
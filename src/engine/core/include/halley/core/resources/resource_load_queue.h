@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <halley/text/halleystring.h>
+#include <halley/data_structures/vector.h>
+#include <halley/data_structures/hash_map.h>
+#include <halley/resources/resource.h>
+#include <halley/resources/resource_data.h>
+#include <halley/concurrency/future.h>
+
+namespace Halley {
+	class Resources;
+	class ResourceLocator;
+	class ResourceLoadState;
+
+	// Tracks a batch of resources queued with Resources::preload()
+	class ResourceLoadHandle {
+		friend class ResourceLoadQueue;
+
+	public:
+		ResourceLoadHandle() = default;
+
+		bool isValid() const;
+		bool isDone() const;
+		float getProgress() const;
+		size_t getNumLoaded() const;
+		size_t getNumTotal() const;
+
+		bool hasErrors() const;
+		Vector<String> getErrors() const;
+
+		// Drops whatever hasn't been constructed yet. Resources already loaded stay loaded.
+		void cancel();
+
+	private:
+		explicit ResourceLoadHandle(std::shared_ptr<ResourceLoadState> state);
+
+		std::shared_ptr<ResourceLoadState> state;
+	};
+
+	// Loads resources over several frames.
+	// Raw data is read ahead of time on the disk IO executor, while construction (which might need the video context)
+	// happens in update() on the main thread, by priority and then by asset type, until the frame's time budget runs out.
+	// Dependencies reported by each loaded resource are queued on the same handle.
+	class ResourceLoadQueue {
+	public:
+		ResourceLoadQueue(Resources& resources, ResourceLocator& locator);
+		~ResourceLoadQueue();
+
+		ResourceLoadHandle enqueue(Vector<std::pair<AssetType, String>> assets, ResourceLoadPriority priority);
+		void update(double budget);
+
+		bool isIdle() const;
+
+	private:
+		struct Request {
+			AssetType type;
+			String name;
+			ResourceLoadPriority priority;
+			uint64_t sequence;
+			std::shared_ptr<ResourceLoadState> state;
+			Future<void> prefetch;
+			std::shared_ptr<Resource> resource;
+		};
+
+		// Reads happen outside of the mutex, which only guards the locator pointer and the count of reads using it
+		struct PrefetchContext {
+			std::mutex mutex;
+			std::condition_variable idle;
+			ResourceLocator* locator = nullptr;
+			int reading = 0;
+		};
+
+		Resources& resources;
+		ResourceLocator& locator;
+		std::shared_ptr<PrefetchContext> prefetchContext;
+
+		Vector<Request> pending;
+		Vector<Request> waiting;
+		uint64_t nextSequence = 0;
+
+		void add(AssetType type, const String& name, ResourceLoadPriority priority, const std::shared_ptr<ResourceLoadState>& state);
+		void construct(Request& request);
+		void addDependencies(const Resource& resource, ResourceLoadPriority priority, const std::shared_ptr<ResourceLoadState>& state);
+		void finish(Request& request, const String& error = "");
+		void updateWaiting();
+	};
+}
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <ctime>
+#include <mutex>
 #include <halley/text/halleystring.h>
 #include <halley/resources/resource_data.h>
 #include <halley/data_structures/hash_map.h>
@@ -39,6 +40,7 @@ namespace Halley {
 		virtual ~IResourceLocatorProvider() {}
 		virtual std::unique_ptr<ResourceData> getData(const String& path, AssetType type, bool stream) = 0;
 		virtual const AssetDatabase& getAssetDatabase() = 0;
+		virtual std::vector<String> getAssets();
 		virtual int getPriority() const { return 0; }
 		virtual void purge(SystemAPI& system) = 0;
 	};
@@ -48,7 +50,8 @@ namespace Halley {
 	public:
 		explicit ResourceLocator(SystemAPI& system);
 		void addFileSystem(const Path& path);
-		void addPack(const Path& path, const String& encryptionKey = "", bool preLoad = false, bool allowFailure = false, std::optional<int> priority = {});
+		// If memoryMap is set, the pack is mapped into memory and resources are views into it, when the platform supports it and the pack is a plain file
+		void addPack(const Path& path, const String& encryptionKey = "", bool preLoad = false, bool allowFailure = false, std::optional<int> priority = {}, bool memoryMap = false);
 		std::vector<String> getAssetsFromPack(const Path& path, const String& encryptionKey = "") const;
 		void removePack(const Path& path);
 
@@ -60,6 +63,11 @@ namespace Halley {
 		void purge(const String& asset, AssetType type);
 		void purgeAll();
 
+		// Reads an asset's data on the calling thread and holds on to it, so the next getStatic() for it doesn't touch the disk
+		void prefetch(const String& asset, AssetType type);
+		void discardPrefetched(const String& asset, AssetType type);
+		void clearPrefetched();
+
 		std::vector<String> enumerate(AssetType type);
 		bool exists(const String& asset, AssetType type);
 
@@ -72,6 +80,9 @@ namespace Halley {
 		Vector<std::unique_ptr<IResourceLocatorProvider>> locators;
 		static const Metadata dummyMetadata;
 
+		std::mutex prefetchMutex;
+		HashMap<String, std::unique_ptr<ResourceDataStatic>> prefetched;
+
 		void add(std::unique_ptr<IResourceLocatorProvider> locator, const Path& path);
 
 		std::unique_ptr<ResourceData> getResource(const String& asset, AssetType type, bool stream, bool throwOnFail) const;
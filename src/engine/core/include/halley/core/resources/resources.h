@@ -26,6 +26,7 @@
 #include <halley/support/exception.h>
 #include "halley/resources/resource.h"
 #include "resource_collection.h"
+#include "resource_load_queue.h"
 #include "halley/text/enum_names.h"
 
 namespace Halley {
@@ -60,6 +61,11 @@ namespace Halley {
 			return *resources[int(assetType)];
 		}
 
+		[[nodiscard]] bool hasType(AssetType assetType) const
+		{
+			return int(assetType) < int(resources.size()) && resources[int(assetType)];
+		}
+
 		template <typename T>
 		std::shared_ptr<const T> get(const String& name, ResourceLoadPriority priority = ResourceLoadPriority::Normal) const
 		{
@@ -101,6 +107,10 @@ namespace Halley {
 			return *locator;
 		}
 
+		// Loads the given assets (and whatever they depend on) over the next few frames, see ResourceLoadQueue
+		ResourceLoadHandle preload(Vector<std::pair<AssetType, String>> assets, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
+		void update();
+
 		void reloadAssets(const std::vector<String>& ids); // ids are in "type:name" format
 		void reloadAssets(const std::map<AssetType, std::vector<String>>& byType);
 
@@ -111,5 +121,6 @@ namespace Halley {
 		Vector<std::unique_ptr<ResourceCollectionBase>> resources;
 		const HalleyAPI* const api;
 		ResourceOptions options;
+		std::unique_ptr<ResourceLoadQueue> loadQueue;
 	};
 }
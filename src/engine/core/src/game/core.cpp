@@ -309,6 +309,10 @@ void Core::processEvents(Time time)
 
 void Core::runStartFrame()
 {
+	if (resources) {
+		resources->update();
+	}
+
 	if (currentStage) {
 		currentStage->onStartFrame();
 	}
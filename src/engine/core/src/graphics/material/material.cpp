@@ -38,8 +38,8 @@ MaterialDataBlock::MaterialDataBlock(const MaterialDataBlock& other)
 	, addresses(other.addresses)
 	, dataBlockType(other.dataBlockType)
 	, bindPoint(other.bindPoint)
-	, needToUpdateHash(other.needToUpdateHash)
-	, hash(other.hash)
+	, needToUpdateHash(other.needToUpdateHash.load(std::memory_order_acquire))
+	, hash(other.hash.load(std::memory_order_relaxed))
 {}
 
 MaterialDataBlock::MaterialDataBlock(MaterialDataBlock&& other) noexcept
@@ -47,10 +47,11 @@ MaterialDataBlock::MaterialDataBlock(MaterialDataBlock&& other) noexcept
 	, addresses(std::move(other.addresses))
 	, dataBlockType(other.dataBlockType)
 	, bindPoint(other.bindPoint)
-	, needToUpdateHash(other.needToUpdateHash)
-	, hash(other.hash)
+	, needToUpdateHash(other.needToUpdateHash.load(std::memory_order_acquire))
+	, hash(other.hash.load(std::memory_order_relaxed))
 {
 	other.hash = 0;
+	other.needToUpdateHash = true;
 }
 
 int MaterialDataBlock::getAddress(int pass, ShaderType stage) const
@@ -75,13 +76,14 @@ MaterialDataBlockType MaterialDataBlock::getType() const
 
 uint64_t MaterialDataBlock::getHash() const
 {
-	if (needToUpdateHash) {
-		needToUpdateHash = false;
+	// Concurrent readers may both compute it, but they'll store the same value, and the flag is only cleared once it's there
+	if (needToUpdateHash.load(std::memory_order_acquire)) {
 		Hash::Hasher hasher;
 		hasher.feedBytes(getData());
-		hash = hasher.digest();
+		hash.store(hasher.digest(), std::memory_order_relaxed);
+		needToUpdateHash.store(false, std::memory_order_release);
 	}
-	return hash;
+	return hash.load(std::memory_order_relaxed);
 }
 
 bool MaterialDataBlock::setUniform(size_t offset, ShaderParameterType type, const void* srcData)
@@ -128,6 +130,7 @@ Material::Material(Material&& other) noexcept
 		u.rebind(*this);
 	}
 	other.hashValue = 0;
+	other.needToUpdateHash = true;
 }
 
 Material::Material(std::shared_ptr<const MaterialDefinition> definition, bool forceLocalBlocks)
@@ -306,6 +309,20 @@ uint64_t Material::computeHash() const
 	return hasher.digest();
 }
 
+uint64_t Material::computeBatchKey(uint64_t hash) const
+{
+	// [shader: 16 bits][textures: 16 bits][everything else: 32 bits]
+	Hash::Hasher shaderHasher;
+	shaderHasher.feed(materialDefinition.get());
+
+	Hash::Hasher textureHasher;
+	for (const auto& texture: textures) {
+		textureHasher.feed(texture.get());
+	}
+
+	return ((shaderHasher.digest() & 0xFFFF) << 48) | ((textureHasher.digest() & 0xFFFF) << 32) | (hash & 0xFFFFFFFF);
+}
+
 const std::shared_ptr<const Texture>& Material::getFallbackTexture() const
 {
 	return materialDefinition->getFallbackTexture();
@@ -434,11 +451,19 @@ bool Material::hasParameter(const String& name) const
 
 uint64_t Material::getHash() const
 {
-	if (needToUpdateHash) {
-		hashValue = computeHash();
-		needToUpdateHash = false;
+	if (needToUpdateHash.load(std::memory_order_acquire)) {
+		const auto hash = computeHash();
+		hashValue.store(hash, std::memory_order_relaxed);
+		batchKeyValue.store(computeBatchKey(hash), std::memory_order_relaxed);
+		needToUpdateHash.store(false, std::memory_order_release);
 	}
-	return hashValue;
+	return hashValue.load(std::memory_order_relaxed);
+}
+
+uint64_t Material::getBatchKey() const
+{
+	getHash();
+	return batchKeyValue.load(std::memory_order_relaxed);
 }
 
 MaterialParameter& Material::getParameter(const String& name)
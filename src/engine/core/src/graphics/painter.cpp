@@ -3,10 +3,12 @@
 #include <cassert>
 
 #include "halley/core/graphics/render_context.h"
+#include "halley/core/graphics/recording_painter.h"
 #include "halley/core/graphics/render_target/render_target.h"
 #include "halley/core/graphics/material/material.h"
 #include "halley/core/graphics/material/material_definition.h"
 #include "halley/core/graphics/material/material_parameter.h"
+#include <atomic>
 #include <cstring> // memmove
 #include <gsl/gsl_assert>
 
@@ -51,6 +53,7 @@ void Painter::startRender()
 	nDrawCalls = nTriangles = nVertices = 0;
 
 	refreshConstantBufferCache();
+	refreshRetainedSpritesCache();
 	resetPending();
 	doStartRender();
 }
@@ -159,31 +162,10 @@ void Painter::drawSprites(const std::shared_ptr<Material>& material, size_t tota
 
 	while (numSpritesLeft > 0) {
 		const size_t numSprites = std::min(numSpritesLeft, maxSpritesPerCall);
-		
 		const size_t numVertices = verticesPerSprite * numSprites;
-		const size_t vertPosOffset = material->getDefinition().getVertexPosOffset();
 
 		const auto result = addDrawData(material, numVertices, numSprites * 6, true);
-
-		const char* const src = reinterpret_cast<const char*>(vertexData) + offset;
-
-		for (size_t i = 0; i < numSprites; i++) {
-			for (size_t j = 0; j < verticesPerSprite; j++) {
-				const size_t srcOffset = i * result.vertexStride;
-				const size_t dstOffset = (i * verticesPerSprite + j) * result.vertexStride;
-				memcpy(result.dstVertex + dstOffset, src + srcOffset, result.vertexSize);
-
-				// j -> vertPos
-				// 0 -> 0, 0
-				// 1 -> 1, 0
-				// 2 -> 1, 1
-				// 3 -> 0, 1
-				const float x = ((j & 1) ^ ((j & 2) >> 1)) * 1.0f;
-				const float y = ((j & 2) >> 1) * 1.0f;
-				getVertPos(result.dstVertex + dstOffset, vertPosOffset) = Vector4f(x, y, x, y);
-			}
-		}
-
+		expandSpriteVertices(material->getDefinition(), numSprites, reinterpret_cast<const char*>(vertexData) + offset, result.dstVertex);
 		generateQuadIndices(result.firstIndex, numSprites, result.dstIndex);
 
 		numSpritesLeft -= numSprites;
@@ -191,6 +173,92 @@ void Painter::drawSprites(const std::shared_ptr<Material>& material, size_t tota
 	}
 }
 
+void Painter::expandSpriteVertices(const MaterialDefinition& material, size_t numSprites, const char* src, char* dst)
+{
+	constexpr size_t verticesPerSprite = 4;
+	const size_t vertexSize = material.getVertexSize();
+	const size_t vertexStride = material.getVertexStride();
+	const size_t vertPosOffset = material.getVertexPosOffset();
+
+	for (size_t i = 0; i < numSprites; i++) {
+		for (size_t j = 0; j < verticesPerSprite; j++) {
+			const size_t srcOffset = i * vertexStride;
+			const size_t dstOffset = (i * verticesPerSprite + j) * vertexStride;
+			memcpy(dst + dstOffset, src + srcOffset, vertexSize);
+
+			// j -> vertPos
+			// 0 -> 0, 0
+			// 1 -> 1, 0
+			// 2 -> 1, 1
+			// 3 -> 0, 1
+			const float x = ((j & 1) ^ ((j & 2) >> 1)) * 1.0f;
+			const float y = ((j & 2) >> 1) * 1.0f;
+			getVertPos(dst + dstOffset, vertPosOffset) = Vector4f(x, y, x, y);
+		}
+	}
+}
+
+void Painter::drawRetainedSprites(const std::shared_ptr<Material>& material, uint64_t id, uint64_t version, size_t numSprites, const void* vertexData)
+{
+	Expects(material != nullptr);
+	Expects(vertexData != nullptr);
+
+	constexpr size_t verticesPerSprite = 4;
+	const size_t maxSprites = (static_cast<size_t>(std::numeric_limits<IndexType>::max()) + 1) / verticesPerSprite;
+	if (numSprites > maxSprites) {
+		throw Exception("Too many retained sprites in draw call: " + toString(numSprites) + ", maximum is " + toString(maxSprites), HalleyExceptions::Graphics);
+	}
+	if (numSprites == 0) {
+		return;
+	}
+
+	const auto& definition = material->getDefinition();
+	const size_t numVertices = numSprites * verticesPerSprite;
+
+	auto iter = retainedSprites.find(id);
+	const bool isNew = iter == retainedSprites.end();
+	if (isNew) {
+		// Recording painters can run on any thread, so they can't create video resources
+		auto buffer = isRecording() ? std::unique_ptr<RetainedVertexBuffer>() : video.createRetainedVertexBuffer();
+		iter = retainedSprites.emplace(id, RetainedSpritesEntry{ std::move(buffer), {}, version, 0 }).first;
+	}
+	auto& entry = iter->second;
+	entry.age = 0;
+
+	if (!entry.buffer) {
+		// Backend can't keep it, but we can at least skip expanding the sprites every frame
+		if (isNew || entry.version != version) {
+			entry.vertices.resize(numVertices * definition.getVertexStride());
+			expandSpriteVertices(definition, numSprites, static_cast<const char*>(vertexData), entry.vertices.data());
+			entry.version = version;
+		}
+		drawQuads(material, numVertices, entry.vertices.data());
+		return;
+	}
+
+	if (isNew || entry.version != version) {
+		retainedScratch.resize(numVertices * definition.getVertexStride());
+		expandSpriteVertices(definition, numSprites, static_cast<const char*>(vertexData), retainedScratch.data());
+		entry.buffer->update(gsl::as_bytes(gsl::span<const char>(retainedScratch.data(), retainedScratch.size())));
+		entry.version = version;
+	}
+
+	updateClip();
+	flushPending();
+	executeDrawRetained(*material, *entry.buffer, numVertices);
+}
+
+uint64_t Painter::allocateRetainedId()
+{
+	static std::atomic<uint64_t> nextId { 1 };
+	return nextId++;
+}
+
+void Painter::setRetainedVertices(const MaterialDefinition& material, RetainedVertexBuffer& buffer, size_t numVertices)
+{
+	throw Exception("Retained vertex buffers are not supported by this painter.", HalleyExceptions::Graphics);
+}
+
 void Painter::drawSlicedSprite(const std::shared_ptr<Material>& material, Vector2f scale, Vector4f slices, const void* vertexData)
 {
 	Expects(vertexData != nullptr);
@@ -438,6 +506,47 @@ void Painter::blitTexture(const std::shared_ptr<const Texture>& texture)
 	blitMaterial->set(0, std::shared_ptr<const Texture>{});
 }
 
+void Painter::submit(const PainterCommandList& commands)
+{
+	const auto prevClip = pendingClip;
+
+	for (const auto& command: commands.commands) {
+		switch (command.type) {
+		case PainterCommandList::CommandType::Draw:
+			{
+				pendingClip = command.clip;
+				const auto result = addDrawData(command.material, command.numVertices, command.numIndices, command.standardQuadsOnly);
+				memcpy(result.dstVertex, commands.vertices.data() + command.vertexOffset, result.dataSize);
+				const auto* srcIndex = commands.indices.data() + command.indexOffset;
+				for (size_t i = 0; i < command.numIndices; ++i) {
+					result.dstIndex[i] = srcIndex[i] + result.firstIndex;
+				}
+			}
+			break;
+
+		case PainterCommandList::CommandType::Clear:
+			flush();
+			clear(command.colour, command.depth, command.stencil);
+			break;
+
+		case PainterCommandList::CommandType::PushDebugGroup:
+			pushDebugGroup(command.debugGroup);
+			break;
+
+		case PainterCommandList::CommandType::PopDebugGroup:
+			popDebugGroup();
+			break;
+		}
+	}
+
+	pendingClip = prevClip;
+}
+
+std::unique_ptr<RecordingPainter> Painter::makeRecordingPainter() const
+{
+	return std::make_unique<RecordingPainter>(video, resources);
+}
+
 void Painter::setLogging(bool logging)
 {
 	this->logging = logging;
@@ -472,17 +581,24 @@ void Painter::makeSpaceForPendingIndices(size_t numIndices)
 }
 
 void Painter::bind(RenderContext& context)
+{
+	bind(context.getCamera(), context.getDefaultRenderTarget(), true);
+}
+
+void Painter::bind(const Camera& cam, RenderTarget& defaultRenderTarget, bool bindRenderTarget)
 {
 	// Setup camera
-	camera = context.getCamera();
-	camera.defaultRenderTarget = &context.getDefaultRenderTarget();
+	camera = cam;
+	camera.defaultRenderTarget = &defaultRenderTarget;
 
 	// Set render target
 	activeRenderTarget = &camera.getActiveRenderTarget();
 	if (!activeRenderTarget) {
 		throw Exception("No active render target", HalleyExceptions::Core);
 	}
-	activeRenderTarget->onBind(*this);
+	if (bindRenderTarget) {
+		activeRenderTarget->onBind(*this);
+	}
 
 	// Set viewport
 	viewPort = camera.getActiveViewPort();
@@ -494,9 +610,16 @@ void Painter::bind(RenderContext& context)
 }
 
 void Painter::unbind(RenderContext& context)
+{
+	unbind(true);
+}
+
+void Painter::unbind(bool bindRenderTarget)
 {
 	flush();
-	activeRenderTarget->onUnbind(*this);
+	if (bindRenderTarget) {
+		activeRenderTarget->onUnbind(*this);
+	}
 	activeRenderTarget = nullptr;
 }
 
@@ -571,6 +694,14 @@ void Painter::refreshConstantBufferCache()
 	std_ex::erase_if_value(constantBuffers, [] (const ConstantBufferEntry& e) { return e.age >= 10; });
 }
 
+void Painter::refreshRetainedSpritesCache()
+{
+	for (auto& [k, v]: retainedSprites) {
+		++v.age;
+	}
+	std_ex::erase_if_value(retainedSprites, [] (const RetainedSpritesEntry& e) { return e.age >= 10; });
+}
+
 void Painter::startDrawCall(const std::shared_ptr<Material>& material)
 {
 	constexpr bool enableDynamicBatching = true;
@@ -586,22 +717,26 @@ void Painter::startDrawCall(const std::shared_ptr<Material>& material)
 void Painter::flushPending()
 {
 	if (verticesPending > 0) {
-		executeDrawPrimitives(*materialPending, verticesPending, vertexBuffer.data(), gsl::span<const IndexType>(indexBuffer.data(), indicesPending));
+		submitPending(materialPending, verticesPending, vertexBuffer.data(), gsl::span<const IndexType>(indexBuffer.data(), indicesPending), allIndicesAreQuads, curClipArea);
 	}
 
 	resetPending();
 }
 
+void Painter::submitPending(const std::shared_ptr<Material>& material, size_t numVertices, char* vertexData, gsl::span<const IndexType> indices, bool standardQuadsOnly, Rect4i clip)
+{
+	// Clip was already applied to the backend by updateClip()
+	executeDrawPrimitives(*material, numVertices, vertexData, indices);
+	Material::resetBindCache();
+}
+
 void Painter::resetPending()
 {
 	bytesPending = 0;
 	verticesPending = 0;
 	indicesPending = 0;
 	allIndicesAreQuads = true;
-	if (materialPending) {
-		Material::resetBindCache();
-		materialPending.reset();
-	}
+	materialPending.reset();
 	pendingDebugGroupStack = curDebugGroupStack;
 }
 
@@ -617,6 +752,25 @@ void Painter::executeDrawPrimitives(Material& material, size_t numVertices, void
 	// BAD: This method should take const IndexType*!
 	setVertices(material.getDefinition(), numVertices, vertexData, indices.size(), const_cast<IndexType*>(indices.data()), allIndicesAreQuads);
 
+	drawMaterialPasses(material, numVertices, indices.size());
+
+	endDrawCall();
+}
+
+void Painter::executeDrawRetained(Material& material, RetainedVertexBuffer& buffer, size_t numVertices)
+{
+	ProfilerEvent event(ProfilerEventType::PainterDrawCall);
+
+	startDrawCall();
+	setRetainedVertices(material.getDefinition(), buffer, numVertices);
+	drawMaterialPasses(material, numVertices, numVertices * 3 / 2);
+	endDrawCall();
+
+	Material::resetBindCache();
+}
+
+void Painter::drawMaterialPasses(Material& material, size_t numVertices, size_t numIndices)
+{
 	// Load material uniforms
 	setMaterialData(material);
 
@@ -627,18 +781,16 @@ void Painter::executeDrawPrimitives(Material& material, size_t numVertices, void
 			material.bind(i, *this);
 
 			// Draw
-			drawTriangles(indices.size());
+			drawTriangles(numIndices);
 
 			// Log stats
 			if (logging) {
 				nDrawCalls++;
-				nTriangles += indices.size() / 3;
+				nTriangles += numIndices / 3;
 				nVertices += numVertices;
 			}
 		}
 	}
-
-	endDrawCall();
 }
 
 IndexType* Painter::getStandardQuadIndices(size_t numQuads)
@@ -744,4 +896,7 @@ void Painter::updateClip()
 		flushPending();
 		setClip(targetClip, enableClip);
 	}
+
+	// Anything pending was flushed above if this changed, so this always applies to the current batch
+	curClipArea = Rect4i(finalRect.getTopLeft() - viewPort.getTopLeft(), finalRect.getWidth(), finalRect.getHeight());
 }
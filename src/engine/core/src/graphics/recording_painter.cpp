@@ -0,0 +1,148 @@
+#include "halley/core/graphics/recording_painter.h"
+#include "halley/core/graphics/material/material.h"
+#include "halley/core/graphics/material/material_definition.h"
+#include <gsl/gsl_assert>
+
+using namespace Halley;
+
+void PainterCommandList::clear()
+{
+	commands.clear();
+	vertices.clear();
+	indices.clear();
+}
+
+bool PainterCommandList::empty() const
+{
+	return commands.empty();
+}
+
+size_t PainterCommandList::getNumCommands() const
+{
+	return commands.size();
+}
+
+RecordingPainter::RecordingPainter(VideoAPI& video, Resources& resources)
+	: Painter(video, resources)
+{
+	setLogging(false);
+}
+
+void RecordingPainter::startRecording(const Camera& camera, RenderTarget& defaultRenderTarget, PainterCommandList& commands)
+{
+	Expects(this->commands == nullptr);
+
+	this->commands = &commands;
+	commands.clear();
+	debugGroupStack.clear();
+
+	refreshRetainedSpritesCache();
+	bind(camera, defaultRenderTarget, false);
+}
+
+void RecordingPainter::finishRecording()
+{
+	Expects(commands != nullptr);
+
+	unbind(false);
+	syncDebugGroups({});
+	commands = nullptr;
+}
+
+void RecordingPainter::clear(std::optional<Colour> colour, std::optional<float> depth, std::optional<uint8_t> stencil)
+{
+	Expects(commands != nullptr);
+
+	flush();
+
+	PainterCommandList::Command command;
+	command.type = PainterCommandList::CommandType::Clear;
+	command.colour = colour;
+	command.depth = depth;
+	command.stencil = stencil;
+	commands->commands.push_back(std::move(command));
+}
+
+void RecordingPainter::submitPending(const std::shared_ptr<Material>& material, size_t numVertices, char* vertexData, gsl::span<const IndexType> indices, bool standardQuadsOnly, Rect4i clip)
+{
+	Expects(commands != nullptr);
+
+	syncDebugGroups(getPendingDebugGroupStack());
+
+	const size_t dataSize = numVertices * material->getDefinition().getVertexStride();
+
+	PainterCommandList::Command command;
+	command.type = PainterCommandList::CommandType::Draw;
+	command.standardQuadsOnly = standardQuadsOnly;
+	command.material = material;
+	command.clip = clip;
+	command.vertexOffset = commands->vertices.size();
+	command.numVertices = numVertices;
+	command.indexOffset = commands->indices.size();
+	command.numIndices = size_t(indices.size());
+
+	commands->vertices.insert(commands->vertices.end(), vertexData, vertexData + dataSize);
+	commands->indices.insert(commands->indices.end(), indices.begin(), indices.end());
+	commands->commands.push_back(std::move(command));
+}
+
+void RecordingPainter::syncDebugGroups(const Vector<String>& stack)
+{
+	size_t common = 0;
+	while (common < stack.size() && common < debugGroupStack.size() && stack[common] == debugGroupStack[common]) {
+		++common;
+	}
+
+	while (debugGroupStack.size() > common) {
+		PainterCommandList::Command command;
+		command.type = PainterCommandList::CommandType::PopDebugGroup;
+		commands->commands.push_back(std::move(command));
+		debugGroupStack.pop_back();
+	}
+
+	for (size_t i = common; i < stack.size(); ++i) {
+		PainterCommandList::Command command;
+		command.type = PainterCommandList::CommandType::PushDebugGroup;
+		command.debugGroup = stack[i];
+		commands->commands.push_back(std::move(command));
+		debugGroupStack.push_back(stack[i]);
+	}
+}
+
+void RecordingPainter::setMaterialPass(const Material& material, int pass)
+{
+}
+
+void RecordingPainter::setMaterialData(const Material& material)
+{
+}
+
+void RecordingPainter::doStartRender()
+{
+}
+
+void RecordingPainter::doEndRender()
+{
+}
+
+void RecordingPainter::setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, IndexType* indices, bool standardQuadsOnly)
+{
+	// Never called, submitPending() is overridden instead
+}
+
+void RecordingPainter::drawTriangles(size_t numIndices)
+{
+}
+
+void RecordingPainter::setViewPort(Rect4i rect)
+{
+}
+
+void RecordingPainter::setClip(Rect4i clip, bool enable)
+{
+	// The clip area of each batch is recorded in submitPending()
+}
+
+void RecordingPainter::onUpdateProjection(Material& material, bool hashChanged)
+{
+}
@@ -1,5 +1,6 @@
 #include "halley/core/graphics/render_context.h"
 #include "halley/core/graphics/render_target/render_target.h"
+#include "halley/core/graphics/recording_painter.h"
 
 using namespace Halley;
 
@@ -63,6 +64,11 @@ RenderTarget& RenderContext::getDefaultRenderTarget() const
 	return defaultRenderTarget;
 }
 
+std::unique_ptr<RecordingPainter> RenderContext::makeRecordingPainter() const
+{
+	return painter.makeRecordingPainter();
+}
+
 void RenderContext::flush()
 {
 	painter.flush();
@@ -1,6 +1,7 @@
 #include "graphics/render_target/render_graph.h"
 #include "api/video_api.h"
 #include "graphics/render_context.h"
+#include "graphics/recording_painter.h"
 #include "graphics/material/material.h"
 #include "graphics/render_target/render_graph_definition.h"
 #include "graphics/render_target/render_graph_node.h"
@@ -8,6 +9,7 @@
 #include "graphics/sprite/sprite.h"
 #include "halley/support/logger.h"
 #include "halley/utils/algorithm.h"
+#include "halley/concurrency/concurrent.h"
 
 using namespace Halley;
 
@@ -21,6 +23,10 @@ RenderGraph::RenderGraph(std::shared_ptr<const RenderGraphDefinition> def)
 	loadDefinition(std::move(def));
 }
 
+RenderGraph::~RenderGraph()
+{
+}
+
 void RenderGraph::loadDefinition(std::shared_ptr<const RenderGraphDefinition> definition)
 {
 	nodes.clear();
@@ -100,8 +106,11 @@ void RenderGraph::render(const RenderContext& rc, VideoAPI& video, std::optional
 		}
 	}
 
-	for (size_t i = 0; i < renderQueue.size(); ++i) {
-		renderQueue[i]->render(*this, video, rc, renderQueue);
+	// Nodes queued while rendering a wave only depend on nodes from that wave or earlier ones
+	for (size_t waveStart = 0; waveStart < renderQueue.size(); ) {
+		const size_t waveEnd = renderQueue.size();
+		renderWave(rc, video, renderQueue, waveStart, waveEnd);
+		waveStart = waveEnd;
 	}
 
 	RenderContext(rc).bind([] (Painter& painter)
@@ -110,6 +119,94 @@ void RenderGraph::render(const RenderContext& rc, VideoAPI& video, std::optional
 	});
 }
 
+void RenderGraph::renderWave(const RenderContext& rc, VideoAPI& video, std::vector<RenderGraphNode*>& renderQueue, size_t start, size_t end)
+{
+	auto& cpu = Executors::getCPU();
+
+	std::vector<size_t> recordable;
+	if (parallelRecording && cpu.threadCount() > 0) {
+		for (size_t i = start; i < end; ++i) {
+			if (renderQueue[i]->canRecord(*this)) {
+				recordable.push_back(i);
+			}
+		}
+	}
+
+	if (recordable.size() < 2) {
+		for (size_t i = start; i < end; ++i) {
+			renderQueue[i]->render(*this, video, rc, renderQueue);
+		}
+		return;
+	}
+
+	// Render targets have to be ready before recording, as their viewports are needed
+	for (size_t i = start; i < end; ++i) {
+		renderQueue[i]->prepareTextures(video, rc);
+	}
+
+	const size_t n = recordable.size();
+	while (recorders.size() < n) {
+		recorders.push_back(rc.makeRecordingPainter());
+	}
+	if (commandLists.size() < n) {
+		commandLists.resize(n);
+	}
+
+	std::vector<std::exception_ptr> errors(n);
+	std::vector<Future<void>> futures;
+	futures.reserve(n - 1);
+	for (size_t i = 1; i < n; ++i) {
+		futures.push_back(Concurrent::execute(cpu, [this, &rc, node = renderQueue[recordable[i]], &recorder = *recorders[i], &commands = commandLists[i], &error = errors[i]] ()
+		{
+			try {
+				node->record(*this, rc, recorder, commands);
+			} catch (...) {
+				error = std::current_exception();
+			}
+		}));
+	}
+
+	try {
+		renderQueue[recordable[0]]->record(*this, rc, *recorders[0], commandLists[0]);
+	} catch (...) {
+		errors[0] = std::current_exception();
+	}
+	auto all = Concurrent::whenAll(futures.begin(), futures.end());
+	while (!all.isReady()) {
+		if (!cpu.tryRunOne()) {
+			std::this_thread::yield();
+		}
+	}
+
+	for (auto& e: errors) {
+		if (e) {
+			std::rethrow_exception(e);
+		}
+	}
+
+	// Submit in the same order the nodes would have been rendered in
+	size_t nextRecorded = 0;
+	for (size_t i = start; i < end; ++i) {
+		auto* node = renderQueue[i];
+		node->blitInputs(rc);
+		if (nextRecorded < n && recordable[nextRecorded] == i) {
+			node->submitRecorded(*this, rc, commandLists[nextRecorded++]);
+		} else {
+			node->renderNode(*this, rc);
+		}
+		node->notifyOutputs(renderQueue);
+	}
+}
+
+void RenderGraph::setParallelRecording(bool enabled)
+{
+	parallelRecording = enabled;
+	if (!enabled) {
+		recorders.clear();
+		commandLists.clear();
+	}
+}
+
 const Camera* RenderGraph::tryGetCamera(std::string_view id) const
 {
 	const auto iter = cameras.find(id);
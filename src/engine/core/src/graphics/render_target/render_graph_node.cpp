@@ -5,6 +5,7 @@
 #include "graphics/render_target/render_graph.h"
 #include "api/video_api.h"
 #include "graphics/render_context.h"
+#include "graphics/recording_painter.h"
 #include "graphics/texture.h"
 #include "graphics/material/material.h"
 #include "graphics/material/material_definition.h"
@@ -196,6 +197,7 @@ std::shared_ptr<Texture> RenderGraphNode::makeTexture(VideoAPI& video, RenderGra
 void RenderGraphNode::render(const RenderGraph& graph, VideoAPI& video, const RenderContext& rc, std::vector<RenderGraphNode*>& renderQueue)
 {
 	prepareTextures(video, rc);
+	blitInputs(rc);
 	renderNode(graph, rc);
 	notifyOutputs(renderQueue);
 }
@@ -221,11 +223,18 @@ void RenderGraphNode::prepareTextures(VideoAPI& video, const RenderContext& rc)
 				} else if (input.type == RenderGraphPinType::DepthStencilBuffer && !renderTarget->hasDepthBuffer()) {
 					renderTarget->setDepthTexture(input.texture);
 				}
-			} else {
-				// No render target, copy instead
-				if (input.type == RenderGraphPinType::ColourBuffer && input.texture) {
-					renderNodeBlitTexture(input.texture, rc);
-				}
+			}
+		}
+	}
+}
+
+void RenderGraphNode::blitInputs(const RenderContext& rc)
+{
+	if (!passThrough && !renderTarget) {
+		// No render target, copy instead
+		for (auto& input: inputPins) {
+			if (input.type == RenderGraphPinType::ColourBuffer && input.texture) {
+				renderNodeBlitTexture(input.texture, rc);
 			}
 		}
 	}
@@ -258,6 +267,39 @@ void RenderGraphNode::renderNodePaintMethod(const RenderGraph& graph, const Rend
 	}
 }
 
+bool RenderGraphNode::canRecord(const RenderGraph& graph) const
+{
+	return method == RenderGraphMethod::Paint && graph.tryGetCamera(cameraId) && graph.tryGetPaintMethod(paintId);
+}
+
+void RenderGraphNode::record(const RenderGraph& graph, const RenderContext& rc, RecordingPainter& painter, PainterCommandList& commands)
+{
+	const auto* camera = graph.tryGetCamera(cameraId);
+	const auto* paintMethod = graph.tryGetPaintMethod(paintId);
+	const auto target = getTargetRenderContext(rc).with(*camera);
+
+	painter.startRecording(target.getCamera(), target.getDefaultRenderTarget(), commands);
+	try {
+		(*paintMethod)(painter);
+	} catch (...) {
+		painter.finishRecording();
+		throw;
+	}
+	painter.finishRecording();
+}
+
+void RenderGraphNode::submitRecorded(const RenderGraph& graph, const RenderContext& rc, const PainterCommandList& commands)
+{
+	const auto* camera = graph.tryGetCamera(cameraId);
+	getTargetRenderContext(rc).with(*camera).bind([&] (Painter& painter)
+	{
+		painter.pushDebugGroup(id);
+		painter.clear(colourClear, depthClear, stencilClear);
+		painter.submit(commands);
+		painter.popDebugGroup();
+	});
+}
+
 void RenderGraphNode::renderNodeOverlayMethod(const RenderGraph& graph, const RenderContext& rc)
 {
 	const auto& texs = overlayMethod->getDefinition().getTextures();
@@ -493,3 +493,15 @@ AnimationPlayer ConfigNodeSerializer<AnimationPlayer>::deserialize(const ConfigN
 	player.setApplyMaterial(node["applyMaterial"].asBool(true));
 	return player;
 }
+
+void ConfigNodeAssetDependencies<AnimationPlayer>::collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result)
+{
+	if (node.getType() != ConfigNodeType::Map) {
+		return;
+	}
+
+	auto animName = node["animation"].asString("");
+	if (!animName.isEmpty()) {
+		result.emplace_back(AssetType::Animation, std::move(animName));
+	}
+}
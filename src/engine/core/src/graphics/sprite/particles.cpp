@@ -1,6 +1,8 @@
 #include "graphics/sprite/particles.h"
 
 #include "halley/maths/random.h"
+#include "halley/maths/simd.h"
+#include "halley/concurrency/concurrent.h"
 #include "halley/support/logger.h"
 
 using namespace Halley;
@@ -134,10 +136,10 @@ void Particles::update(Time t)
 
 	// Remove dead particles
 	for (size_t i = 0; i < nParticlesAlive; ) {
-		if (!particles[i].alive) {
+		if (particles.time[i] >= particles.ttl[i]) {
 			if (i != nParticlesAlive - 1) {
-				// Swap with last particle that's alive
-				std::swap(particles[i], particles[nParticlesAlive - 1]);
+				// Move last particle that's alive into this slot
+				particles.move(nParticlesAlive - 1, i);
 				std::swap(sprites[i], sprites[nParticlesAlive - 1]);
 				if (isAnimated()) {
 					std::swap(animationPlayers[i], animationPlayers[nParticlesAlive - 1]);
@@ -195,8 +197,9 @@ void Particles::spawn(size_t n)
 
 	const size_t start = nParticlesAlive;
 	nParticlesAlive += n;
+	// Always a multiple of 8, so the update kernels can run past the last particle without a scalar tail
 	const size_t size = std::max(size_t(8), nextPowerOf2(nParticlesAlive));
-	if (particles.size() < size) {
+	if (sprites.size() < size) {
 		particles.resize(size);
 		sprites.resize(size);
 		if (isAnimated()) {
@@ -212,15 +215,18 @@ void Particles::spawn(size_t n)
 void Particles::initializeParticle(size_t index)
 {
 	const auto startDirection = Angle1f::fromDegrees(rng->getFloat(angle - angleScatter, angle + angleScatter));
-	
-	auto& particle = particles[index];
-	particle.alive = true;
-	particle.time = 0;
-	particle.ttl = rng->getFloat(ttl - ttlScatter, ttl + ttlScatter);
-	particle.pos = getSpawnPosition();
-	particle.angle = rotateTowardsMovement ? startDirection : Angle1f();
-	particle.scale = startScale;
-	particle.vel = Vector2f(rng->getFloat(speed - speedScatter, speed + speedScatter), startDirection);
+	const auto pos = getSpawnPosition();
+	const auto vel = Vector2f(rng->getFloat(speed - speedScatter, speed + speedScatter), startDirection);
+
+	particles.time[index] = 0;
+	particles.ttl[index] = rng->getFloat(ttl - ttlScatter, ttl + ttlScatter);
+	particles.posX[index] = pos.x;
+	particles.posY[index] = pos.y;
+	particles.velX[index] = vel.x;
+	particles.velY[index] = vel.y;
+	particles.rotation[index] = rotateTowardsMovement ? startDirection.getRadians() : 0.0f;
+	particles.scale[index] = startScale;
+	particles.alpha[index] = 1.0f;
 
 	auto& sprite = sprites[index];
 	if (isAnimated()) {
@@ -233,50 +239,167 @@ void Particles::initializeParticle(size_t index)
 
 void Particles::updateParticles(float time)
 {
-	const bool hasAnim = isAnimated();
+	const size_t n = nParticlesAlive;
 	
-	for (size_t i = 0; i < nParticlesAlive; ++i) {
-		if (hasAnim) {
+	// Animation players and the random number generator aren't safe to touch from other threads, so they're stepped here first
+	if (isAnimated()) {
+		for (size_t i = 0; i < n; ++i) {
 			animationPlayers[i].update(time, sprites[i]);
 		}
-		
-		auto& particle = particles[i];
+	}
 
-		particle.time += time;
-		if (particle.time >= particle.ttl) {
-			particle.alive = false;
-		} else {
-			particle.vel += acceleration * time;
-			
-			if (stopTime > 0.00001f && particle.time + stopTime >= particle.ttl) {
-				particle.vel = damp(particle.vel, Vector2f(), 10.0f, time);
-			}
-			
-			if (speedDamp > 0.0001f) {
-				particle.vel = damp(particle.vel, Vector2f(), speedDamp, time);
-			}
+	if (directionScatter > 0.00001f) {
+		scatterAngles.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			scatterAngles[i] = Angle1f::fromDegrees(rng->getFloat(-directionScatter * time, directionScatter * time)).getRadians();
+		}
+	}
 
-			if (directionScatter > 0.00001f) {
-				particle.vel = particle.vel.rotate(Angle1f::fromDegrees(rng->getFloat(-directionScatter * time, directionScatter * time)));
-			}
-			
-			particle.pos += particle.vel * time;
+	constexpr size_t minParticlesPerJob = 4096;
+	if (n < 2 * minParticlesPerJob) {
+		updateParticleRange(time, 0, n);
+		return;
+	}
+
+	auto& cpu = Executors::getCPU();
+	const size_t nJobs = std::min(cpu.threadCount() + 1, n / minParticlesPerJob);
+	if (nJobs <= 1) {
+		updateParticleRange(time, 0, n);
+		return;
+	}
+
+	// Job boundaries are kept at multiples of 8, so no two jobs ever share a kernel step
+	const size_t perJob = alignUp((n + nJobs - 1) / nJobs, size_t(8));
+	Vector<Future<void>> futures;
+	futures.reserve(nJobs - 1);
+	for (size_t i = 1; i < nJobs; ++i) {
+		const size_t start = std::min(n, i * perJob);
+		const size_t end = std::min(n, start + perJob);
+		if (start < end) {
+			futures.push_back(Concurrent::execute(cpu, [this, time, start, end] ()
+			{
+				updateParticleRange(time, start, end);
+			}));
+		}
+	}
+
+	updateParticleRange(time, 0, std::min(n, perJob));
+	auto all = Concurrent::whenAll(futures.begin(), futures.end());
+	while (!all.isReady()) {
+		if (!cpu.tryRunOne()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void Particles::updateParticleRange(float time, size_t start, size_t end)
+{
+	// Work through the range in blocks small enough that every pass over a block stays in cache
+	constexpr size_t blockSize = 256;
+	const bool hasScatter = directionScatter > 0.00001f;
+
+	for (size_t blockStart = start; blockStart < end; blockStart += blockSize) {
+		const size_t blockEnd = std::min(end, blockStart + blockSize);
+
+		integrateVelocities(time, blockStart, blockEnd);
 
-			if (rotateTowardsMovement && particle.vel.squaredLength() > 0.001f) {
-				particle.angle = particle.vel.angle();
+		if (hasScatter) {
+			for (size_t i = blockStart; i < blockEnd; ++i) {
+				const auto vel = Vector2f(particles.velX[i], particles.velY[i]).rotate(std::sin(scatterAngles[i]), std::cos(scatterAngles[i]));
+				particles.velX[i] = vel.x;
+				particles.velY[i] = vel.y;
 			}
+		}
 
-			particle.scale = lerp(startScale, endScale, particle.time / particle.ttl);
+		integratePositions(time, blockStart, blockEnd);
 
-			if (fadeInTime > 0.000001f || fadeOutTime > 0.00001f) {
-				const float alpha = clamp(std::min(particle.time / fadeInTime, (particle.ttl - particle.time) / fadeOutTime), 0.0f, 1.0f);
-				sprites[i].getColour().a = alpha;
+		if (rotateTowardsMovement) {
+			for (size_t i = blockStart; i < blockEnd; ++i) {
+				const auto vel = Vector2f(particles.velX[i], particles.velY[i]);
+				if (vel.squaredLength() > 0.001f) {
+					particles.rotation[i] = vel.angle().getRadians();
+				}
 			}
+		}
+
+		writeSprites(blockStart, blockEnd);
+	}
+}
 
-			sprites[i]
-				.setPosition(particle.pos)
-				.setRotation(particle.angle)
-				.setScale(particle.scale);
+void Particles::integrateVelocities(float time, size_t start, size_t end)
+{
+	// Damping towards zero is just a scale, so both kinds of damping fold into a single factor per particle
+	const float damping = speedDamp > 0.0001f ? std::exp(-speedDamp * time) : 1.0f;
+	const float stopDamping = stopTime > 0.00001f ? damping * std::exp(-10.0f * time) : damping;
+
+	const auto dt = SIMDVec4::loadSingleValue(time);
+	const auto accelX = SIMDVec4::loadSingleValue(acceleration.x * time);
+	const auto accelY = SIMDVec4::loadSingleValue(acceleration.y * time);
+	const auto stopTimeV = SIMDVec4::loadSingleValue(stopTime);
+	const auto dampingV = SIMDVec4::loadSingleValue(damping);
+	const auto stopDampingV = SIMDVec4::loadSingleValue(stopDamping);
+
+	auto step = [&] (size_t i)
+	{
+		const auto t = SIMDVec4::loadUnaligned(&particles.time[i]) + dt;
+		const auto ttl = SIMDVec4::loadUnaligned(&particles.ttl[i]);
+		const auto factor = SIMDVec4::select((t + stopTimeV).lessThan(ttl), dampingV, stopDampingV);
+		t.storeUnaligned(&particles.time[i]);
+		((SIMDVec4::loadUnaligned(&particles.velX[i]) + accelX) * factor).storeUnaligned(&particles.velX[i]);
+		((SIMDVec4::loadUnaligned(&particles.velY[i]) + accelY) * factor).storeUnaligned(&particles.velY[i]);
+	};
+
+	// 8 particles per step. Ranges always start at a multiple of 8 and the arrays are padded to one, so this can overrun end safely.
+	for (size_t i = start; i < end; i += 8) {
+		step(i);
+		step(i + 4);
+	}
+}
+
+void Particles::integratePositions(float time, size_t start, size_t end)
+{
+	const bool hasFade = fadeInTime > 0.000001f || fadeOutTime > 0.00001f;
+
+	const auto dt = SIMDVec4::loadSingleValue(time);
+	const auto scale0 = SIMDVec4::loadSingleValue(startScale);
+	const auto scaleDelta = SIMDVec4::loadSingleValue(endScale - startScale);
+	const auto invFadeIn = SIMDVec4::loadSingleValue(1.0f / fadeInTime);
+	const auto invFadeOut = SIMDVec4::loadSingleValue(1.0f / fadeOutTime);
+	const auto zero = SIMDVec4::loadZero();
+	const auto one = SIMDVec4::loadSingleValue(1.0f);
+
+	auto step = [&] (size_t i)
+	{
+		(SIMDVec4::loadUnaligned(&particles.posX[i]) + SIMDVec4::loadUnaligned(&particles.velX[i]) * dt).storeUnaligned(&particles.posX[i]);
+		(SIMDVec4::loadUnaligned(&particles.posY[i]) + SIMDVec4::loadUnaligned(&particles.velY[i]) * dt).storeUnaligned(&particles.posY[i]);
+
+		const auto t = SIMDVec4::loadUnaligned(&particles.time[i]);
+		const auto ttl = SIMDVec4::loadUnaligned(&particles.ttl[i]);
+		(scale0 + scaleDelta * (t / ttl)).storeUnaligned(&particles.scale[i]);
+
+		if (hasFade) {
+			const auto alpha = (t * invFadeIn).min((ttl - t) * invFadeOut).max(zero).min(one);
+			alpha.storeUnaligned(&particles.alpha[i]);
+		}
+	};
+
+	for (size_t i = start; i < end; i += 8) {
+		step(i);
+		step(i + 4);
+	}
+}
+
+void Particles::writeSprites(size_t start, size_t end)
+{
+	// Straight into the vertex attributes, skipping the validation done by the Sprite setters
+	const bool hasFade = fadeInTime > 0.000001f || fadeOutTime > 0.00001f;
+	for (size_t i = start; i < end; ++i) {
+		auto& vertex = sprites[i].vertexAttrib;
+		vertex.pos = Vector2f(particles.posX[i], particles.posY[i]);
+		vertex.rotation = particles.rotation[i];
+		vertex.scale = Vector2f(particles.scale[i], particles.scale[i]);
+		if (hasFade) {
+			vertex.colour.a = particles.alpha[i];
 		}
 	}
 }
@@ -286,6 +409,32 @@ Vector2f Particles::getSpawnPosition() const
 	return position + Vector2f(rng->getFloat(-spawnArea.x * 0.5f, spawnArea.x * 0.5f), rng->getFloat(-spawnArea.y * 0.5f, spawnArea.y * 0.5f));
 }
 
+void Particles::ParticleState::resize(size_t size)
+{
+	posX.resize(size);
+	posY.resize(size);
+	velX.resize(size);
+	velY.resize(size);
+	rotation.resize(size);
+	scale.resize(size, 1.0f);
+	alpha.resize(size, 1.0f);
+	time.resize(size);
+	ttl.resize(size, 1.0f);
+}
+
+void Particles::ParticleState::move(size_t from, size_t to)
+{
+	posX[to] = posX[from];
+	posY[to] = posY[from];
+	velX[to] = velX[from];
+	velY[to] = velY[from];
+	rotation[to] = rotation[from];
+	scale[to] = scale[from];
+	alpha[to] = alpha[from];
+	time[to] = time[from];
+	ttl[to] = ttl[from];
+}
+
 ConfigNode ConfigNodeSerializer<Particles>::serialize(const Particles& particles, const ConfigNodeSerializationContext& context)
 {
 	return particles.toConfigNode();
@@ -765,6 +765,37 @@ void ConfigNodeSerializer<Sprite>::deserialize(const ConfigNodeSerializationCont
 	}
 }
 
+void ConfigNodeAssetDependencies<Sprite>::collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result)
+{
+	if (node.getType() != ConfigNodeType::Map) {
+		return;
+	}
+
+	// Same keys as ConfigNodeSerializer<Sprite>::deserialize reads
+	for (const auto& [key, value]: node.asMap()) {
+		if (value.getType() != ConfigNodeType::String) {
+			continue;
+		}
+		auto name = value.asString();
+		if (name.isEmpty()) {
+			continue;
+		}
+		if (key == "material") {
+			result.emplace_back(AssetType::MaterialDefinition, std::move(name));
+		} else if (key == "image" || key == "image1" || key.startsWith("tex_")) {
+			result.emplace_back(AssetType::Sprite, std::move(name));
+		}
+	}
+}
+
+void DetachedCopy<Sprite>::detach(Sprite& sprite)
+{
+	// Shared materials are already copied on write, but a private one would otherwise be modified through every copy
+	if (sprite.material && !sprite.sharedMaterial) {
+		sprite.material = sprite.material->clone();
+	}
+}
+
 
 #ifdef ENABLE_HOT_RELOAD
 Sprite::~Sprite()
@@ -2,10 +2,12 @@
 #include "graphics/sprite/sprite.h"
 #include "graphics/painter.h"
 #include <gsl/gsl>
+#include <numeric>
 
 #include "graphics/material/material.h"
 #include "graphics/text/text_renderer.h"
 #include "halley/utils/algorithm.h"
+#include "halley/utils/radix_sort.h"
 
 using namespace Halley;
 
@@ -89,6 +91,12 @@ bool SpritePainterEntry::operator<(const SpritePainterEntry& o) const
 	}
 }
 
+uint64_t SpritePainterEntry::getSortKey() const
+{
+	// Same order as operator<, with insertOrder coming from the sort being stable
+	return (uint64_t(toRadixKey(int32_t(layer))) << 32) | uint64_t(toRadixKey(tieBreaker));
+}
+
 SpritePainterEntryType SpritePainterEntry::getType() const
 {
 	return type;
@@ -124,6 +132,16 @@ int SpritePainterEntry::getMask() const
 	return mask;
 }
 
+int SpritePainterEntry::getLayer() const
+{
+	return layer;
+}
+
+float SpritePainterEntry::getTieBreaker() const
+{
+	return tieBreaker;
+}
+
 const std::optional<Rect4f>& SpritePainterEntry::getClip() const
 {
 	return clip;
@@ -135,6 +153,8 @@ void SpritePainter::start(bool forceCopy)
 	sprites.clear();
 	cachedSprites.clear();
 	cachedText.clear();
+	callbacks.clear();
+	dirty = true;
 	materialRecycler.startFrame();
 }
 
@@ -213,11 +233,11 @@ void SpritePainter::add(SpritePainterEntry::Callback callback, int mask, int lay
 void SpritePainter::draw(int mask, Painter& painter)
 {
 	if (dirty) {
-		// TODO: implement hierarchical bucketing.
-		// - one bucket per layer
-		// - for each layer, one bucket per vertical band of the screen (32px or so)
-		// - sort each leaf bucket
-		std::sort(sprites.begin(), sprites.end()); // lol
+		sort();
+		if (!batchReorderLayers.empty()) {
+			reorderForBatching();
+		}
+		buildCullBlocks();
 		dirty = false;
 	}
 
@@ -226,26 +246,182 @@ void SpritePainter::draw(int mask, Painter& painter)
 	Rect4f view = cam.getClippingRectangle();
 
 	// Draw!
-	for (auto& s : sprites) {
-		if ((s.getMask() & mask) != 0) {
-			const auto type = s.getType();
-			
-			if (type == SpritePainterEntryType::SpriteRef) {
-				draw(s.getSprites(), painter, view, s.getClip());
-			} else if (type == SpritePainterEntryType::SpriteCached) {
-				draw(gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
-			} else if (type == SpritePainterEntryType::TextRef) {
-				draw(s.getTexts(), painter, view, s.getClip());
-			} else if (type == SpritePainterEntryType::TextCached) {
-				draw(gsl::span<const TextRenderer>(cachedText.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
-			} else if (type == SpritePainterEntryType::Callback) {
-				draw(callbacks.at(s.getIndex()), painter, s.getClip());
+	for (const auto& block: cullBlocks) {
+		if ((block.mask & mask) == 0 || !block.bounds.isInView(view)) {
+			continue;
+		}
+
+		for (uint32_t i = block.start; i < block.end; ++i) {
+			const auto& s = sprites[i];
+			if ((s.getMask() & mask) != 0 && entryBounds[i].isInView(view)) {
+				draw(s, painter, view);
 			}
 		}
 	}
 	painter.flush();
 }
 
+void SpritePainter::sort()
+{
+	// Radix sort on (layer, tieBreaker). Entries are always in insertion order (or already sorted, for entries added after
+	// a previous draw), so the stable sort keeps insertOrder as the last tie breaker without having it in the key.
+	const size_t n = sprites.size();
+	sortKeys.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		sortKeys[i] = sprites[i].getSortKey();
+	}
+	radixSortIndices<uint64_t>(sortKeys, sortOrder, sortScratch);
+
+	sortedSprites.clear();
+	sortedSprites.reserve(n);
+	for (const auto idx: sortOrder) {
+		sortedSprites.push_back(std::move(sprites[idx]));
+	}
+	std::swap(sprites, sortedSprites);
+	sortedSprites.clear();
+}
+
+void SpritePainter::setBatchReordering(int layer, std::optional<float> tieBreakerTolerance)
+{
+	if (tieBreakerTolerance) {
+		batchReorderLayers[layer] = *tieBreakerTolerance;
+	} else {
+		batchReorderLayers.erase(layer);
+	}
+	dirty = true;
+}
+
+void SpritePainter::reorderForBatching()
+{
+	auto isSprite = [] (const SpritePainterEntry& e)
+	{
+		return e.getType() == SpritePainterEntryType::SpriteRef || e.getType() == SpritePainterEntryType::SpriteCached;
+	};
+
+	const size_t n = sprites.size();
+	for (size_t i = 0; i < n; ) {
+		const auto& first = sprites[i];
+		const auto iter = batchReorderLayers.find(first.getLayer());
+		if (!isSprite(first) || iter == batchReorderLayers.end()) {
+			++i;
+			continue;
+		}
+
+		// Find the run of sprites that can be freely reordered
+		const float maxTieBreaker = first.getTieBreaker() + iter->second;
+		size_t end = i + 1;
+		while (end < n && isSprite(sprites[end]) && sprites[end].getLayer() == first.getLayer() && sprites[end].getTieBreaker() <= maxTieBreaker) {
+			++end;
+		}
+
+		if (end - i > 1) {
+			sortKeys.resize(end - i);
+			for (size_t j = i; j < end; ++j) {
+				sortKeys[j - i] = getBatchKey(sprites[j]);
+			}
+			// Runs are usually short, so a comparison sort beats clearing radix histograms here
+			sortOrder.resize(end - i);
+			std::iota(sortOrder.begin(), sortOrder.end(), 0);
+			std::stable_sort(sortOrder.begin(), sortOrder.end(), [&] (uint32_t a, uint32_t b) { return sortKeys[a] < sortKeys[b]; });
+
+			sortedSprites.clear();
+			for (const auto idx: sortOrder) {
+				sortedSprites.push_back(std::move(sprites[i + idx]));
+			}
+			std::move(sortedSprites.begin(), sortedSprites.end(), sprites.begin() + i);
+			sortedSprites.clear();
+		}
+
+		i = end;
+	}
+}
+
+uint64_t SpritePainter::getBatchKey(const SpritePainterEntry& entry) const
+{
+	const auto& sprite = entry.getType() == SpritePainterEntryType::SpriteRef ? entry.getSprites()[0] : cachedSprites[entry.getIndex()];
+	return sprite.hasMaterial() ? sprite.getMaterial().getBatchKey() : 0;
+}
+
+void SpritePainter::buildCullBlocks()
+{
+	// Entries sorted by tieBreaker (typically the y coordinate) are spatially coherent, so short runs within a layer
+	// have tight bounds and most of them can be skipped whole when drawing a camera that only sees part of the world.
+	constexpr uint32_t maxBlockSize = 64;
+
+	const auto n = uint32_t(sprites.size());
+	entryBounds.resize(n);
+	cullBlocks.clear();
+
+	for (uint32_t i = 0; i < n; ++i) {
+		const auto& entry = sprites[i];
+		entryBounds[i] = getBounds(entry);
+
+		if (cullBlocks.empty() || cullBlocks.back().end - cullBlocks.back().start >= maxBlockSize || sprites[cullBlocks.back().start].getLayer() != entry.getLayer()) {
+			cullBlocks.push_back(CullBlock{ i, i, 0, {} });
+		}
+		auto& block = cullBlocks.back();
+		block.end = i + 1;
+		block.mask |= entry.getMask();
+		block.bounds.add(entryBounds[i]);
+	}
+}
+
+SpritePainter::CullBounds SpritePainter::getBounds(const SpritePainterEntry& entry) const
+{
+	CullBounds result;
+
+	const auto type = entry.getType();
+	if (type == SpritePainterEntryType::SpriteRef || type == SpritePainterEntryType::SpriteCached) {
+		const auto entrySprites = type == SpritePainterEntryType::SpriteRef ? entry.getSprites() : gsl::span<const Sprite>(cachedSprites.data() + entry.getIndex(), entry.getCount());
+		for (const auto& sprite: entrySprites) {
+			if (sprite.isVisible()) {
+				result.add(CullBounds{ true, true, sprite.getAABB() });
+			}
+		}
+	} else {
+		result.visible = true;
+		result.hasBounds = false;
+	}
+
+	return result;
+}
+
+void SpritePainter::CullBounds::add(const CullBounds& other)
+{
+	if (!other.visible) {
+		return;
+	}
+	if (!visible) {
+		*this = other;
+		return;
+	}
+	hasBounds = hasBounds && other.hasBounds;
+	if (hasBounds) {
+		bounds = bounds.merge(other.bounds);
+	}
+}
+
+bool SpritePainter::CullBounds::isInView(Rect4f view) const
+{
+	return visible && (!hasBounds || bounds.overlaps(view));
+}
+
+void SpritePainter::draw(const SpritePainterEntry& s, Painter& painter, Rect4f view) const
+{
+	const auto type = s.getType();
+	if (type == SpritePainterEntryType::SpriteRef) {
+		draw(s.getSprites(), painter, view, s.getClip());
+	} else if (type == SpritePainterEntryType::SpriteCached) {
+		draw(gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
+	} else if (type == SpritePainterEntryType::TextRef) {
+		draw(s.getTexts(), painter, view, s.getClip());
+	} else if (type == SpritePainterEntryType::TextCached) {
+		draw(gsl::span<const TextRenderer>(cachedText.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
+	} else if (type == SpritePainterEntryType::Callback) {
+		draw(callbacks.at(s.getIndex()), painter, s.getClip());
+	}
+}
+
 void SpritePainter::draw(gsl::span<const Sprite> sprites, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const
 {
 	for (const auto& sprite: sprites) {
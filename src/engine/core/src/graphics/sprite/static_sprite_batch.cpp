@@ -0,0 +1,133 @@
+#include "graphics/sprite/static_sprite_batch.h"
+#include "graphics/painter.h"
+#include "graphics/material/material.h"
+#include "graphics/material/material_definition.h"
+#include <algorithm>
+#include <gsl/gsl_assert>
+
+using namespace Halley;
+
+StaticSpriteBatch::StaticSpriteBatch(Vector<Sprite> sprites)
+	: sprites(std::move(sprites))
+{
+}
+
+void StaticSpriteBatch::setSprites(Vector<Sprite> sprites)
+{
+	this->sprites = std::move(sprites);
+	dirty = true;
+}
+
+void StaticSpriteBatch::add(Sprite sprite)
+{
+	sprites.push_back(std::move(sprite));
+	dirty = true;
+}
+
+void StaticSpriteBatch::clear()
+{
+	sprites.clear();
+	dirty = true;
+}
+
+size_t StaticSpriteBatch::size() const
+{
+	return sprites.size();
+}
+
+bool StaticSpriteBatch::empty() const
+{
+	return sprites.empty();
+}
+
+const Sprite& StaticSpriteBatch::getSprite(size_t idx) const
+{
+	return sprites.at(idx);
+}
+
+Sprite& StaticSpriteBatch::getMutableSprite(size_t idx)
+{
+	dirty = true;
+	return sprites.at(idx);
+}
+
+void StaticSpriteBatch::setDirty()
+{
+	dirty = true;
+}
+
+Rect4f StaticSpriteBatch::getAABB()
+{
+	if (dirty) {
+		rebuild();
+	}
+	return aabb;
+}
+
+void StaticSpriteBatch::draw(Painter& painter)
+{
+	if (dirty) {
+		rebuild();
+	}
+	if (runs.empty() || !aabb.overlaps(painter.getCurrentCamera().getClippingRectangle())) {
+		return;
+	}
+
+	size_t retainedIdx = 0;
+	for (const auto& run: runs) {
+		if (run.retained) {
+			painter.drawRetainedSprites(run.material, retainedIds[retainedIdx++], version, run.count, vertexData.data() + run.start);
+		} else {
+			sprites[run.start].draw(painter);
+		}
+	}
+}
+
+void StaticSpriteBatch::rebuild()
+{
+	constexpr size_t maxSpritesPerRun = (static_cast<size_t>(std::numeric_limits<IndexType>::max()) + 1) / 4;
+
+	runs.clear();
+	vertexData.clear();
+	vertexData.reserve(sprites.size());
+	bool first = true;
+
+	for (uint32_t i = 0; i < uint32_t(sprites.size()); ++i) {
+		const auto& sprite = sprites[i];
+		if (!sprite.isVisible() || !sprite.hasMaterial()) {
+			continue;
+		}
+
+		const auto spriteAABB = sprite.getAABB();
+		aabb = first ? spriteAABB : aabb.merge(spriteAABB);
+		first = false;
+
+		if (sprite.isSliced() || sprite.getClip()) {
+			runs.push_back(Run{ sprite.material, i, 1, false });
+			continue;
+		}
+
+		Expects(sprite.material->getDefinition().getVertexStride() == sizeof(SpriteVertexAttrib));
+
+		const bool sameMaterial = !runs.empty() && runs.back().retained && runs.back().count < maxSpritesPerRun
+			&& (runs.back().material == sprite.material || *runs.back().material == *sprite.material);
+		if (sameMaterial) {
+			++runs.back().count;
+		} else {
+			runs.push_back(Run{ sprite.material, uint32_t(vertexData.size()), 1, true });
+		}
+		vertexData.push_back(sprite.vertexAttrib);
+	}
+
+	if (first) {
+		aabb = Rect4f();
+	}
+
+	const auto nRetained = size_t(std::count_if(runs.begin(), runs.end(), [] (const Run& r) { return r.retained; }));
+	while (retainedIds.size() < nRetained) {
+		retainedIds.push_back(Painter::allocateRetainedId());
+	}
+
+	++version;
+	dirty = false;
+}
@@ -5,31 +5,39 @@
 #include "halley/bytes/compression.h"
 #include "halley/maths/random.h"
 #include "halley/utils/encrypt.h"
+#include "halley/file/memory_mapped_file.h"
+#include "halley/resources/resource.h"
+#include "halley/utils/hash.h"
+#include "halley/resources/metadata.h"
 
 using namespace Halley;
 
-void AssetPackHeader::init(size_t assetDbSize)
+void AssetPackHeader::init(size_t indexSize, size_t assetDbSize)
 {
 	memcpy(identifier.data(), "HALLEYPK", 8);
-	assetDbStartPos = sizeof(AssetPackHeader);
+	assetDbStartPos = sizeof(AssetPackHeader) + indexSize;
 	dataStartPos = assetDbStartPos + assetDbSize;
 	memset(iv.data(), 0, iv.size());
 }
 
 AssetPack::AssetPack()
 	: assetDb(std::make_unique<AssetDatabase>())
+	, assetDbLoaded(true)
 	, hasReader(false)
 {
 	memset(iv.data(), 0, iv.size());
 }
 
 AssetPack::AssetPack(AssetPack&& other) noexcept
+	: assetDbLoaded(false)
+	, hasReader(false)
 {
 	*this = std::move(other);
 }
 
 AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String& encryptionKey, bool preLoad)
-	: reader(std::move(_reader))
+	: assetDbLoaded(false)
+	, reader(std::move(_reader))
 	, hasReader(true)
 {
 	// Read header
@@ -45,24 +53,31 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 	if (memcmp(header.identifier.data(), "HALLEYPK", 8) != 0) {
 		throw Exception("Asset pack is invalid (invalid identifier)", HalleyExceptions::Resources);
 	}
-	iv = header.iv;
-	dataOffset = size_t(header.dataStartPos);
+	if (header.assetDbStartPos < sizeof(AssetPackHeader) || header.assetDbStartPos > header.dataStartPos || header.dataStartPos > totalSize) {
+		throw Exception("Asset pack is invalid (bad header)", HalleyExceptions::Resources);
+	}
 
-	// Read asset database
-	{
-		const size_t assetDbSize = size_t(header.dataStartPos - header.assetDbStartPos);
-		auto assetDbBytes = Bytes(assetDbSize);
-		nRead = reader->read(gsl::as_writable_bytes(gsl::span<Byte>(assetDbBytes)));
-		if (nRead != int(assetDbBytes.size())) {
-			throw Exception("Unable to read header", HalleyExceptions::Resources);
+	// Read index
+	auto indexBytes = Bytes(size_t(header.assetDbStartPos) - sizeof(AssetPackHeader));
+	if (!indexBytes.empty()) {
+		nRead = reader->read(gsl::as_writable_bytes(gsl::span<Byte>(indexBytes)));
+		if (nRead != int(indexBytes.size())) {
+			throw Exception("Unable to read index", HalleyExceptions::Resources);
 		}
-		assetDb = std::make_unique<AssetDatabase>();
-		Deserializer::fromBytes<AssetDatabase>(*assetDb, Compression::decompress(assetDbBytes));
+		index.load(std::move(indexBytes));
 	}
 
-	std::array<char, 16> ivEmpty;
-	memset(ivEmpty.data(), 0, ivEmpty.size());
-	const bool hasCrypt = memcmp(iv.data(), ivEmpty.data(), iv.size()) != 0 && !encryptionKey.isEmpty();
+	// Read asset database
+	const size_t assetDbSize = size_t(header.dataStartPos - header.assetDbStartPos);
+	auto assetDbBytes = Bytes(assetDbSize);
+	nRead = reader->read(gsl::as_writable_bytes(gsl::span<Byte>(assetDbBytes)));
+	if (nRead != int(assetDbBytes.size())) {
+		throw Exception("Unable to read header", HalleyExceptions::Resources);
+	}
+	readHeader(header, gsl::as_bytes(gsl::span<Byte>(assetDbBytes)));
+	buildLegacyIndex();
+
+	const bool hasCrypt = needsDecryption(encryptionKey);
 
 	if (preLoad || hasCrypt) {
 		readToMemory();
@@ -73,18 +88,96 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 	}
 }
 
+AssetPack::AssetPack(std::unique_ptr<MemoryMappedFile> _mapping, const String& encryptionKey, bool preLoad)
+	: assetDbLoaded(false)
+	, mapping(std::move(_mapping))
+	, hasReader(false)
+{
+	const auto bytes = mapping->getSpan();
+	if (size_t(bytes.size()) < sizeof(AssetPackHeader)) {
+		throw Exception("Asset pack is invalid (too small)", HalleyExceptions::Resources);
+	}
+	AssetPackHeader header;
+	memcpy(&header, bytes.data(), sizeof(header));
+	if (memcmp(header.identifier.data(), "HALLEYPK", 8) != 0) {
+		throw Exception("Asset pack is invalid (invalid identifier)", HalleyExceptions::Resources);
+	}
+	if (header.assetDbStartPos < sizeof(AssetPackHeader) || header.assetDbStartPos > header.dataStartPos || header.dataStartPos > uint64_t(bytes.size())) {
+		throw Exception("Asset pack is invalid (bad header)", HalleyExceptions::Resources);
+	}
+	if (header.assetDbStartPos > sizeof(AssetPackHeader)) {
+		// Used in place
+		index.load(bytes.subspan(ptrdiff_t(sizeof(AssetPackHeader)), ptrdiff_t(header.assetDbStartPos - sizeof(AssetPackHeader))));
+	}
+	readHeader(header, bytes.subspan(ptrdiff_t(header.assetDbStartPos), ptrdiff_t(header.dataStartPos - header.assetDbStartPos)));
+	buildLegacyIndex();
+
+	if (needsDecryption(encryptionKey)) {
+		// Decryption can't happen in place on a read-only mapping, so this ends up as a regular in-memory pack
+		const auto src = bytes.subspan(ptrdiff_t(dataOffset));
+		data.resize(size_t(src.size()));
+		memcpy(data.data(), src.data(), data.size());
+		mapping.reset();
+		decrypt(encryptionKey);
+	} else if (preLoad) {
+		mapping->prefetch();
+	}
+}
+
 AssetPack::~AssetPack()
 {
 }
 
+void AssetPack::readHeader(const AssetPackHeader& header, gsl::span<const gsl::byte> assetDbBytes)
+{
+	iv = header.iv;
+	dataOffset = size_t(header.dataStartPos);
+
+	assetDbData.resize(size_t(assetDbBytes.size()));
+	memcpy(assetDbData.data(), assetDbBytes.data(), assetDbData.size());
+}
+
+void AssetPack::buildLegacyIndex()
+{
+	if (index.isEmpty()) {
+		index.load(AssetPackIndex::build(getAssetDatabase()));
+	}
+}
+
+void AssetPack::loadAssetDatabase() const
+{
+	std::unique_lock<std::mutex> lock(assetDbMutex);
+	if (!assetDbLoaded) {
+		assetDb = std::make_unique<AssetDatabase>();
+		Deserializer::fromBytes<AssetDatabase>(*assetDb, Compression::decompress(assetDbData));
+		assetDbData = Bytes();
+		assetDbLoaded = true;
+	}
+}
+
+bool AssetPack::needsDecryption(const String& encryptionKey) const
+{
+	std::array<char, 16> ivEmpty;
+	memset(ivEmpty.data(), 0, ivEmpty.size());
+	return memcmp(iv.data(), ivEmpty.data(), iv.size()) != 0 && !encryptionKey.isEmpty();
+}
+
 AssetPack& AssetPack::operator=(AssetPack&& other) noexcept
 {
 	std::unique_lock<std::mutex> lock(other.readerMutex);
+	std::unique_lock<std::mutex> dbLock(other.assetDbMutex);
 
 	assetDb = std::move(other.assetDb);
+	assetDbData = std::move(other.assetDbData);
+	assetDbLoaded = other.assetDbLoaded.load();
+	index = std::move(other.index);
+	indexSources = std::move(other.indexSources);
+	indexDirty = other.indexDirty;
 	dataOffset = other.dataOffset;
 	reader = std::move(other.reader);
+	mapping = std::move(other.mapping);
 	data = std::move(other.data);
+	iv = other.iv;
 	hasReader = !!reader;
 
 	other.hasReader = false;
@@ -95,14 +188,29 @@ AssetPack& AssetPack::operator=(AssetPack&& other) noexcept
 
 AssetDatabase& AssetPack::getAssetDatabase()
 {
+	if (!assetDbLoaded) {
+		loadAssetDatabase();
+	}
 	return *assetDb;
 }
 
 const AssetDatabase& AssetPack::getAssetDatabase() const
 {
+	if (!assetDbLoaded) {
+		loadAssetDatabase();
+	}
 	return *assetDb;
 }
 
+const AssetPackIndex& AssetPack::getIndex() const
+{
+	if (indexDirty) {
+		index.load(AssetPackIndex::build(indexSources));
+		indexDirty = false;
+	}
+	return index;
+}
+
 Bytes& AssetPack::getData()
 {
 	return data;
@@ -113,15 +221,46 @@ const Bytes& AssetPack::getData() const
 	return data;
 }
 
+size_t AssetPack::addAsset(AssetType type, const String& name, gsl::span<const gsl::byte> assetData, const Metadata& meta, AssetPackCompression compression)
+{
+	const uint64_t contentHash = Hash::hash(assetData);
+
+	Bytes compressed;
+	if (compression == AssetPackCompression::LZ4) {
+		compressed = Compression::compressLZ4(assetData);
+	} else if (compression == AssetPackCompression::Deflate) {
+		compressed = Compression::compress(assetData);
+	}
+	if (compression != AssetPackCompression::None && compressed.size() >= size_t(assetData.size())) {
+		// Not worth it
+		compression = AssetPackCompression::None;
+	}
+	const auto stored = compression == AssetPackCompression::None ? assetData : gsl::as_bytes(gsl::span<const Byte>(compressed));
+
+	const size_t pos = data.size();
+	const size_t size = size_t(stored.size());
+	data.reserve(nextPowerOf2(pos + size));
+	data.resize(pos + size);
+	memcpy(data.data() + pos, stored.data(), size);
+
+	getAssetDatabase().addAsset(name, type, AssetDatabase::Entry(toString(pos) + ":" + toString(size), meta));
+	indexSources.push_back(AssetPackIndex::Source{ type, name, pos, size, contentHash, compression });
+	indexDirty = true;
+
+	return size;
+}
+
 Bytes AssetPack::writeOut() const
 {
-	auto assetDbBytes = Compression::compress(Serializer::toBytes(*assetDb));
+	auto indexBytes = indexSources.empty() ? AssetPackIndex::build(getAssetDatabase(), gsl::as_bytes(gsl::span<const Byte>(data))) : AssetPackIndex::build(indexSources);
+	auto assetDbBytes = Compression::compress(Serializer::toBytes(getAssetDatabase()));
 	AssetPackHeader header;
-	header.init(assetDbBytes.size());
+	header.init(indexBytes.size(), assetDbBytes.size());
 	header.iv = iv;
 
 	auto result = Bytes(size_t(header.dataStartPos + data.size()));
 	memcpy(result.data(), &header, sizeof(AssetPackHeader));
+	memcpy(result.data() + sizeof(AssetPackHeader), indexBytes.data(), indexBytes.size());
 	memcpy(result.data() + header.assetDbStartPos, assetDbBytes.data(), assetDbBytes.size());
 	memcpy(result.data() + header.dataStartPos, data.data(), data.size());
 	return result;
@@ -129,17 +268,58 @@ Bytes AssetPack::writeOut() const
 
 std::unique_ptr<ResourceData> AssetPack::getData(const String& asset, AssetType type, bool stream)
 {
+	const auto* entry = getIndex().find(type, asset);
+	if (!entry) {
+		throw Exception("Asset not found: " + toString(type) + ":" + asset, HalleyExceptions::Resources);
+	}
+	const size_t pos = size_t(entry->pos);
+	const size_t size = size_t(entry->size);
 	auto path = asset;
-	auto ps = assetDb->getDatabase(type).get(asset).path.split(':');
-	size_t pos = size_t(ps.at(0).toInteger());
-	size_t size = size_t(ps.at(1).toInteger());
+
+	if (entry->isCompressed()) {
+		// Compressed assets are decoded whole, on whichever thread asked for them (the disk IO executor, for async loads)
+		const auto compression = entry->compression;
+		auto decode = [this, pos, size, compression] (auto&& makeBuffer)
+		{
+			Bytes tmp;
+			const auto stored = getStoredData(pos, size, tmp);
+			const size_t rawSize = getUncompressedSize(stored);
+			auto dst = makeBuffer(rawSize);
+			decompress(compression, stored, gsl::as_writable_bytes(dst));
+			return rawSize;
+		};
+
+		if (stream) {
+			return std::make_unique<ResourceDataStream>(path, [=] () -> std::unique_ptr<ResourceDataReader> {
+				Bytes decoded;
+				decode([&] (size_t rawSize) { decoded.resize(rawSize); return gsl::span<Byte>(decoded); });
+				return std::make_unique<PackDataReader>(std::move(decoded));
+			});
+		} else {
+			char* result = nullptr;
+			try {
+				const size_t rawSize = decode([&] (size_t rawSize) { result = new char[rawSize]; return gsl::span<char>(result, rawSize); });
+				return std::make_unique<ResourceDataStatic>(result, rawSize, path, true);
+			} catch (...) {
+				delete[] result;
+				throw;
+			}
+		}
+	}
 
 	if (stream) {
 		return std::make_unique<ResourceDataStream>(path, [=] () -> std::unique_ptr<ResourceDataReader> {
 			return std::make_unique<PackDataReader>(*this, pos, size);
 		});
 	} else {
-		if (hasReader) {
+		if (mapping) {
+			// Hand out a view straight into the mapping, the pack outlives its resources
+			if (pos + size > mapping->getSize() - dataOffset) {
+				throw Exception("Asset \"" + asset + "\" is out of pack bounds.", HalleyExceptions::Resources);
+			}
+
+			return std::make_unique<ResourceDataStatic>(mapping->getData() + dataOffset + pos, size, path, false);
+		} else if (hasReader) {
 			auto result = new char[size];
 			try {
 				readData(pos, gsl::as_writable_bytes(gsl::span<char>(result, size)));
@@ -197,6 +377,14 @@ void AssetPack::readData(size_t pos, gsl::span<gsl::byte> dst)
 		}
 	}
 
+	if (mapping) {
+		if (pos + size_t(dst.size()) > mapping->getSize() - dataOffset) {
+			throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
+		}
+		memcpy(dst.data(), mapping->getData() + dataOffset + pos, dst.size());
+		return;
+	}
+
 	// Didn't read with reader, read from data
 	if (pos + size_t(dst.size()) > data.size()) {
 		throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
@@ -204,6 +392,56 @@ void AssetPack::readData(size_t pos, gsl::span<gsl::byte> dst)
 	memcpy(dst.data(), data.data() + pos, dst.size());
 }
 
+gsl::span<const gsl::byte> AssetPack::getStoredData(size_t pos, size_t size, Bytes& tmp)
+{
+	if (mapping) {
+		if (pos + size > mapping->getSize() - dataOffset) {
+			throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
+		}
+		return mapping->getSpan().subspan(ptrdiff_t(dataOffset + pos), ptrdiff_t(size));
+	} else if (hasReader) {
+		tmp.resize(size);
+		readData(pos, gsl::as_writable_bytes(gsl::span<Byte>(tmp)));
+		return gsl::as_bytes(gsl::span<const Byte>(tmp));
+	} else {
+		if (pos + size > data.size()) {
+			throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
+		}
+		return gsl::as_bytes(gsl::span<const Byte>(data.data() + pos, size));
+	}
+}
+
+size_t AssetPack::getUncompressedSize(gsl::span<const gsl::byte> stored)
+{
+	if (stored.size() < 8) {
+		throw Exception("Compressed asset is truncated.", HalleyExceptions::Resources);
+	}
+	uint64_t rawSize;
+	memcpy(&rawSize, stored.data(), 8);
+	return size_t(rawSize);
+}
+
+void AssetPack::decompress(AssetPackCompression compression, gsl::span<const gsl::byte> stored, gsl::span<gsl::byte> dst)
+{
+	switch (compression) {
+	case AssetPackCompression::None:
+		if (stored.size() != dst.size()) {
+			throw Exception("Asset size mismatch.", HalleyExceptions::Resources);
+		}
+		memcpy(dst.data(), stored.data(), dst.size());
+		break;
+	case AssetPackCompression::LZ4:
+		Compression::decompressLZ4Raw(stored.subspan(8), dst);
+		break;
+	case AssetPackCompression::Deflate:
+		{
+			auto result = Compression::decompressRaw(stored.subspan(8), size_t(dst.size()), size_t(dst.size()));
+			memcpy(dst.data(), result.data(), dst.size());
+		}
+		break;
+	}
+}
+
 std::unique_ptr<ResourceDataReader> AssetPack::extractReader()
 {
 	std::unique_lock<std::mutex> lock(readerMutex);
@@ -211,13 +449,24 @@ std::unique_ptr<ResourceDataReader> AssetPack::extractReader()
 	return std::move(reader);
 }
 
+bool AssetPack::isMemoryMapped() const
+{
+	return !!mapping;
+}
+
 PackDataReader::PackDataReader(AssetPack& pack, size_t startPos, size_t fileSize)
-	: pack(pack)
+	: pack(&pack)
 	, startPos(startPos)
 	, fileSize(fileSize)
 {
 }
 
+PackDataReader::PackDataReader(Bytes decoded)
+	: fileSize(decoded.size())
+	, decoded(std::move(decoded))
+{
+}
+
 size_t PackDataReader::size() const
 {
 	return fileSize;
@@ -229,7 +478,11 @@ int PackDataReader::read(gsl::span<gsl::byte> dst)
 	size_t available = fileSize - curPos;
 	size_t toRead = std::min(available, size_t(dst.size()));
 
-	pack.readData(startPos + curPos, dst.subspan(0, toRead));
+	if (pack) {
+		pack->readData(startPos + curPos, dst.subspan(0, toRead));
+	} else {
+		memcpy(dst.data(), decoded.data() + curPos, toRead);
+	}
 	curPos += toRead;
 
 	return int(toRead);
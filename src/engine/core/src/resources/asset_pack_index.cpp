@@ -0,0 +1,170 @@
+#include "resources/asset_pack_index.h"
+#include "resources/asset_database.h"
+#include "halley/resources/resource.h"
+#include "halley/support/exception.h"
+#include "halley/utils/hash.h"
+#include "halley/text/string_converter.h"
+#include <algorithm>
+
+using namespace Halley;
+
+namespace {
+	constexpr const char* indexIdentifier = "HALLEYIX";
+
+	bool entryLess(const AssetPackIndex::Entry& entry, int32_t type, uint64_t nameHash)
+	{
+		return entry.type != type ? entry.type < type : entry.nameHash < nameHash;
+	}
+}
+
+AssetPackIndex::AssetPackIndex() = default;
+
+void AssetPackIndex::load(gsl::span<const gsl::byte> data)
+{
+	if (!isIndex(data)) {
+		throw Exception("Asset pack index is invalid", HalleyExceptions::Resources);
+	}
+
+	Header header;
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.version != version) {
+		throw Exception("Asset pack index has unsupported version " + toString(header.version), HalleyExceptions::Resources);
+	}
+
+	const size_t entriesSize = size_t(header.numEntries) * sizeof(Entry);
+	if (sizeof(Header) + entriesSize + header.namesSize > size_t(data.size())) {
+		throw Exception("Asset pack index is truncated", HalleyExceptions::Resources);
+	}
+
+	// Entries are read in place, so they need to be suitably aligned
+	if (reinterpret_cast<size_t>(data.data()) % alignof(Entry) != 0) {
+		load(Bytes(reinterpret_cast<const Byte*>(data.data()), reinterpret_cast<const Byte*>(data.data()) + data.size()));
+		return;
+	}
+
+	numEntries = header.numEntries;
+	namesSize = size_t(header.namesSize);
+	entries = reinterpret_cast<const Entry*>(data.data() + sizeof(Header));
+	names = reinterpret_cast<const char*>(data.data() + sizeof(Header) + entriesSize);
+
+	for (size_t i = 0; i < numEntries; ++i) {
+		if (size_t(entries[i].nameOffset) + entries[i].nameLength > namesSize) {
+			throw Exception("Asset pack index has an out of bounds name", HalleyExceptions::Resources);
+		}
+		if (uint32_t(entries[i].compression) > uint32_t(AssetPackCompression::Deflate)) {
+			throw Exception("Asset pack index has an unknown compression type", HalleyExceptions::Resources);
+		}
+	}
+}
+
+void AssetPackIndex::load(Bytes data)
+{
+	ownedData = std::move(data);
+	load(gsl::as_bytes(gsl::span<const Byte>(ownedData)));
+}
+
+const AssetPackIndex::Entry* AssetPackIndex::find(AssetType type, std::string_view name) const
+{
+	const auto typeId = int32_t(type);
+	const auto nameHash = hashName(name);
+
+	const Entry* end = entries + numEntries;
+	for (auto* e = std::lower_bound(entries, end, nameHash, [&] (const Entry& entry, uint64_t hash) { return entryLess(entry, typeId, hash); }); e != end; ++e) {
+		if (e->type != typeId || e->nameHash != nameHash) {
+			break;
+		}
+		if (getName(*e) == name) {
+			return e;
+		}
+	}
+	return nullptr;
+}
+
+std::string_view AssetPackIndex::getName(const Entry& entry) const
+{
+	return std::string_view(names + entry.nameOffset, entry.nameLength);
+}
+
+gsl::span<const AssetPackIndex::Entry> AssetPackIndex::getEntries() const
+{
+	return gsl::span<const Entry>(entries, numEntries);
+}
+
+bool AssetPackIndex::isEmpty() const
+{
+	return numEntries == 0;
+}
+
+bool AssetPackIndex::isIndex(gsl::span<const gsl::byte> data)
+{
+	return size_t(data.size()) >= sizeof(Header) && memcmp(data.data(), indexIdentifier, 8) == 0;
+}
+
+uint64_t AssetPackIndex::hashName(std::string_view name)
+{
+	return Hash::hash(gsl::as_bytes(gsl::span<const char>(name.data(), name.size())));
+}
+
+Bytes AssetPackIndex::build(Vector<Source> sources)
+{
+	Vector<Entry> result;
+	result.reserve(sources.size());
+	String allNames;
+	for (const auto& s: sources) {
+		Entry entry;
+		entry.nameHash = hashName(s.name);
+		entry.pos = s.pos;
+		entry.size = s.size;
+		entry.contentHash = s.contentHash;
+		entry.nameOffset = uint32_t(allNames.size());
+		entry.nameLength = uint32_t(s.name.size());
+		entry.type = int32_t(s.type);
+		entry.compression = s.compression;
+		result.push_back(entry);
+		allNames += s.name;
+	}
+
+	std::sort(result.begin(), result.end(), [&] (const Entry& a, const Entry& b)
+	{
+		if (a.type != b.type || a.nameHash != b.nameHash) {
+			return entryLess(a, b.type, b.nameHash);
+		}
+		return std::string_view(allNames.c_str() + a.nameOffset, a.nameLength) < std::string_view(allNames.c_str() + b.nameOffset, b.nameLength);
+	});
+
+	Header header;
+	memcpy(header.identifier.data(), indexIdentifier, 8);
+	header.version = version;
+	header.numEntries = uint32_t(result.size());
+	header.namesSize = allNames.size();
+
+	// Padded so that whatever follows the index stays 8-byte aligned
+	const size_t entriesSize = result.size() * sizeof(Entry);
+	Bytes bytes(alignUp(sizeof(Header) + entriesSize + allNames.size(), size_t(8)), 0);
+	memcpy(bytes.data(), &header, sizeof(Header));
+	if (!result.empty()) {
+		memcpy(bytes.data() + sizeof(Header), result.data(), entriesSize);
+	}
+	memcpy(bytes.data() + sizeof(Header) + entriesSize, allNames.c_str(), allNames.size());
+	return bytes;
+}
+
+Bytes AssetPackIndex::build(const AssetDatabase& db, gsl::span<const gsl::byte> packData)
+{
+	Vector<Source> sources;
+	const int numTypes = int(EnumNames<AssetType>()().size());
+	for (int i = 0; i < numTypes; ++i) {
+		const auto type = AssetType(i);
+		if (!db.hasDatabase(type)) {
+			continue;
+		}
+		for (const auto& [name, entry]: db.getDatabase(type).getAssets()) {
+			const auto ps = entry.path.split(':');
+			const auto pos = uint64_t(ps.at(0).toInteger64());
+			const auto size = uint64_t(ps.at(1).toInteger64());
+			const uint64_t contentHash = pos + size <= uint64_t(packData.size()) ? Hash::hash(packData.subspan(ptrdiff_t(pos), ptrdiff_t(size))) : 0;
+			sources.push_back(Source{ type, name, pos, size, contentHash, AssetPackCompression::None });
+		}
+	}
+	return build(std::move(sources));
+}
@@ -152,6 +152,12 @@ bool ResourceCollectionBase::exists(const String& assetId) const
 	return parent.locator->exists(assetId, type);
 }
 
+bool ResourceCollectionBase::isLoaded(const String& assetId) const
+{
+	std::shared_lock lock(mutex);
+	return resources.find(assetId) != resources.end();
+}
+
 void ResourceCollectionBase::setFallback(const String& assetId)
 {
 	fallback = assetId;
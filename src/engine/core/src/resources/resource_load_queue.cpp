@@ -0,0 +1,273 @@
+#include "resources/resource_load_queue.h"
+#include "resources/resources.h"
+#include "resources/resource_locator.h"
+#include "halley/concurrency/concurrent.h"
+#include "halley/support/logger.h"
+#include "halley/support/profiler.h"
+#include "halley/text/string_converter.h"
+#include <chrono>
+
+namespace Halley {
+	class ResourceLoadState {
+	public:
+		mutable std::mutex mutex;
+		size_t total = 0;
+		size_t loaded = 0;
+		Vector<String> errors;
+		HashSet<String> queued;
+		std::atomic<bool> cancelled { false };
+	};
+}
+
+using namespace Halley;
+
+ResourceLoadHandle::ResourceLoadHandle(std::shared_ptr<ResourceLoadState> state)
+	: state(std::move(state))
+{
+}
+
+bool ResourceLoadHandle::isValid() const
+{
+	return !!state;
+}
+
+bool ResourceLoadHandle::isDone() const
+{
+	if (!state) {
+		return true;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	return state->cancelled || state->loaded == state->total;
+}
+
+float ResourceLoadHandle::getProgress() const
+{
+	if (!state) {
+		return 1.0f;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	return state->total == 0 ? 1.0f : float(state->loaded) / float(state->total);
+}
+
+size_t ResourceLoadHandle::getNumLoaded() const
+{
+	if (!state) {
+		return 0;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	return state->loaded;
+}
+
+size_t ResourceLoadHandle::getNumTotal() const
+{
+	if (!state) {
+		return 0;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	return state->total;
+}
+
+bool ResourceLoadHandle::hasErrors() const
+{
+	if (!state) {
+		return false;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	return !state->errors.empty();
+}
+
+Vector<String> ResourceLoadHandle::getErrors() const
+{
+	if (!state) {
+		return {};
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	return state->errors;
+}
+
+void ResourceLoadHandle::cancel()
+{
+	if (state) {
+		state->cancelled = true;
+	}
+}
+
+ResourceLoadQueue::ResourceLoadQueue(Resources& resources, ResourceLocator& locator)
+	: resources(resources)
+	, locator(locator)
+	, prefetchContext(std::make_shared<PrefetchContext>())
+{
+	prefetchContext->locator = &locator;
+}
+
+ResourceLoadQueue::~ResourceLoadQueue()
+{
+	// Prefetch jobs still sitting in the IO queue will find no locator and do nothing, but the ones already reading have to finish first
+	std::unique_lock<std::mutex> lock(prefetchContext->mutex);
+	prefetchContext->locator = nullptr;
+	prefetchContext->idle.wait(lock, [&] () { return prefetchContext->reading == 0; });
+}
+
+ResourceLoadHandle ResourceLoadQueue::enqueue(Vector<std::pair<AssetType, String>> assets, ResourceLoadPriority priority)
+{
+	auto state = std::make_shared<ResourceLoadState>();
+	for (auto& [type, name]: assets) {
+		add(type, name, priority, state);
+	}
+	return ResourceLoadHandle(std::move(state));
+}
+
+bool ResourceLoadQueue::isIdle() const
+{
+	return pending.empty() && waiting.empty();
+}
+
+void ResourceLoadQueue::add(AssetType type, const String& name, ResourceLoadPriority priority, const std::shared_ptr<ResourceLoadState>& state)
+{
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		if (!state->queued.insert(toString(type) + ":" + name).second) {
+			return;
+		}
+		++state->total;
+		if (resources.ofType(type).isLoaded(name)) {
+			++state->loaded;
+			return;
+		}
+	}
+
+	Request request{ type, name, priority, nextSequence++, state, {}, {} };
+	request.prefetch = Concurrent::execute(Executors::getDiskIO(), [context = prefetchContext, type, name, state] ()
+	{
+		if (state->cancelled) {
+			return;
+		}
+
+		ResourceLocator* locator;
+		{
+			std::unique_lock<std::mutex> lock(context->mutex);
+			locator = context->locator;
+			if (!locator) {
+				return;
+			}
+			++context->reading;
+		}
+
+		try {
+			ProfilerEvent event(ProfilerEventType::DiskIO);
+			locator->prefetch(name, type);
+		} catch (...) {
+			// Nothing gets staged, so construction reads it again and reports the error
+		}
+
+		std::unique_lock<std::mutex> lock(context->mutex);
+		if (--context->reading == 0) {
+			context->idle.notify_all();
+		}
+	});
+	pending.push_back(std::move(request));
+}
+
+void ResourceLoadQueue::update(double budget)
+{
+	updateWaiting();
+	if (pending.empty()) {
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(budget));
+
+	// Higher priority first, then asset type (which is also dependency order), then order of request
+	// Dependencies found while constructing go into a fresh pending list, so they'll only be picked up next frame
+	Vector<Request> batch;
+	std::swap(batch, pending);
+	std::sort(batch.begin(), batch.end(), [] (const Request& a, const Request& b)
+	{
+		if (a.priority != b.priority) {
+			return a.priority > b.priority;
+		}
+		if (a.type != b.type) {
+			return a.type < b.type;
+		}
+		return a.sequence < b.sequence;
+	});
+
+	bool outOfTime = false;
+	for (auto& request: batch) {
+		if (!request.prefetch.isReady()) {
+			pending.push_back(std::move(request));
+		} else if (request.state->cancelled) {
+			locator.discardPrefetched(request.name, request.type);
+		} else if (outOfTime) {
+			pending.push_back(std::move(request));
+		} else {
+			construct(request);
+			outOfTime = std::chrono::steady_clock::now() >= deadline;
+		}
+	}
+}
+
+void ResourceLoadQueue::construct(Request& request)
+{
+	try {
+		request.resource = resources.ofType(request.type).getUntyped(request.name, request.priority);
+	} catch (const std::exception& e) {
+		locator.discardPrefetched(request.name, request.type);
+		finish(request, e.what());
+		return;
+	}
+
+	// Data fetched for an asset that ended up being loaded some other way (e.g. streamed) would otherwise linger
+	locator.discardPrefetched(request.name, request.type);
+
+	addDependencies(*request.resource, request.priority, request.state);
+
+	const auto* async = dynamic_cast<const AsyncResource*>(request.resource.get());
+	if (async && !async->isLoaded()) {
+		waiting.push_back(std::move(request));
+	} else {
+		finish(request);
+	}
+}
+
+void ResourceLoadQueue::addDependencies(const Resource& resource, ResourceLoadPriority priority, const std::shared_ptr<ResourceLoadState>& state)
+{
+	for (const auto& [type, name]: resource.getDependencies()) {
+		if (resources.hasType(type) && locator.exists(name, type)) {
+			add(type, name, priority, state);
+		}
+	}
+}
+
+void ResourceLoadQueue::finish(Request& request, const String& error)
+{
+	auto& state = *request.state;
+	{
+		std::unique_lock<std::mutex> lock(state.mutex);
+		++state.loaded;
+		if (!error.isEmpty()) {
+			state.errors.push_back(toString(request.type) + ":" + request.name + ": " + error);
+		}
+	}
+	if (!error.isEmpty()) {
+		Logger::logError("Failed to preload " + toString(request.type) + ":" + request.name + ": " + error);
+	}
+
+	request.state.reset();
+	request.resource.reset();
+}
+
+void ResourceLoadQueue::updateWaiting()
+{
+	for (auto& request: waiting) {
+		const auto* async = dynamic_cast<const AsyncResource*>(request.resource.get());
+		if (async->isLoaded()) {
+			finish(request, async->hasFailed() ? "Resource failed to load." : "");
+		} else if (request.state->cancelled) {
+			request.state.reset();
+			request.resource.reset();
+		}
+	}
+	waiting.erase(std::remove_if(waiting.begin(), waiting.end(), [] (const Request& r) { return !r.state; }), waiting.end());
+}
@@ -2,6 +2,7 @@
 #include "resources/resource_locator.h"
 #include <halley/support/exception.h>
 #include "resource_pack.h"
+#include "halley/file/memory_mapped_file.h"
 #include "halley/support/logger.h"
 #include "api/system_api.h"
 #include "halley/text/string_converter.h"
@@ -9,6 +10,11 @@
 
 using namespace Halley;
 
+std::vector<String> IResourceLocatorProvider::getAssets()
+{
+	return getAssetDatabase().getAssets();
+}
+
 ResourceLocator::ResourceLocator(SystemAPI& system)
 	: system(system)
 {
@@ -23,8 +29,7 @@ void ResourceLocator::add(std::unique_ptr<IResourceLocatorProvider> locator, con
 
 void ResourceLocator::loadLocatorData(IResourceLocatorProvider& locator)
 {
-	auto& db = locator.getAssetDatabase();
-	for (auto& asset: db.getAssets()) {
+	for (auto& asset: locator.getAssets()) {
 		auto result = assetToLocator.find(asset);
 		if (result == assetToLocator.end() || result->second->getPriority() < locator.getPriority()) {
 			assetToLocator[asset] = &locator;
@@ -34,6 +39,8 @@ void ResourceLocator::loadLocatorData(IResourceLocatorProvider& locator)
 
 void ResourceLocator::purge(const String& asset, AssetType type)
 {
+	clearPrefetched();
+
 	auto result = assetToLocator.find(toString(type) + ":" + asset);
 	if (result != assetToLocator.end()) {
 		// Found the locator for this file, purge it
@@ -46,6 +53,7 @@ void ResourceLocator::purge(const String& asset, AssetType type)
 
 void ResourceLocator::purgeAll()
 {
+	clearPrefetched();
 	assetToLocator.clear();
 	for (auto& locator: locators) {
 		locator->purge(system);
@@ -72,8 +80,54 @@ std::unique_ptr<ResourceData> ResourceLocator::getResource(const String& asset,
 	}
 }
 
+void ResourceLocator::prefetch(const String& asset, AssetType type)
+{
+	auto key = toString(type) + ":" + asset;
+	{
+		std::unique_lock<std::mutex> lock(prefetchMutex);
+		if (prefetched.find(key) != prefetched.end()) {
+			return;
+		}
+	}
+
+	auto data = getResource(asset, type, false, false);
+	auto* staticData = dynamic_cast<ResourceDataStatic*>(data.get());
+	if (staticData) {
+		data.release();
+		std::unique_lock<std::mutex> lock(prefetchMutex);
+		prefetched[std::move(key)] = std::unique_ptr<ResourceDataStatic>(staticData);
+	}
+}
+
+void ResourceLocator::discardPrefetched(const String& asset, AssetType type)
+{
+	std::unique_lock<std::mutex> lock(prefetchMutex);
+	if (!prefetched.empty()) {
+		prefetched.erase(toString(type) + ":" + asset);
+	}
+}
+
+void ResourceLocator::clearPrefetched()
+{
+	// Prefetched data might be a view into a pack that is about to go away
+	std::unique_lock<std::mutex> lock(prefetchMutex);
+	prefetched.clear();
+}
+
 std::unique_ptr<ResourceDataStatic> ResourceLocator::getStatic(const String& asset, AssetType type, bool throwOnFail)
 {
+	{
+		std::unique_lock<std::mutex> lock(prefetchMutex);
+		if (!prefetched.empty()) {
+			const auto iter = prefetched.find(toString(type) + ":" + asset);
+			if (iter != prefetched.end()) {
+				auto result = std::move(iter->second);
+				prefetched.erase(iter);
+				return result;
+			}
+		}
+	}
+
 	auto rawPtr = getResource(asset, type, false, throwOnFail).release();
 	if (!rawPtr) {
 		return std::unique_ptr<ResourceDataStatic>();
@@ -118,8 +172,17 @@ void ResourceLocator::addFileSystem(const Path& path)
 	add(std::make_unique<FileSystemResourceLocator>(system, path), path);
 }
 
-void ResourceLocator::addPack(const Path& path, const String& encryptionKey, bool preLoad, bool allowFailure, std::optional<int> priority)
+void ResourceLocator::addPack(const Path& path, const String& encryptionKey, bool preLoad, bool allowFailure, std::optional<int> priority, bool memoryMap)
 {
+	if (memoryMap) {
+		auto mapping = std::make_unique<MemoryMappedFile>();
+		if (mapping->open(path)) {
+			add(std::make_unique<PackResourceLocator>(std::move(mapping), path, encryptionKey, preLoad, priority), path);
+			return;
+		}
+		// Not a file we can map (e.g. packed inside an APK), go through the system reader instead
+	}
+
 	auto dataReader = system.getDataReader(path.string());
 	if (dataReader) {
 		auto resourceLocator = std::make_unique<PackResourceLocator>(std::move(dataReader), path, encryptionKey, preLoad, priority);
@@ -136,9 +199,10 @@ void ResourceLocator::addPack(const Path& path, const String& encryptionKey, boo
 
 void ResourceLocator::removePack(const Path& path)
 {
+	clearPrefetched();
+
 	auto* locatorToRemove = locatorPaths.find(path.getString())->second;
-	auto& dbToRemove = locatorToRemove->getAssetDatabase();
-	for (auto& asset : dbToRemove.getAssets()) {
+	for (auto& asset : locatorToRemove->getAssets()) {
 		auto result = assetToLocator.find(asset);
 		if (result != assetToLocator.end()) {
 			assetToLocator.erase(asset);
@@ -149,8 +213,7 @@ void ResourceLocator::removePack(const Path& path)
 	
 	for (const auto& locator : locators)
 	{
-		auto& db = locator->getAssetDatabase();
-		for (auto& asset : db.getAssets()) {
+		for (auto& asset : locator->getAssets()) {
 			auto result = assetToLocator.find(asset);
 			if (result == assetToLocator.end() || result->second->getPriority() < locator->getPriority()) {
 				assetToLocator[asset] = locator.get();
@@ -164,8 +227,7 @@ std::vector<String> ResourceLocator::getAssetsFromPack(const Path& path, const S
 	auto dataReader = system.getDataReader(path.string());
 	if (dataReader) {
 		std::unique_ptr<IResourceLocatorProvider> resourceLocator = std::make_unique<PackResourceLocator>(std::move(dataReader), path, "", true);
-		auto& db = resourceLocator->getAssetDatabase();
-		return db.getAssets();
+		return resourceLocator->getAssets();
 	}
 	else {
 		throw Exception("Unable to load resource pack \"" + path.string() + "\"", HalleyExceptions::Resources);
@@ -2,6 +2,8 @@
 #include <utility>
 #include "resources/asset_pack.h"
 #include "api/system_api.h"
+#include "halley/resources/resource.h"
+#include "halley/file/memory_mapped_file.h"
 using namespace Halley;
 
 PackResourceLocator::PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String key, bool preLoad, std::optional<int> priority)
@@ -13,6 +15,16 @@ PackResourceLocator::PackResourceLocator(std::unique_ptr<ResourceDataReader> rea
 	assetPack = std::make_unique<AssetPack>(std::move(reader), encryptionKey, preLoad);
 }
 
+PackResourceLocator::PackResourceLocator(std::unique_ptr<MemoryMappedFile> mapping, Path path, String key, bool preLoad, std::optional<int> priority)
+	: path(std::move(path))
+	, encryptionKey(std::move(key))
+	, preLoad(preLoad)
+	, memoryMapped(true)
+	, priority(priority)
+{
+	assetPack = std::make_unique<AssetPack>(std::move(mapping), encryptionKey, preLoad);
+}
+
 PackResourceLocator::~PackResourceLocator()
 {
 }
@@ -33,6 +45,22 @@ const AssetDatabase& PackResourceLocator::getAssetDatabase()
 	return assetPack->getAssetDatabase();
 }
 
+std::vector<String> PackResourceLocator::getAssets()
+{
+	if (!assetPack) {
+		loadAfterPurge();
+	}
+
+	// Served from the pack index, so the asset database doesn't need decoding until metadata is requested
+	const auto& index = assetPack->getIndex();
+	std::vector<String> result;
+	result.reserve(index.getEntries().size());
+	for (const auto& entry: index.getEntries()) {
+		result.push_back(toString(AssetType(entry.type)) + ":" + String(index.getName(entry)));
+	}
+	return result;
+}
+
 void PackResourceLocator::purge(SystemAPI& sys)
 {
 	assetPack.reset();
@@ -41,6 +69,13 @@ void PackResourceLocator::purge(SystemAPI& sys)
 
 void PackResourceLocator::loadAfterPurge()
 {
+	if (memoryMapped) {
+		auto mapping = std::make_unique<MemoryMappedFile>();
+		if (mapping->open(path)) {
+			assetPack = std::make_unique<AssetPack>(std::move(mapping), encryptionKey, preLoad);
+			return;
+		}
+	}
 	assetPack = std::make_unique<AssetPack>(system->getDataReader(path.string()), encryptionKey, preLoad);
 }
 
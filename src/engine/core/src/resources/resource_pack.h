@@ -6,15 +6,18 @@
 namespace Halley {
 	class SystemAPI;
 	class AssetPack;
+	class MemoryMappedFile;
 
 	class PackResourceLocator final : public IResourceLocatorProvider {
 	public:
 		explicit PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String encryptionKey = "", bool preLoad = false, std::optional<int> priority = {});
+		explicit PackResourceLocator(std::unique_ptr<MemoryMappedFile> mapping, Path path, String encryptionKey = "", bool preLoad = false, std::optional<int> priority = {});
 		~PackResourceLocator();
 
 	protected:
 		std::unique_ptr<ResourceData> getData(const String& asset, AssetType type, bool stream) override;
 		const AssetDatabase& getAssetDatabase() override;
+		std::vector<String> getAssets() override;
 		void purge(SystemAPI& system) override;
 		int getPriority() const override;
 		
@@ -26,6 +29,7 @@ namespace Halley {
 		Path path;
 		String encryptionKey; // :(
 		bool preLoad;
+		bool memoryMapped = false;
 		std::optional<int> priority;
 		SystemAPI* system = nullptr;
 	};
@@ -10,6 +10,17 @@ Resources::Resources(std::unique_ptr<ResourceLocator> locator, const HalleyAPI&
 	, api(&api)
 	, options(options)
 {
+	loadQueue = std::make_unique<ResourceLoadQueue>(*this, *this->locator);
+}
+
+ResourceLoadHandle Resources::preload(Vector<std::pair<AssetType, String>> assets, ResourceLoadPriority priority)
+{
+	return loadQueue->enqueue(std::move(assets), priority);
+}
+
+void Resources::update()
+{
+	loadQueue->update(options.preloadFrameBudget);
 }
 
 void Resources::reloadAssets(const std::vector<String>& ids)
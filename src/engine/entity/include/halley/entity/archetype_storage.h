@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include "family_mask.h"
+#include "type_deleter.h"
+#include <halley/data_structures/vector.h>
+#include <halley/data_structures/tree_map.h>
+
+namespace Halley {
+	class Component;
+	class Archetype;
+
+	struct ArchetypeSlot {
+		Archetype* archetype = nullptr;
+		uint32_t index = 0;
+
+		bool isValid() const { return archetype != nullptr; }
+	};
+
+	// An archetype holds every entity that has exactly the same set of components.
+	// Storage is split into fixed-size chunks, and inside each chunk every component type gets its own contiguous column (SoA),
+	// so a family iterating entities of the same archetype walks memory linearly instead of chasing one heap allocation per component.
+	// Slots are never compacted, so component addresses stay stable until the entity's component set changes.
+	class Archetype {
+	public:
+		Archetype(FamilyMaskType mask, const Vector<std::pair<int, Component*>>& components, const ComponentDeleterTable& table);
+		~Archetype();
+
+		Archetype(const Archetype& other) = delete;
+		Archetype& operator=(const Archetype& other) = delete;
+
+		FamilyMaskType getMask() const { return mask; }
+		size_t getEntityCount() const { return entityCount; }
+		size_t getChunkCount() const { return chunks.size(); }
+		size_t getChunkCapacity() const { return chunkCapacity; }
+
+		uint32_t allocSlot();
+		void freeSlot(uint32_t index);
+
+		void* getComponent(uint32_t index, int componentId) const;
+		bool owns(uint32_t index, int componentId, const void* ptr) const;
+
+	private:
+		struct Column {
+			int componentId;
+			size_t offset;
+			size_t stride;
+		};
+
+		constexpr static size_t chunkTargetSize = 16 * 1024;
+		constexpr static size_t chunkAlignment = 64;
+
+		FamilyMaskType mask;
+		Vector<Column> columns;
+		size_t chunkCapacity = 1;
+		size_t chunkBytes = 0;
+		Vector<std::unique_ptr<char[]>> chunkMemory;
+		Vector<char*> chunks;
+		Vector<uint32_t> freeSlots;
+		uint32_t nextSlot = 0;
+		size_t entityCount = 0;
+
+		const Column* getColumn(int componentId) const;
+		void addChunk();
+	};
+
+	class ArchetypeStorage {
+	public:
+		// Returns nullptr if the component set can't be stored in chunks (e.g. a component isn't move constructible)
+		Archetype* getArchetype(FamilyMaskType mask, const Vector<std::pair<int, Component*>>& components, const ComponentDeleterTable& table);
+
+		size_t getArchetypeCount() const;
+		size_t getEntityCount() const;
+
+	private:
+		TreeMap<FamilyMaskType, std::unique_ptr<Archetype>> archetypes;
+	};
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <type_traits>
+#include "entity.h"
+#include "halley/data_structures/memory_pool.h"
+
 namespace Halley {
     class ComponentReflector {
     public:
@@ -7,6 +11,12 @@ namespace Halley {
 
     	virtual const char* getName() const = 0;
     	virtual ConfigNode serialize(const ConfigNodeSerializationContext& context, const Component& component) const = 0;
+
+    	// Used to stamp out copies of prefab components, see EntityFactory::createEntities
+    	// Copies don't share mutable state (e.g. a sprite's private material) with the component they were made from
+    	virtual Component* clone(const Component& component) const = 0; // Returns nullptr if the component can't be copied
+    	virtual void destroy(Component* component) const = 0;
+    	virtual void addCopy(EntityRef& entity, const Component& component) const = 0;
     };
 
 	template <typename T>
@@ -21,5 +31,32 @@ namespace Halley {
 		{
 			return static_cast<const T&>(component).serialize(context);
 		}
+
+		Component* clone(const Component& component) const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>) {
+				auto* copy = new T(static_cast<const T&>(component));
+				copy->detachCopy();
+				return copy;
+			} else {
+				return nullptr;
+			}
+		}
+
+		void destroy(Component* component) const override
+		{
+			// Components come from the pool allocator (see Component::operator new), so they can't go through delete
+			static_cast<T*>(component)->~T();
+			PoolPool::getPool(sizeof(T))->free(component);
+		}
+
+		void addCopy(EntityRef& entity, const Component& component) const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>) {
+				T copy(static_cast<const T&>(component));
+				copy.detachCopy();
+				entity.addComponent<T>(std::move(copy));
+			}
+		}
 	};
 }
@@ -18,6 +18,10 @@ public:
 	explicit Transform2DComponent(Halley::Vector2f localPosition, Halley::Angle1f localRotation = {}, Halley::Vector2f localScale = Halley::Vector2f(1, 1), int subWorld = 0);
 	~Transform2DComponent();
 
+	// Copies only take the local transform, they're bound to an entity (and its hierarchy) once added to one
+	Transform2DComponent(const Transform2DComponent& other);
+	Transform2DComponent& operator=(const Transform2DComponent& other);
+
 	const Halley::Vector2f& getLocalPosition() const { return position; }
 	Halley::Vector2f& getLocalPosition() { return position; }
 	void setLocalPosition(Halley::Vector2f v);
@@ -2,6 +2,8 @@
 
 #include <memory>
 #include <functional>
+#include <utility>
+#include "halley/data_structures/vector.h"
 
 namespace Halley {
     class EntityFactoryContext;
@@ -9,6 +11,7 @@ namespace Halley {
 	class String;
 	class ConfigNode;
 	class System;
+	enum class AssetType;
 
 	class CreateComponentFunctionResult {
 	public:
@@ -18,10 +21,12 @@ namespace Halley {
 	
     using CreateComponentFunction = std::function<CreateComponentFunctionResult(const EntityFactoryContext& context, const String& componentName, EntityRef& entity, const ConfigNode& componentData)>;
     using CreateSystemFunction = std::function<std::unique_ptr<System>(String)>;
+	using GetComponentAssetDependenciesFunction = std::function<void(const String& componentName, const ConfigNode& componentData, Vector<std::pair<AssetType, String>>& result)>;
 
 	class CreateEntityFunctions {
 	public:
 		static CreateComponentFunction& getCreateComponent();
 		static CreateSystemFunction& getCreateSystem();
+		static GetComponentAssetDependenciesFunction& getComponentAssetDependencies();
 	};
 }
@@ -7,6 +7,7 @@
 #include "family_mask.h"
 #include "entity_id.h"
 #include "type_deleter.h"
+#include "archetype_storage.h"
 #include <halley/data_structures/vector.h>
 
 #include "prefab.h"
@@ -23,17 +24,6 @@ namespace Halley {
 	template <class, class = void_t<>> struct HasOnAddedToEntityMember : std::false_type {};
 	template <class T> struct HasOnAddedToEntityMember<T, decltype(std::declval<T&>().onAddedToEntity(std::declval<EntityRef&>()))> : std::true_type { };
 	
-	class MessageEntry
-	{
-	public:
-		std::unique_ptr<Message> msg;
-		int type = -1;
-		int age = -1;
-
-		MessageEntry() {}
-		MessageEntry(std::unique_ptr<Message> msg, int type, int age) : msg(std::move(msg)), type(type), age(age) {}
-	};
-
 	class EntityRef;
 	class ConstEntityRef;
 
@@ -157,7 +147,6 @@ namespace Halley {
 		Vector<Entity*> children; // Cacheline 1 starts 16 bytes into this
 
 		// Cacheline 1
-		Vector<MessageEntry> inbox;
 		String name;
 
 		// Cacheline 2
@@ -167,6 +156,8 @@ namespace Halley {
 
 		uint8_t hierarchyRevision = 0;
 
+		ArchetypeSlot archetypeSlot;
+
 		Entity();
 		void destroyComponents(ComponentDeleterTable& storage);
 
@@ -5,6 +5,7 @@
 #include "prefab.h"
 #include "halley/file_formats/config_file.h"
 #include "halley/data_structures/maybe.h"
+#include "halley/data_structures/hash_map.h"
 #include "halley/entity/entity.h"
 
 namespace Halley {
@@ -39,6 +40,12 @@ namespace Halley {
 		
 		EntityRef createEntity(const String& prefabName);
 		EntityRef createEntity(const EntityData& data, EntityRef parent = EntityRef(), EntityScene* scene = nullptr);
+
+		// Spawns count instances of a prefab in one go.
+		// The first instance ever spawned goes through the regular path, and its components are kept as a blueprint that later instances are
+		// copied from, skipping ConfigNode deserialization altogether. Prefabs whose components can't be copied, or that reference other
+		// entities by UUID, are instantiated one by one instead.
+		Vector<EntityRef> createEntities(const String& prefabName, size_t count, EntityRef parent = EntityRef(), EntityScene* scene = nullptr);
 		EntityScene createScene(const std::shared_ptr<const Prefab>& scene, bool allowReload, uint8_t worldPartition = 0);
 
 		void updateEntity(EntityRef& entity, const IEntityData& data, int serializationMask, EntityScene* scene = nullptr);
@@ -48,8 +55,12 @@ namespace Halley {
 		std::shared_ptr<EntityFactoryContext> makeStandaloneContext();
 
 	private:
+		struct BlueprintNode;
+		struct Blueprint;
+
 		World& world;
 		Resources& resources;
+		HashMap<const Prefab*, std::unique_ptr<Blueprint>> blueprints;
 
 		void updateEntityNode(const IEntityData& iData, EntityRef entity, std::optional<EntityRef> parent, const std::shared_ptr<EntityFactoryContext>& context);
 		void updateEntityComponents(EntityRef entity, const EntityData& data, const EntityFactoryContext& context);
@@ -65,6 +76,11 @@ namespace Halley {
 		void preInstantiateEntities(const IEntityData& data, EntityFactoryContext& context, int depth);
 		void collectExistingEntities(EntityRef entity, EntityFactoryContext& context);
 
+		EntityRef doCreateEntity(const EntityData& data, EntityRef parent, EntityScene* scene, bool& resolvedEntityIds);
+		const Blueprint& getBlueprint(const std::shared_ptr<const Prefab>& prefab, EntityRef parent, EntityScene* scene, Vector<EntityRef>& created);
+		void makeBlueprintNode(BlueprintNode& node, EntityRef entity, const std::shared_ptr<const Prefab>& parentPrefab, bool& canCopy) const;
+		EntityRef instantiateBlueprint(const BlueprintNode& node, const UUID& uuid, const UUID& rootUUID, EntityRef parent, EntityScene* scene, uint8_t worldPartition);
+
 		[[nodiscard]] std::shared_ptr<const Prefab> getPrefab(const String& id) const;
 		[[nodiscard]] std::shared_ptr<const Prefab> getPrefab(std::optional<EntityRef> entity, const IEntityData& data) const;
 	};
@@ -102,6 +118,7 @@ namespace Halley {
 		EntityId getEntityIdFromUUID(const UUID& uuid) const;
 
 		void addEntity(EntityRef entity);
+		bool hasResolvedEntityIds() const;
 		void notifyEntity(const EntityRef& entity) const;
 		EntityRef getEntity(const UUID& uuid, bool allowPrefabUUID, bool allowWorldLookup) const;
 
@@ -121,6 +138,7 @@ namespace Halley {
 		EntityFactoryContext* parent;
 		std::vector<EntityRef> entities;
 		bool update = false;
+		mutable bool resolvedEntityIds = false;
 		uint8_t worldPartition = 0;
 
 		const IEntityData* entityData = nullptr;
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <mutex>
+#include <optional>
 #include <gsl/gsl_assert>
 #include "family_type.h"
 #include "family_mask.h"
 #include "entity_id.h"
 #include "halley/data_structures/nullable_reference.h"
+#include "halley/data_structures/hash_map.h"
 #include "halley/support/exception.h"
 #include "halley/support/debug.h"
 #include "halley/utils/utils.h"
@@ -42,6 +45,9 @@ namespace Halley {
 		void notifyRemove(void* entities, size_t count);
 		void notifyReload(void* entities, size_t count);
 
+		// Index of the entity's element, if it's in this family. The lookup table is rebuilt lazily after the family changes.
+		std::optional<size_t> findIndex(EntityId id) const;
+
 	protected:
 		virtual void addEntity(Entity& entity) = 0;
 		virtual void refreshEntity(Entity& entity) = 0;
@@ -60,9 +66,14 @@ namespace Halley {
 		Vector<FamilyBindingBase*> removeEntityCallbacks;
 		Vector<FamilyBindingBase*> modifiedEntityCallbacks;
 
+		mutable bool indexDirty = true;
+
 	private:
 		FamilyMaskType inclusionMask;
 		FamilyMaskType optionalMask;
+
+		mutable std::mutex indexMutex;
+		mutable HashMap<EntityId, size_t> index;
 	};
 
 	class FamilyBase {
@@ -182,6 +193,7 @@ namespace Halley {
 			elems = entities.empty() ? nullptr : entities.data();
 			elemCount = entities.size();
 			elemSize = sizeof(StorageType);
+			indexDirty = true;
 		}
 
 		void removeDeadEntities()
@@ -88,6 +88,13 @@ namespace Halley {
 
 		
 
+		template <typename T>
+		struct IsReadOnly : std::is_const<T> {};
+
+		template <typename T>
+		struct IsReadOnly<MaybeRef<T>> : std::is_const<T> {};
+
+
 		template <typename... Ts>
 		struct MutableEvaluator;
 
@@ -101,10 +108,10 @@ namespace Halley {
 		template <typename T, typename... Ts>
 		struct MutableEvaluator <T, Ts...> {
 			constexpr static void makeMask(RealType& mask) {
-				if constexpr (!std::is_const<T>::value) {
+				if constexpr (!IsReadOnly<T>::value) {
 					FamilyMask::setBit(mask, RetrieveComponentIndex<T>::componentIndex);
 				}
-				Evaluator<Ts...>::makeMask(mask);
+				MutableEvaluator<Ts...>::makeMask(mask);
 			}
 
 			constexpr static HandleType getMask(MaskStorage& storage) {
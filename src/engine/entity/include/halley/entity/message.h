@@ -2,6 +2,9 @@
 
 #include <new>
 #include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <halley/data_structures/vector.h>
 
 namespace Halley
 {
@@ -10,10 +13,49 @@ namespace Halley
 	public:
 		virtual ~Message() {}
 		virtual size_t getSize() const = 0;
+	};
+
+	// Owns the messages sent by a system between two purges.
+	// Each message type gets its own pool of fixed-size slots, which are all destroyed and handed out again on reset(),
+	// so a system sending the same messages every frame stops allocating after the first few frames.
+	class MessageArena
+	{
+	public:
+		MessageArena() = default;
+		MessageArena(const MessageArena& other) = delete;
+		MessageArena(MessageArena&& other) = default;
+		~MessageArena();
+
+		MessageArena& operator=(const MessageArena& other) = delete;
+		MessageArena& operator=(MessageArena&& other) = default;
+
+		template <typename T>
+		T* make(T msg)
+		{
+			static_assert(std::is_base_of_v<Message, T>, "T must derive from Message");
+			static_assert(alignof(T) <= alignof(std::max_align_t), "Message type is over-aligned");
+
+			void* slot = allocate(T::messageIndex, sizeof(T));
+			T* result = ::new (slot) T(std::move(msg));
+			pools[T::messageIndex].live.push_back(result);
+			return result;
+		}
+
+		void reset();
+		bool empty() const;
+
+	private:
+		constexpr static size_t slotsPerBlock = 32;
+
+		struct TypePool {
+			size_t slotSize = 0;
+			size_t used = 0;
+			Vector<std::unique_ptr<std::byte[]>> blocks;
+			Vector<Message*> live;
+		};
+
+		Vector<TypePool> pools;
 
-		/*
-		void* operator new(size_t size);
-		void operator delete(void* ptr);
-		*/
+		void* allocate(int msgType, size_t size);
 	};
 }
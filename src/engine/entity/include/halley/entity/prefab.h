@@ -45,6 +45,8 @@ namespace Halley {
 
 		virtual std::shared_ptr<Prefab> clone() const;
 
+		Vector<std::pair<AssetType, String>> getDependencies() const override;
+
 	protected:
 		struct Deltas {
 			std::map<UUID, EntityDataDelta> entitiesModified;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <utility>
+#include "halley/data_structures/vector.h"
 
 namespace Halley {
     class System;
@@ -9,8 +11,10 @@ namespace Halley {
     class CreateComponentFunctionResult;
 	class ComponentReflector;
 	class EntityFactoryContext;
+	enum class AssetType;
 
 	std::unique_ptr<System> createSystem(String name);
 	CreateComponentFunctionResult createComponent(const EntityFactoryContext& context, const String& name, EntityRef& entity, const ConfigNode& componentData);
 	ComponentReflector& getComponentReflector(int componentId);
+	void getComponentAssetDependencies(const String& name, const ConfigNode& componentData, Vector<std::pair<AssetType, String>>& result);
 }
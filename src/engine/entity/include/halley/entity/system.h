@@ -37,7 +37,7 @@ namespace Halley {
 	class System
 	{
 	public:
-		System(Vector<FamilyBindingBase*> families, Vector<int> messageTypesReceived);
+		System(Vector<FamilyBindingBase*> families, Vector<int> messageTypesReceived, Vector<int> messageTypesSent = {}, bool canRunConcurrently = false);
 		virtual ~System() {}
 
 		const String& getName() const { return name; }
@@ -51,6 +51,12 @@ namespace Halley {
 		void processSystemMessages();
 		size_t getSystemMessagesInInbox() const;
 
+		// Systems that only touch their own families can be updated alongside others, see SystemScheduler
+		bool canRunConcurrently() const { return concurrent; }
+		void getComponentAccess(MaskStorage& storage, FamilyMask::RealType& read, FamilyMask::RealType& write) const;
+		const Vector<int>& getMessageTypesReceived() const { return messageTypesReceived; }
+		const Vector<int>& getMessageTypesSent() const { return messageTypesSent; }
+
 	protected:
 		const HalleyAPI& doGetAPI() const { return *api; }
 		World& doGetWorld() const { return *world; }
@@ -82,9 +88,7 @@ namespace Halley {
 		template <typename T>
 		void sendMessageGeneric(EntityId entityId, T msg)
 		{
-			auto toSend = std::make_unique<T>();
-			*toSend = std::move(msg);
-			doSendMessage(entityId, std::move(toSend), T::messageIndex);
+			doSendMessage(entityId, messageArena.make<T>(std::move(msg)), T::messageIndex);
 		}
 
 		template <typename T, typename R, typename F>
@@ -170,11 +174,31 @@ namespace Halley {
 
 	private:
 		friend class World;
+		friend class SystemScheduler;
+
+		struct OutgoingMessage {
+			EntityId target;
+			Message* msg;
+			int type;
+		};
+
+		struct IncomingMessage {
+			EntityId target;
+			Message* msg;
+			const System* sender;
+		};
 
 		Vector<FamilyBindingBase*> families;
 		Vector<int> messageTypesReceived;
-		Vector<EntityId> messagesSentTo;
-		Vector<std::pair<EntityId, MessageEntry>> outbox;
+		Vector<int> messageTypesSent;
+
+		// Messages sent live in the arena until this system's next purge, and are queued directly on each system that receives their type
+		MessageArena messageArena;
+		Vector<OutgoingMessage> outbox;
+		Vector<System*> messagesSentTo;
+		Vector<Vector<IncomingMessage>> inboxes; // One per entry in messageTypesReceived
+		Vector<Message*> receivedMessages;
+		Vector<size_t> receivedIndices;
 		Vector<const SystemMessageContext*> systemMessageInbox;
 		Vector<const SystemMessageContext*> systemMessages;
 
@@ -184,14 +208,19 @@ namespace Halley {
 		String name;
 		int systemId = -1;
 		bool initialised = false;
+		bool concurrent = false;
 
 		void doUpdate(Time time);
+		void runUpdate(Time time);
 		void doRender(RenderContext& rc);
 		void onAddedToWorld(World& world, int id);
 
 		void purgeMessages();
 		void processMessages();
-		void doSendMessage(EntityId target, std::unique_ptr<Message> msg, int msgId);
+		void doSendMessage(EntityId target, Message* msg, int msgId);
+		void receiveMessage(int msgId, EntityId target, Message* msg, const System& sender);
+		void dropMessagesFrom(const System& sender);
+		void forgetReceiver(const System& receiver);
 		size_t doSendSystemMessage(SystemMessageContext context, const String& targetSystem);
 		void dispatchMessages();
 	};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <halley/data_structures/vector.h>
+#include <halley/time/halleytime.h>
+#include <memory>
+#include "family_mask.h"
+
+namespace Halley {
+	class System;
+	class World;
+
+	// Splits the systems of a timeline into waves, where no two systems in the same wave touch the same components
+	// (unless both only read them) or exchange entity messages. Systems inside a wave are updated in parallel on the CPU executors,
+	// waves run in order, and messages are dispatched in timeline order at the end of each wave so the outcome doesn't depend on thread timing.
+	class SystemScheduler {
+	public:
+		void setDirty();
+		void update(World& world, Vector<std::unique_ptr<System>>& systems, Time elapsed);
+
+		size_t getNumWaves() const { return waves.size(); }
+
+	private:
+		struct Access {
+			FamilyMask::RealType read;
+			FamilyMask::RealType write;
+		};
+
+		Vector<Vector<System*>> waves;
+		bool dirty = true;
+
+		void buildWaves(World& world, Vector<std::unique_ptr<System>>& systems);
+		void runWave(const Vector<System*>& wave, Time elapsed);
+
+		static bool conflicts(const System& a, const Access& accessA, const System& b, const Access& accessB);
+		static bool sendsTo(const System& from, const System& to);
+	};
+}
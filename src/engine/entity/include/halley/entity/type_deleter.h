@@ -1,5 +1,7 @@
 #pragma once
 
+#include <new>
+#include <type_traits>
 #include <halley/data_structures/vector.h>
 
 namespace Halley {
@@ -8,7 +10,12 @@ namespace Halley {
 	public:
 		virtual ~TypeDeleterBase() {}
 		virtual size_t getSize() = 0;
+		virtual size_t getAlignment() = 0;
 		virtual void callDestructor(void* ptr) = 0;
+
+		// Used by chunked component storage to move components between archetypes
+		virtual bool isRelocatable() = 0;
+		virtual void moveConstruct(void* dst, void* src) = 0;
 	};
 
 	class ComponentDeleterTable
@@ -52,6 +59,11 @@ namespace Halley {
 			return sizeof(T);
 		}
 
+		size_t getAlignment() override
+		{
+			return alignof(T);
+		}
+
 		void callDestructor(void* ptr) override
 		{
 #ifdef _MSC_VER
@@ -59,5 +71,17 @@ namespace Halley {
 #endif
 			static_cast<T*>(ptr)->~T();
 		}
+
+		bool isRelocatable() override
+		{
+			return std::is_move_constructible_v<T>;
+		}
+
+		void moveConstruct(void* dst, void* src) override
+		{
+			if constexpr (std::is_move_constructible_v<T>) {
+				::new (dst) T(std::move(*static_cast<T*>(src)));
+			}
+		}
 	};
 }
@@ -6,6 +6,8 @@
 #include "entity_id.h"
 #include "family_mask.h"
 #include "family.h"
+#include "archetype_storage.h"
+#include "system_scheduler.h"
 #include <halley/time/halleytime.h>
 #include <halley/text/halleystring.h>
 #include <halley/data_structures/mapped_pool.h>
@@ -76,6 +78,8 @@ namespace Halley {
 		EntityRef createEntity(String name, EntityId parentId);
 		EntityRef createEntity(UUID uuid, String name, EntityId parentId);
 		EntityRef createEntity(UUID uuid, String name = "", std::optional<EntityRef> parent = {}, uint8_t worldPartition = 0);
+		// Makes room for count more entities to be created before the next spawnPending()
+		void reserveEntities(size_t count);
 
 		void destroyEntity(EntityId id);
 		void destroyEntity(EntityRef entity);
@@ -121,20 +125,36 @@ namespace Halley {
 		ComponentDeleterTable& getComponentDeleterTable();
 
 		size_t sendSystemMessage(SystemMessageContext context, const String& targetSystem);
+		const Vector<System*>& getMessageReceivers(int msgType);
 
 		bool isDevMode() const;
 
 		void setEditor(bool isEditor);
 		bool isEditor() const;
 
+		// Opt-in: stores components of entities with the same component set in contiguous chunks, instead of one heap allocation each
+		// Components get moved whenever an entity's component set changes, so don't hold on to component pointers outside of families
+		// Families still keep one pointer per component for each entity (refreshed on moves), they don't get their own copy of the data
+		void setChunkedComponentStorage(bool enabled);
+		bool hasChunkedComponentStorage() const;
+		const ArchetypeStorage* getArchetypeStorage() const;
+
+		// Opt-in: update systems that don't conflict on component access in parallel, see SystemScheduler
+		// Only systems declared with "concurrent: true" in their schema take part, the others run on their own
+		void setParallelSystemUpdate(bool enabled);
+		bool hasParallelSystemUpdate() const;
+
 	private:
 		const HalleyAPI& api;
 		Resources& resources;
 		std::array<Vector<std::unique_ptr<System>>, static_cast<int>(TimeLine::NUMBER_OF_TIMELINES)> systems;
+		std::array<SystemScheduler, static_cast<int>(TimeLine::NUMBER_OF_TIMELINES)> systemSchedulers;
 		CreateComponentFunction createComponent;
 		bool entityDirty = false;
 		bool entityReloaded = false;
 		bool editor = false;
+		bool chunkedStorage = false;
+		bool parallelSystemUpdate = false;
 		
 		Vector<Entity*> entities;
 		Vector<Entity*> entitiesPendingCreation;
@@ -150,9 +170,13 @@ namespace Halley {
 		std::shared_ptr<MaskStorage> maskStorage;
 		std::shared_ptr<ComponentDeleterTable> componentDeleterTable;
 		std::shared_ptr<PoolAllocator<Entity>> entityPool;
+		std::unique_ptr<ArchetypeStorage> archetypeStorage;
 
 		std::list<SystemMessageContext> pendingSystemMessages;
 
+		Vector<Vector<System*>> messageReceivers;
+		bool messageReceiversDirty = true;
+
 		void allocateEntity(Entity* entity);
 		void updateEntities();
 		void initSystems(gsl::span<const TimeLine> timelines);
@@ -160,6 +184,7 @@ namespace Halley {
 		void doDestroyEntity(EntityId id);
 		void doDestroyEntity(Entity* entity);
 		void deleteEntity(Entity* entity);
+		bool relocateComponents(Entity& entity);
 
 		void updateSystems(TimeLine timeline, Time elapsed);
 		void renderSystems(RenderContext& rc) const;
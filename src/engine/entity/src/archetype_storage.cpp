@@ -0,0 +1,148 @@
+#include "archetype_storage.h"
+#include <algorithm>
+#include <functional>
+#include <gsl/gsl_assert>
+#include "halley/utils/utils.h"
+
+using namespace Halley;
+
+Archetype::Archetype(FamilyMaskType mask, const Vector<std::pair<int, Component*>>& components, const ComponentDeleterTable& table)
+	: mask(mask)
+{
+	struct ColumnType {
+		int componentId;
+		size_t size;
+		size_t alignment;
+	};
+
+	Vector<ColumnType> types;
+	types.reserve(components.size());
+	size_t rowSize = 0;
+	for (const auto& c: components) {
+		auto* deleter = table.get(c.first);
+		types.push_back(ColumnType{ c.first, deleter->getSize(), deleter->getAlignment() });
+		rowSize += alignUp(deleter->getSize(), deleter->getAlignment());
+	}
+	std::sort(types.begin(), types.end(), [] (const ColumnType& a, const ColumnType& b) { return a.componentId < b.componentId; });
+
+	// Pick as many entities per chunk as fit the target size, then lay out each column back to back
+	chunkCapacity = std::max(size_t(1), chunkTargetSize / std::max(size_t(1), rowSize));
+	size_t offset = 0;
+	columns.reserve(types.size());
+	for (const auto& t: types) {
+		const size_t stride = alignUp(t.size, t.alignment);
+		offset = alignUp(offset, t.alignment);
+		columns.push_back(Column{ t.componentId, offset, stride });
+		offset += stride * chunkCapacity;
+	}
+	chunkBytes = std::max(offset, size_t(1));
+}
+
+// Components are destroyed by their owning entities, this only releases memory
+Archetype::~Archetype() = default;
+
+uint32_t Archetype::allocSlot()
+{
+	++entityCount;
+
+	if (!freeSlots.empty()) {
+		// Always reuse the lowest slot, to keep live entities packed towards the start of the chunks
+		std::pop_heap(freeSlots.begin(), freeSlots.end(), std::greater<>());
+		const auto index = freeSlots.back();
+		freeSlots.pop_back();
+		return index;
+	}
+
+	if (nextSlot == chunks.size() * chunkCapacity) {
+		addChunk();
+	}
+	return nextSlot++;
+}
+
+void Archetype::freeSlot(uint32_t index)
+{
+	Expects(index < nextSlot);
+	Expects(entityCount > 0);
+
+	--entityCount;
+	freeSlots.push_back(index);
+	std::push_heap(freeSlots.begin(), freeSlots.end(), std::greater<>());
+}
+
+void* Archetype::getComponent(uint32_t index, int componentId) const
+{
+	const auto* column = getColumn(componentId);
+	if (!column) {
+		return nullptr;
+	}
+
+	const size_t chunkIdx = index / chunkCapacity;
+	const size_t localIdx = index % chunkCapacity;
+	return chunks[chunkIdx] + column->offset + localIdx * column->stride;
+}
+
+bool Archetype::owns(uint32_t index, int componentId, const void* ptr) const
+{
+	return ptr != nullptr && getComponent(index, componentId) == ptr;
+}
+
+const Archetype::Column* Archetype::getColumn(int componentId) const
+{
+	for (const auto& c: columns) {
+		if (c.componentId == componentId) {
+			return &c;
+		}
+	}
+	return nullptr;
+}
+
+void Archetype::addChunk()
+{
+	auto& memory = chunkMemory.emplace_back(new char[chunkBytes + chunkAlignment]);
+	const auto base = reinterpret_cast<size_t>(memory.get());
+	chunks.push_back(memory.get() + (alignUp(base, chunkAlignment) - base));
+}
+
+Archetype* ArchetypeStorage::getArchetype(FamilyMaskType mask, const Vector<std::pair<int, Component*>>& components, const ComponentDeleterTable& table)
+{
+	const auto iter = archetypes.find(mask);
+	if (iter != archetypes.end()) {
+		return iter->second.get();
+	}
+
+	bool canChunk = !components.empty();
+	for (const auto& c: components) {
+		if (!table.get(c.first)->isRelocatable()) {
+			canChunk = false;
+			break;
+		}
+	}
+
+	auto& result = archetypes[mask];
+	if (canChunk) {
+		result = std::make_unique<Archetype>(mask, components, table);
+	}
+	return result.get();
+}
+
+size_t ArchetypeStorage::getArchetypeCount() const
+{
+	size_t n = 0;
+	for (const auto& a: archetypes) {
+		if (a.second) {
+			++n;
+		}
+	}
+	return n;
+}
+
+size_t ArchetypeStorage::getEntityCount() const
+{
+	size_t n = 0;
+	for (const auto& a: archetypes) {
+		if (a.second) {
+			n += a.second->getEntityCount();
+		}
+	}
+	return n;
+}
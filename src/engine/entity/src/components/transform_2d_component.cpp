@@ -19,6 +19,20 @@ Transform2DComponent::~Transform2DComponent()
 	}
 }
 
+Transform2DComponent::Transform2DComponent(const Transform2DComponent& other)
+	: Transform2DComponentBase(other)
+{
+}
+
+Transform2DComponent& Transform2DComponent::operator=(const Transform2DComponent& other)
+{
+	Transform2DComponentBase::operator=(other);
+	if (entity.isValid()) {
+		markDirty();
+	}
+	return *this;
+}
+
 void Transform2DComponent::onAddedToEntity(EntityRef& entity)
 {
 	this->entity = entity;
@@ -12,3 +12,9 @@ CreateSystemFunction& CreateEntityFunctions::getCreateSystem()
 	static CreateSystemFunction f;
 	return f;
 }
+
+GetComponentAssetDependenciesFunction& CreateEntityFunctions::getComponentAssetDependencies()
+{
+	static GetComponentAssetDependenciesFunction f;
+	return f;
+}
@@ -26,6 +26,11 @@ void Entity::destroyComponents(ComponentDeleterTable& table)
 	}
 	components.clear();
 	liveComponents = 0;
+
+	if (archetypeSlot.isValid()) {
+		archetypeSlot.archetype->freeSlot(archetypeSlot.index);
+		archetypeSlot = ArchetypeSlot();
+	}
 }
 
 void Entity::removeComponentById(World& world, int id)
@@ -85,7 +90,11 @@ void Entity::deleteComponent(Component* component, int id, ComponentDeleterTable
 {
 	TypeDeleterBase* deleter = table.get(id);
 	deleter->callDestructor(component);
-	PoolPool::getPool(deleter->getSize())->free(component);
+
+	// Components living in an archetype chunk are owned by it, so only the destructor is called
+	if (!archetypeSlot.isValid() || !archetypeSlot.archetype->owns(archetypeSlot.index, id, component)) {
+		PoolPool::getPool(deleter->getSize())->free(component);
+	}
 }
 
 void Entity::keepOnlyComponentsWithIds(const std::vector<int>& ids, World& world)
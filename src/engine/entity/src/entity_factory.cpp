@@ -134,6 +134,10 @@ EntityFactoryContext::EntityFactoryContext(World& world, Resources& resources, i
 
 EntityId EntityFactoryContext::getEntityIdFromUUID(const UUID& uuid) const
 {
+	for (auto* c = this; c; c = c->parent) {
+		c->resolvedEntityIds = true;
+	}
+
 	const auto result = getEntity(uuid, true, true);
 	if (result.isValid()) {
 		return result.getEntityId();
@@ -169,6 +173,11 @@ EntityRef EntityFactoryContext::getEntity(const UUID& uuid, bool allowPrefabUUID
 	}
 }
 
+bool EntityFactoryContext::hasResolvedEntityIds() const
+{
+	return resolvedEntityIds;
+}
+
 bool EntityFactoryContext::needsNewContextFor(const EntityData& data) const
 {
 	const bool entityDataIsPrefabInstance = !data.getPrefab().isEmpty();
@@ -227,11 +236,166 @@ void EntityFactoryContext::notifyEntity(const EntityRef& entity) const
 }
 
 EntityRef EntityFactory::createEntity(const EntityData& data, EntityRef parent, EntityScene* scene)
+{
+	bool resolvedEntityIds;
+	return doCreateEntity(data, parent, scene, resolvedEntityIds);
+}
+
+EntityRef EntityFactory::doCreateEntity(const EntityData& data, EntityRef parent, EntityScene* scene, bool& resolvedEntityIds)
 {
 	const auto mask = makeMask(EntitySerialization::Type::Prefab, EntitySerialization::Type::SaveData);
 	const auto context = makeContext(data, {}, scene, false, mask);
 	const auto entity = tryGetEntity(data.getInstanceUUID(), *context, false);
 	updateEntityNode(context->getRootEntityData(), entity, parent, context);
+	resolvedEntityIds = context->hasResolvedEntityIds();
+	return entity;
+}
+
+struct EntityFactory::BlueprintNode {
+	String name;
+	bool selectable = true;
+	bool prefabRoot = false;
+	std::shared_ptr<const Prefab> prefab;
+	UUID prefabUUID;
+	Vector<std::pair<int, Component*>> components;
+	Vector<BlueprintNode> children;
+
+	BlueprintNode() = default;
+	BlueprintNode(const BlueprintNode& other) = delete;
+	BlueprintNode(BlueprintNode&& other) noexcept = default;
+	BlueprintNode& operator=(const BlueprintNode& other) = delete;
+	BlueprintNode& operator=(BlueprintNode&& other) noexcept = default;
+
+	~BlueprintNode()
+	{
+		for (auto& [id, component]: components) {
+			getComponentReflector(id).destroy(component);
+		}
+	}
+
+	size_t getEntityCount() const
+	{
+		size_t n = 1;
+		for (const auto& c: children) {
+			n += c.getEntityCount();
+		}
+		return n;
+	}
+};
+
+struct EntityFactory::Blueprint {
+	std::shared_ptr<const Prefab> prefab;
+	int assetVersion = 0;
+	bool canCopy = false;
+	size_t entityCount = 0;
+	BlueprintNode root;
+};
+
+Vector<EntityRef> EntityFactory::createEntities(const String& prefabName, size_t count, EntityRef parent, EntityScene* scene)
+{
+	Vector<EntityRef> result;
+	const auto prefab = getPrefab(prefabName);
+	if (!prefab || count == 0) {
+		return result;
+	}
+	if (prefab->isScene()) {
+		throw Exception("Can't spawn scene \"" + prefabName + "\" as entities, use createScene instead.", HalleyExceptions::Entity);
+	}
+
+	result.reserve(count);
+	const auto& blueprint = getBlueprint(prefab, parent, scene, result);
+	world.reserveEntities(blueprint.entityCount * (count - result.size()));
+
+	const uint8_t worldPartition = scene ? scene->getWorldPartition() : 0;
+	while (result.size() < count) {
+		if (blueprint.canCopy) {
+			const auto uuid = UUID::generate();
+			result.push_back(instantiateBlueprint(blueprint.root, uuid, uuid, parent, scene, worldPartition));
+		} else {
+			EntityData data(UUID::generate());
+			data.setPrefab(prefabName);
+			result.push_back(createEntity(data, parent, scene));
+		}
+	}
+
+	return result;
+}
+
+const EntityFactory::Blueprint& EntityFactory::getBlueprint(const std::shared_ptr<const Prefab>& prefab, EntityRef parent, EntityScene* scene, Vector<EntityRef>& created)
+{
+	auto& blueprint = blueprints[prefab.get()];
+	if (blueprint && blueprint->prefab == prefab && blueprint->assetVersion == prefab->getAssetVersion()) {
+		return *blueprint;
+	}
+
+	// Build a regular instance, and use it as the template
+	EntityData data(UUID::generate());
+	data.setPrefab(prefab->getAssetId());
+	bool resolvedEntityIds = false;
+	const auto entity = doCreateEntity(data, parent, scene, resolvedEntityIds);
+	created.push_back(entity);
+
+	blueprint = std::make_unique<Blueprint>();
+	blueprint->prefab = prefab;
+	blueprint->assetVersion = prefab->getAssetVersion();
+	blueprint->canCopy = !resolvedEntityIds;
+	if (blueprint->canCopy) {
+		makeBlueprintNode(blueprint->root, entity, {}, blueprint->canCopy);
+	}
+	blueprint->entityCount = blueprint->root.getEntityCount();
+
+	return *blueprint;
+}
+
+void EntityFactory::makeBlueprintNode(BlueprintNode& node, EntityRef entity, const std::shared_ptr<const Prefab>& parentPrefab, bool& canCopy) const
+{
+	node.name = entity.getName();
+	node.selectable = entity.isSelectable();
+	node.prefab = entity.getPrefab();
+	node.prefabUUID = entity.getPrefabUUID();
+	node.prefabRoot = node.prefab && node.prefab != parentPrefab;
+
+	for (auto [componentId, component]: entity) {
+		auto* copy = getComponentReflector(componentId).clone(*component);
+		if (!copy) {
+			canCopy = false;
+			return;
+		}
+		node.components.emplace_back(componentId, copy);
+	}
+
+	for (auto child: entity.getChildren()) {
+		makeBlueprintNode(node.children.emplace_back(), child, node.prefab, canCopy);
+		if (!canCopy) {
+			return;
+		}
+	}
+}
+
+EntityRef EntityFactory::instantiateBlueprint(const BlueprintNode& node, const UUID& uuid, const UUID& rootUUID, EntityRef parent, EntityScene* scene, uint8_t worldPartition)
+{
+	auto entity = world.createEntity(uuid, node.name, std::optional<EntityRef>(), worldPartition);
+	if (parent.isValid()) {
+		entity.setParent(parent);
+	}
+	entity.setSelectable(node.selectable);
+	if (node.prefabUUID.isValid()) {
+		entity.setPrefab(node.prefab, node.prefabUUID);
+	}
+	if (scene && node.prefabRoot) {
+		scene->addPrefabReference(node.prefab, entity);
+	}
+
+	for (const auto& [componentId, component]: node.components) {
+		getComponentReflector(componentId).addCopy(entity, *component);
+	}
+
+	for (const auto& child: node.children) {
+		// Same instance UUIDs as EntityData::instantiateWith would generate
+		const auto childUUID = child.prefabUUID.isValid() ? UUID::generateFromUUIDs(child.prefabUUID, rootUUID) : UUID::generate();
+		instantiateBlueprint(child, childUUID, rootUUID, entity, scene, worldPartition);
+	}
+
 	return entity;
 }
 
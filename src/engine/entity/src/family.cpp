@@ -70,3 +70,23 @@ void Family::reloadEntity(Entity& entity)
 {
 	toReload.push_back(entity.getEntityId());
 }
+
+std::optional<size_t> Family::findIndex(EntityId id) const
+{
+	// Systems sharing this family can be looking up from several threads at once
+	std::unique_lock<std::mutex> lock(indexMutex);
+	if (indexDirty) {
+		index.clear();
+		index.reserve(elemCount);
+		for (size_t i = 0; i < elemCount; ++i) {
+			index[static_cast<const FamilyBase*>(getElement(i))->entityId] = i;
+		}
+		indexDirty = false;
+	}
+
+	const auto iter = index.find(id);
+	if (iter == index.end()) {
+		return {};
+	}
+	return iter->second;
+}
@@ -1,15 +1,54 @@
 #include "message.h"
+#include <gsl/gsl_assert>
+#include "halley/utils/utils.h"
 
 using namespace Halley;
 
-/*
-void* Message::operator new(size_t size)
+MessageArena::~MessageArena()
 {
-	return PoolPool::getPool(size)->alloc();
+	reset();
 }
 
-void Message::operator delete(void* ptr)
+void MessageArena::reset()
 {
-	PoolPool::getPool(static_cast<Message*>(ptr)->getSize())->free(ptr);
+	for (auto& pool: pools) {
+		for (auto* msg: pool.live) {
+			msg->~Message();
+		}
+		pool.live.clear();
+		pool.used = 0;
+	}
+}
+
+bool MessageArena::empty() const
+{
+	for (const auto& pool: pools) {
+		if (!pool.live.empty()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void* MessageArena::allocate(int msgType, size_t size)
+{
+	Expects(msgType >= 0);
+	if (size_t(msgType) >= pools.size()) {
+		pools.resize(size_t(msgType) + 1);
+	}
+
+	auto& pool = pools[msgType];
+	if (pool.slotSize == 0) {
+		pool.slotSize = alignUp(size, alignof(std::max_align_t));
+	}
+	Expects(pool.slotSize >= size);
+
+	const size_t block = pool.used / slotsPerBlock;
+	const size_t slot = pool.used % slotsPerBlock;
+	if (block == pool.blocks.size()) {
+		pool.blocks.emplace_back(new std::byte[pool.slotSize * slotsPerBlock]);
+	}
+	++pool.used;
+
+	return pool.blocks[block].get() + slot * pool.slotSize;
 }
-*/
@@ -1,6 +1,7 @@
 #include "prefab.h"
 
 #include "entity_data_delta.h"
+#include "create_functions.h"
 #include "halley/bytes/byte_serializer.h"
 #include "halley/file_formats/yaml_convert.h"
 #include "halley/resources/resource_data.h"
@@ -210,6 +211,36 @@ std::shared_ptr<Prefab> Prefab::clone() const
 	return std::make_shared<Prefab>(*this);
 }
 
+namespace {
+	void collectDependencies(const EntityData& data, Vector<std::pair<AssetType, String>>& result)
+	{
+		if (!data.getPrefab().isEmpty()) {
+			result.emplace_back(AssetType::Prefab, data.getPrefab());
+		}
+
+		// Component fields don't carry their types at runtime, so this goes through the dependency lists generated from the component schemas
+		const auto& getComponentDependencies = CreateEntityFunctions::getComponentAssetDependencies();
+		if (getComponentDependencies) {
+			for (const auto& [componentName, componentData]: data.getComponents()) {
+				getComponentDependencies(componentName, componentData, result);
+			}
+		}
+
+		for (const auto& child: data.getChildren()) {
+			collectDependencies(child, result);
+		}
+	}
+}
+
+Vector<std::pair<AssetType, String>> Prefab::getDependencies() const
+{
+	Vector<std::pair<AssetType, String>> result;
+	for (const auto& data: getEntityDatas()) {
+		collectDependencies(data, result);
+	}
+	return result;
+}
+
 EntityData Prefab::makeEntityData(const ConfigNode& node) const
 {
 	return EntityData(node, true);
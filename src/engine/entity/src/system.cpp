@@ -1,15 +1,19 @@
 #include "system.h"
-#include <halley/data_structures/flat_map.h>
 #include "halley/support/debug.h"
 #include "halley/support/profiler.h"
 #include "halley/utils/algorithm.h"
 
 using namespace Halley;
 
-System::System(Vector<FamilyBindingBase*> uninitializedFamilies, Vector<int> messageTypesReceived)
+System::System(Vector<FamilyBindingBase*> uninitializedFamilies, Vector<int> messageTypesReceived, Vector<int> messageTypesSent, bool canRunConcurrently)
 	: families(std::move(uninitializedFamilies))
 	, messageTypesReceived(std::move(messageTypesReceived))
+	, messageTypesSent(std::move(messageTypesSent))
+	, concurrent(canRunConcurrently)
 {
+	// Sorted so that receiveMessage can find the inbox with a binary search, and messages are handed out in type order
+	std::sort(this->messageTypesReceived.begin(), this->messageTypesReceived.end());
+	inboxes.resize(this->messageTypesReceived.size());
 }
 
 size_t System::getEntityCount() const
@@ -41,70 +45,82 @@ void System::onAddedToWorld(World& w, int id) {
 
 void System::purgeMessages()
 {
-	if (!messagesSentTo.empty()) {
-		for (auto& target: messagesSentTo) {
-			// Purge all messages of this age
-			Entity* entity = world->tryGetRawEntity(target);
-
-			if (entity) {
-				std_ex::erase_if(entity->inbox, [&] (const MessageEntry& e) { return e.age == systemId; });
-			}
-		}
-		messagesSentTo.clear();
+	// Receivers that haven't run since the last dispatch don't get to see these messages any more
+	for (auto* receiver: messagesSentTo) {
+		receiver->dropMessagesFrom(*this);
 	}
+	messagesSentTo.clear();
+	outbox.clear();
+	messageArena.reset();
 }
 
 void System::processMessages()
 {
-	// This whole method is probably very inefficient.
-	struct MessageBox
-	{
-		Vector<Message*> msg;
-		Vector<size_t> elemIdx;
-	};
-	FlatMap<int, MessageBox> inboxes;
-
-	if (!families.empty()) {
-		auto& fam = *families[0];
-		size_t sz = fam.count();
-		for (size_t i = 0; i < sz; i++) {
-			FamilyBase* elem = reinterpret_cast<FamilyBase*>(fam.getElement(i));
-			Entity* entity = world->tryGetRawEntity(elem->entityId);
-			if (entity) {
-				for (const auto& msg: entity->inbox) {
-					if (std::find(messageTypesReceived.begin(), messageTypesReceived.end(), msg.type) != messageTypesReceived.end()) {
-						auto& inbox = inboxes[msg.type];
-						inbox.msg.emplace_back(msg.msg.get());
-						inbox.elemIdx.emplace_back(i);
-					}
+	const Family* family = families.empty() ? nullptr : families[0]->family;
+
+	for (size_t i = 0; i < inboxes.size(); ++i) {
+		auto& inbox = inboxes[i];
+		if (inbox.empty()) {
+			continue;
+		}
+
+		if (family) {
+			for (const auto& msg: inbox) {
+				if (const auto idx = family->findIndex(msg.target)) {
+					receivedMessages.push_back(msg.msg);
+					receivedIndices.push_back(idx.value());
 				}
 			}
 		}
-		for (auto& iter : inboxes) {
-			int id = iter.first;
-			auto& inbox = iter.second;
-			onMessagesReceived(id, inbox.msg.data(), inbox.elemIdx.data(), inbox.msg.size());
+		inbox.clear();
+
+		if (!receivedMessages.empty()) {
+			onMessagesReceived(messageTypesReceived[i], receivedMessages.data(), receivedIndices.data(), receivedMessages.size());
+			receivedMessages.clear();
+			receivedIndices.clear();
 		}
 	}
 }
 
-void System::doSendMessage(EntityId entityId, std::unique_ptr<Message> msg, int id)
+void System::doSendMessage(EntityId entityId, Message* msg, int id)
+{
+	outbox.push_back(OutgoingMessage{ entityId, msg, id });
+}
+
+void System::receiveMessage(int msgId, EntityId target, Message* msg, const System& sender)
+{
+	const auto iter = std::lower_bound(messageTypesReceived.begin(), messageTypesReceived.end(), msgId);
+	Expects(iter != messageTypesReceived.end() && *iter == msgId);
+	inboxes[iter - messageTypesReceived.begin()].push_back(IncomingMessage{ target, msg, &sender });
+}
+
+void System::dropMessagesFrom(const System& sender)
+{
+	for (auto& inbox: inboxes) {
+		std_ex::erase_if(inbox, [&] (const IncomingMessage& msg) { return msg.sender == &sender; });
+	}
+}
+
+void System::forgetReceiver(const System& receiver)
 {
-	outbox.emplace_back(std::make_pair(entityId, MessageEntry(std::move(msg), id, systemId)));
+	std_ex::erase_if(messagesSentTo, [&] (const System* s) { return s == &receiver; });
 }
 
 void System::dispatchMessages()
 {
-	if (!outbox.empty()) {
-		for (auto& o: outbox) {
-			Entity* entity = world->tryGetRawEntity(o.first);
-			if (entity) {
-				entity->inbox.emplace_back(std::move(o.second));
-				messagesSentTo.push_back(o.first);
+	for (const auto& o: outbox) {
+		if (!world->tryGetRawEntity(o.target)) {
+			continue;
+		}
+
+		for (auto* receiver: world->getMessageReceivers(o.type)) {
+			receiver->receiveMessage(o.type, o.target, o.msg, *this);
+			if (std::find(messagesSentTo.begin(), messagesSentTo.end(), receiver) == messagesSentTo.end()) {
+				messagesSentTo.push_back(receiver);
 			}
 		}
-		outbox.clear();
 	}
+	outbox.clear();
 }
 
 size_t System::doSendSystemMessage(SystemMessageContext context, const String& targetSystem)
@@ -136,17 +152,31 @@ size_t System::getSystemMessagesInInbox() const
 	return systemMessageInbox.size();
 }
 
+void System::getComponentAccess(MaskStorage& storage, FamilyMask::RealType& read, FamilyMask::RealType& write) const
+{
+	for (const auto* f: families) {
+		read |= f->readMask.getRealValue(storage);
+		write |= f->writeMask.getRealValue(storage);
+	}
+}
+
 void System::doUpdate(Time time) {
+	purgeMessages();
+	runUpdate(time);
+	dispatchMessages();
+}
+
+void System::runUpdate(Time time)
+{
+	// Touches nothing outside of this system's families and messages, so it can be called from SystemScheduler's worker threads
 	HALLEY_DEBUG_TRACE_COMMENT(name.c_str());
 	ProfilerEvent event(ProfilerEventType::WorldSystemUpdate, name);
 
-	purgeMessages();
 	if (!messageTypesReceived.empty()) {
 		processMessages();
 	}
 	
 	updateBase(time);
-	dispatchMessages();
 	HALLEY_DEBUG_TRACE_COMMENT(name.c_str());
 }
 
@@ -0,0 +1,130 @@
+#include "system_scheduler.h"
+#include "system.h"
+#include "world.h"
+#include <halley/concurrency/concurrent.h>
+
+using namespace Halley;
+
+void SystemScheduler::setDirty()
+{
+	dirty = true;
+}
+
+void SystemScheduler::update(World& world, Vector<std::unique_ptr<System>>& systems, Time elapsed)
+{
+	if (dirty) {
+		buildWaves(world, systems);
+		dirty = false;
+	}
+
+	for (const auto& wave: waves) {
+		runWave(wave, elapsed);
+		world.spawnPending();
+	}
+}
+
+void SystemScheduler::buildWaves(World& world, Vector<std::unique_ptr<System>>& systems)
+{
+	const size_t n = systems.size();
+
+	Vector<Access> access(n);
+	for (size_t i = 0; i < n; ++i) {
+		systems[i]->getComponentAccess(world.getMaskStorage(), access[i].read, access[i].write);
+	}
+
+	// Each system goes into the wave right after the last earlier system it conflicts with
+	Vector<size_t> level(n, 0);
+	size_t nWaves = 0;
+	for (size_t j = 0; j < n; ++j) {
+		for (size_t i = 0; i < j; ++i) {
+			if (level[i] + 1 > level[j] && conflicts(*systems[i], access[i], *systems[j], access[j])) {
+				level[j] = level[i] + 1;
+			}
+		}
+		nWaves = std::max(nWaves, level[j] + 1);
+	}
+
+	waves.clear();
+	waves.resize(nWaves);
+	for (size_t i = 0; i < n; ++i) {
+		waves[level[i]].push_back(systems[i].get());
+	}
+}
+
+void SystemScheduler::runWave(const Vector<System*>& wave, Time elapsed)
+{
+	auto& cpu = Executors::getCPU();
+	if (wave.size() == 1 || cpu.threadCount() == 0) {
+		for (auto* system: wave) {
+			system->doUpdate(elapsed);
+		}
+		return;
+	}
+
+	// Purging touches the inboxes of other systems, so it stays on this thread
+	for (auto* system: wave) {
+		system->purgeMessages();
+	}
+
+	Vector<std::exception_ptr> errors(wave.size());
+	Vector<Future<void>> futures;
+	futures.reserve(wave.size() - 1);
+	for (size_t i = 1; i < wave.size(); ++i) {
+		futures.push_back(Concurrent::execute(cpu, [system = wave[i], &error = errors[i], elapsed] ()
+		{
+			try {
+				system->runUpdate(elapsed);
+			} catch (...) {
+				error = std::current_exception();
+			}
+		}));
+	}
+
+	try {
+		wave[0]->runUpdate(elapsed);
+	} catch (...) {
+		errors[0] = std::current_exception();
+	}
+	auto all = Concurrent::whenAll(futures.begin(), futures.end());
+	while (!all.isReady()) {
+		if (!cpu.tryRunOne()) {
+			std::this_thread::yield();
+		}
+	}
+
+	for (auto& e: errors) {
+		if (e) {
+			std::rethrow_exception(e);
+		}
+	}
+
+	// Dispatch in timeline order, so inboxes end up the same regardless of which thread finished first
+	for (auto* system: wave) {
+		system->dispatchMessages();
+	}
+}
+
+bool SystemScheduler::conflicts(const System& a, const Access& accessA, const System& b, const Access& accessB)
+{
+	if (!a.canRunConcurrently() || !b.canRunConcurrently()) {
+		return true;
+	}
+
+	if ((accessA.write & accessB.read).any() || (accessB.write & accessA.read).any()) {
+		return true;
+	}
+
+	// Either order of message exchange matters: the receiver has to see the messages, and the sender purges them on its next update
+	return sendsTo(a, b) || sendsTo(b, a);
+}
+
+bool SystemScheduler::sendsTo(const System& from, const System& to)
+{
+	for (const int type: from.getMessageTypesSent()) {
+		const auto& received = to.getMessageTypesReceived();
+		if (std::find(received.begin(), received.end(), type) != received.end()) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -67,15 +67,28 @@ System& World::addSystem(std::unique_ptr<System> system, TimeLine timelineType)
 	auto& timeline = getSystems(timelineType);
 	timeline.emplace_back(std::move(system));
 	ref.onAddedToWorld(*this, int(timeline.size()));
+	systemSchedulers[static_cast<int>(timelineType)].setDirty();
+	messageReceiversDirty = true;
 	return ref;
 }
 
 void World::removeSystem(System& system)
 {
-	for (auto& sys : systems) {
+	for (size_t tl = 0; tl < systems.size(); ++tl) {
+		auto& sys = systems[tl];
 		for (size_t i = 0; i < sys.size(); i++) {
 			if (sys[i].get() == &system) {
+				// Make sure no other system is left pointing at messages owned by this one, or waiting to purge its inbox
+				system.purgeMessages();
+				for (auto& timeline: systems) {
+					for (auto& other: timeline) {
+						other->forgetReceiver(system);
+					}
+				}
+
 				sys.erase(sys.begin() + i);
+				systemSchedulers[tl].setDirty();
+				messageReceiversDirty = true;
 				return;
 			}
 		}
@@ -206,6 +219,13 @@ EntityRef World::createEntity(UUID uuid, String name, std::optional<EntityRef> p
 	return e;
 }
 
+void World::reserveEntities(size_t count)
+{
+	entitiesPendingCreation.reserve(entitiesPendingCreation.size() + count);
+	entities.reserve(entities.size() + entitiesPendingCreation.size() + count);
+	uuidMap.reserve(uuidMap.size() + count);
+}
+
 void World::destroyEntity(EntityId id)
 {
 	doDestroyEntity(id);
@@ -410,6 +430,29 @@ size_t World::sendSystemMessage(SystemMessageContext origContext, const String&
 	return count;
 }
 
+const Vector<System*>& World::getMessageReceivers(int msgType)
+{
+	if (messageReceiversDirty) {
+		messageReceiversDirty = false;
+		for (auto& receivers: messageReceivers) {
+			receivers.clear();
+		}
+		for (auto& timeline: systems) {
+			for (auto& system: timeline) {
+				for (const int type: system->getMessageTypesReceived()) {
+					if (size_t(type) >= messageReceivers.size()) {
+						messageReceivers.resize(size_t(type) + 1);
+					}
+					messageReceivers[type].push_back(system.get());
+				}
+			}
+		}
+	}
+
+	static const Vector<System*> none;
+	return size_t(msgType) < messageReceivers.size() ? messageReceivers[msgType] : none;
+}
+
 bool World::isDevMode() const
 {
 	return api.core->isDevMode();
@@ -425,6 +468,34 @@ bool World::isEditor() const
 	return editor;
 }
 
+void World::setChunkedComponentStorage(bool enabled)
+{
+	chunkedStorage = enabled;
+	if (enabled && !archetypeStorage) {
+		archetypeStorage = std::make_unique<ArchetypeStorage>();
+	}
+}
+
+bool World::hasChunkedComponentStorage() const
+{
+	return chunkedStorage;
+}
+
+const ArchetypeStorage* World::getArchetypeStorage() const
+{
+	return archetypeStorage.get();
+}
+
+void World::setParallelSystemUpdate(bool enabled)
+{
+	parallelSystemUpdate = enabled;
+}
+
+bool World::hasParallelSystemUpdate() const
+{
+	return parallelSystemUpdate;
+}
+
 void World::deleteEntity(Entity* entity)
 {
 	Expects (entity);
@@ -433,6 +504,33 @@ void World::deleteEntity(Entity* entity)
 	entityPool->free(entity);
 }
 
+bool World::relocateComponents(Entity& entity)
+{
+	// Entity must be refreshed, i.e. it has no dead components
+	Expects(entity.components.size() == entity.liveComponents);
+
+	Archetype* target = chunkedStorage ? archetypeStorage->getArchetype(entity.getMask(), entity.components, *componentDeleterTable) : nullptr;
+	const auto oldSlot = entity.archetypeSlot;
+	if (target == oldSlot.archetype) {
+		return false;
+	}
+
+	const uint32_t newIndex = target ? target->allocSlot() : 0;
+	for (auto& c: entity.components) {
+		auto* deleter = componentDeleterTable->get(c.first);
+		void* dst = target ? target->getComponent(newIndex, c.first) : PoolPool::getPool(deleter->getSize())->alloc();
+		deleter->moveConstruct(dst, c.second);
+		entity.deleteComponent(c.second, c.first, *componentDeleterTable); // Still uses the old slot to decide ownership
+		c.second = static_cast<Component*>(dst);
+	}
+
+	if (oldSlot.isValid()) {
+		oldSlot.archetype->freeSlot(oldSlot.index);
+	}
+	entity.archetypeSlot = target ? ArchetypeSlot{ target, newIndex } : ArchetypeSlot();
+	return true;
+}
+
 bool World::hasSystemsOnTimeLine(TimeLine timeline) const
 {
 	return !getSystems(timeline).empty();
@@ -523,6 +621,9 @@ void World::updateEntities()
 
 				// Did it change?
 				if (oldMask != newMask) {
+					if (archetypeStorage) {
+						relocateComponents(entity);
+					}
 					pending[oldMask].toRemove.emplace_back(newMask, &entity);
 					pending[newMask].toAdd.emplace_back(oldMask, &entity);
 				}
@@ -563,8 +664,8 @@ void World::updateEntities()
 				const auto& newMask = todo.first;
 				if (!oldMask.contains(famMask, ms)) {
 					fam->addEntity(*e.second);
-				} else if (optFamMask.unionChangedBetween(oldMask, newMask, ms)) {
-					// Needs refreshing of optional references
+				} else if (archetypeStorage || optFamMask.unionChangedBetween(oldMask, newMask, ms)) {
+					// Needs refreshing of optional references, or components were moved to a different archetype
 					fam->refreshEntity(*e.second);
 				}
 			}
@@ -617,6 +718,11 @@ void World::initSystems(gsl::span<const TimeLine> timelines)
 
 void World::updateSystems(TimeLine timeline, Time elapsed)
 {
+	if (parallelSystemUpdate) {
+		systemSchedulers[static_cast<int>(timeline)].update(*this, getSystems(timeline), elapsed);
+		return;
+	}
+
 	for (auto& system : getSystems(timeline)) {
 		system->doUpdate(elapsed);
 		spawnPending();
@@ -3,9 +3,7 @@
 #include "network_message.h"
 #include <memory>
 #include <vector>
-#include <map>
 #include "reliable_connection.h"
-#include <list>
 #include <chrono>
 #include "message_queue.h"
 
@@ -19,9 +17,10 @@ namespace Halley
 		{
 			std::vector<std::unique_ptr<NetworkMessage>> msgs;
 			std::chrono::steady_clock::time_point timeSent;
-			size_t size;
-			unsigned short seq;
-			bool reliable;
+			size_t size = 0;
+			unsigned short seq = 0;
+			bool reliable = false;
+			bool waiting = false;
 		};
 
 		struct Channel
@@ -38,9 +37,11 @@ namespace Halley
 		};
 
 	public:
-		MessageQueueUDP(std::shared_ptr<ReliableConnection> connection);
+		// maxPendingPackets is how many packets can be waiting to be acknowledged, sending more than that throws
+		MessageQueueUDP(std::shared_ptr<ReliableConnection> connection, size_t maxPendingPackets = 1024);
 		~MessageQueueUDP();
 		
+		bool isConnected() const override;
 		void setChannel(int channel, ChannelSettings settings) override;
 
 		std::vector<std::unique_ptr<NetworkMessage>> receiveAll() override;
@@ -52,16 +53,25 @@ namespace Halley
 		std::shared_ptr<ReliableConnection> connection;
 		std::vector<Channel> channels;
 
-		std::list<std::unique_ptr<NetworkMessage>> pendingMsgs;
-		std::map<int, PendingPacket> pendingPackets;
+		std::vector<std::unique_ptr<NetworkMessage>> pendingMsgs;
+
+		// Ring buffer indexed by packet tag, tags in flight are [firstPendingTag, nextPacketId)
+		std::vector<PendingPacket> pendingPackets;
+		int firstPendingTag = 0;
 		int nextPacketId = 0;
 
+		// Scratch space, kept between calls so sending doesn't allocate once it's warmed up
+		std::vector<ReliableSubPacket> toSend;
+		std::vector<std::unique_ptr<NetworkMessage>> packetMsgs;
+		std::vector<std::vector<gsl::byte>> spareBuffers;
+
 		void onPacketAcked(int tag) override;
 		void checkReSend(std::vector<ReliableSubPacket>& collect);
 
 		ReliableSubPacket createPacket();
 		ReliableSubPacket makeTaggedPacket(std::vector<std::unique_ptr<NetworkMessage>>& msgs, size_t size, bool resends = false, unsigned short resendSeq = 0);
-		std::vector<gsl::byte> serializeMessages(const std::vector<std::unique_ptr<NetworkMessage>>& msgs, size_t size) const;
+		std::vector<gsl::byte> serializeMessages(const std::vector<std::unique_ptr<NetworkMessage>>& msgs, size_t size); // Reuses a spare buffer if there's one
+		PendingPacket* getPendingPacket(int tag);
 
 		void receiveMessages();
 	};
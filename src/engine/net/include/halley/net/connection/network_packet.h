@@ -5,6 +5,34 @@
 
 namespace Halley
 {
+	// Byte buffer backing network packets.
+	// Buffers up to poolBufferSize bytes come from a shared free list and go back to it when released,
+	// so sending and receiving packets doesn't hit the allocator once the pool is warm. Bigger ones are allocated as usual.
+	class NetworkBuffer
+	{
+	public:
+		constexpr static size_t poolBufferSize = 2048;
+
+		NetworkBuffer() = default;
+		explicit NetworkBuffer(size_t capacity);
+		NetworkBuffer(const NetworkBuffer& other) = delete;
+		NetworkBuffer(NetworkBuffer&& other) noexcept;
+		~NetworkBuffer();
+
+		NetworkBuffer& operator=(const NetworkBuffer& other) = delete;
+		NetworkBuffer& operator=(NetworkBuffer&& other) noexcept;
+
+		gsl::byte* data() { return buffer; }
+		const gsl::byte* data() const { return buffer; }
+		size_t capacity() const { return bufferCapacity; }
+
+	private:
+		gsl::byte* buffer = nullptr;
+		size_t bufferCapacity = 0;
+
+		void release();
+	};
+
 	class NetworkPacketBase
 	{
 	public:
@@ -19,18 +47,25 @@ namespace Halley
 		NetworkPacketBase();
 		NetworkPacketBase(gsl::span<const gsl::byte> data, size_t prePadding);
 
+		NetworkBuffer buffer;
 		size_t dataStart;
-		std::vector<gsl::byte> data;
+		size_t dataEnd;
+
+		void moveFrom(NetworkPacketBase& other);
 	};
 
 	class OutboundNetworkPacket : public NetworkPacketBase
 	{
 	public:
+		constexpr static size_t headerRoom = 128;
+
+		OutboundNetworkPacket();
 		OutboundNetworkPacket(const OutboundNetworkPacket& other);
 		explicit OutboundNetworkPacket(OutboundNetworkPacket&& other) noexcept;
 		explicit OutboundNetworkPacket(gsl::span<const gsl::byte> data);
 		explicit OutboundNetworkPacket(const Bytes& data);
-		
+
+		// Headers are written in place, into the room left before the data
 		void addHeader(gsl::span<const gsl::byte> src);
 
 		template <typename T>
@@ -39,6 +74,8 @@ namespace Halley
 			addHeader(gsl::as_bytes(gsl::span<const T>(&h, 1)));
 		}
 
+		void append(gsl::span<const gsl::byte> src);
+
 		OutboundNetworkPacket& operator=(OutboundNetworkPacket&& other) noexcept;
 	};
 
@@ -49,6 +86,7 @@ namespace Halley
 		explicit InboundNetworkPacket(InboundNetworkPacket&& other) noexcept;
 		explicit InboundNetworkPacket(gsl::span<const gsl::byte> data);
 		void extractHeader(gsl::span<gsl::byte> dst);
+		void skip(size_t bytes);
 
 		template <typename T>
 		void extractHeader(T& h)
@@ -5,7 +5,7 @@
 #include <memory>
 #include <vector>
 #include <chrono>
-#include <deque>
+#include <array>
 #include <limits>
 
 namespace Halley
@@ -34,12 +34,12 @@ namespace Halley
 		ReliableSubPacket(ReliableSubPacket&& other) = default;
 
 		ReliableSubPacket(std::vector<gsl::byte>&& data)
-			: data(data)
+			: data(std::move(data))
 			, resends(false)
 		{}
 
 		ReliableSubPacket(std::vector<gsl::byte>&& data, unsigned short resendSeq)
-			: data(data)
+			: data(std::move(data))
 			, resends(true)
 			, resendSeq(resendSeq)
 		{}
@@ -80,7 +80,8 @@ namespace Halley
 
 		std::vector<char> receivedSeqs; // 0 = not received, 1 = received, 2 = received re-send, 3 = both
 		std::vector<SentPacketData> sentPackets;
-		std::deque<InboundNetworkPacket> pendingPackets;
+		std::vector<InboundNetworkPacket> pendingPackets;
+		size_t nextPendingPacket = 0;
 
 		std::vector<IReliableConnectionAckListener*> ackListeners;
 
@@ -88,6 +89,12 @@ namespace Halley
 		Clock::time_point lastReceive;
 		Clock::time_point lastSend;
 
+		constexpr static size_t maxSubHeaderSize = 4;
+
+		static size_t makeSubHeader(std::array<gsl::byte, maxSubHeaderSize>& dst, size_t size, bool isResend, unsigned short resending);
+		void onSubPacketSent(int tag);
+		void sendWithHeader(OutboundNetworkPacket packet, unsigned short firstSeq);
+
 		void processReceivedPacket(InboundNetworkPacket& packet);
 		unsigned int generateAckBits();
 
@@ -13,4 +13,5 @@ namespace Halley {}
 #include <halley/net/connection/reliable_connection.h>
 #include <halley/net/connection/standard_message_stream.h>
 
+#include <halley/net/session/entity_replication.h>
 #include <halley/net/session/network_session.h>
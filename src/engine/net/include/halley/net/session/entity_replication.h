@@ -0,0 +1,142 @@
+#pragma once
+#include <memory>
+#include "halley/utils/utils.h"
+#include "halley/bytes/byte_serializer.h"
+#include "halley/data_structures/vector.h"
+#include "halley/data_structures/hash_map.h"
+#include "../connection/reliable_connection.h"
+
+namespace Halley {
+	using ReplicatedEntityId = uint64_t;
+
+	// Serialized state of one replicated entity.
+	// Each slot holds one component, serialized with the byte Serializer. An empty slot means the component isn't present.
+	class ReplicatedEntityState {
+	public:
+		constexpr static size_t maxComponents = 32;
+
+		template <typename T>
+		void set(size_t slot, const T& component)
+		{
+			setBytes(slot, Serializer::toBytes(component, getSerializerOptions()));
+		}
+
+		template <typename T>
+		bool get(size_t slot, T& component) const
+		{
+			const auto& bytes = getBytes(slot);
+			if (bytes.empty()) {
+				return false;
+			}
+			Deserializer::fromBytes(component, bytes, getSerializerOptions());
+			return true;
+		}
+
+		void setBytes(size_t slot, Bytes bytes);
+		const Bytes& getBytes(size_t slot) const;
+		void clear(size_t slot);
+		bool has(size_t slot) const;
+		size_t getNumSlots() const;
+
+		// Bit mask of the slots that differ between the two states
+		uint32_t getChangedMask(const ReplicatedEntityState& other) const;
+
+		bool operator==(const ReplicatedEntityState& other) const;
+		bool operator!=(const ReplicatedEntityState& other) const;
+
+		static SerializerOptions getSerializerOptions();
+
+	private:
+		Vector<Bytes> components;
+	};
+
+	struct ReplicationInterest {
+		ReplicatedEntityId id;
+		float priority;
+	};
+
+	// Implemented by the authority (e.g. the host's world) to decide what each peer sees, and what it looks like
+	class IEntityReplicationSource {
+	public:
+		virtual ~IEntityReplicationSource() = default;
+
+		// Interest management: lists the entities relevant to this peer.
+		// Priority is accumulated every update an entity doesn't make it into a packet, so low priority entities still get through eventually.
+		virtual void getRelevantEntities(int peerId, Vector<ReplicationInterest>& result) = 0;
+
+		// Called at most once per entity per update, regardless of how many peers it's relevant to
+		virtual void serializeEntity(ReplicatedEntityId id, ReplicatedEntityState& state) = 0;
+	};
+
+	// Implemented by the receiving end to apply replicated state
+	class IEntityReplicationSink {
+	public:
+		virtual ~IEntityReplicationSink() = default;
+
+		// Called when the entity is first seen, and whenever it changes afterwards. changedMask has a bit set for every slot that changed.
+		virtual void onEntityUpdated(ReplicatedEntityId id, const ReplicatedEntityState& state, uint32_t changedMask) = 0;
+		virtual void onEntityRemoved(ReplicatedEntityId id) = 0;
+	};
+
+	// Sends snapshots of entity state to every peer.
+	// Each entity is delta-compressed against the last state that peer acknowledged receiving (as reported by ReliableConnection),
+	// so lost packets never need re-sending: whatever is still different just goes out again in the next update.
+	// Each peer needs its own ReliableConnection, which this takes over (incoming packets on it are only used for acks).
+	class EntityReplicationServer {
+	public:
+		explicit EntityReplicationServer(IEntityReplicationSource& source);
+		~EntityReplicationServer();
+
+		void addPeer(int peerId, std::shared_ptr<ReliableConnection> connection);
+		void removePeer(int peerId);
+
+		// Packets are kept under maxPacketSize bytes (before the connection's own headers), so they fit in the MTU
+		void setMaxPacketSize(size_t size);
+		void setMaxPacketsPerUpdate(size_t packets);
+
+		void update();
+
+	private:
+		class Peer;
+
+		IEntityReplicationSource& source;
+		Vector<std::unique_ptr<Peer>> peers;
+		size_t maxPacketSize = 1024;
+		size_t maxPacketsPerUpdate = 8;
+
+		HashMap<ReplicatedEntityId, ReplicatedEntityState> frameStates;
+
+		const ReplicatedEntityState& getFrameState(ReplicatedEntityId id);
+	};
+
+	// Receives snapshots from an EntityReplicationServer and applies them to the sink
+	class EntityReplicationClient {
+	public:
+		EntityReplicationClient(std::shared_ptr<ReliableConnection> connection, IEntityReplicationSink& sink);
+
+		void update();
+
+	private:
+		struct HistoryEntry {
+			uint32_t packetId;
+			ReplicatedEntityState state;
+		};
+
+		struct EntityData {
+			Vector<HistoryEntry> history; // Sorted by packetId
+			uint32_t lastEventId = 0;
+			bool removed = false;
+		};
+
+		std::shared_ptr<ReliableConnection> connection;
+		IEntityReplicationSink& sink;
+
+		HashMap<ReplicatedEntityId, EntityData> entities;
+		uint32_t latestPacketId = 0;
+
+		void receivePacket(gsl::span<const gsl::byte> data);
+		void receiveRemoval(ReplicatedEntityId id, uint32_t packetId);
+		void receiveUpdate(ReplicatedEntityId id, uint32_t packetId, uint32_t baselineId, uint32_t mask, Deserializer& s);
+		void pruneHistory();
+	};
+}
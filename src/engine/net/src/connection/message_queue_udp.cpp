@@ -60,11 +60,13 @@ void MessageQueueUDP::Channel::getReadyMessages(std::vector<std::unique_ptr<Netw
 	}
 }
 
-MessageQueueUDP::MessageQueueUDP(std::shared_ptr<ReliableConnection> conn)
+MessageQueueUDP::MessageQueueUDP(std::shared_ptr<ReliableConnection> conn, size_t maxPendingPackets)
 	: connection(conn)
 	, channels(32)
+	, pendingPackets(maxPendingPackets)
 {
 	Expects(connection != nullptr);
+	Expects(maxPendingPackets > 0);
 	connection->addAckListener(*this);
 }
 
@@ -73,6 +75,11 @@ MessageQueueUDP::~MessageQueueUDP()
 	connection->removeAckListener(*this);
 }
 
+bool MessageQueueUDP::isConnected() const
+{
+	return connection->getStatus() == ConnectionStatus::Connected;
+}
+
 void MessageQueueUDP::setChannel(int channel, ChannelSettings settings)
 {
 	Expects(channel >= 0);
@@ -200,8 +207,7 @@ void MessageQueueUDP::enqueue(std::unique_ptr<NetworkMessage> msg, int channelNu
 
 void MessageQueueUDP::sendAll()
 {
-	//int firstTag = nextPacketId;
-	std::vector<ReliableSubPacket> toSend;
+	toSend.clear();
 
 	// Add packets which need to be re-sent
 	checkReSend(toSend);
@@ -213,18 +219,29 @@ void MessageQueueUDP::sendAll()
 
 	// Send and update sequences
 	connection->sendTagged(toSend);
-	for (auto& pending: toSend) {
-		pendingPackets[pending.tag].seq = pending.seq;
+	for (auto& sent: toSend) {
+		if (auto* pending = getPendingPacket(sent.tag)) {
+			pending->seq = sent.seq;
+		}
+		spareBuffers.push_back(std::move(sent.data));
 	}
+	toSend.clear();
 }
 
-void MessageQueueUDP::onPacketAcked(int tag)
+MessageQueueUDP::PendingPacket* MessageQueueUDP::getPendingPacket(int tag)
 {
-	auto i = pendingPackets.find(tag);
-	if (i != pendingPackets.end()) {
-		auto& packet = i->second;
+	if (tag < firstPendingTag || tag >= nextPacketId) {
+		return nullptr;
+	}
+	auto& pending = pendingPackets[size_t(tag) % pendingPackets.size()];
+	return pending.waiting ? &pending : nullptr;
+}
 
-		for (auto& m : packet.msgs) {
+void MessageQueueUDP::onPacketAcked(int tag)
+{
+	auto* packet = getPendingPacket(tag);
+	if (packet) {
+		for (auto& m : packet->msgs) {
 			auto& channel = channels[m->channel];
 			if (m->seq - channel.lastAckSeq < 0x7FFFFFFF) {
 				channel.lastAckSeq = m->seq;
@@ -235,42 +252,59 @@ void MessageQueueUDP::onPacketAcked(int tag)
 		}
 
 		// Remove pending
-		pendingPackets.erase(tag);
+		packet->msgs.clear();
+		packet->waiting = false;
+		while (firstPendingTag < nextPacketId && !pendingPackets[size_t(firstPendingTag) % pendingPackets.size()].waiting) {
+			++firstPendingTag;
+		}
 	}
 }
 
 void MessageQueueUDP::checkReSend(std::vector<ReliableSubPacket>& collect)
 {
-	auto next = pendingPackets.begin();
-	for (auto iter = pendingPackets.begin(); iter != pendingPackets.end(); iter = next) {
-		++next;
-		auto& pending = iter->second;
+	const int lastTag = nextPacketId;
+	for (int tag = firstPendingTag; tag < lastTag; ++tag) {
+		auto* pending = getPendingPacket(tag);
+		if (!pending) {
+			continue;
+		}
 
 		// Check how long it's been waiting
-		float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - pending.timeSent).count();
+		float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - pending->timeSent).count();
 		if (elapsed > 0.1f && elapsed > connection->getLatency() * 3.0f) {
-			// Re-send if it's reliable
-			if (pending.reliable) {
-				collect.push_back(makeTaggedPacket(pending.msgs, pending.size, true, pending.seq));
+			if (pending->reliable) {
+				// Re-sent under the same tag, so it keeps its slot (a full ring can't refuse it) and an ack for either copy releases it
+				auto result = ReliableSubPacket(serializeMessages(pending->msgs, pending->size));
+				result.tag = tag;
+				result.resends = true;
+				result.resendSeq = pending->seq;
+				collect.push_back(std::move(result));
+				pending->timeSent = std::chrono::steady_clock::now();
+			} else {
+				pending->waiting = false;
+				pending->msgs.clear();
 			}
-			pendingPackets.erase(iter);
 		}
 	}
+
+	while (firstPendingTag < nextPacketId && !pendingPackets[size_t(firstPendingTag) % pendingPackets.size()].waiting) {
+		++firstPendingTag;
+	}
 }
 
 ReliableSubPacket MessageQueueUDP::createPacket()
 {
-	std::vector<std::unique_ptr<NetworkMessage>> sentMsgs;
 	size_t maxSize = 1200;
 	size_t size = 0;
 	bool first = true;
 	bool packetReliable = false;
 
-	// Figure out what messages are going in this packet
-	auto next = pendingMsgs.begin();
-	for (auto iter = pendingMsgs.begin(); iter != pendingMsgs.end(); iter = next) {
-		++next;
-		auto& msg = *iter;
+	// Figure out what messages are going in this packet, the ones left behind are compacted in place
+	packetMsgs.clear();
+	size_t nLeft = 0;
+	for (size_t i = 0; i < pendingMsgs.size(); ++i) {
+		auto& msg = pendingMsgs[i];
+		bool taken = false;
 
 		// Check if this message is compatible
 		auto& channel = channels[msg->channel];
@@ -278,8 +312,8 @@ ReliableSubPacket MessageQueueUDP::createPacket()
 		bool isOrdered = channel.settings.ordered;
 		if (first || isReliable == packetReliable) {
 			// Check if the message fits
-			size_t msgSize = (*iter)->getSerializedSize();
-			int msgType = getMessageType(**iter);
+			size_t msgSize = msg->getSerializedSize();
+			int msgType = getMessageType(*msg);
 			size_t headerSize = 1 + (isOrdered ? 2 : 0) + (msgSize >= 128 ? 2 : 1) + (msgType >= 128 ? 2 : 1);
 			size_t totalSize = headerSize + msgSize;
 
@@ -287,33 +321,50 @@ ReliableSubPacket MessageQueueUDP::createPacket()
 				// It fits, so add it
 				size += totalSize;
 
-				sentMsgs.push_back(std::move(*iter));
-				pendingMsgs.erase(iter);
+				packetMsgs.push_back(std::move(msg));
+				taken = true;
 
 				first = false;
 				packetReliable = isReliable;
 			}
 		}
+
+		if (!taken) {
+			if (nLeft != i) {
+				pendingMsgs[nLeft] = std::move(msg);
+			}
+			++nLeft;
+		}
 	}
+	pendingMsgs.resize(nLeft);
 
-	if (sentMsgs.empty()) {
+	if (packetMsgs.empty()) {
 		throw Exception("Was not able to fit any messages into packet!", HalleyExceptions::Network);
 	}
 
-	return makeTaggedPacket(sentMsgs, size);
+	return makeTaggedPacket(packetMsgs, size);
 }
 
 ReliableSubPacket MessageQueueUDP::makeTaggedPacket(std::vector<std::unique_ptr<NetworkMessage>>& msgs, size_t size, bool resends, unsigned short resendSeq)
 {
 	bool reliable = !msgs.empty() && channels[msgs[0]->channel].settings.reliable;
 
+	if (nextPacketId - firstPendingTag >= int(pendingPackets.size())) {
+		throw Exception("Too many packets waiting to be acknowledged.", HalleyExceptions::Network);
+	}
+
 	auto data = serializeMessages(msgs, size);
 
 	int tag = nextPacketId++;
-	auto& pendingData = pendingPackets[tag];
-	pendingData.msgs = std::move(msgs);
+	auto& pendingData = pendingPackets[size_t(tag) % pendingPackets.size()];
+	pendingData.msgs.clear();
+	for (auto& m: msgs) {
+		pendingData.msgs.push_back(std::move(m));
+	}
+	msgs.clear();
 	pendingData.size = size;
 	pendingData.reliable = reliable;
+	pendingData.waiting = true;
 	pendingData.timeSent = std::chrono::steady_clock::now();
 
 	auto result = ReliableSubPacket(std::move(data));
@@ -323,9 +374,14 @@ ReliableSubPacket MessageQueueUDP::makeTaggedPacket(std::vector<std::unique_ptr<
 	return result;
 }
 
-std::vector<gsl::byte> MessageQueueUDP::serializeMessages(const std::vector<std::unique_ptr<NetworkMessage>>& msgs, size_t size) const
+std::vector<gsl::byte> MessageQueueUDP::serializeMessages(const std::vector<std::unique_ptr<NetworkMessage>>& msgs, size_t size)
 {
-	std::vector<gsl::byte> result(size);
+	std::vector<gsl::byte> result;
+	if (!spareBuffers.empty()) {
+		result = std::move(spareBuffers.back());
+		spareBuffers.pop_back();
+	}
+	result.resize(size);
 	size_t pos = 0;
 	
 	for (auto& msg: msgs) {
@@ -1,18 +1,112 @@
 #include "connection/network_packet.h"
 #include <halley/support/exception.h>
 #include <cassert>
+#include <mutex>
 
 using namespace Halley;
 
+namespace {
+	class NetworkBufferPool
+	{
+	public:
+		gsl::byte* acquire()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (freeBuffers.empty()) {
+				return new gsl::byte[NetworkBuffer::poolBufferSize];
+			}
+			auto* result = freeBuffers.back();
+			freeBuffers.pop_back();
+			return result;
+		}
+
+		void release(gsl::byte* buffer)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (freeBuffers.size() < maxFreeBuffers) {
+				freeBuffers.push_back(buffer);
+			} else {
+				delete[] buffer;
+			}
+		}
+
+	private:
+		constexpr static size_t maxFreeBuffers = 4096;
+
+		std::mutex mutex;
+		std::vector<gsl::byte*> freeBuffers;
+	};
+
+	NetworkBufferPool& getPool()
+	{
+		// Never destroyed, so packets released during static destruction are still safe
+		static NetworkBufferPool* pool = new NetworkBufferPool();
+		return *pool;
+	}
+}
+
+NetworkBuffer::NetworkBuffer(size_t capacity)
+{
+	if (capacity <= poolBufferSize) {
+		buffer = getPool().acquire();
+		bufferCapacity = poolBufferSize;
+	} else {
+		buffer = new gsl::byte[capacity];
+		bufferCapacity = capacity;
+	}
+}
+
+NetworkBuffer::NetworkBuffer(NetworkBuffer&& other) noexcept
+	: buffer(other.buffer)
+	, bufferCapacity(other.bufferCapacity)
+{
+	other.buffer = nullptr;
+	other.bufferCapacity = 0;
+}
+
+NetworkBuffer::~NetworkBuffer()
+{
+	release();
+}
+
+NetworkBuffer& NetworkBuffer::operator=(NetworkBuffer&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		buffer = other.buffer;
+		bufferCapacity = other.bufferCapacity;
+		other.buffer = nullptr;
+		other.bufferCapacity = 0;
+	}
+	return *this;
+}
+
+void NetworkBuffer::release()
+{
+	if (buffer) {
+		if (bufferCapacity == poolBufferSize) {
+			getPool().release(buffer);
+		} else {
+			delete[] buffer;
+		}
+		buffer = nullptr;
+		bufferCapacity = 0;
+	}
+}
+
 NetworkPacketBase::NetworkPacketBase()
 	: dataStart(0)
+	, dataEnd(0)
 {}
 
 NetworkPacketBase::NetworkPacketBase(gsl::span<const gsl::byte> src, size_t prePadding)
-	: dataStart(prePadding)
+	: buffer(src.size_bytes() + prePadding)
+	, dataStart(prePadding)
+	, dataEnd(prePadding + src.size_bytes())
 {
-	data.resize(src.size_bytes() + prePadding);
-	memcpy(data.data() + prePadding, src.data(), src.size_bytes());
+	if (!src.empty()) {
+		memcpy(buffer.data() + prePadding, src.data(), src.size_bytes());
+	}
 }
 
 size_t NetworkPacketBase::copyTo(gsl::span<gsl::byte> dst) const
@@ -20,57 +114,92 @@ size_t NetworkPacketBase::copyTo(gsl::span<gsl::byte> dst) const
 	if (dst.size() < signed(getSize())) {
 		throw Exception("Destination buffer is too small for network packet.", HalleyExceptions::Network);
 	}
-	memcpy(dst.data(), data.data() + dataStart, getSize());
+	if (getSize() > 0) {
+		memcpy(dst.data(), buffer.data() + dataStart, getSize());
+	}
 	return getSize();
 }
 
 size_t NetworkPacketBase::getSize() const
 {
-	Expects(data.size() >= dataStart);
-	return data.size() - dataStart;
+	Expects(dataEnd >= dataStart);
+	return dataEnd - dataStart;
 }
 
 gsl::span<const gsl::byte> NetworkPacketBase::getBytes() const
 {
-	return gsl::span<const gsl::byte>(data).subspan(dataStart, getSize());
+	return gsl::span<const gsl::byte>(buffer.data() + dataStart, getSize());
 }
 
+void NetworkPacketBase::moveFrom(NetworkPacketBase& other)
+{
+	if (this == &other) {
+		return;
+	}
+	buffer = std::move(other.buffer);
+	dataStart = other.dataStart;
+	dataEnd = other.dataEnd;
+	other.dataStart = 0;
+	other.dataEnd = 0;
+}
+
+OutboundNetworkPacket::OutboundNetworkPacket()
+	: NetworkPacketBase(gsl::span<const gsl::byte>(), headerRoom)
+{}
+
 OutboundNetworkPacket::OutboundNetworkPacket(const OutboundNetworkPacket& other)
 	: NetworkPacketBase()
 {
-	data = other.data;
+	buffer = NetworkBuffer(other.buffer.capacity());
 	dataStart = other.dataStart;
+	dataEnd = other.dataEnd;
+	if (getSize() > 0) {
+		memcpy(buffer.data() + dataStart, other.buffer.data() + dataStart, getSize());
+	}
 }
 
 OutboundNetworkPacket::OutboundNetworkPacket(OutboundNetworkPacket&& other) noexcept
 {
-	data = other.data;
-	dataStart = other.dataStart;
-	other.dataStart = 0;
+	moveFrom(other);
 }
 
 OutboundNetworkPacket::OutboundNetworkPacket(gsl::span<const gsl::byte> data)
-	: NetworkPacketBase(data, 128)
+	: NetworkPacketBase(data, headerRoom)
 {}
 
 OutboundNetworkPacket::OutboundNetworkPacket(const Bytes& data)
-	: NetworkPacketBase(gsl::as_bytes(gsl::span<const Byte>(data)), 128)
+	: NetworkPacketBase(gsl::as_bytes(gsl::span<const Byte>(data)), headerRoom)
 {
 }
 
 void OutboundNetworkPacket::addHeader(gsl::span<const gsl::byte> src)
 {
 	Expects(src.size_bytes() <= signed(dataStart));
-	
+
 	dataStart -= src.size_bytes();
-	memcpy(data.data() + dataStart, src.data(), src.size_bytes());
+	memcpy(buffer.data() + dataStart, src.data(), src.size_bytes());
+}
+
+void OutboundNetworkPacket::append(gsl::span<const gsl::byte> src)
+{
+	const size_t size = src.size_bytes();
+	if (size == 0) {
+		return;
+	}
+
+	if (dataEnd + size > buffer.capacity()) {
+		auto newBuffer = NetworkBuffer(std::max(dataEnd + size, buffer.capacity() * 2));
+		memcpy(newBuffer.data() + dataStart, buffer.data() + dataStart, getSize());
+		buffer = std::move(newBuffer);
+	}
+
+	memcpy(buffer.data() + dataEnd, src.data(), size);
+	dataEnd += size;
 }
 
 OutboundNetworkPacket& OutboundNetworkPacket::operator=(OutboundNetworkPacket&& other) noexcept
 {
-	data = other.data;
-	dataStart = other.dataStart;
-	other.dataStart = 0;
+	moveFrom(other);
 	return *this;
 }
 
@@ -81,9 +210,7 @@ InboundNetworkPacket::InboundNetworkPacket()
 InboundNetworkPacket::InboundNetworkPacket(InboundNetworkPacket&& other) noexcept
 	: NetworkPacketBase()
 {
-	data = other.data;
-	dataStart = other.dataStart;
-	other.dataStart = 0;
+	moveFrom(other);
 }
 
 InboundNetworkPacket::InboundNetworkPacket(gsl::span<const gsl::byte> data)
@@ -92,16 +219,21 @@ InboundNetworkPacket::InboundNetworkPacket(gsl::span<const gsl::byte> data)
 
 void InboundNetworkPacket::extractHeader(gsl::span<gsl::byte> dst)
 {
-	Expects(dst.size_bytes() <= signed(data.size()));
+	Expects(size_t(dst.size_bytes()) <= getSize());
 
-	memcpy(dst.data(), data.data() + dataStart, dst.size_bytes());
+	memcpy(dst.data(), buffer.data() + dataStart, dst.size_bytes());
 	dataStart += dst.size_bytes();
 }
 
+void InboundNetworkPacket::skip(size_t bytes)
+{
+	Expects(bytes <= getSize());
+
+	dataStart += bytes;
+}
+
 InboundNetworkPacket& InboundNetworkPacket::operator=(InboundNetworkPacket&& other) noexcept
 {
-	data = other.data;
-	dataStart = other.dataStart;
-	other.dataStart = 0;
+	moveFrom(other);
 	return *this;
 }
@@ -44,81 +44,75 @@ ConnectionStatus ReliableConnection::getStatus() const
 
 void ReliableConnection::send(OutboundNetworkPacket packet)
 {
-	ReliableSubPacket subPacket;
-	subPacket.data.resize(packet.getSize());
-	packet.copyTo(subPacket.data);
-	subPacket.resends = false;
-	subPacket.tag = -1;
-
-	sendTagged(gsl::span<ReliableSubPacket>(&subPacket, 1));
+	// A single untagged sub-packet, so both headers can go straight into the packet's header room
+	std::array<gsl::byte, maxSubHeaderSize> subHeader;
+	const size_t subHeaderSize = makeSubHeader(subHeader, packet.getSize(), false, 0);
+	packet.addHeader(gsl::span<const gsl::byte>(subHeader).subspan(0, subHeaderSize));
+
+	const unsigned short seq = nextSequenceToSend;
+	onSubPacketSent(-1);
+	sendWithHeader(std::move(packet), seq);
 }
 
 void ReliableConnection::sendTagged(gsl::span<ReliableSubPacket> subPackets)
 {
-	unsigned short firstSeq = nextSequenceToSend;
-	std::array<gsl::byte, 2048> buffer;
-	gsl::span<gsl::byte, 2048> dst(buffer);
-	size_t pos = sizeof(ReliableHeader);
+	const unsigned short firstSeq = nextSequenceToSend;
+	OutboundNetworkPacket packet;
 
 	for (auto& subPacket : subPackets) {
-		// Add reliable sub-header
-		bool isResend = subPacket.resends;
-		unsigned short resending = subPacket.resendSeq;
-		size_t size = subPacket.data.size();
-		bool longSize = size >= 64;
-		if (longSize) {
-			std::array<unsigned char, 2> b;
-			b[0] = static_cast<unsigned char>((size >> 8) & 0x3F) | 0x40 | (isResend ? 0x80 : 0);
-			b[1] = static_cast<unsigned char>(size & 0xFF);
-			memcpy(dst.subspan(pos, 2).data(), b.data(), 2);
-			pos += 2;
-		} else {
-			unsigned char b = static_cast<unsigned char>(size) | (isResend ? 0x80 : 0);
-			memcpy(dst.subspan(pos, 1).data(), &b, 1);
-			pos += 1;
-		}
-		if (resending) {
-			memcpy(dst.subspan(pos, 2).data(), &resending, 2);
-			pos += 2;
-		}
-
-		// Add data
-#ifdef _MSC_VER
-		memcpy_s(dst.subspan(pos).data(), dst.subspan(pos).size_bytes(), subPacket.data.data(), subPacket.data.size());
-#else
-		memcpy(dst.subspan(pos).data(), subPacket.data.data(), subPacket.data.size());
-#endif
-		pos += subPacket.data.size();
-
-		// Get sequence
-		unsigned short seq = nextSequenceToSend++;
-		size_t idx = seq % BUFFER_SIZE;
-		auto& sent = sentPackets[idx];
-		sent.waiting = true;
-		sent.tag = subPacket.tag;
-		lastSend = sent.timestamp = Clock::now();
+		std::array<gsl::byte, maxSubHeaderSize> subHeader;
+		const size_t subHeaderSize = makeSubHeader(subHeader, subPacket.data.size(), subPacket.resends, subPacket.resendSeq);
+		packet.append(gsl::span<const gsl::byte>(subHeader).subspan(0, subHeaderSize));
+		packet.append(gsl::span<const gsl::byte>(subPacket.data));
 
 		// Update caller on the sequence number of this
-		subPacket.seq = seq;
-		if (subPacket.resends) {
-			//std::cout << "Re-sending " << subPacket.resendSeq << " as " << seq << std::endl;
-		}
+		subPacket.seq = nextSequenceToSend;
+		onSubPacketSent(subPacket.tag);
 	}
 
-	// Add reliable header
+	sendWithHeader(std::move(packet), firstSeq);
+}
+
+size_t ReliableConnection::makeSubHeader(std::array<gsl::byte, maxSubHeaderSize>& dst, size_t size, bool isResend, unsigned short resending)
+{
+	size_t pos = 0;
+	if (size >= 64) {
+		std::array<unsigned char, 2> b;
+		b[0] = static_cast<unsigned char>((size >> 8) & 0x3F) | 0x40 | (isResend ? 0x80 : 0);
+		b[1] = static_cast<unsigned char>(size & 0xFF);
+		memcpy(dst.data(), b.data(), 2);
+		pos += 2;
+	} else {
+		unsigned char b = static_cast<unsigned char>(size) | (isResend ? 0x80 : 0);
+		memcpy(dst.data(), &b, 1);
+		pos += 1;
+	}
+	if (isResend) {
+		memcpy(dst.data() + pos, &resending, 2);
+		pos += 2;
+	}
+	return pos;
+}
+
+void ReliableConnection::onSubPacketSent(int tag)
+{
+	unsigned short seq = nextSequenceToSend++;
+	size_t idx = seq % BUFFER_SIZE;
+	auto& sent = sentPackets[idx];
+	sent.waiting = true;
+	sent.tag = tag;
+	lastSend = sent.timestamp = Clock::now();
+}
+
+void ReliableConnection::sendWithHeader(OutboundNetworkPacket packet, unsigned short firstSeq)
+{
 	ReliableHeader header;
 	header.sequence = firstSeq;
 	header.ack = highestReceived;
 	header.ackBits = generateAckBits();
-	auto headerData = gsl::as_bytes(gsl::span<ReliableHeader>(&header, 1));
-#ifdef _MSC_VER
-	memcpy_s(dst.data(), dst.size_bytes(), headerData.data(), headerData.size());
-#else
-	memcpy(dst.data(), headerData.data(), headerData.size());
-#endif
-
-	// Send
-	parent->send(OutboundNetworkPacket(dst.subspan(0, pos)));
+	packet.addHeader(header);
+
+	parent->send(std::move(packet));
 }
 
 bool ReliableConnection::receive(InboundNetworkPacket& packet)
@@ -136,9 +130,13 @@ bool ReliableConnection::receive(InboundNetworkPacket& packet)
 		return false;
 	}
 
-	if (!pendingPackets.empty()) {
-		packet = std::move(pendingPackets.front());
-		pendingPackets.pop_front();
+	if (nextPendingPacket < pendingPackets.size()) {
+		packet = std::move(pendingPackets[nextPendingPacket++]);
+		if (nextPendingPacket == pendingPackets.size()) {
+			// Keeps the capacity around for the next batch
+			pendingPackets.clear();
+			nextPendingPacket = 0;
+		}
 		return true;
 	}
 
@@ -191,17 +189,15 @@ void ReliableConnection::processReceivedPacket(InboundNetworkPacket& packet)
 		}
 
 		// Extract data
-		std::array<char, 2048> buffer;
-		if (size > buffer.size() || size > packet.getSize()) {
+		if (size > packet.getSize()) {
 			throw Exception("Unexpected sub-packet size: " + toString(size) + " bytes, packet is " + toString(packet.getSize()) + " bytes.", HalleyExceptions::Network);
 		}
-		auto subPacketData = gsl::span<char, 2048>(buffer).subspan(0, size);
-		packet.extractHeader(gsl::as_writable_bytes(subPacketData));
 
 		// Process sub-packet
 		if (onSeqReceived(seq, resend, resendOf)) {
-			pendingPackets.push_back(InboundNetworkPacket(gsl::as_bytes(subPacketData)));
+			pendingPackets.emplace_back(packet.getBytes().subspan(0, size));
 		}
+		packet.skip(size);
 		++seq;
 	}
 }
@@ -0,0 +1,579 @@
+#include "session/entity_replication.h"
+#include "connection/network_packet.h"
+#include "halley/support/logger.h"
+#include "halley/text/string_converter.h"
+
+using namespace Halley;
+
+namespace {
+	// Baselines older than this (in packets) are only used if nothing was sent after them, otherwise the full state is sent instead
+	constexpr uint32_t maxBaselineAge = 64;
+
+	// ReliableConnection never acks packets more than 32 sequences behind the newest one received, so a baseline can't be referenced
+	// once it's older than maxBaselineAge plus that window. Kept with plenty of slack.
+	constexpr uint32_t clientHistoryAge = maxBaselineAge + 64;
+
+	// Upper bound for the packet header (packet id and both counts), assuming variable length integers
+	constexpr size_t maxPacketHeaderSize = 16;
+	constexpr size_t maxRemovalSize = 10;
+
+	// Measures first, then writes straight into the buffer the sub-packet takes ownership of
+	template <typename F>
+	std::vector<gsl::byte> serializeToPacket(F f)
+	{
+		const auto options = ReplicatedEntityState::getSerializerOptions();
+		auto dry = Serializer(options);
+		f(dry);
+
+		std::vector<gsl::byte> result(dry.getSize());
+		auto s = Serializer(gsl::span<gsl::byte>(result), options);
+		f(s);
+		return result;
+	}
+}
+
+void ReplicatedEntityState::setBytes(size_t slot, Bytes bytes)
+{
+	Expects(slot < maxComponents);
+
+	if (slot >= components.size()) {
+		if (bytes.empty()) {
+			return;
+		}
+		components.resize(slot + 1);
+	}
+	components[slot] = std::move(bytes);
+
+	// Trailing empty slots are trimmed, so equal states always compare equal
+	while (!components.empty() && components.back().empty()) {
+		components.pop_back();
+	}
+}
+
+const Bytes& ReplicatedEntityState::getBytes(size_t slot) const
+{
+	static const Bytes empty;
+	return slot < components.size() ? components[slot] : empty;
+}
+
+void ReplicatedEntityState::clear(size_t slot)
+{
+	setBytes(slot, Bytes());
+}
+
+bool ReplicatedEntityState::has(size_t slot) const
+{
+	return !getBytes(slot).empty();
+}
+
+size_t ReplicatedEntityState::getNumSlots() const
+{
+	return components.size();
+}
+
+uint32_t ReplicatedEntityState::getChangedMask(const ReplicatedEntityState& other) const
+{
+	uint32_t mask = 0;
+	const size_t n = std::max(components.size(), other.components.size());
+	for (size_t i = 0; i < n; ++i) {
+		if (getBytes(i) != other.getBytes(i)) {
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+
+bool ReplicatedEntityState::operator==(const ReplicatedEntityState& other) const
+{
+	return components == other.components;
+}
+
+bool ReplicatedEntityState::operator!=(const ReplicatedEntityState& other) const
+{
+	return components != other.components;
+}
+
+SerializerOptions ReplicatedEntityState::getSerializerOptions()
+{
+	return SerializerOptions(SerializerOptions::maxVersion);
+}
+
+
+class EntityReplicationServer::Peer : private IReliableConnectionAckListener {
+public:
+	Peer(int peerId, std::shared_ptr<ReliableConnection> connection)
+		: peerId(peerId)
+		, connection(std::move(connection))
+	{
+		this->connection->addAckListener(*this);
+	}
+
+	~Peer()
+	{
+		connection->removeAckListener(*this);
+	}
+
+	int getId() const
+	{
+		return peerId;
+	}
+
+	void update(EntityReplicationServer& server)
+	{
+		// Incoming packets only carry acks, which get processed as they're read
+		InboundNetworkPacket packet;
+		while (connection->receive(packet)) {}
+
+		if (connection->getStatus() != ConnectionStatus::Connected) {
+			return;
+		}
+
+		pruneHistory();
+		updateInterest(server.source);
+		sendPackets(server);
+	}
+
+private:
+	struct SentState {
+		uint32_t packetId;
+		ReplicatedEntityState state;
+	};
+
+	struct EntityRecord {
+		uint32_t baselineId = 0; // 0 means the client has nothing to delta against
+		uint32_t lastSentId = 0;
+		ReplicatedEntityState baseline;
+		Vector<SentState> unacked;
+		float priority = 0;
+		bool relevant = false;
+		bool oversized = false; // Last attempt didn't fit in a packet, only used to avoid logging it every update
+	};
+
+	struct SentPacket {
+		uint32_t id;
+		Vector<ReplicatedEntityId> updated;
+		Vector<ReplicatedEntityId> removed;
+	};
+
+	struct Candidate {
+		ReplicatedEntityId id;
+		EntityRecord* record;
+	};
+
+	int peerId;
+	std::shared_ptr<ReliableConnection> connection;
+
+	HashMap<ReplicatedEntityId, EntityRecord> entities;
+	Vector<SentPacket> sentPackets; // Sorted by id
+	uint32_t nextPacketId = 1;
+
+	Vector<ReplicationInterest> interest;
+	Vector<Candidate> candidates;
+	Vector<ReplicatedEntityId> removals;
+
+	void pruneHistory()
+	{
+		const auto isOld = [&] (uint32_t packetId) { return packetId + maxBaselineAge < nextPacketId; };
+
+		sentPackets.erase(std::remove_if(sentPackets.begin(), sentPackets.end(), [&] (const SentPacket& p) { return isOld(p.id); }), sentPackets.end());
+
+		for (auto& [id, record]: entities) {
+			record.unacked.erase(std::remove_if(record.unacked.begin(), record.unacked.end(), [&] (const SentState& s) { return isOld(s.packetId); }), record.unacked.end());
+
+			// If something was sent after the baseline, the client might have moved on and dropped it
+			if (record.baselineId != 0 && isOld(record.baselineId) && record.lastSentId > record.baselineId) {
+				record.baselineId = 0;
+				record.baseline = ReplicatedEntityState();
+			}
+		}
+	}
+
+	void updateInterest(IEntityReplicationSource& source)
+	{
+		interest.clear();
+		source.getRelevantEntities(peerId, interest);
+
+		for (auto& [id, record]: entities) {
+			record.relevant = false;
+		}
+		for (const auto& i: interest) {
+			auto& record = entities[i.id];
+			record.relevant = true;
+			record.priority += i.priority;
+		}
+
+		removals.clear();
+		for (auto iter = entities.begin(); iter != entities.end(); ) {
+			auto& record = iter->second;
+			if (!record.relevant) {
+				if (record.lastSentId == 0) {
+					// Client never heard of it
+					iter = entities.erase(iter);
+					continue;
+				}
+				removals.push_back(iter->first);
+			}
+			++iter;
+		}
+		std::sort(removals.begin(), removals.end());
+	}
+
+	void sendPackets(EntityReplicationServer& server)
+	{
+		candidates.clear();
+		for (auto& [id, record]: entities) {
+			if (record.relevant) {
+				const auto& state = server.getFrameState(id);
+				if (record.baselineId == 0 || record.lastSentId > record.baselineId || state != record.baseline) {
+					candidates.push_back(Candidate{ id, &record });
+				} else {
+					// Nothing to send, so don't let it build up priority over entities that actually changed
+					record.priority = 0;
+				}
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [] (const Candidate& a, const Candidate& b)
+		{
+			if (a.record->priority != b.record->priority) {
+				return a.record->priority > b.record->priority;
+			}
+			return a.id < b.id;
+		});
+
+		size_t nextRemoval = 0;
+		size_t nextCandidate = 0;
+		for (size_t nPackets = 0; nPackets < server.maxPacketsPerUpdate; ++nPackets) {
+			if (nextRemoval == removals.size() && nextCandidate == candidates.size()) {
+				break;
+			}
+
+			SentPacket sent;
+			sent.id = nextPacketId++;
+			size_t size = maxPacketHeaderSize;
+
+			while (nextRemoval < removals.size() && size + maxRemovalSize <= server.maxPacketSize) {
+				const auto id = removals[nextRemoval++];
+				entities.at(id).lastSentId = sent.id;
+				sent.removed.push_back(id);
+				size += maxRemovalSize;
+			}
+
+			Bytes updates;
+			while (nextCandidate < candidates.size()) {
+				auto& candidate = candidates[nextCandidate];
+				auto& record = *candidate.record;
+				const auto& state = server.getFrameState(candidate.id);
+				auto entry = encodeUpdate(candidate.id, record, state);
+
+				if (maxPacketHeaderSize + entry.size() > server.maxPacketSize) {
+					// Wouldn't fit even on its own. Skip it, and try again next update in case it shrinks.
+					if (!record.oversized) {
+						Logger::logWarning("Replicated entity " + toString(candidate.id) + " takes " + toString(entry.size()) + " bytes, which doesn't fit in a packet. Not replicating it.");
+						record.oversized = true;
+					}
+					record.priority = 0;
+					++nextCandidate;
+					continue;
+				}
+				if (size + entry.size() > server.maxPacketSize) {
+					break;
+				}
+
+				updates.insert(updates.end(), entry.begin(), entry.end());
+				size += entry.size();
+				sent.updated.push_back(candidate.id);
+				record.unacked.push_back(SentState{ sent.id, state });
+				record.lastSentId = sent.id;
+				record.priority = 0;
+				record.oversized = false;
+				++nextCandidate;
+			}
+
+			if (sent.removed.empty() && sent.updated.empty()) {
+				// Everything left was skipped
+				--nextPacketId;
+				break;
+			}
+
+			const auto nRemoved = uint32_t(sent.removed.size());
+			const auto nUpdated = uint32_t(sent.updated.size());
+			ReliableSubPacket subPacket(serializeToPacket([&] (Serializer& s)
+			{
+				s << sent.id;
+				s << nRemoved;
+				for (const auto id: sent.removed) {
+					s << id;
+				}
+				s << nUpdated;
+				s << gsl::as_bytes(gsl::span<const Byte>(updates));
+			}));
+			subPacket.tag = int(sent.id);
+			connection->sendTagged(gsl::span<ReliableSubPacket>(&subPacket, 1));
+
+			sentPackets.push_back(std::move(sent));
+		}
+	}
+
+	Bytes encodeUpdate(ReplicatedEntityId id, const EntityRecord& record, const ReplicatedEntityState& state) const
+	{
+		const uint32_t mask = state.getChangedMask(record.baseline);
+		return Serializer::toBytes([&] (Serializer& s)
+		{
+			s << id;
+			s << record.baselineId;
+			s << mask;
+			for (size_t i = 0; i < ReplicatedEntityState::maxComponents; ++i) {
+				if (mask & (1u << i)) {
+					s << state.getBytes(i);
+				}
+			}
+		}, ReplicatedEntityState::getSerializerOptions());
+	}
+
+	void onPacketAcked(int tag) override
+	{
+		const auto packetId = uint32_t(tag);
+		const auto iter = std::lower_bound(sentPackets.begin(), sentPackets.end(), packetId, [] (const SentPacket& p, uint32_t id) { return p.id < id; });
+		if (iter == sentPackets.end() || iter->id != packetId) {
+			// Too old, already forgotten
+			return;
+		}
+
+		for (const auto id: iter->updated) {
+			const auto entityIter = entities.find(id);
+			if (entityIter == entities.end()) {
+				continue;
+			}
+
+			auto& record = entityIter->second;
+			auto& unacked = record.unacked;
+			const auto stateIter = std::find_if(unacked.begin(), unacked.end(), [&] (const SentState& s) { return s.packetId == packetId; });
+			if (stateIter != unacked.end() && packetId > record.baselineId) {
+				record.baselineId = packetId;
+				record.baseline = std::move(stateIter->state);
+				unacked.erase(unacked.begin(), stateIter + 1);
+			}
+		}
+
+		for (const auto id: iter->removed) {
+			const auto entityIter = entities.find(id);
+			// Don't forget it if it came back into view after this removal was sent
+			if (entityIter != entities.end() && !entityIter->second.relevant && entityIter->second.lastSentId <= packetId) {
+				entities.erase(entityIter);
+			}
+		}
+
+		sentPackets.erase(iter);
+	}
+};
+
+
+EntityReplicationServer::EntityReplicationServer(IEntityReplicationSource& source)
+	: source(source)
+{
+}
+
+EntityReplicationServer::~EntityReplicationServer() = default;
+
+void EntityReplicationServer::addPeer(int peerId, std::shared_ptr<ReliableConnection> connection)
+{
+	removePeer(peerId);
+	peers.push_back(std::make_unique<Peer>(peerId, std::move(connection)));
+}
+
+void EntityReplicationServer::removePeer(int peerId)
+{
+	peers.erase(std::remove_if(peers.begin(), peers.end(), [&] (const std::unique_ptr<Peer>& p) { return p->getId() == peerId; }), peers.end());
+}
+
+void EntityReplicationServer::setMaxPacketSize(size_t size)
+{
+	maxPacketSize = size;
+}
+
+void EntityReplicationServer::setMaxPacketsPerUpdate(size_t packets)
+{
+	maxPacketsPerUpdate = packets;
+}
+
+void EntityReplicationServer::update()
+{
+	frameStates.clear();
+	for (auto& peer: peers) {
+		peer->update(*this);
+	}
+}
+
+const ReplicatedEntityState& EntityReplicationServer::getFrameState(ReplicatedEntityId id)
+{
+	const auto iter = frameStates.find(id);
+	if (iter != frameStates.end()) {
+		return iter->second;
+	}
+
+	auto& state = frameStates[id];
+	source.serializeEntity(id, state);
+	return state;
+}
+
+
+EntityReplicationClient::EntityReplicationClient(std::shared_ptr<ReliableConnection> connection, IEntityReplicationSink& sink)
+	: connection(std::move(connection))
+	, sink(sink)
+{
+}
+
+void EntityReplicationClient::update()
+{
+	bool received = false;
+	InboundNetworkPacket packet;
+	while (connection->receive(packet)) {
+		try {
+			receivePacket(packet.getBytes());
+		} catch (const std::exception& e) {
+			Logger::logError("Error receiving entity snapshot: " + String(e.what()));
+			connection->close();
+			return;
+		}
+		received = true;
+	}
+
+	if (received) {
+		pruneHistory();
+
+		// Acks only travel on outbound packets, so make sure there is one
+		connection->send(OutboundNetworkPacket(Bytes()));
+	}
+}
+
+void EntityReplicationClient::receivePacket(gsl::span<const gsl::byte> data)
+{
+	auto s = Deserializer(data, ReplicatedEntityState::getSerializerOptions());
+
+	uint32_t packetId;
+	s >> packetId;
+	latestPacketId = std::max(latestPacketId, packetId);
+
+	uint32_t nRemoved;
+	s >> nRemoved;
+	for (uint32_t i = 0; i < nRemoved; ++i) {
+		ReplicatedEntityId id;
+		s >> id;
+		receiveRemoval(id, packetId);
+	}
+
+	uint32_t nUpdated;
+	s >> nUpdated;
+	for (uint32_t i = 0; i < nUpdated; ++i) {
+		ReplicatedEntityId id;
+		uint32_t baselineId;
+		uint32_t mask;
+		s >> id;
+		s >> baselineId;
+		s >> mask;
+		receiveUpdate(id, packetId, baselineId, mask, s);
+	}
+}
+
+void EntityReplicationClient::receiveRemoval(ReplicatedEntityId id, uint32_t packetId)
+{
+	const auto iter = entities.find(id);
+	if (iter == entities.end()) {
+		return;
+	}
+
+	auto& entity = iter->second;
+	if (packetId > entity.lastEventId) {
+		entity.lastEventId = packetId;
+		if (!entity.removed) {
+			entity.removed = true;
+			sink.onEntityRemoved(id);
+		}
+	}
+}
+
+void EntityReplicationClient::receiveUpdate(ReplicatedEntityId id, uint32_t packetId, uint32_t baselineId, uint32_t mask, Deserializer& s)
+{
+	Vector<Bytes> changed;
+	for (size_t i = 0; i < ReplicatedEntityState::maxComponents; ++i) {
+		if (mask & (1u << i)) {
+			s >> changed.emplace_back();
+		}
+	}
+
+	auto& entity = entities[id];
+	auto& history = entity.history;
+	const auto findEntry = [&] (uint32_t packetId)
+	{
+		return std::lower_bound(history.begin(), history.end(), packetId, [] (const HistoryEntry& e, uint32_t id) { return e.packetId < id; });
+	};
+
+	if (const auto iter = findEntry(packetId); iter != history.end() && iter->packetId == packetId) {
+		// Already have it
+		return;
+	}
+
+	ReplicatedEntityState state;
+	if (baselineId != 0) {
+		const auto iter = findEntry(baselineId);
+		if (iter == history.end() || iter->packetId != baselineId) {
+			// Can only happen with packets arriving so late that they'll never be acked, so the server won't rely on them
+			Logger::logWarning("Dropping entity snapshot " + toString(packetId) + " for " + toString(id) + ", baseline " + toString(baselineId) + " is gone.");
+			if (history.empty()) {
+				entities.erase(id);
+			}
+			return;
+		}
+		state = iter->state;
+	}
+
+	size_t nextChanged = 0;
+	for (size_t i = 0; i < ReplicatedEntityState::maxComponents; ++i) {
+		if (mask & (1u << i)) {
+			state.setBytes(i, std::move(changed[nextChanged++]));
+		}
+	}
+
+	// Packets older than the last one applied are still kept, as the server might use them as baselines
+	if (packetId > entity.lastEventId) {
+		const ReplicatedEntityState* prev = nullptr;
+		if (!entity.removed && entity.lastEventId != 0) {
+			const auto iter = findEntry(entity.lastEventId);
+			if (iter != history.end() && iter->packetId == entity.lastEventId) {
+				prev = &iter->state;
+			}
+		}
+
+		const auto changedMask = prev ? state.getChangedMask(*prev) : state.getChangedMask(ReplicatedEntityState());
+		entity.lastEventId = packetId;
+		entity.removed = false;
+		if (changedMask != 0 || !prev) {
+			sink.onEntityUpdated(id, state, changedMask);
+		}
+	}
+
+	history.insert(findEntry(packetId), HistoryEntry{ packetId, std::move(state) });
+}
+
+void EntityReplicationClient::pruneHistory()
+{
+	const auto isOld = [&] (uint32_t packetId) { return packetId + clientHistoryAge < latestPacketId; };
+
+	for (auto iter = entities.begin(); iter != entities.end(); ) {
+		auto& entity = iter->second;
+		auto& history = entity.history;
+
+		// The newest state is always kept, the server might still be using it as a baseline if the entity hasn't changed since
+		size_t nOld = 0;
+		while (nOld < history.size() && isOld(history[nOld].packetId)) {
+			++nOld;
+		}
+		const bool allOld = nOld == history.size();
+		if (allOld && entity.removed && isOld(entity.lastEventId)) {
+			iter = entities.erase(iter);
+			continue;
+		}
+		history.erase(history.begin(), history.begin() + std::min(nOld, history.size() - 1));
+		++iter;
+	}
+}
@@ -37,6 +37,25 @@ namespace Halley {
 
 	class SerializerState {};
 
+	// Whether T is serialized as exactly its in-memory bytes, so contiguous arrays of it can be copied in bulk.
+	// Integers only are when they're fixed-length (version 0), as later versions encode them with variable length.
+	template <typename T>
+	struct ByteSerializerRawType {
+		constexpr static bool isFloat = std::is_floating_point_v<T>;
+		constexpr static bool isInteger = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+	};
+
+	template <typename T, typename Element, size_t N>
+	struct ByteSerializerRawAggregate {
+		constexpr static bool isPacked = std::is_trivially_copyable_v<T> && sizeof(T) == N * sizeof(Element);
+		constexpr static bool isFloat = isPacked && ByteSerializerRawType<Element>::isFloat;
+		constexpr static bool isInteger = isPacked && ByteSerializerRawType<Element>::isInteger;
+	};
+
+	template <typename T> struct ByteSerializerRawType<Vector2D<T>> : ByteSerializerRawAggregate<Vector2D<T>, T, 2> {};
+	template <typename T> struct ByteSerializerRawType<Vector4D<T>> : ByteSerializerRawAggregate<Vector4D<T>, T, 4> {};
+	template <typename T> struct ByteSerializerRawType<Colour4<T>> : ByteSerializerRawAggregate<Colour4<T>, T, 4> {};
+
 	class ByteSerializationBase {
 	public:
 		ByteSerializationBase(SerializerOptions options)
@@ -56,6 +75,12 @@ namespace Halley {
 
 	protected:
 		SerializerOptions options;
+
+		template <typename T>
+		bool canCopyRaw() const
+		{
+			return ByteSerializerRawType<T>::isFloat || (ByteSerializerRawType<T>::isInteger && options.version == 0);
+		}
 		
 	private:
 		SerializerState* state = nullptr;
@@ -64,18 +89,27 @@ namespace Halley {
 		
 	class Serializer : public ByteSerializationBase {
 	public:
-		Serializer(SerializerOptions options);
+		// Receives the serialized data in order, in chunks of up to the buffer size (larger writes are passed through whole)
+		using Sink = std::function<void(gsl::span<const gsl::byte>)>;
+
+		Serializer(SerializerOptions options); // Dry run, only measures the size
 		explicit Serializer(gsl::span<gsl::byte> dst, SerializerOptions options);
+		explicit Serializer(Sink sink, SerializerOptions options, size_t bufferSize = 4096); // Call flush() when done
+
+		// Writes into a buffer that grows as needed, retrieve it with takeBytes()
+		static Serializer makeGrowable(SerializerOptions options, size_t initialCapacity = 256);
+
+		Serializer(const Serializer& other) = delete;
+		Serializer(Serializer&& other) = default;
+		Serializer& operator=(const Serializer& other) = delete;
+		Serializer& operator=(Serializer&& other) = default;
 
 		template <typename T, typename std::enable_if<std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
 		static Bytes toBytes(const T& f, SerializerOptions options = {})
 		{
-			auto dry = Serializer(options);
-			f(dry);
-			Bytes result(dry.getSize());
-			auto s = Serializer(gsl::as_writable_bytes(gsl::span<Halley::Byte>(result)), options);
+			auto s = makeGrowable(std::move(options));
 			f(s);
-			return result;
+			return s.takeBytes();
 		}
 
 		template <typename T, typename std::enable_if<!std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
@@ -84,6 +118,26 @@ namespace Halley {
 			return toBytes([&value](Serializer& s) { s << value; }, options);
 		}
 
+		template <typename T, typename std::enable_if<std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
+		static void toSink(const T& f, Sink sink, SerializerOptions options = {})
+		{
+			auto s = Serializer(std::move(sink), std::move(options));
+			f(s);
+			s.flush();
+		}
+
+		template <typename T, typename std::enable_if<!std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
+		static void toSink(const T& value, Sink sink, SerializerOptions options = {})
+		{
+			toSink([&value](Serializer& s) { s << value; }, std::move(sink), options);
+		}
+
+		// Growable serializers only. Leaves the serializer empty.
+		Bytes takeBytes();
+
+		// Sink serializers only, passes on any buffered data
+		void flush();
+
 		size_t getSize() const { return size; }
 
 		Serializer& operator<<(bool val) { return serializePod(val); }
@@ -110,6 +164,12 @@ namespace Halley {
 		{
 			unsigned int sz = static_cast<unsigned int>(val.size());
 			*this << sz;
+			if constexpr (ByteSerializerRawType<T>::isFloat || ByteSerializerRawType<T>::isInteger) {
+				if (canCopyRaw<T>()) {
+					write(val.data(), val.size() * sizeof(T));
+					return *this;
+				}
+			}
 			for (unsigned int i = 0; i < sz; i++) {
 				*this << val[i];
 			}
@@ -222,17 +282,39 @@ namespace Halley {
 		size_t getPosition() const { return size; }
 
 	private:
+		enum class Mode : uint8_t {
+			DryRun,
+			Fixed,
+			Growable,
+			Sink
+		};
+
 		size_t size = 0;
+		size_t dstOffset = 0; // Position of dst's first byte in the output, only non-zero once a sink has been flushed
 		gsl::span<gsl::byte> dst;
-		bool dryRun;
+		Mode mode;
+		Bytes buffer;
+		Sink sink;
+
+		void write(const void* data, size_t n)
+		{
+			if (mode != Mode::DryRun) {
+				const size_t offset = size - dstOffset;
+				if (offset + n > static_cast<size_t>(dst.size())) {
+					writeOverflow(data, n);
+					return;
+				}
+				memcpy(dst.data() + offset, data, n);
+			}
+			size += n;
+		}
+
+		void writeOverflow(const void* data, size_t n);
 
 		template <typename T>
 		Serializer& serializePod(T val)
 		{
-			if (!dryRun) {
-				memcpy(dst.data() + size, &val, sizeof(T));
-			}
-			size += sizeof(T);
+			write(&val, sizeof(T));
 			return *this;
 		}
 
@@ -319,6 +401,17 @@ namespace Halley {
 			*this >> sz;
 			ensureSufficientBytesRemaining(sz); // Expect at least one byte per vector entry
 
+			if constexpr (ByteSerializerRawType<T>::isFloat || ByteSerializerRawType<T>::isInteger) {
+				if (canCopyRaw<T>()) {
+					const size_t bytes = size_t(sz) * sizeof(T);
+					ensureSufficientBytesRemaining(bytes);
+					val.resize(sz);
+					memcpy(val.data(), src.data() + pos, bytes);
+					pos += bytes;
+					return *this;
+				}
+			}
+
 			val.clear();
 			val.reserve(sz);
 			for (unsigned int i = 0; i < sz; i++) {
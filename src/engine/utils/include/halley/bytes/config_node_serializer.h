@@ -5,6 +5,7 @@
 #include "halley/maths/colour.h"
 #include "halley/maths/rect.h"
 #include "config_node_serializer_base.h"
+#include <array>
 #include <set>
 
 
@@ -488,6 +489,33 @@ namespace Halley {
 	template<typename L, typename R = L>
 	struct HasOperatorDifferent : Detail::HasOperatorDifferent<L, R>::type {};
 
+	// Looks up several fields of a map node in a single ordered pass over it, rather than doing one map lookup per field.
+	// sortedNames must be in ascending (byte-wise) order. Fields that aren't present are returned as nullptr.
+	template <size_t N>
+	std::array<const ConfigNode*, N> findConfigNodeFields(const ConfigNode& node, const std::array<const char*, N>& sortedNames)
+	{
+		std::array<const ConfigNode*, N> result = {};
+		if (node.getType() != ConfigNodeType::Map && node.getType() != ConfigNodeType::DeltaMap) {
+			return result;
+		}
+
+		const auto& map = node.asMap();
+		auto iter = map.begin();
+		size_t i = 0;
+		while (i < N && iter != map.end()) {
+			const int cmp = std::string_view(iter->first).compare(sortedNames[i]);
+			if (cmp < 0) {
+				++iter;
+			} else if (cmp > 0) {
+				++i;
+			} else {
+				result[i++] = &iter->second;
+				++iter;
+			}
+		}
+		return result;
+	}
+
 	template <typename T>
 	class EntityConfigNodeSerializer {
 	public:
@@ -518,7 +546,23 @@ namespace Halley {
 				const bool delta = node.getType() == ConfigNodeType::DeltaMap;
 				const auto& fieldNode = node[name];
 				if (fieldNode.getType() != ConfigNodeType::Noop && (fieldNode.getType() != ConfigNodeType::Undefined || !delta)) {
-					ConfigNodeHelper<T>::deserialize(value, defaultValue, context, node[name]);
+					ConfigNodeHelper<T>::deserialize(value, defaultValue, context, fieldNode);
+				}
+			}
+		}
+
+		// Same as above, but with the field already looked up (see findConfigNodeFields). nullptr means the field is missing.
+		static void deserialize(T& value, const T& defaultValue, const ConfigNodeSerializationContext& context, const ConfigNode& node, const ConfigNode* fieldNode, int serializationMask)
+		{
+			if (context.matchType(serializationMask) && node.getType() != ConfigNodeType::Noop) {
+				const bool delta = node.getType() == ConfigNodeType::DeltaMap;
+				if (fieldNode) {
+					if (fieldNode->getType() != ConfigNodeType::Noop && (fieldNode->getType() != ConfigNodeType::Undefined || !delta)) {
+						ConfigNodeHelper<T>::deserialize(value, defaultValue, context, *fieldNode);
+					}
+				} else if (!delta) {
+					static const ConfigNode undefinedNode;
+					ConfigNodeHelper<T>::deserialize(value, defaultValue, context, undefinedNode);
 				}
 			}
 		}
@@ -538,5 +582,61 @@ namespace Halley {
 			return ConfigNode(node);
 		}
 	};
+
+	template <typename T>
+	class ConfigNodeAssetDependencies<ResourceReference<T>> {
+	public:
+		static void collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result)
+		{
+			auto assetId = node.hasKey("asset") ? node["asset"].asString("") : (node.getType() == ConfigNodeType::String ? node.asString("") : "");
+			if (!assetId.isEmpty()) {
+				result.emplace_back(T::getAssetType(), std::move(assetId));
+			}
+		}
+	};
+
+	template <typename T>
+	class ConfigNodeAssetDependencies<std::optional<T>> {
+	public:
+		static void collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result)
+		{
+			ConfigNodeAssetDependencies<T>::collect(node, result);
+		}
+	};
+
+	template <typename T>
+	class ConfigNodeAssetDependencies<std::vector<T>> {
+	public:
+		static void collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result)
+		{
+			if (node.getType() == ConfigNodeType::Sequence) {
+				for (const auto& n: node.asSequence()) {
+					ConfigNodeAssetDependencies<T>::collect(n, result);
+				}
+			}
+		}
+	};
+
+	template <typename T>
+	class DetachedCopy<std::optional<T>> {
+	public:
+		static void detach(std::optional<T>& value)
+		{
+			if (value) {
+				DetachedCopy<T>::detach(*value);
+			}
+		}
+	};
+
+	template <typename T>
+	class DetachedCopy<std::vector<T>> {
+	public:
+		static void detach(std::vector<T>& value)
+		{
+			for (auto& v: value) {
+				DetachedCopy<T>::detach(v);
+			}
+		}
+	};
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <utility>
 #include "halley/file_formats/config_file.h"
 #include "halley/support/exception.h"
 
@@ -68,4 +69,20 @@ namespace Halley {
             }
         }
     };
+
+	// Lists the assets a serialized value refers to, so they can be queued for preloading before it's deserialized (see Prefab::getDependencies)
+	// Types that don't refer to assets don't need to specialise this.
+	template <typename T>
+	class ConfigNodeAssetDependencies {
+	public:
+		static void collect(const ConfigNode& node, Vector<std::pair<AssetType, String>>& result) {}
+	};
+
+	// Called on a copy that mustn't share mutable state with the value it was copied from (see EntityFactory::createEntities)
+	// Only types whose copies share state through pointers, like Sprite's private material, need to specialise this.
+	template <typename T>
+	class DetachedCopy {
+	public:
+		static void detach(T& value) {}
+	};
 }
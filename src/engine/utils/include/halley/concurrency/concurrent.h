@@ -1,13 +1,14 @@
 #pragma once
 #include <array>
+#include <atomic>
+#include <exception>
 #include <functional>
+#include <thread>
 #include <halley/text/halleystring.h>
 #include "executor.h"
 #include "future.h"
 #include "task.h"
 
-#define HAS_THREADS 1
-
 namespace Halley
 {
 	enum class ThreadPriority {
@@ -22,7 +23,12 @@ namespace Halley
 		auto execute(ExecutionQueue& e, F f) -> Future<typename std::result_of<F()>::type>
 		{
 			using R = typename std::result_of<F()>::type;
-			return TaskQueueHelper<R>::enqueueOn(e, MovableFunction<R>(std::move(f)));
+			Promise<R> promise;
+			auto future = promise.getFuture();
+			e.addToQueue([f = std::move(f), promise = std::move(promise)] () mutable {
+				TaskHelper<R>::setPromise(promise, f);
+			});
+			return future;
 		}
 
 		template <typename F>
@@ -41,28 +47,101 @@ namespace Halley
 			return future.getFuture();
 		}
 
-		template <typename T, typename F>
-		void foreach(ExecutionQueue& e, T begin, T end, F f)
+		namespace Detail
 		{
-			const size_t n = end - begin;
-			constexpr size_t maxThreads = 8;
-			size_t nThreads = std::max(size_t(1), std::min(maxThreads, e.threadCount()));
-			std::array<Future<void>, maxThreads> futures;
+			template <typename F>
+			struct ParallelForContext
+			{
+				ExecutionQueue& queue;
+				F& f;
+				size_t grainSize;
+				size_t splitAbove;
+				std::atomic<int> pending { 0 };
+				std::atomic<bool> failed { false };
+				std::exception_ptr error;
+
+				ParallelForContext(ExecutionQueue& queue, F& f, size_t grainSize, size_t splitAbove)
+					: queue(queue)
+					, f(f)
+					, grainSize(grainSize)
+					, splitAbove(splitAbove)
+				{}
 
-			size_t prevEnd = 0;
-			for (size_t j = 0; j < nThreads; ++j) {
-				size_t curStart = prevEnd;
-				size_t curEnd = n * (j + 1) / nThreads;
-				prevEnd = curEnd;
+				void run(size_t start, size_t end)
+				{
+					try {
+						while (start < end && !failed) {
+							// Fork off the upper half while it's above the initial share, or while there are idle threads to pick it up
+							while (end - start > grainSize && (end - start > splitAbove || queue.hasIdleThreads())) {
+								const size_t mid = start + (end - start) / 2;
+								++pending;
+								queue.addToQueue([this, mid, end] ()
+								{
+									run(mid, end);
+									--pending;
+								});
+								end = mid;
+							}
 
-				futures[j] = execute([begin, f, curStart, curEnd]() {
-					for (auto i = begin + curStart; i < begin + curEnd; ++i) {
-						f(*i);
+							const size_t chunkEnd = std::min(end, start + grainSize);
+							for (size_t i = start; i < chunkEnd; ++i) {
+								f(i);
+							}
+							start = chunkEnd;
+						}
+					} catch (...) {
+						if (!failed.exchange(true)) {
+							error = std::current_exception();
+						}
 					}
-				});
+				}
+			};
+		}
+
+		// Fork/join loop over [begin, end). The range is split recursively, and ranges only keep being split while other threads are idle,
+		// so the grain adapts to the load. The calling thread helps running tasks until everything is done, which also makes it safe to nest.
+		template <typename F>
+		void parallelFor(ExecutionQueue& e, size_t begin, size_t end, F f, size_t grainSize = 0)
+		{
+			if (end <= begin) {
+				return;
+			}
+
+			const size_t n = end - begin;
+			const size_t nThreads = e.threadCount() + 1;
+			if (nThreads == 1 || n == 1) {
+				for (size_t i = begin; i < end; ++i) {
+					f(i);
+				}
+				return;
 			}
 
-			whenAll(futures.data(), futures.data() + nThreads).wait();
+			Detail::ParallelForContext<F> ctx(e, f, grainSize > 0 ? grainSize : std::max(size_t(1), n / (nThreads * 16)), std::max(size_t(1), n / nThreads));
+			ctx.run(begin, end);
+			while (ctx.pending > 0) {
+				if (!e.tryRunOne()) {
+					std::this_thread::yield();
+				}
+			}
+
+			if (ctx.error) {
+				std::rethrow_exception(ctx.error);
+			}
+		}
+
+		template <typename F>
+		void parallelFor(size_t begin, size_t end, F f, size_t grainSize = 0)
+		{
+			parallelFor(ExecutionQueue::getDefault(), begin, end, std::move(f), grainSize);
+		}
+
+		template <typename T, typename F>
+		void foreach(ExecutionQueue& e, T begin, T end, F f)
+		{
+			parallelFor(e, 0, size_t(end - begin), [&] (size_t i)
+			{
+				f(*(begin + i));
+			});
 		}
 
 		template <typename T, typename F>
@@ -6,22 +6,50 @@
 #include <functional>
 #include <atomic>
 #include <vector>
+#include <array>
 #include "halley/text/halleystring.h"
+#include "job.h"
+
+#ifndef HAS_THREADS
+#define HAS_THREADS 1
+#endif
 
 namespace Halley
 {
 	using TaskBase = std::function<void()>;
 
+	class WorkStealingDeque;
+
+	// Each thread running an Executor on this queue gets its own lock-free deque. Tasks enqueued from those threads go to their own deque,
+	// and idle workers steal from each other. Tasks from any other thread go through a shared, mutex-protected queue.
 	class ExecutionQueue
 	{
 	public:
 		ExecutionQueue();
-		void addToQueue(TaskBase task);
+		~ExecutionQueue();
+
+		ExecutionQueue(const ExecutionQueue& other) = delete;
+		ExecutionQueue& operator=(const ExecutionQueue& other) = delete;
+
+		template <typename F>
+		void addToQueue(F&& task)
+		{
+#if HAS_THREADS
+			submit(Job::make(std::forward<F>(task)));
+#else
+			task();
+#endif
+		}
+
+		// Runs one pending task on the calling thread, returning false if none could be found.
+		// Threads waiting on work they've forked should call this instead of blocking, so nested parallelism can't starve the pool.
+		bool tryRunOne();
 
-		TaskBase getNext();
-		std::vector<TaskBase> getAll();
+		Job* getNext();
+		std::vector<Job*> getAll();
 
 		size_t threadCount() const;
+		bool hasIdleThreads() const;
 		void onAttached();
 		void onDetached();
 		void abort();
@@ -29,13 +57,30 @@ namespace Halley
 		static ExecutionQueue& getDefault();
 
 	private:
-		std::deque<TaskBase> queue;
+		friend class Executor;
+
+		constexpr static size_t maxWorkers = 128;
+		constexpr static size_t workerQueueCapacity = 4096;
+		constexpr static int spinsBeforeSleep = 32;
+
+		std::deque<Job*> queue;
 		std::mutex mutex;
 		std::condition_variable condition;
 
+		std::array<std::atomic<WorkStealingDeque*>, maxWorkers> workerQueues;
+		std::atomic<size_t> numWorkerQueues;
+		std::atomic<int> pendingCount;
+		std::atomic<int> sleepingCount;
+
 		std::atomic<int> attachedCount;
 		std::atomic<bool> hasTasks;
 		std::atomic<bool> aborted;
+
+		void submit(Job* job);
+		Job* tryGetJob();
+		void attachWorkerThread();
+		void detachWorkerThread();
+		WorkStealingDeque* getLocalQueue() const;
 	};
 
 	class Executors
@@ -352,23 +352,10 @@ namespace Halley
 
 		int notify()
 		{
-			std::unique_lock<std::mutex> lock(mutex);
-			return --waitingFor;
-			/*
-			// Lock-free, juggling razors here!
-			while (true) {
-				int prev = waitingFor;
-				int next = prev - 1;
-				if (waitingFor.exchange(next) == prev) {
-					return next; // Swapped successfully
-				}
-				// Nope, race condition. Try again.
-			}
-			*/
+			return waitingFor.fetch_sub(1) - 1;
 		}
 
 	private:
-		std::mutex mutex;
 		std::atomic<int> waitingFor;
 	};
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Halley
+{
+	class JobPool;
+
+	// Type-erased, move-only callable used by ExecutionQueue.
+	// Small payloads (which covers most lambdas) are stored inline, and Job objects themselves are recycled through the pool of the thread
+	// that allocated them. Jobs released on another thread (typically a worker) are handed back to that pool, so a thread that keeps
+	// enqueueing tasks reuses its own jobs and doesn't touch the heap once it has warmed up.
+	class Job
+	{
+	public:
+		template <typename F>
+		static Job* make(F&& f)
+		{
+			using T = std::decay_t<F>;
+
+			Job* job = alloc();
+			if constexpr (sizeof(T) <= inlineSize && alignof(T) <= alignof(std::max_align_t)) {
+				job->payload = ::new (job->storage.data()) T(std::forward<F>(f));
+				job->destroyFunc = [] (void* p) { static_cast<T*>(p)->~T(); };
+			} else {
+				job->payload = ::new T(std::forward<F>(f));
+				job->destroyFunc = [] (void* p) { delete static_cast<T*>(p); };
+			}
+			job->invokeFunc = [] (void* p) { (*static_cast<T*>(p))(); };
+			return job;
+		}
+
+		// Runs the payload, then releases the job (even if the payload throws)
+		void run();
+
+		// Releases the job without running it
+		void discard();
+
+	private:
+		friend class JobPool;
+
+		constexpr static size_t inlineSize = 64;
+
+		alignas(std::max_align_t) std::array<std::byte, inlineSize> storage;
+		void* payload = nullptr;
+		void (*invokeFunc)(void*) = nullptr;
+		void (*destroyFunc)(void*) = nullptr;
+		JobPool* pool = nullptr;
+		Job* nextFree = nullptr;
+
+		Job() = default;
+
+		static Job* alloc();
+		static void release(Job* job);
+	};
+}
@@ -45,6 +45,11 @@ namespace Halley {
 	        heap.reserve(size);
         }
 
+        void clear()
+        {
+	        heap.clear();
+        }
+
     private:
         std::vector<T> heap;
         Comparator comparator;
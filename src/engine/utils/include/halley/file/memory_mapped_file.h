@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <gsl/span>
+
+namespace Halley
+{
+	class Path;
+	class MemoryMappedFilePimpl;
+
+	// Read-only view of a whole file mapped into the address space.
+	// Pages are shared with every other process mapping the same file, and only faulted in when touched.
+	class MemoryMappedFile
+	{
+	public:
+		MemoryMappedFile();
+		MemoryMappedFile(const MemoryMappedFile& other) = delete;
+		MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+		~MemoryMappedFile();
+
+		MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+		MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+		// Returns false if the file doesn't exist, is empty, or mapping isn't supported on this platform
+		bool open(const Path& path);
+		void close();
+		bool isOpen() const;
+
+		// Asks the OS to start paging in the whole file ahead of use
+		void prefetch() const;
+
+		gsl::span<const gsl::byte> getSpan() const;
+		const char* getData() const;
+		size_t getSize() const;
+
+		static bool isSupported();
+
+	private:
+		std::unique_ptr<MemoryMappedFilePimpl> pimpl;
+	};
+}
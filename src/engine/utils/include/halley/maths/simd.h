@@ -174,6 +174,28 @@ namespace Halley {
 #endif
         }
 
+		// Returns a mask with all bits set on the lanes where this < other, to be used with select()
+		inline SIMDVec4 lessThan(const SIMDVec4& other) const
+		{
+#if defined(HAS_SSE)
+			return SIMDVec4(_mm_cmplt_ps(x, other.x));
+#else
+			const float t = maskTrue();
+			return SIMDVec4(x[0] < other.x[0] ? t : 0.0f, x[1] < other.x[1] ? t : 0.0f, x[2] < other.x[2] ? t : 0.0f, x[3] < other.x[3] ? t : 0.0f);
+#endif
+		}
+
+		// Picks a on the lanes where mask is set, b elsewhere
+		static inline SIMDVec4 select(const SIMDVec4& mask, const SIMDVec4& a, const SIMDVec4& b)
+		{
+#if defined(HAS_SSE)
+			return SIMDVec4(_mm_or_ps(_mm_and_ps(mask.x, a.x), _mm_andnot_ps(mask.x, b.x)));
+#else
+			// The mask value is a NaN, which never compares equal
+			return SIMDVec4(mask.x[0] != 0.0f ? a.x[0] : b.x[0], mask.x[1] != 0.0f ? a.x[1] : b.x[1], mask.x[2] != 0.0f ? a.x[2] : b.x[2], mask.x[3] != 0.0f ? a.x[3] : b.x[3]);
+#endif
+		}
+
 		// Returns a[0] + a[1], a[2] + a[3], b[0] + b[1], b[2] + b[3]
 		static inline SIMDVec4 horizontalAdd(SIMDVec4 a, SIMDVec4 b)
 		{
@@ -213,6 +235,14 @@ namespace Halley {
 			x[2] = c;
 			x[3] = d;
 		}
+
+		static float maskTrue()
+		{
+			const uint32_t bits = 0xFFFFFFFFu;
+			float result;
+			memcpy(&result, &bits, sizeof(result));
+			return result;
+		}
 #endif
     };
 }
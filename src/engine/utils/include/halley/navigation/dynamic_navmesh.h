@@ -0,0 +1,82 @@
+#pragma once
+
+#include <map>
+#include "navmesh_generator.h"
+#include "halley/concurrency/future.h"
+
+namespace Halley {
+	class ExecutionQueue;
+
+	// Keeps the per-cell output of NavmeshGenerator around, so adding or removing obstacles at runtime only regenerates the cells they overlap.
+	// The whole-map passes (merging, regions, portals) still run on every rebuild, but those are cheap next to carving the obstacles out of each cell.
+	// This covers one chunk; the resulting NavmeshSet can be added to a larger one with addChunk.
+	class DynamicNavmesh {
+	public:
+		using ObstacleId = uint32_t;
+
+		// Obstacles, regions and portals in params are copied, so they don't need to outlive this
+		// Every rebuild links the result with numLandmarks, see NavmeshSet::linkNavmeshes
+		explicit DynamicNavmesh(const NavmeshGenerator::Params& params, size_t numLandmarks = 0);
+		~DynamicNavmesh();
+
+		DynamicNavmesh(const DynamicNavmesh& other) = delete;
+		DynamicNavmesh(DynamicNavmesh&& other) = delete;
+		DynamicNavmesh& operator=(const DynamicNavmesh& other) = delete;
+		DynamicNavmesh& operator=(DynamicNavmesh&& other) = delete;
+
+		ObstacleId addObstacle(Polygon obstacle);
+		void removeObstacle(ObstacleId id);
+
+		bool isDirty() const;
+		bool isRebuilding() const;
+
+		// Regenerates dirty cells right away, blocking until done
+		void rebuild();
+
+		// Regenerates dirty cells on the given queue. Obstacles can keep being added and removed in the meantime; those changes go into the next rebuild.
+		// The result only replaces the current NavmeshSet on update().
+		// params.getPolygonWeightCallback is called from the job, on one of the queue's threads, for polygons that only exist once the cells are merged.
+		// It has to be safe to call concurrently with the rest of the game, and anything it captures has to outlive the build (see isRebuilding).
+		void rebuildAsync(ExecutionQueue& queue);
+
+		// Swaps in the result of rebuildAsync if it's finished, returning true if the NavmeshSet changed.
+		// Only call this while no queries are running against getNavmeshSet() (e.g. a PathfindingService between frames), and call newFrame() on any such service afterwards.
+		bool update();
+
+		const NavmeshSet& getNavmeshSet() const;
+
+	private:
+		using Cell = std::vector<NavmeshGenerator::NavmeshNode>;
+
+		struct BuildResult {
+			std::vector<Cell> cells;
+			std::vector<size_t> builtCells;
+			std::optional<NavmeshSet> navmeshSet;
+		};
+
+		NavmeshGenerator::Params params;
+		std::vector<Polygon> regions;
+		std::vector<NavmeshSubworldPortal> subworldPortals;
+		size_t numLandmarks = 0;
+
+		std::vector<Polygon> staticObstacles;
+		std::map<ObstacleId, std::vector<Polygon>> dynamicObstacles;
+		ObstacleId nextObstacleId = 0;
+
+		std::vector<Cell> cells;
+		std::vector<Circle> cellBounds;
+		std::vector<bool> dirtyCells;
+
+		NavmeshSet navmeshSet;
+		Future<std::unique_ptr<BuildResult>> pendingBuild;
+		ExecutionQueue* pendingQueue = nullptr;
+
+		void markDirty(gsl::span<const Polygon> obstacle);
+		std::vector<size_t> takeDirtyCells();
+		std::vector<Polygon> getObstacles() const;
+		void applyResult(BuildResult& result);
+		void waitForPendingBuild();
+
+		static std::unique_ptr<BuildResult> build(const NavmeshGenerator::Params& params, size_t numLandmarks, std::vector<Cell> cells, std::vector<size_t> dirtyCells, std::vector<Polygon> obstacles);
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include "navmesh_set.h"
+#include "halley/data_structures/hash_map.h"
+
+namespace Halley {
+	// Distance to a goal and next step towards it, for every node of a NavmeshSet (across regions), from a single Dijkstra search outwards from the goal.
+	// Meant for crowds sharing a destination: any number of agents can sample it, instead of each one running its own query.
+	// Costs match Navmesh's, so weights are respected. The NavmeshSet must be linked, must outlive this, and any change to it invalidates the field.
+	class NavigationFlowField {
+	public:
+		struct Sample {
+			Vector2f nextPosition; // Heads to the next node, straight line from the sampled position is always walkable
+			float distance; // Estimated distance left to the goal node
+			uint16_t region;
+			bool inGoalNode; // If true, nextPosition is the goal the field was built for; agents can head straight for their own target instead
+		};
+
+		NavigationFlowField(const NavmeshSet& navmeshSet, Vector2f goal, int subWorld);
+
+		bool isValid() const;
+		Vector2f getGoal() const { return goal; }
+
+		// Locating the node is the only cost, and regionHint (e.g. the region of the previous sample) skips the region search when it's still correct
+		std::optional<Sample> sample(Vector2f pos, int subWorld, std::optional<uint16_t> regionHint = {}) const;
+
+	private:
+		constexpr static size_t notFound = std::numeric_limits<size_t>::max();
+
+		struct Entry {
+			float distance = std::numeric_limits<float>::infinity();
+			Vector2f nextPosition;
+		};
+
+		const NavmeshSet& navmeshSet;
+		Vector2f goal;
+		size_t goalNode = notFound;
+
+		std::vector<size_t> regionStart; // Index of the first node of each navmesh in entries
+		std::vector<Entry> entries;
+
+		void build();
+	};
+
+	// Shares flow fields between everyone heading to the same place. Fields are keyed by the navmesh node the goal is in,
+	// so a goal that moves within its node (e.g. a player being chased) keeps reusing the same field, and fields for nodes visited recently stay around.
+	// Not thread safe, but the fields it returns are immutable and can be sampled from any thread.
+	class NavigationFlowFieldCache {
+	public:
+		explicit NavigationFlowFieldCache(const NavmeshSet& navmeshSet, int maxAge = 60);
+
+		// Returns null if the goal isn't on the navmesh
+		std::shared_ptr<const NavigationFlowField> get(Vector2f goal, int subWorld);
+
+		// Call once per frame to drop fields that haven't been requested in maxAge frames
+		void newFrame();
+
+		// Call after changing the NavmeshSet
+		void clear();
+
+	private:
+		struct Entry {
+			std::shared_ptr<const NavigationFlowField> field;
+			int age = 0;
+		};
+
+		const NavmeshSet& navmeshSet;
+		int maxAge;
+		HashMap<uint64_t, Entry> fields;
+	};
+}
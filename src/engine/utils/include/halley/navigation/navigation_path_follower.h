@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include "navigation_path.h"
 
 namespace Halley {
 	class NavmeshSet;
+	class NavigationFlowField;
 
 	class NavigationPathFollower {
 	public:
@@ -15,6 +17,11 @@ namespace Halley {
 		void setPath(std::optional<NavigationPath> p);
 		const std::optional<NavigationPath>& getPath() const;
 
+		// Follows a flow field towards target instead of a path, so agents sharing a destination don't each need their own query.
+		// The field isn't serialized, so it has to be set again after loading.
+		void setFlowField(std::shared_ptr<const NavigationFlowField> field, Vector2f target);
+		const std::shared_ptr<const NavigationFlowField>& getFlowField() const;
+
 		void update(Vector2f curPos, int curSubWorld, const NavmeshSet& navmeshSet, float threshold);
 		
 		Vector2f getNextPosition() const;
@@ -29,8 +36,14 @@ namespace Halley {
 		std::optional<NavigationPath> path;
 		bool needsToReEvaluatePath = false;
 
+		std::shared_ptr<const NavigationFlowField> flowField;
+		Vector2f flowFieldTarget;
+		Vector2f flowFieldNextPos;
+		std::optional<uint16_t> flowFieldRegion;
+
 		void goToNextRegion(const NavmeshSet& navmeshSet);
 		void reEvaluatePath(const NavmeshSet& navmeshSet);
+		void updateFlowField(float threshold);
 	};
 
 	template<>
@@ -95,7 +95,9 @@ namespace Halley {
 		[[nodiscard]] const std::vector<Node>& getNodes() const { return nodes; }
 		[[nodiscard]] const std::vector<Polygon>& getPolygons() const { return polygons; }
 		[[nodiscard]] const std::vector<Portal>& getPortals() const { return portals; }
+		[[nodiscard]] float getPortalCost(size_t fromPortal, size_t toPortal) const; // Cost of crossing this navmesh between two portals, infinity if there's no path
 		[[nodiscard]] const std::vector<float>& getWeights() const { return weights; }
+		[[nodiscard]] Vector2f getScaleFactor() const { return scaleFactor; }
 		[[nodiscard]] const std::vector<std::pair<uint16_t, LineSegment>>& getOpenEdges() const { return openEdges; }
 		[[nodiscard]] const Polygon& getPolygon(int id) const;
 		[[nodiscard]] size_t getNumNodes() const { return nodes.size(); }
@@ -145,6 +147,7 @@ namespace Halley {
 		std::vector<Node> nodes;
 		std::vector<Polygon> polygons;
 		std::vector<Portal> portals;
+		std::vector<float> portalCosts; // portals.size() squared, indexed by [from * portals.size() + to]
 		std::vector<float> weights;
 		std::vector<std::pair<uint16_t, LineSegment>> openEdges;
 		int subWorld = 0;
@@ -160,6 +163,7 @@ namespace Halley {
 		Vector2i worldGridPos;
 
 		float totalArea = 0;
+		Rect4f aabb; // Slightly grown, so it's a cheap early out for containsPoint
 
 		std::optional<std::vector<NodeAndConn>> pathfind(int fromId, int toId) const;
 		std::vector<NodeAndConn> makeResult(const std::vector<State>& state, int startId, int endId) const;
@@ -174,8 +178,10 @@ namespace Halley {
 		void addToPortals(NodeAndConn nodeAndConn, int id);
 		Portal& getPortals(int id);
 		void postProcessPortals();
+		void computePortalCosts();
 
 		void computeArea();
+		void computeAABB();
 
 		void generateOpenEdges();
 	};
@@ -4,6 +4,8 @@
 #include "navmesh_set.h"
 
 namespace Halley {
+	class ExecutionQueue;
+
 	class NavmeshGenerator {
 	public:
 		struct Params {
@@ -14,11 +16,14 @@ namespace Halley {
 			int subWorld = 0;
 			float agentSize = 1.0f;
 			std::function<float(int, const Polygon&)> getPolygonWeightCallback;
+			ExecutionQueue* executionQueue = nullptr; // If set, the bounds' cells are generated in parallel on this queue
 		};
 
 		static NavmeshSet generate(const Params& params);
 
 	private:
+		friend class DynamicNavmesh;
+
 		enum class NavmeshNodePortalSide {
 			Unknown,
 			Before,
@@ -49,6 +54,11 @@ namespace Halley {
 		
 		constexpr static size_t maxPolygonSides = 8;
 
+		static Polygon makeCell(const NavmeshBounds& bounds, size_t i, size_t j);
+		static float getMaxPolygonSize(const NavmeshBounds& bounds);
+		static std::vector<NavmeshNode> generateCell(const NavmeshBounds& bounds, size_t i, size_t j, gsl::span<const Polygon> obstacles);
+		static NavmeshSet generateFromCells(const Params& params, gsl::span<const std::vector<NavmeshNode>> cells);
+
 		static std::vector<Polygon> generateByPolygonSubtraction(gsl::span<const Polygon> inputPolygons, gsl::span<const Polygon> obstacles, Circle bounds);
 		static std::vector<Polygon> preProcessObstacles(gsl::span<const Polygon> obstacles, float agentSize);
 		static Polygon makeAgentMask(float agentSize);
@@ -1,12 +1,31 @@
 #pragma once
 
+#include <mutex>
 #include "navmesh.h"
 #include "navigation_query.h"
 #include "navigation_path.h"
+#include "halley/data_structures/hash_map.h"
 
 namespace Halley {
+	// Remembers region-level paths by start and end region, so a burst of queries between the same regions only searches the portal graph once.
+	// Entries ignore where in those regions the queries started and ended, so this is meant to be cleared every frame, and whenever the navmeshes change.
+	// Safe to share between threads.
+	class NavmeshRegionPathCache {
+	public:
+		void clear();
+
+		bool tryGet(uint16_t fromRegion, uint16_t toRegion, std::vector<NavigationPath::RegionNode>& result) const;
+		void set(uint16_t fromRegion, uint16_t toRegion, std::vector<NavigationPath::RegionNode> path);
+
+	private:
+		mutable std::mutex mutex;
+		HashMap<uint32_t, std::vector<NavigationPath::RegionNode>> paths;
+	};
+
 	class NavmeshSet {
 	public:
+		constexpr static size_t maxLandmarks = 32;
+
 		NavmeshSet();
 		NavmeshSet(const ConfigNode& nodeData);
 
@@ -18,14 +37,22 @@ namespace Halley {
 		void clear();
 		void clearSubWorld(int subWorld);
 
-		void linkNavmeshes();
+		// Builds the portal graph used for cross-region queries. Edge costs come from each navmesh's precomputed portal-to-portal costs.
+		// Optionally, distances from numLandmarks portals are also stored, which tightens the search's heuristic (ALT) on maps where straight lines are a poor estimate, e.g. mazes.
+		void linkNavmeshes(size_t numLandmarks = 0);
+
+		// Weights the heuristic of the search between regions, so it expands fewer portals at the cost of optimality: paths found can cost up to weight times the cheapest one.
+		// Defaults to 1, which always finds the cheapest path.
+		void setHeuristicWeight(float weight);
+
 		void reportUnlinkedPortals(std::function<String(Vector2i)> getChunkName) const;
 
-		std::optional<NavigationPath> pathfind(const NavigationQuery& query) const;
+		std::optional<NavigationPath> pathfind(const NavigationQuery& query, NavmeshRegionPathCache* regionPathCache = nullptr) const;
 		std::optional<NavigationPath> pathfindInRegion(const NavigationQuery& query, uint16_t regionId) const;
 		std::optional<NavigationPath> pathfindBetweenRegions(const NavigationQuery& queryStart, const NavigationQuery& queryEnd, uint16_t startRegionId, uint16_t endRegionId, const Navmesh::Portal& portal, NavigationQuery::PostProcessingType postProcessing) const;
 
 		gsl::span<const Navmesh> getNavmeshes() const { return navmeshes; }
+		size_t getNumLandmarks() const { return numLandmarks; }
 		const Navmesh* getNavMeshAt(Vector2f pos, int subWorld) const;
 		size_t getNavMeshIdxAt(Vector2f pos, int subWorld) const;
 
@@ -91,7 +118,13 @@ namespace Halley {
 		std::vector<PortalNode> portalNodes;
 		std::vector<RegionNode> regionNodes;
 
+		float heuristicWeight = 1.0f;
+		size_t numLandmarks = 0;
+		std::vector<float> landmarkDistances; // Distance from each landmark to each portal node, indexed by [portalId * numLandmarks + landmark]
+
 		void tryLinkNavMeshes(uint16_t idxA, uint16_t idxB);
+		void computeLandmarks(size_t count);
+		void computeDistancesFrom(NodeId portalId, std::vector<float>& dist) const;
 
 		std::vector<NavigationPath::RegionNode> findRegionPath(Vector2f startPos, Vector2f endPos, uint16_t fromRegionId, uint16_t toRegionId) const;
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <gsl/gsl>
+#include "navmesh_set.h"
+#include "halley/concurrency/future.h"
+#include "halley/data_structures/vector.h"
+
+namespace Halley {
+	class ExecutionQueue;
+
+	// Runs batches of navigation queries against a NavmeshSet on a worker pool.
+	// Each worker thread reuses its own search state, and region-level paths are shared between queries until the next call to newFrame().
+	// The NavmeshSet must outlive this, and must not be modified while queries are in flight.
+	class PathfindingService {
+	public:
+		using Result = std::optional<NavigationPath>;
+
+		explicit PathfindingService(const NavmeshSet& navmeshSet);
+		PathfindingService(const NavmeshSet& navmeshSet, ExecutionQueue& queue);
+
+		// Call once per frame, and after changing the NavmeshSet, to drop cached region paths
+		void newFrame();
+
+		// Queries are split into jobs of up to queriesPerJob each. Every future is fulfilled as soon as its own query is done.
+		// This object must outlive the returned futures.
+		Vector<Future<Result>> submit(Vector<NavigationQuery> queries);
+		Future<Result> submit(NavigationQuery query);
+
+		// Same as submit, but blocks until all results are ready, running jobs on the calling thread while it waits
+		Vector<Result> run(gsl::span<const NavigationQuery> queries);
+
+		void setQueriesPerJob(size_t n);
+
+	private:
+		const NavmeshSet& navmeshSet;
+		ExecutionQueue& queue;
+		NavmeshRegionPathCache regionPathCache;
+		size_t queriesPerJob = 8;
+
+		Result pathfind(const NavigationQuery& query);
+	};
+}
@@ -6,6 +6,7 @@
 #include <condition_variable>
 #include "metadata.h"
 #include "halley/text/enum_names.h"
+#include "halley/data_structures/vector.h"
 
 #if defined(DEV_BUILD) && !defined(__NX_TOOLCHAIN_MAJOR__)
 #define ENABLE_HOT_RELOAD
@@ -144,6 +145,9 @@ namespace Halley
 		void increaseAssetVersion();
 		void reloadResource(Resource&& resource);
 
+		// Other assets this one is going to need, so they can be loaded ahead of time (doesn't need to be exhaustive, missing entries are skipped)
+		virtual Vector<std::pair<AssetType, String>> getDependencies() const;
+
 	protected:
 		virtual void reload(Resource&& resource);
 
@@ -185,6 +189,7 @@ namespace Halley
 		void waitForLoad() const;
 
 		bool isLoaded() const;
+		bool hasFailed() const;
 
 	private:
 		std::atomic<bool> failed;
@@ -195,6 +200,7 @@ namespace Halley
 
 	struct ResourceOptions {
 		bool retainPixelData = false;
+		double preloadFrameBudget = 0.004; // Seconds per frame that Resources::update() can spend constructing preloaded resources
 
 		ResourceOptions() = default;
 		ResourceOptions(bool retainPixelData)
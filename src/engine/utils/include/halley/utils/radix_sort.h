@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <gsl/span>
+#include "halley/data_structures/vector.h"
+
+namespace Halley
+{
+	// Maps values to unsigned integers that sort in the same order, so they can be packed into radix sort keys
+	inline uint32_t toRadixKey(int32_t value)
+	{
+		return static_cast<uint32_t>(value) ^ 0x80000000u;
+	}
+
+	inline uint32_t toRadixKey(float value)
+	{
+		if (value == 0.0f) {
+			// Make -0 and +0 the same key
+			value = 0.0f;
+		}
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		// Negative numbers have all bits flipped (so larger magnitudes come first), positive numbers just get the sign bit set
+		return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	}
+
+	// Stable LSD radix sort of the indices of keys, one byte per pass.
+	// Passes where every key has the same byte are skipped, so keys that only use a few distinct bits are cheap.
+	// On return, order contains the indices of keys in ascending order, and scratch is garbage.
+	template <typename Key>
+	void radixSortIndices(gsl::span<const Key> keys, Vector<uint32_t>& order, Vector<uint32_t>& scratch)
+	{
+		static_assert(std::is_unsigned_v<Key>, "Radix sort keys must be unsigned integers");
+		constexpr size_t nPasses = sizeof(Key);
+
+		const size_t n = size_t(keys.size());
+		order.resize(n);
+		scratch.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			order[i] = uint32_t(i);
+		}
+
+		// Build every histogram in one go
+		std::array<std::array<uint32_t, 256>, nPasses> counts = {};
+		for (const auto key: keys) {
+			for (size_t pass = 0; pass < nPasses; ++pass) {
+				++counts[pass][(key >> (pass * 8)) & 0xFF];
+			}
+		}
+
+		for (size_t pass = 0; pass < nPasses; ++pass) {
+			auto& count = counts[pass];
+			const auto shift = pass * 8;
+			if (n == 0 || count[(keys[0] >> shift) & 0xFF] == n) {
+				continue;
+			}
+
+			uint32_t total = 0;
+			for (auto& c: count) {
+				const auto cur = c;
+				c = total;
+				total += cur;
+			}
+
+			for (size_t i = 0; i < n; ++i) {
+				const auto idx = order[i];
+				scratch[count[(keys[idx] >> shift) & 0xFF]++] = idx;
+			}
+			std::swap(order, scratch);
+		}
+	}
+}
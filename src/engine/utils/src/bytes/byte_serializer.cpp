@@ -15,15 +15,86 @@ SerializerState* ByteSerializationBase::setState(SerializerState* s)
 
 Serializer::Serializer(SerializerOptions options)
 	: ByteSerializationBase(std::move(options))
-	, dryRun(true)
+	, mode(Mode::DryRun)
 {}
 
 Serializer::Serializer(gsl::span<gsl::byte> dst, SerializerOptions options)
 	: ByteSerializationBase(std::move(options))
 	, dst(dst)
-	, dryRun(false)
+	, mode(Mode::Fixed)
 {}
 
+Serializer::Serializer(Sink sink, SerializerOptions options, size_t bufferSize)
+	: ByteSerializationBase(std::move(options))
+	, mode(Mode::Sink)
+	, sink(std::move(sink))
+{
+	buffer.resize(std::max(bufferSize, size_t(16)));
+	dst = gsl::as_writable_bytes(gsl::span<Byte>(buffer));
+}
+
+Serializer Serializer::makeGrowable(SerializerOptions options, size_t initialCapacity)
+{
+	auto result = Serializer(std::move(options));
+	result.mode = Mode::Growable;
+	result.buffer.resize(initialCapacity);
+	result.dst = gsl::as_writable_bytes(gsl::span<Byte>(result.buffer));
+	return result;
+}
+
+Bytes Serializer::takeBytes()
+{
+	if (mode != Mode::Growable) {
+		throw Exception("Only growable serializers can return their bytes.", HalleyExceptions::Utils);
+	}
+
+	buffer.resize(size);
+	size = 0;
+	dst = {};
+	return std::move(buffer);
+}
+
+void Serializer::flush()
+{
+	if (mode != Mode::Sink) {
+		throw Exception("Only sink serializers can be flushed.", HalleyExceptions::Utils);
+	}
+
+	if (size > dstOffset) {
+		sink(gsl::span<const gsl::byte>(dst.data(), size - dstOffset));
+		dstOffset = size;
+	}
+}
+
+void Serializer::writeOverflow(const void* data, size_t n)
+{
+	const auto* bytes = static_cast<const gsl::byte*>(data);
+
+	switch (mode) {
+	case Mode::Growable:
+		buffer.resize(std::max(buffer.size() * 2, size + n));
+		dst = gsl::as_writable_bytes(gsl::span<Byte>(buffer));
+		memcpy(dst.data() + size, bytes, n);
+		break;
+
+	case Mode::Sink:
+		flush();
+		if (n >= static_cast<size_t>(dst.size())) {
+			// Too big to be worth buffering
+			sink(gsl::span<const gsl::byte>(bytes, n));
+			dstOffset += n;
+		} else {
+			memcpy(dst.data(), bytes, n);
+		}
+		break;
+
+	default:
+		throw Exception("Serializer ran out of space in its buffer.", HalleyExceptions::Utils);
+	}
+
+	size += n;
+}
+
 Serializer& Serializer::operator<<(const std::string& str)
 {
 	return *this << String(str);
@@ -74,10 +145,7 @@ Serializer& Serializer::operator<<(const Path& path)
 
 Serializer& Serializer::operator<<(gsl::span<const gsl::byte> span)
 {
-	if (!dryRun) {
-		memcpy(dst.data() + size, span.data(), span.size_bytes());
-	}
-	size += span.size_bytes();
+	write(span.data(), span.size_bytes());
 	return *this;
 }
 
@@ -85,11 +153,7 @@ Serializer& Serializer::operator<<(const Bytes& bytes)
 {
 	const uint32_t byteSize = static_cast<uint32_t>(bytes.size());
 	*this << byteSize;
-
-	if (!dryRun) {
-		memcpy(dst.data() + size, bytes.data(), bytes.size());
-	}
-	size += bytes.size();
+	write(bytes.data(), bytes.size());
 	return *this;
 }
 
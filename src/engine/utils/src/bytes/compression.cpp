@@ -1,5 +1,7 @@
 #include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <vector>
 #include "halley/bytes/compression.h"
 //#include "../../contrib/lodepng/lodepng.h"
 #include "../../../../contrib/zlib/zlib.h"
@@ -168,3 +170,202 @@ Bytes Compression::decompressRaw(gsl::span<const gsl::byte> bytes, size_t maxSiz
 		return result;
 	}
 }
+
+namespace {
+	constexpr size_t lz4MinMatch = 4;
+	constexpr size_t lz4LastLiterals = 5;
+	constexpr size_t lz4MatchSearchLimit = 12; // A match can't start within the last 12 bytes
+	constexpr size_t lz4MaxOffset = 65535;
+	constexpr int lz4HashBits = 14;
+
+	uint32_t lz4Read32(const uint8_t* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, 4);
+		return v;
+	}
+
+	uint32_t lz4Hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - lz4HashBits);
+	}
+
+	uint8_t* lz4WriteLength(uint8_t* op, size_t len)
+	{
+		while (len >= 255) {
+			*op++ = 255;
+			len -= 255;
+		}
+		*op++ = uint8_t(len);
+		return op;
+	}
+
+	uint8_t* lz4WriteSequence(uint8_t* op, const uint8_t* literals, size_t litLen, size_t offset, size_t matchLen)
+	{
+		uint8_t* token = op++;
+		*token = uint8_t(std::min(litLen, size_t(15)) << 4);
+		if (litLen >= 15) {
+			op = lz4WriteLength(op, litLen - 15);
+		}
+		memcpy(op, literals, litLen);
+		op += litLen;
+
+		if (matchLen > 0) {
+			*op++ = uint8_t(offset & 0xFF);
+			*op++ = uint8_t(offset >> 8);
+			const size_t len = matchLen - lz4MinMatch;
+			*token |= uint8_t(std::min(len, size_t(15)));
+			if (len >= 15) {
+				op = lz4WriteLength(op, len - 15);
+			}
+		}
+		return op;
+	}
+}
+
+Bytes Compression::compressLZ4(gsl::span<const gsl::byte> bytes)
+{
+	const uint64_t inSize = bytes.size_bytes();
+	const auto* src = reinterpret_cast<const uint8_t*>(bytes.data());
+	const size_t n = size_t(inSize);
+
+	// Worst case is all literals: one length byte per 255, plus token and the length prefix
+	Bytes result(8 + n + n / 255 + 16);
+	memcpy(result.data(), &inSize, 8);
+	uint8_t* op = result.data() + 8;
+
+	size_t anchor = 0;
+	if (n > lz4MatchSearchLimit) {
+		std::vector<uint32_t> table(size_t(1) << lz4HashBits, 0); // Stores position + 1, so zero is empty
+		const size_t matchLimit = n - lz4LastLiterals;
+		size_t ip = 0;
+		size_t step = 1 << 6;
+
+		while (ip < n - lz4MatchSearchLimit) {
+			const uint32_t sequence = lz4Read32(src + ip);
+			const uint32_t h = lz4Hash(sequence);
+			const size_t ref = table[h];
+			table[h] = uint32_t(ip + 1);
+
+			if (ref != 0 && ip - (ref - 1) <= lz4MaxOffset && lz4Read32(src + ref - 1) == sequence) {
+				size_t match = ref - 1;
+
+				// Extend backwards into pending literals, then forwards
+				while (ip > anchor && match > 0 && src[ip - 1] == src[match - 1]) {
+					--ip;
+					--match;
+				}
+				size_t len = lz4MinMatch;
+				while (ip + len < matchLimit && src[match + len] == src[ip + len]) {
+					++len;
+				}
+
+				op = lz4WriteSequence(op, src + anchor, ip - anchor, ip - match, len);
+				ip += len;
+				anchor = ip;
+				step = 1 << 6;
+			} else {
+				// Skip faster through data that doesn't compress
+				ip += step >> 6;
+				++step;
+			}
+		}
+	}
+
+	op = lz4WriteSequence(op, src + anchor, n - anchor, 0, 0);
+	result.resize(size_t(op - result.data()));
+	return result;
+}
+
+Bytes Compression::decompressLZ4(gsl::span<const gsl::byte> bytes, size_t maxSize)
+{
+	if (bytes.size_bytes() < 8) {
+		throw Exception("LZ4 data is too short.", HalleyExceptions::Compression);
+	}
+	uint64_t expectedOutSize;
+	memcpy(&expectedOutSize, bytes.data(), 8);
+	if (expectedOutSize > uint64_t(maxSize)) {
+		throw Exception("File is too big to decompress: " + String::prettySize(expectedOutSize), HalleyExceptions::Compression);
+	}
+
+	auto result = Bytes(size_t(expectedOutSize));
+	decompressLZ4Raw(bytes.subspan(8), gsl::as_writable_bytes(gsl::span<Byte>(result)));
+	return result;
+}
+
+void Compression::decompressLZ4Raw(gsl::span<const gsl::byte> bytes, gsl::span<gsl::byte> dst)
+{
+	const auto* ip = reinterpret_cast<const uint8_t*>(bytes.data());
+	const auto* const inEnd = ip + bytes.size_bytes();
+	auto* op = reinterpret_cast<uint8_t*>(dst.data());
+	auto* const outStart = op;
+	auto* const outEnd = op + dst.size_bytes();
+
+	auto readLength = [&] (size_t len) -> size_t
+	{
+		if (len == 15) {
+			uint8_t b;
+			do {
+				if (ip >= inEnd) {
+					throw Exception("LZ4 data is truncated.", HalleyExceptions::Compression);
+				}
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		return len;
+	};
+
+	while (ip < inEnd) {
+		const uint8_t token = *ip++;
+
+		const size_t litLen = readLength(token >> 4);
+		if (litLen > size_t(inEnd - ip) || litLen > size_t(outEnd - op)) {
+			throw Exception("LZ4 data is corrupt (literals out of bounds).", HalleyExceptions::Compression);
+		}
+		if (litLen <= 16 && inEnd - ip >= 16 && outEnd - op >= 16) {
+			// Short literal runs are copied with a fixed-size copy, overshooting into space that gets overwritten next
+			memcpy(op, ip, 16);
+		} else {
+			memcpy(op, ip, litLen);
+		}
+		ip += litLen;
+		op += litLen;
+
+		if (ip == inEnd) {
+			// The last sequence has no match
+			break;
+		}
+
+		if (inEnd - ip < 2) {
+			throw Exception("LZ4 data is truncated.", HalleyExceptions::Compression);
+		}
+		const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+		ip += 2;
+		const size_t matchLen = readLength(token & 15) + lz4MinMatch;
+		if (offset == 0 || offset > size_t(op - outStart) || matchLen > size_t(outEnd - op)) {
+			throw Exception("LZ4 data is corrupt (match out of bounds).", HalleyExceptions::Compression);
+		}
+
+		const uint8_t* match = op - offset;
+		if (offset >= 8 && size_t(outEnd - op) >= matchLen + 8) {
+			// Copy in 8-byte steps, which is safe with overlap as long as the offset is at least 8
+			for (size_t i = 0; i < matchLen; i += 8) {
+				memcpy(op + i, match + i, 8);
+			}
+			op += matchLen;
+		} else if (offset >= matchLen) {
+			memcpy(op, match, matchLen);
+			op += matchLen;
+		} else {
+			// Overlapping copy, repeats the last offset bytes
+			for (size_t i = 0; i < matchLen; ++i) {
+				*op++ = *match++;
+			}
+		}
+	}
+
+	if (op != outEnd) {
+		throw Exception("Unexpected outsize (" + toString(size_t(op - outStart)) + ") when decompressing LZ4 data, expected (" + toString(dst.size_bytes()) + ").", HalleyExceptions::Compression);
+	}
+}
@@ -3,55 +3,350 @@
 #include <halley/support/exception.h>
 #include "halley/text/string_converter.h"
 #include "halley/support/logger.h"
+#include "work_stealing_deque.h"
 
 using namespace Halley;
 
 Executors* Executors::instance = nullptr;
 
+namespace {
+	struct WorkerThreadInfo {
+		ExecutionQueue* queue = nullptr;
+		WorkStealingDeque* localQueue = nullptr;
+		uint32_t rng = 0x9E3779B9u;
+	};
+
+	thread_local WorkerThreadInfo workerThreadInfo;
+
+	uint32_t nextRandom()
+	{
+		// xorshift32, only used to spread out steal attempts
+		auto& x = workerThreadInfo.rng;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		return x;
+	}
+}
+
+namespace Halley {
+	// Free list of the jobs allocated by one thread. Only the owning thread touches the local list, other threads return jobs through
+	// a lock-free stack which the owner takes over in one go once its local list runs dry.
+	// Pools outlive their threads: when a thread exits its pool is parked, and the next thread to need one adopts it. That way jobs
+	// still in flight always have somewhere to go, and the number of pools is bounded by the number of threads alive at once.
+	class JobPool
+	{
+	public:
+		Job* alloc()
+		{
+			if (freeJobs.empty()) {
+				reclaimRemote();
+			}
+			if (!freeJobs.empty()) {
+				Job* job = freeJobs.back();
+				freeJobs.pop_back();
+				return job;
+			}
+
+			auto* job = new Job();
+			job->pool = this;
+			return job;
+		}
+
+		void releaseLocal(Job* job)
+		{
+			if (freeJobs.size() < maxFreeJobs) {
+				freeJobs.push_back(job);
+			} else {
+				delete job;
+			}
+		}
+
+		void releaseRemote(Job* job)
+		{
+			Job* head = remoteFree.load(std::memory_order_relaxed);
+			do {
+				job->nextFree = head;
+			} while (!remoteFree.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		static JobPool& getCurrent()
+		{
+			thread_local PoolHandle handle;
+			if (!handle.pool) {
+				handle.pool = adopt();
+			}
+			return *handle.pool;
+		}
+
+	private:
+		constexpr static size_t maxFreeJobs = 1024;
+
+		std::vector<Job*> freeJobs;
+		std::atomic<Job*> remoteFree { nullptr };
+
+		struct PoolHandle {
+			JobPool* pool = nullptr;
+
+			~PoolHandle()
+			{
+				if (pool) {
+					park(pool);
+				}
+			}
+		};
+
+		void reclaimRemote()
+		{
+			Job* job = remoteFree.exchange(nullptr, std::memory_order_acquire);
+			while (job) {
+				Job* next = job->nextFree;
+				job->nextFree = nullptr;
+				releaseLocal(job);
+				job = next;
+			}
+		}
+
+		static std::mutex& getParkedMutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		static std::vector<JobPool*>& getParked()
+		{
+			static std::vector<JobPool*> parked;
+			return parked;
+		}
+
+		static JobPool* adopt()
+		{
+			std::unique_lock<std::mutex> lock(getParkedMutex());
+			auto& parked = getParked();
+			if (!parked.empty()) {
+				auto* pool = parked.back();
+				parked.pop_back();
+				return pool;
+			}
+			return new JobPool();
+		}
+
+		static void park(JobPool* pool)
+		{
+			std::unique_lock<std::mutex> lock(getParkedMutex());
+			getParked().push_back(pool);
+		}
+	};
+}
+
+Job* Job::alloc()
+{
+	return JobPool::getCurrent().alloc();
+}
+
+void Job::release(Job* job)
+{
+	job->destroyFunc(job->payload);
+	job->payload = nullptr;
+
+	auto& current = JobPool::getCurrent();
+	if (job->pool == &current) {
+		current.releaseLocal(job);
+	} else {
+		job->pool->releaseRemote(job);
+	}
+}
+
+void Job::run()
+{
+	struct Releaser {
+		Job* job;
+		~Releaser() { release(job); }
+	} releaser { this };
+
+	invokeFunc(payload);
+}
+
+void Job::discard()
+{
+	release(this);
+}
+
 ExecutionQueue::ExecutionQueue()
-	: aborted(false)
+	: numWorkerQueues(0)
+	, pendingCount(0)
+	, sleepingCount(0)
+	, attachedCount(0)
+	, aborted(false)
 {
 	hasTasks.store(false);
+	for (auto& q: workerQueues) {
+		q.store(nullptr);
+	}
 }
 
-TaskBase ExecutionQueue::getNext()
+ExecutionQueue::~ExecutionQueue()
 {
-	std::unique_lock<std::mutex> lock(mutex);
-	while (queue.empty()) {
-		if (!aborted) {
+	for (auto* job: getAll()) {
+		job->discard();
+	}
+	for (size_t i = 0; i < numWorkerQueues; ++i) {
+		delete workerQueues[i].load();
+	}
+}
+
+void ExecutionQueue::submit(Job* job)
+{
+	++pendingCount;
+
+	auto* local = getLocalQueue();
+	if (!local || !local->push(job)) {
+		std::unique_lock<std::mutex> lock(mutex);
+		queue.push_back(job);
+		hasTasks.store(true);
+	}
+
+	if (sleepingCount.load() > 0) {
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.notify_one();
+	}
+}
+
+Job* ExecutionQueue::tryGetJob()
+{
+	auto* local = getLocalQueue();
+	if (local) {
+		if (Job* job = local->pop()) {
+			--pendingCount;
+			return job;
+		}
+	}
+
+	const size_t n = numWorkerQueues.load(std::memory_order_acquire);
+	if (n > 0) {
+		const size_t start = nextRandom() % n;
+		for (size_t i = 0; i < n; ++i) {
+			auto* victim = workerQueues[(start + i) % n].load(std::memory_order_acquire);
+			if (victim != local) {
+				if (Job* job = victim->steal()) {
+					--pendingCount;
+					return job;
+				}
+			}
+		}
+	}
+
+	if (hasTasks.load()) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!queue.empty()) {
+			Job* job = queue.front();
+			queue.pop_front();
+			hasTasks.store(!queue.empty());
+			--pendingCount;
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+bool ExecutionQueue::tryRunOne()
+{
+	if (Job* job = tryGetJob()) {
+		job->run();
+		return true;
+	}
+	return false;
+}
+
+Job* ExecutionQueue::getNext()
+{
+	while (true) {
+		for (int i = 0; i < spinsBeforeSleep; ++i) {
+			if (aborted) {
+				return nullptr;
+			}
+			if (Job* job = tryGetJob()) {
+				return job;
+			}
+			if (pendingCount.load() <= 0) {
+				break;
+			}
+			std::this_thread::yield();
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		++sleepingCount;
+		while (pendingCount.load() <= 0 && !aborted) {
 			condition.wait(lock);
 		}
+		--sleepingCount;
 		if (aborted) {
-			queue.clear();
-			return TaskBase([] () {});
+			return nullptr;
 		}
 	}
-
-	TaskBase value = queue.front();
-	queue.pop_front();
-	return value;
 }
 
-std::vector<TaskBase> ExecutionQueue::getAll()
+std::vector<Job*> ExecutionQueue::getAll()
 {
-	std::unique_lock<std::mutex> lock(mutex);
-	hasTasks.store(false);
-	std::vector<TaskBase> tasks(queue.begin(), queue.end());
-	queue.clear();
+	std::vector<Job*> tasks;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		hasTasks.store(false);
+		tasks.assign(queue.begin(), queue.end());
+		queue.clear();
+	}
+
+	const size_t n = numWorkerQueues.load(std::memory_order_acquire);
+	for (size_t i = 0; i < n; ++i) {
+		auto* q = workerQueues[i].load(std::memory_order_acquire);
+		while (!q->isEmpty()) {
+			if (Job* job = q->steal()) {
+				tasks.push_back(job);
+			}
+		}
+	}
+
+	pendingCount -= int(tasks.size());
 	return tasks;
 }
 
-void ExecutionQueue::addToQueue(TaskBase task)
+void ExecutionQueue::attachWorkerThread()
 {
-#if HAS_THREADS
+	auto& info = workerThreadInfo;
+	if (info.queue) {
+		// Already a worker of some queue, tasks from this thread go to the shared queue
+		return;
+	}
+
 	std::unique_lock<std::mutex> lock(mutex);
-	queue.emplace_back(task);
-	hasTasks.store(true);
+	const size_t idx = numWorkerQueues.load();
+	if (idx >= maxWorkers) {
+		return;
+	}
+	auto* q = new WorkStealingDeque(workerQueueCapacity);
+	workerQueues[idx].store(q, std::memory_order_release);
+	numWorkerQueues.store(idx + 1, std::memory_order_release);
 
-	condition.notify_one();
-#else
-	task();
-#endif
+	info.queue = this;
+	info.localQueue = q;
+	info.rng ^= uint32_t(reinterpret_cast<size_t>(q) >> 4);
+}
+
+void ExecutionQueue::detachWorkerThread()
+{
+	// The deque stays registered, so anything left in it can still be stolen
+	auto& info = workerThreadInfo;
+	if (info.queue == this) {
+		info.queue = nullptr;
+		info.localQueue = nullptr;
+	}
+}
+
+WorkStealingDeque* ExecutionQueue::getLocalQueue() const
+{
+	const auto& info = workerThreadInfo;
+	return info.queue == this ? info.localQueue : nullptr;
 }
 
 Executors& Executors::get()
@@ -72,6 +367,11 @@ size_t ExecutionQueue::threadCount() const
 	return attachedCount.load();
 }
 
+bool ExecutionQueue::hasIdleThreads() const
+{
+	return sleepingCount.load() > 0;
+}
+
 void ExecutionQueue::onAttached()
 {
 	++attachedCount;
@@ -119,8 +419,15 @@ bool Executor::runPending()
 {
 #if HAS_THREADS
 	auto tasks = queue.getAll();
-	for (auto& t : tasks) {
-		t();
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		try {
+			tasks[i]->run();
+		} catch (...) {
+			for (size_t j = i + 1; j < tasks.size(); ++j) {
+				tasks[j]->discard();
+			}
+			throw;
+		}
 	}
 #endif
 	return false;
@@ -129,11 +436,16 @@ bool Executor::runPending()
 void Executor::runForever()
 {
 #if HAS_THREADS
+	queue.attachWorkerThread();
 	try {
 		while (running)	{
-			auto next = queue.getNext();
-			if (running) {
-				next();
+			auto* next = queue.getNext();
+			if (next) {
+				if (running) {
+					next->run();
+				} else {
+					next->discard();
+				}
 			}
 		}
 	} catch (std::exception& e) {
@@ -142,6 +454,7 @@ void Executor::runForever()
 	} catch (...) {
 		Logger::logError("Executor aborting due to unknown exception.");
 	}
+	queue.detachWorkerThread();
 #endif
 }
 
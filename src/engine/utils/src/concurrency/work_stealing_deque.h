@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Halley
+{
+	class Job;
+
+	// Fixed-capacity Chase-Lev deque (as described in "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013)
+	// The owning worker pushes and pops at the bottom without locking, other threads steal from the top.
+	class WorkStealingDeque
+	{
+	public:
+		explicit WorkStealingDeque(size_t capacity)
+			: mask(int64_t(capacity) - 1)
+			, buffer(new std::atomic<Job*>[capacity])
+		{
+			// Capacity must be a power of two
+			for (size_t i = 0; i < capacity; ++i) {
+				buffer[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		// Owner only. Returns false if the deque is full.
+		bool push(Job* job)
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			if (b - t > mask) {
+				return false;
+			}
+			buffer[b & mask].store(job, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Owner only
+		Job* pop()
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b) {
+				// Empty
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			Job* job = buffer[b & mask].load(std::memory_order_relaxed);
+			if (t == b) {
+				// Last element, race against stealers for it
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					job = nullptr;
+				}
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		// Any thread. Can fail spuriously if another thread is racing for the same element.
+		Job* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+
+			if (t < b) {
+				Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+				if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					return job;
+				}
+			}
+			return nullptr;
+		}
+
+		bool isEmpty() const
+		{
+			return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+		}
+
+	private:
+		alignas(64) std::atomic<int64_t> top { 0 };
+		alignas(64) std::atomic<int64_t> bottom { 0 };
+		const int64_t mask;
+		std::unique_ptr<std::atomic<Job*>[]> buffer;
+	};
+}
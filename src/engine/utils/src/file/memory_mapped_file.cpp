@@ -0,0 +1,229 @@
+#include "halley/file/memory_mapped_file.h"
+#include "halley/file/path.h"
+
+using namespace Halley;
+
+#if defined(_WIN32) && !defined(WINDOWS_STORE)
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace Halley {
+	class MemoryMappedFilePimpl
+	{
+	public:
+		~MemoryMappedFilePimpl()
+		{
+			close();
+		}
+
+		bool open(const Path& path)
+		{
+			close();
+
+			file = CreateFileA(path.string().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+				close();
+				return false;
+			}
+
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping) {
+				close();
+				return false;
+			}
+
+			data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			if (!data) {
+				close();
+				return false;
+			}
+			size = size_t(fileSize.QuadPart);
+			return true;
+		}
+
+		void close()
+		{
+			if (data) {
+				UnmapViewOfFile(data);
+				data = nullptr;
+			}
+			if (mapping) {
+				CloseHandle(mapping);
+				mapping = nullptr;
+			}
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+				file = INVALID_HANDLE_VALUE;
+			}
+			size = 0;
+		}
+
+		void prefetch() const
+		{
+			WIN32_MEMORY_RANGE_ENTRY range;
+			range.VirtualAddress = const_cast<char*>(data);
+			range.NumberOfBytes = size;
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+
+		const char* data = nullptr;
+		size_t size = 0;
+
+	private:
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+	};
+}
+
+bool MemoryMappedFile::isSupported()
+{
+	return true;
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Halley {
+	class MemoryMappedFilePimpl
+	{
+	public:
+		~MemoryMappedFilePimpl()
+		{
+			close();
+		}
+
+		bool open(const Path& path)
+		{
+			close();
+
+			const int fd = ::open(path.string().c_str(), O_RDONLY);
+			if (fd < 0) {
+				return false;
+			}
+
+			struct stat st;
+			if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+				::close(fd);
+				return false;
+			}
+
+			void* result = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			// The mapping keeps its own reference to the file
+			::close(fd);
+			if (result == MAP_FAILED) {
+				return false;
+			}
+
+			data = static_cast<const char*>(result);
+			size = size_t(st.st_size);
+			return true;
+		}
+
+		void close()
+		{
+			if (data) {
+				munmap(const_cast<char*>(data), size);
+				data = nullptr;
+			}
+			size = 0;
+		}
+
+		void prefetch() const
+		{
+			madvise(const_cast<char*>(data), size, MADV_WILLNEED);
+		}
+
+		const char* data = nullptr;
+		size_t size = 0;
+	};
+}
+
+bool MemoryMappedFile::isSupported()
+{
+	return true;
+}
+
+#else
+
+namespace Halley {
+	// Not implemented
+	class MemoryMappedFilePimpl
+	{
+	public:
+		bool open(const Path&) { return false; }
+		void close() {}
+		void prefetch() const {}
+
+		const char* data = nullptr;
+		size_t size = 0;
+	};
+}
+
+bool MemoryMappedFile::isSupported()
+{
+	return false;
+}
+
+#endif
+
+MemoryMappedFile::MemoryMappedFile()
+	: pimpl(std::make_unique<MemoryMappedFilePimpl>())
+{}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept = default;
+
+MemoryMappedFile::~MemoryMappedFile() = default;
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept = default;
+
+bool MemoryMappedFile::open(const Path& path)
+{
+	if (!pimpl) {
+		pimpl = std::make_unique<MemoryMappedFilePimpl>();
+	}
+	return pimpl->open(path);
+}
+
+void MemoryMappedFile::close()
+{
+	if (pimpl) {
+		pimpl->close();
+	}
+}
+
+bool MemoryMappedFile::isOpen() const
+{
+	return pimpl && pimpl->data != nullptr;
+}
+
+void MemoryMappedFile::prefetch() const
+{
+	if (isOpen()) {
+		pimpl->prefetch();
+	}
+}
+
+gsl::span<const gsl::byte> MemoryMappedFile::getSpan() const
+{
+	return gsl::as_bytes(gsl::span<const char>(getData(), getSize()));
+}
+
+const char* MemoryMappedFile::getData() const
+{
+	return pimpl ? pimpl->data : nullptr;
+}
+
+size_t MemoryMappedFile::getSize() const
+{
+	return pimpl ? pimpl->size : 0;
+}
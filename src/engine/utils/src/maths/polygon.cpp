@@ -1038,10 +1038,34 @@ std::optional<std::vector<Polygon>> Polygon::subtractOverlapping(const Polygon&
 			if (!segmentA.sharesVertexWith(segmentB)) {
 				const auto intersection = segmentA.intersection(segmentB);
 				if (intersection) {
-					const int idA = static_cast<int>(polyA.size());
-					const int idB = static_cast<int>(polyB.size());
-					polyA.insert(polyA.begin() + i + 1, VertexInfo(intersection.value(), idA, idB));
-					polyB.insert(polyB.begin() + j + 1, VertexInfo(intersection.value(), idB, idA));
+					// If the crossing lands on an existing vertex of either polygon, that vertex becomes the crossing point
+					// Inserting a new one on top of it would create a zero-length edge, which intersects everything and never terminates
+					constexpr float vertexEpsilon = 0.0001f;
+					const size_t iNext = (i + 1) % polyA.size();
+					const size_t jNext = (j + 1) % polyB.size();
+					const auto onA = intersection->epsilonEquals(a, vertexEpsilon) ? std::optional<size_t>(i) : intersection->epsilonEquals(b, vertexEpsilon) ? std::optional<size_t>(iNext) : std::nullopt;
+					const auto onB = intersection->epsilonEquals(c, vertexEpsilon) ? std::optional<size_t>(j) : intersection->epsilonEquals(d, vertexEpsilon) ? std::optional<size_t>(jNext) : std::nullopt;
+
+					if (onA && onB) {
+						// Common vertex, already handled above
+						continue;
+					}
+					if ((onA && polyA[*onA].crossIdx != -1) || (onB && polyB[*onB].crossIdx != -1)) {
+						continue;
+					}
+
+					const int idA = onA ? polyA[*onA].origId : static_cast<int>(polyA.size());
+					const int idB = onB ? polyB[*onB].origId : static_cast<int>(polyB.size());
+					if (onA) {
+						polyA[*onA].crossIdx = idB;
+						polyB.insert(polyB.begin() + j + 1, VertexInfo(polyA[*onA].pos, idB, idA));
+					} else if (onB) {
+						polyB[*onB].crossIdx = idA;
+						polyA.insert(polyA.begin() + i + 1, VertexInfo(polyB[*onB].pos, idA, idB));
+					} else {
+						polyA.insert(polyA.begin() + i + 1, VertexInfo(intersection.value(), idA, idB));
+						polyB.insert(polyB.begin() + j + 1, VertexInfo(intersection.value(), idB, idA));
+					}
 					++crossings;
 					inserted = true;
 					break;
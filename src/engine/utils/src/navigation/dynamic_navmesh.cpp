@@ -0,0 +1,199 @@
+#include "halley/navigation/dynamic_navmesh.h"
+
+#include "halley/concurrency/concurrent.h"
+#include "halley/support/logger.h"
+using namespace Halley;
+
+DynamicNavmesh::DynamicNavmesh(const NavmeshGenerator::Params& p, size_t numLandmarks)
+	: params(p)
+	, regions(p.regions.begin(), p.regions.end())
+	, subworldPortals(p.subworldPortals.begin(), p.subworldPortals.end())
+	, numLandmarks(numLandmarks)
+{
+	params.obstacles = {};
+	params.regions = regions;
+	params.subworldPortals = subworldPortals;
+
+	staticObstacles = NavmeshGenerator::preProcessObstacles(p.obstacles, p.agentSize);
+
+	const auto& bounds = params.bounds;
+	const size_t nCells = bounds.side0Divisions * bounds.side1Divisions;
+	cells.resize(nCells);
+	cellBounds.reserve(nCells);
+	for (size_t i = 0; i < nCells; ++i) {
+		cellBounds.push_back(NavmeshGenerator::makeCell(bounds, i / bounds.side1Divisions, i % bounds.side1Divisions).getBoundingCircle());
+	}
+	dirtyCells.resize(nCells, true);
+
+	rebuild();
+}
+
+DynamicNavmesh::~DynamicNavmesh()
+{
+	waitForPendingBuild();
+}
+
+DynamicNavmesh::ObstacleId DynamicNavmesh::addObstacle(Polygon obstacle)
+{
+	const auto id = nextObstacleId++;
+	auto& polygons = dynamicObstacles[id];
+	polygons = NavmeshGenerator::preProcessObstacles(gsl::span<const Polygon>(&obstacle, 1), params.agentSize);
+	markDirty(polygons);
+	return id;
+}
+
+void DynamicNavmesh::removeObstacle(ObstacleId id)
+{
+	const auto iter = dynamicObstacles.find(id);
+	if (iter != dynamicObstacles.end()) {
+		markDirty(iter->second);
+		dynamicObstacles.erase(iter);
+	}
+}
+
+bool DynamicNavmesh::isDirty() const
+{
+	return std::find(dirtyCells.begin(), dirtyCells.end(), true) != dirtyCells.end();
+}
+
+bool DynamicNavmesh::isRebuilding() const
+{
+	return pendingBuild.isValid();
+}
+
+void DynamicNavmesh::rebuild()
+{
+	waitForPendingBuild();
+	update();
+	if (!isDirty()) {
+		return;
+	}
+
+	const auto result = build(params, numLandmarks, std::move(cells), takeDirtyCells(), getObstacles());
+	applyResult(*result);
+}
+
+void DynamicNavmesh::rebuildAsync(ExecutionQueue& queue)
+{
+	if (isRebuilding() || !isDirty()) {
+		return;
+	}
+
+	// The cells are handed over to the job, and come back with its result
+	pendingQueue = &queue;
+	pendingBuild = Concurrent::execute(queue, [params = params, numLandmarks = numLandmarks, cells = std::move(cells), dirty = takeDirtyCells(), obstacles = getObstacles()] () mutable
+	{
+		return build(params, numLandmarks, std::move(cells), std::move(dirty), std::move(obstacles));
+	});
+}
+
+bool DynamicNavmesh::update()
+{
+	if (!pendingBuild.isValid() || !pendingBuild.isReady()) {
+		return false;
+	}
+
+	const auto result = pendingBuild.get();
+	pendingBuild = {};
+	pendingQueue = nullptr;
+	applyResult(*result);
+	return result->navmeshSet.has_value();
+}
+
+const NavmeshSet& DynamicNavmesh::getNavmeshSet() const
+{
+	return navmeshSet;
+}
+
+void DynamicNavmesh::markDirty(gsl::span<const Polygon> obstacle)
+{
+	// Same test used by NavmeshGenerator to decide which obstacles are carved out of each cell
+	for (const auto& o: obstacle) {
+		for (size_t i = 0; i < cellBounds.size(); ++i) {
+			if (o.getBoundingCircle().overlaps(cellBounds[i])) {
+				dirtyCells[i] = true;
+			}
+		}
+	}
+}
+
+std::vector<size_t> DynamicNavmesh::takeDirtyCells()
+{
+	std::vector<size_t> result;
+	for (size_t i = 0; i < dirtyCells.size(); ++i) {
+		if (dirtyCells[i]) {
+			result.push_back(i);
+			dirtyCells[i] = false;
+		}
+	}
+	return result;
+}
+
+std::vector<Polygon> DynamicNavmesh::getObstacles() const
+{
+	std::vector<Polygon> result = staticObstacles;
+	for (const auto& [id, polygons]: dynamicObstacles) {
+		result.insert(result.end(), polygons.begin(), polygons.end());
+	}
+	return result;
+}
+
+void DynamicNavmesh::applyResult(BuildResult& result)
+{
+	cells = std::move(result.cells);
+
+	if (result.navmeshSet) {
+		navmeshSet = std::move(result.navmeshSet.value());
+	} else {
+		// Failed, so try those cells again next time
+		for (const auto idx: result.builtCells) {
+			dirtyCells[idx] = true;
+		}
+	}
+}
+
+void DynamicNavmesh::waitForPendingBuild()
+{
+	if (!pendingBuild.isValid()) {
+		return;
+	}
+
+	// The build might be queued behind other work, so help out rather than block
+	while (!pendingBuild.isReady()) {
+		if (!pendingQueue->tryRunOne()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+std::unique_ptr<DynamicNavmesh::BuildResult> DynamicNavmesh::build(const NavmeshGenerator::Params& params, size_t numLandmarks, std::vector<Cell> cells, std::vector<size_t> dirtyCells, std::vector<Polygon> obstacles)
+{
+	auto result = std::make_unique<BuildResult>();
+
+	try {
+		const auto& bounds = params.bounds;
+		auto generateCellAt = [&] (size_t i)
+		{
+			const auto idx = dirtyCells[i];
+			cells[idx] = NavmeshGenerator::generateCell(bounds, idx / bounds.side1Divisions, idx % bounds.side1Divisions, obstacles);
+		};
+
+		if (params.executionQueue) {
+			Concurrent::parallelFor(*params.executionQueue, 0, dirtyCells.size(), generateCellAt, 1);
+		} else {
+			for (size_t i = 0; i < dirtyCells.size(); ++i) {
+				generateCellAt(i);
+			}
+		}
+
+		auto navmeshSet = NavmeshGenerator::generateFromCells(params, cells);
+		navmeshSet.linkNavmeshes(numLandmarks);
+		result->navmeshSet = std::move(navmeshSet);
+	} catch (const std::exception& e) {
+		Logger::logException(e);
+	}
+
+	result->cells = std::move(cells);
+	result->builtCells = std::move(dirtyCells);
+	return result;
+}
@@ -0,0 +1,204 @@
+#include "halley/navigation/navigation_flow_field.h"
+
+#include <queue>
+using namespace Halley;
+
+NavigationFlowField::NavigationFlowField(const NavmeshSet& navmeshSet, Vector2f goal, int subWorld)
+	: navmeshSet(navmeshSet)
+	, goal(goal)
+{
+	const auto navmeshes = navmeshSet.getNavmeshes();
+	regionStart.reserve(navmeshes.size());
+	size_t nNodes = 0;
+	for (const auto& navmesh: navmeshes) {
+		regionStart.push_back(nNodes);
+		nNodes += navmesh.getNumNodes();
+	}
+
+	const auto region = navmeshSet.getNavMeshIdxAt(goal, subWorld);
+	if (region != notFound) {
+		const auto node = navmeshes[region].getNodeAt(goal);
+		if (node) {
+			goalNode = regionStart[region] + node.value();
+			entries.resize(nNodes);
+			build();
+		}
+	}
+}
+
+bool NavigationFlowField::isValid() const
+{
+	return goalNode != notFound;
+}
+
+std::optional<NavigationFlowField::Sample> NavigationFlowField::sample(Vector2f pos, int subWorld, std::optional<uint16_t> regionHint) const
+{
+	if (!isValid()) {
+		return {};
+	}
+
+	const auto navmeshes = navmeshSet.getNavmeshes();
+	size_t region;
+	if (regionHint && regionHint.value() < navmeshes.size() && navmeshes[regionHint.value()].getSubWorld() == subWorld && navmeshes[regionHint.value()].containsPoint(pos)) {
+		region = regionHint.value();
+	} else {
+		region = navmeshSet.getNavMeshIdxAt(pos, subWorld);
+		if (region == notFound) {
+			return {};
+		}
+	}
+
+	const auto node = navmeshes[region].getNodeAt(pos);
+	if (!node) {
+		return {};
+	}
+
+	const auto idx = regionStart[region] + node.value();
+	const auto& entry = entries[idx];
+	if (entry.distance == std::numeric_limits<float>::infinity()) {
+		return {};
+	}
+
+	return Sample{ entry.nextPosition, entry.distance, static_cast<uint16_t>(region), idx == goalNode };
+}
+
+void NavigationFlowField::build()
+{
+	const auto navmeshes = navmeshSet.getNavmeshes();
+
+	auto getNextPosition = [&] (size_t region, size_t fromNode, size_t edge, Vector2f toCentre)
+	{
+		// Just past the middle of the edge being crossed, so agents that reach it are already in the next node
+		const auto segment = navmeshes[region].getPolygon(static_cast<int>(fromNode)).getEdge(edge);
+		return lerp((segment.a + segment.b) * 0.5f, toCentre, 0.1f);
+	};
+
+	auto getWeight = [&] (size_t region, size_t node)
+	{
+		const auto& weights = navmeshes[region].getWeights();
+		return weights.empty() ? 1.0f : weights[node];
+	};
+
+	// Links between nodes on either side of each portal, stored on the node being linked to, as the search runs backwards from the goal
+	struct PortalLink {
+		size_t from;
+		float cost;
+		Vector2f nextPosition;
+	};
+	HashMap<size_t, std::vector<PortalLink>> portalLinks;
+	for (size_t regionA = 0; regionA < navmeshes.size(); ++regionA) {
+		const auto& portals = navmeshes[regionA].getPortals();
+		for (size_t portalA = 0; portalA < portals.size(); ++portalA) {
+			const auto [regionB, portalB] = navmeshSet.getPortalDestination(static_cast<uint16_t>(regionA), static_cast<uint16_t>(portalA));
+			if (regionB >= navmeshes.size()) {
+				continue;
+			}
+
+			const auto& portal = portals[portalA];
+			const auto& dstPortal = navmeshes[regionB].getPortals()[portalB];
+			for (const auto& a: portal.connections) {
+				const auto& nodeA = navmeshes[regionA].getNodes()[a.node];
+				for (const auto& b: dstPortal.connections) {
+					const auto& nodeB = navmeshes[regionB].getNodes()[b.node];
+					// Same as Node::costs: the scaled distance travelled, weighted by the node being entered
+					const float distance = ((portal.pos - nodeA.pos) * navmeshes[regionA].getScaleFactor()).length() + ((nodeB.pos - portal.pos) * navmeshes[regionB].getScaleFactor()).length();
+					const float cost = distance * getWeight(regionB, b.node);
+					const auto nextPosition = getNextPosition(regionA, a.node, a.connectionIdx, navmeshes[regionB].getPolygon(b.node).getCentre());
+					portalLinks[regionStart[regionB] + b.node].push_back(PortalLink{ regionStart[regionA] + a.node, cost, nextPosition });
+				}
+			}
+		}
+	}
+
+	using QueueEntry = std::pair<float, size_t>;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> openSet;
+
+	entries[goalNode].distance = 0;
+	entries[goalNode].nextPosition = goal;
+	openSet.push(QueueEntry(0.0f, goalNode));
+
+	auto relax = [&] (size_t idx, float distance, Vector2f nextPosition)
+	{
+		auto& entry = entries[idx];
+		if (distance < entry.distance) {
+			entry.distance = distance;
+			entry.nextPosition = nextPosition;
+			openSet.push(QueueEntry(distance, idx));
+		}
+	};
+
+	while (!openSet.empty()) {
+		const auto [curDist, curIdx] = openSet.top();
+		openSet.pop();
+		if (curDist > entries[curIdx].distance) {
+			continue;
+		}
+
+		const auto region = static_cast<size_t>(std::upper_bound(regionStart.begin(), regionStart.end(), curIdx) - regionStart.begin() - 1);
+		const auto& navmesh = navmeshes[region];
+		const auto curId = static_cast<Navmesh::NodeId>(curIdx - regionStart[region]);
+		const auto& curNode = navmesh.getNodes()[curId];
+		const auto curCentre = navmesh.getPolygon(curId).getCentre();
+
+		// Costs aren't symmetric (they're weighted by the node being entered), so use the cost from each neighbour into this node
+		for (size_t i = 0; i < curNode.nConnections; ++i) {
+			if (curNode.connections[i]) {
+				const auto neighId = curNode.connections[i].value();
+				const auto& neighNode = navmesh.getNodes()[neighId];
+				for (size_t j = 0; j < neighNode.nConnections; ++j) {
+					if (neighNode.connections[j] && neighNode.connections[j].value() == curId) {
+						relax(regionStart[region] + neighId, curDist + neighNode.costs[j], getNextPosition(region, neighId, j, curCentre));
+						break;
+					}
+				}
+			}
+		}
+
+		const auto iter = portalLinks.find(curIdx);
+		if (iter != portalLinks.end()) {
+			for (const auto& link: iter->second) {
+				relax(link.from, curDist + link.cost, link.nextPosition);
+			}
+		}
+	}
+}
+
+NavigationFlowFieldCache::NavigationFlowFieldCache(const NavmeshSet& navmeshSet, int maxAge)
+	: navmeshSet(navmeshSet)
+	, maxAge(maxAge)
+{}
+
+std::shared_ptr<const NavigationFlowField> NavigationFlowFieldCache::get(Vector2f goal, int subWorld)
+{
+	const auto region = navmeshSet.getNavMeshIdxAt(goal, subWorld);
+	if (region == std::numeric_limits<size_t>::max()) {
+		return {};
+	}
+	const auto node = navmeshSet.getNavmeshes()[region].getNodeAt(goal);
+	if (!node) {
+		return {};
+	}
+
+	auto& entry = fields[(static_cast<uint64_t>(region) << 32) | node.value()];
+	entry.age = 0;
+	if (!entry.field) {
+		entry.field = std::make_shared<NavigationFlowField>(navmeshSet, goal, subWorld);
+	}
+	return entry.field;
+}
+
+void NavigationFlowFieldCache::newFrame()
+{
+	for (auto iter = fields.begin(); iter != fields.end();) {
+		if (++iter->second.age > maxAge) {
+			iter = fields.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+void NavigationFlowFieldCache::clear()
+{
+	fields.clear();
+}
@@ -1,5 +1,6 @@
 #include "halley/navigation/navigation_path_follower.h"
 
+#include "halley/navigation/navigation_flow_field.h"
 #include "halley/navigation/navmesh_set.h"
 #include "halley/support/logger.h"
 using namespace Halley;
@@ -44,6 +45,7 @@ void NavigationPathFollower::setPath(std::optional<NavigationPath> p)
 	path = std::move(p);
 	nextPathIdx = 0;
 	nextRegionIdx = 0;
+	flowField.reset();
 }
 
 const std::optional<NavigationPath>& NavigationPathFollower::getPath() const
@@ -51,11 +53,30 @@ const std::optional<NavigationPath>& NavigationPathFollower::getPath() const
 	return path;
 }
 
+void NavigationPathFollower::setFlowField(std::shared_ptr<const NavigationFlowField> field, Vector2f target)
+{
+	setPath({});
+	flowField = std::move(field);
+	flowFieldTarget = target;
+	flowFieldNextPos = curPos;
+	flowFieldRegion = {};
+}
+
+const std::shared_ptr<const NavigationFlowField>& NavigationPathFollower::getFlowField() const
+{
+	return flowField;
+}
+
 void NavigationPathFollower::update(Vector2f curPos, int curSubWorld, const NavmeshSet& navmeshSet, float threshold)
 {
 	this->curPos = curPos;
 	this->curSubWorld = curSubWorld;
 
+	if (flowField) {
+		updateFlowField(threshold);
+		return;
+	}
+
 	if (!path) {
 		return;
 	}
@@ -137,8 +158,29 @@ void NavigationPathFollower::reEvaluatePath(const NavmeshSet& navmeshSet)
 	setPath(navmeshSet.pathfind(query));
 }
 
+void NavigationPathFollower::updateFlowField(float threshold)
+{
+	if ((flowFieldTarget - curPos).length() < threshold) {
+		flowField.reset();
+		return;
+	}
+
+	const auto sample = flowField->sample(curPos, curSubWorld, flowFieldRegion);
+	if (!sample) {
+		Logger::logWarning("Agent is outside of its flow field.");
+		flowField.reset();
+		return;
+	}
+
+	flowFieldRegion = sample->region;
+	flowFieldNextPos = sample->inGoalNode ? flowFieldTarget : sample->nextPosition;
+}
+
 Vector2f NavigationPathFollower::getNextPosition() const
 {
+	if (flowField) {
+		return flowFieldNextPos;
+	}
 	return path->path.size() > nextPathIdx ? path->path[nextPathIdx] : curPos;
 }
 
@@ -149,7 +191,7 @@ size_t NavigationPathFollower::getNextPathIdx() const
 
 bool NavigationPathFollower::isDone() const
 {
-	return !path;
+	return !path && !flowField;
 }
 
 ConfigNode ConfigNodeSerializer<NavigationPathFollower>::serialize(const NavigationPathFollower& follower, const ConfigNodeSerializationContext& context)
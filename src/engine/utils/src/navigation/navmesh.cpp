@@ -1,8 +1,10 @@
 #include "halley/navigation/navmesh.h"
 
 #include <cassert>
+#include <queue>
 
 #include "halley/data_structures/priority_queue.h"
+#include "pathfinding_scratch.h"
 #include "halley/maths/random.h"
 #include "halley/maths/ray.h"
 using namespace Halley;
@@ -59,6 +61,7 @@ Navmesh::Navmesh(std::vector<PolygonData> polys, const NavmeshBounds& bounds, in
 	// Generate edges
 	postProcessPortals();
 	generateOpenEdges();
+	computePortalCosts();
 }
 
 Navmesh::Navmesh(const ConfigNode& nodeData)
@@ -71,9 +74,14 @@ Navmesh::Navmesh(const ConfigNode& nodeData)
 	portals = nodeData["portals"].asVector<Portal>();
 	subWorld = nodeData["subWorld"].asInt(0);
 	weights = nodeData["weights"].asVector<float>({});
+	portalCosts = nodeData["portalCosts"].asVector<float>({});
 
 	processPolygons();
 	generateOpenEdges();
+	if (portalCosts.size() != portals.size() * portals.size()) {
+		// Older data, compute them now
+		computePortalCosts();
+	}
 }
 
 ConfigNode Navmesh::toConfigNode() const
@@ -88,10 +96,16 @@ ConfigNode Navmesh::toConfigNode() const
 	result["portals"] = portals;
 	result["subWorld"] = subWorld;
 	result["weights"] = weights;
+	result["portalCosts"] = portalCosts;
 	
 	return result;
 }
 
+float Navmesh::getPortalCost(size_t fromPortal, size_t toPortal) const
+{
+	return portalCosts[fromPortal * portals.size() + toPortal];
+}
+
 const Polygon& Navmesh::getPolygon(int id) const
 {
 	return polygons[id];
@@ -148,6 +162,10 @@ std::optional<Navmesh::NodeId> Navmesh::getNodeAt(Vector2f position) const
 
 bool Navmesh::containsPoint(Vector2f position) const
 {
+	if (!aabb.contains(position)) {
+		return false;
+	}
+
 	const auto& polyIndices = getPolygonsAt(position, false);
 	
 	for (auto i: polyIndices) {
@@ -283,13 +301,13 @@ std::optional<std::vector<Navmesh::NodeAndConn>> Navmesh::pathfind(int fromId, i
 		return {};
 	}
 
-	// State map. Using vector for perf, trading space for CPU.
-	// TODO: measure this vs unordered_map or some other hashtable, it's not impossible that it'd perform better (compact memory)
-	std::vector<State> state(nodes.size(), State{});
+	// State map. Kept per thread and reused across queries, so it's never allocated or cleared in the steady state
+	thread_local PathfindingScratch<State> state;
+	state.begin(nodes.size());
 
 	// Open set
-	auto openSet = PriorityQueue<NodeId, NodeComparator>(NodeComparator(state));
-	openSet.reserve(std::min(static_cast<size_t>(100), nodes.size()));
+	thread_local PriorityQueue<NodeId, NodeComparator> openSet(NodeComparator(state.getValues()));
+	openSet.clear();
 
 	// Define heuristic function
 	const Vector2f endPos = nodes[toId].pos;
@@ -314,7 +332,7 @@ std::optional<std::vector<Navmesh::NodeAndConn>> Navmesh::pathfind(int fromId, i
 		const auto curId = openSet.top();
 		if (curId == toId) {
 			// Done!
-			return makeResult(state, fromId, toId);
+			return makeResult(state.getValues(), fromId, toId);
 		}
 
 		state[curId].inOpenSet = false;
@@ -543,6 +561,7 @@ void Navmesh::setWorldPosition(Vector2f newOffset, Vector2i gridPos)
 		edge.second.b += delta;
 	}
 	origin += delta;
+	aabb += delta;
 }
 
 void Navmesh::markPortalConnected(size_t idx)
@@ -561,6 +580,7 @@ void Navmesh::processPolygons()
 {
 	addPolygonsToGrid();
 	computeArea();
+	computeAABB();
 }
 
 void Navmesh::addPolygonsToGrid()
@@ -639,6 +659,20 @@ void Navmesh::computeArea()
 	}
 }
 
+void Navmesh::computeAABB()
+{
+	if (polygons.empty()) {
+		aabb = Rect4f();
+		return;
+	}
+
+	aabb = polygons[0].getAABB();
+	for (const auto& p: polygons) {
+		aabb = aabb.merge(p.getAABB());
+	}
+	aabb = aabb.grow(1.0f);
+}
+
 void Navmesh::generateOpenEdges()
 {
 	openEdges.clear();
@@ -676,6 +710,67 @@ void Navmesh::postProcessPortals()
 	}
 }
 
+void Navmesh::computePortalCosts()
+{
+	// One Dijkstra over the node graph from each portal, recording what it costs to get to every other portal
+	const size_t nPortals = portals.size();
+	portalCosts.assign(nPortals * nPortals, std::numeric_limits<float>::infinity());
+
+	std::vector<std::optional<NodeId>> portalNodes(nPortals);
+	for (size_t i = 0; i < nPortals; ++i) {
+		portalNodes[i] = getNodeAt(portals[i].pos);
+	}
+
+	using Entry = std::pair<float, NodeId>;
+	std::vector<float> dist;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<>> openSet;
+
+	for (size_t from = 0; from < nPortals; ++from) {
+		if (!portalNodes[from]) {
+			continue;
+		}
+		const auto startNode = portalNodes[from].value();
+
+		dist.assign(nodes.size(), std::numeric_limits<float>::infinity());
+		dist[startNode] = ((nodes[startNode].pos - portals[from].pos) * scaleFactor).length();
+		openSet.push(Entry(dist[startNode], startNode));
+
+		while (!openSet.empty()) {
+			const auto [curDist, curId] = openSet.top();
+			openSet.pop();
+			if (curDist > dist[curId]) {
+				continue;
+			}
+
+			const auto& curNode = nodes[curId];
+			for (size_t i = 0; i < curNode.nConnections; ++i) {
+				if (curNode.connections[i]) {
+					const auto nodeId = curNode.connections[i].value();
+					const float newDist = curDist + curNode.costs[i];
+					if (newDist < dist[nodeId]) {
+						dist[nodeId] = newDist;
+						openSet.push(Entry(newDist, nodeId));
+					}
+				}
+			}
+		}
+
+		for (size_t to = 0; to < nPortals; ++to) {
+			if (!portalNodes[to]) {
+				continue;
+			}
+			const auto endNode = portalNodes[to].value();
+			float cost;
+			if (endNode == startNode) {
+				cost = ((portals[to].pos - portals[from].pos) * scaleFactor).length();
+			} else {
+				cost = dist[endNode] + ((portals[to].pos - nodes[endNode].pos) * scaleFactor).length();
+			}
+			portalCosts[from * nPortals + to] = cost;
+		}
+	}
+}
+
 Navmesh::Portal::Portal(int id)
 	: id(id)
 {
@@ -715,6 +810,7 @@ void Navmesh::Portal::postProcess(gsl::span<const Polygon> polygons, std::vector
 {
 	const float epsilon = 0.01f;
 	std::vector<std::deque<Vector2f>> chains;
+	std::vector<std::vector<NodeAndConn>> chainConnections;
 	
 	for (auto& conn: connections) {
 		const auto edge = polygons[conn.node].getEdge(conn.connectionIdx);
@@ -737,6 +833,9 @@ void Navmesh::Portal::postProcess(gsl::span<const Polygon> polygons, std::vector
 		// Found no chains
 		if (!mergedLeft && !mergedRight) {
 			chains.push_back(std::deque<Vector2f>{ edge.a, edge.b });
+			chainConnections.push_back({ conn });
+		} else {
+			chainConnections[mergedLeft ? mergedLeft.value() : mergedRight.value()].push_back(conn);
 		}
 
 		// Found two chains, merge them
@@ -747,12 +846,19 @@ void Navmesh::Portal::postProcess(gsl::span<const Polygon> polygons, std::vector
 			left.pop_back();
 			left.insert(left.end(), right.begin(), right.end());
 			chains.erase(chains.begin() + mergedRight.value());
+
+			auto& leftConnections = chainConnections[mergedLeft.value()];
+			auto& rightConnections = chainConnections[mergedRight.value()];
+			leftConnections.insert(leftConnections.end(), rightConnections.begin(), rightConnections.end());
+			chainConnections.erase(chainConnections.begin() + mergedRight.value());
 		}
 	}
 
 	// Output edges
-	for (auto& chain: chains) {
+	for (size_t chainIdx = 0; chainIdx < chains.size(); ++chainIdx) {
+		const auto& chain = chains[chainIdx];
 		auto& result = dst.emplace_back(id);
+		result.connections = std::move(chainConnections[chainIdx]);
 		auto& vs = result.vertices;
 		vs.insert(vs.end(), chain.begin(), chain.end());
 
@@ -775,9 +881,6 @@ void Navmesh::Portal::postProcess(gsl::span<const Polygon> polygons, std::vector
 				curLen += segmentLen;
 			}
 		}
-		
-		// TODO: output connections too
-		
 	}
 }
 
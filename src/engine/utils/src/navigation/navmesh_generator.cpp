@@ -3,41 +3,76 @@
 #include <cassert>
 
 #include "halley/navigation/navmesh_set.h"
+#include "halley/concurrency/concurrent.h"
+#include "halley/data_structures/hash_map.h"
 #include "halley/support/logger.h"
 #include "halley/utils/algorithm.h"
 using namespace Halley;
 
 NavmeshSet NavmeshGenerator::generate(const Params& params)
 {
-	auto obstacles = preProcessObstacles(params.obstacles, params.agentSize);
-
+	const auto obstacles = preProcessObstacles(params.obstacles, params.agentSize);
 	const auto& bounds = params.bounds;
+
+	std::vector<std::vector<NavmeshNode>> cells(bounds.side0Divisions * bounds.side1Divisions);
+	auto generateCellAt = [&] (size_t idx)
+	{
+		cells[idx] = generateCell(bounds, idx / bounds.side1Divisions, idx % bounds.side1Divisions, obstacles);
+	};
+
+	// Cells are independent of each other, so they can be generated in parallel
+	if (params.executionQueue) {
+		Concurrent::parallelFor(*params.executionQueue, 0, cells.size(), generateCellAt, 1);
+	} else {
+		for (size_t i = 0; i < cells.size(); ++i) {
+			generateCellAt(i);
+		}
+	}
+
+	return generateFromCells(params, cells);
+}
+
+Polygon NavmeshGenerator::makeCell(const NavmeshBounds& bounds, size_t i, size_t j)
+{
 	const auto u = bounds.side0 / bounds.side0Divisions;
 	const auto v = bounds.side1 / bounds.side1Divisions;
-	const float maxSize = (u - v).length() * 0.6f;
+	return Polygon(VertexList{{
+		bounds.origin + (i + 1) * u + j * v,
+		bounds.origin + (i + 1) * u + (j + 1) * v,
+		bounds.origin + i * u + (j + 1) * v,
+		bounds.origin + i * u + j * v
+	}});
+}
+
+float NavmeshGenerator::getMaxPolygonSize(const NavmeshBounds& bounds)
+{
+	const auto u = bounds.side0 / bounds.side0Divisions;
+	const auto v = bounds.side1 / bounds.side1Divisions;
+	return (u - v).length() * 0.6f;
+}
+
+std::vector<NavmeshGenerator::NavmeshNode> NavmeshGenerator::generateCell(const NavmeshBounds& bounds, size_t i, size_t j, gsl::span<const Polygon> obstacles)
+{
+	const auto cell = makeCell(bounds, i, j);
+
+	auto cellPolygons = toNavmeshNode(generateByPolygonSubtraction(gsl::span<const Polygon>(&cell, 1), obstacles, cell.getBoundingCircle()));
+	generateConnectivity(cellPolygons);
+	postProcessPolygons(cellPolygons, getMaxPolygonSize(bounds), false);
+	return cellPolygons;
+}
+
+NavmeshSet NavmeshGenerator::generateFromCells(const Params& params, gsl::span<const std::vector<NavmeshNode>> cells)
+{
+	const auto& bounds = params.bounds;
 
 	std::vector<NavmeshNode> polygons;
-	
-	for (size_t i = 0; i < bounds.side0Divisions; ++i) {
-		for (size_t j = 0; j < bounds.side1Divisions; ++j) {
-			const auto cell = Polygon(VertexList{{
-				bounds.origin + (i + 1) * u + j * v,
-				bounds.origin + (i + 1) * u + (j + 1) * v,
-				bounds.origin + i * u + (j + 1) * v,
-				bounds.origin + i * u + j * v
-			}});
-
-			auto cellPolygons = toNavmeshNode(generateByPolygonSubtraction(gsl::span<const Polygon>(&cell, 1), obstacles, cell.getBoundingCircle()));
-			generateConnectivity(cellPolygons);
-			postProcessPolygons(cellPolygons, maxSize, false);
-
-			const int startIdx = static_cast<int>(polygons.size());
-			for (auto& p: cellPolygons) {
-				polygons.emplace_back(std::move(p));
-				for (auto& c: polygons.back().connections) {
-					if (c >= 0) {
-						c += startIdx;
-					}
+	for (const auto& cellPolygons: cells) {
+		const int startIdx = static_cast<int>(polygons.size());
+		for (const auto& p: cellPolygons) {
+			polygons.push_back(p);
+			for (auto& c: polygons.back().connections) {
+				if (c >= 0) {
+					c += startIdx;
 				}
 			}
 		}
@@ -47,7 +82,7 @@ NavmeshSet NavmeshGenerator::generate(const Params& params)
 	generateConnectivity(polygons);
 	tagEdgeConnections(polygons, params.bounds.makeEdges());
 	removeNodesBeyondPortals(polygons);
-	postProcessPolygons(polygons, maxSize, true);
+	postProcessPolygons(polygons, getMaxPolygonSize(bounds), true);
 	simplifyPolygons(polygons);
 	applyRegions(polygons, params.regions);
 	const int nRegions = assignRegions(polygons);
@@ -168,21 +203,64 @@ std::vector<NavmeshGenerator::NavmeshNode> NavmeshGenerator::toNavmeshNode(std::
 
 void NavmeshGenerator::generateConnectivity(gsl::span<NavmeshNode> polygons)
 {
+	// Two polygons can only share an edge if they share its vertices, so bucket polygons by their (quantized) vertices,
+	// and only test edges against polygons found around their first vertex. The neighbouring buckets are checked too, in case the vertices are within epsilon but on either side of a bucket boundary.
+	constexpr float epsilon = 0.0001f;
+	constexpr float bucketSize = 0.01f;
+	auto getBucket = [&] (Vector2f p) -> Vector2i
+	{
+		return Vector2i(static_cast<int>(std::floor(p.x / bucketSize)), static_cast<int>(std::floor(p.y / bucketSize)));
+	};
+	auto getKey = [] (Vector2i bucket) -> uint64_t
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(bucket.x)) << 32) | static_cast<uint32_t>(bucket.y);
+	};
+
+	HashMap<uint64_t, std::vector<int>> polygonsAtVertex;
+	for (size_t polyIdx = 0; polyIdx < polygons.size(); ++polyIdx) {
+		for (const auto& v: polygons[polyIdx].polygon.getVertices()) {
+			auto& bucket = polygonsAtVertex[getKey(getBucket(v))];
+			if (bucket.empty() || bucket.back() != static_cast<int>(polyIdx)) {
+				bucket.push_back(static_cast<int>(polyIdx));
+			}
+		}
+	}
+
+	std::vector<int> candidates;
 	for (size_t polyAIdx = 0; polyAIdx < polygons.size(); ++polyAIdx) {
 		NavmeshNode& a = polygons[polyAIdx];
 
 		for (size_t edgeAIdx = 0; edgeAIdx < a.connections.size(); ++edgeAIdx) {
 			if (a.connections[edgeAIdx] < 0) {
 				const auto edgeA = a.polygon.getEdge(edgeAIdx);
-				
-				for (size_t polyBIdx = polyAIdx + 1; polyBIdx < polygons.size(); ++polyBIdx) {
+
+				candidates.clear();
+				const auto centre = getBucket(edgeA.a);
+				for (int y = -1; y <= 1; ++y) {
+					for (int x = -1; x <= 1; ++x) {
+						const auto iter = polygonsAtVertex.find(getKey(centre + Vector2i(x, y)));
+						if (iter != polygonsAtVertex.end()) {
+							for (const int idx: iter->second) {
+								if (idx > static_cast<int>(polyAIdx)) {
+									candidates.push_back(idx);
+								}
+							}
+						}
+					}
+				}
+
+				// Visit candidates in the same order as a full scan would
+				std::sort(candidates.begin(), candidates.end());
+				candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+				for (const int polyBIdx: candidates) {
 					NavmeshNode& b = polygons[polyBIdx];
 
-					const auto edgeBIdx = b.polygon.findEdge(edgeA, 0.0001f);
+					const auto edgeBIdx = b.polygon.findEdge(edgeA, epsilon);
 					if (edgeBIdx) {
 						if (b.connections[edgeBIdx.value()] < 0) {
 							// Establish connection
-							a.connections[edgeAIdx] = static_cast<int>(polyBIdx);
+							a.connections[edgeAIdx] = polyBIdx;
 							b.connections[edgeBIdx.value()] = static_cast<int>(polyAIdx);
 						}
 					}
@@ -1,10 +1,36 @@
 #include "halley/navigation/navmesh_set.h"
 
+#include <queue>
+
 #include "halley/data_structures/priority_queue.h"
+#include "pathfinding_scratch.h"
 #include "halley/maths/ray.h"
 #include "halley/support/logger.h"
 using namespace Halley;
 
+void NavmeshRegionPathCache::clear()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	paths.clear();
+}
+
+bool NavmeshRegionPathCache::tryGet(uint16_t fromRegion, uint16_t toRegion, std::vector<NavigationPath::RegionNode>& result) const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const auto iter = paths.find((static_cast<uint32_t>(fromRegion) << 16) | toRegion);
+	if (iter == paths.end()) {
+		return false;
+	}
+	result = iter->second;
+	return true;
+}
+
+void NavmeshRegionPathCache::set(uint16_t fromRegion, uint16_t toRegion, std::vector<NavigationPath::RegionNode> path)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	paths[(static_cast<uint32_t>(fromRegion) << 16) | toRegion] = std::move(path);
+}
+
 NavmeshSet::NavmeshSet()
 {
 }
@@ -53,7 +79,7 @@ void NavmeshSet::clearSubWorld(int subWorld)
 	navmeshes.erase(std::remove_if(navmeshes.begin(), navmeshes.end(), [&] (const Navmesh& nav) { return nav.getSubWorld() == subWorld; }), navmeshes.end());
 }
 
-std::optional<NavigationPath> NavmeshSet::pathfind(const NavigationQuery& query) const
+std::optional<NavigationPath> NavmeshSet::pathfind(const NavigationQuery& query, NavmeshRegionPathCache* regionPathCache) const
 {
 	const size_t fromRegion = getNavMeshIdxAt(query.from, query.fromSubWorld);
 	const size_t toRegion = getNavMeshIdxAt(query.to, query.toSubWorld);
@@ -67,7 +93,15 @@ std::optional<NavigationPath> NavmeshSet::pathfind(const NavigationQuery& query)
 		return pathfindInRegion(query, static_cast<uint16_t>(fromRegion));
 	} else {
 		// Gotta path between regions first
-		auto regionPath = findRegionPath(query.from, query.to, static_cast<uint16_t>(fromRegion), static_cast<uint16_t>(toRegion));
+		const auto fromRegionId = static_cast<uint16_t>(fromRegion);
+		const auto toRegionId = static_cast<uint16_t>(toRegion);
+		std::vector<NodeAndConn> regionPath;
+		if (!regionPathCache || !regionPathCache->tryGet(fromRegionId, toRegionId, regionPath)) {
+			regionPath = findRegionPath(query.from, query.to, fromRegionId, toRegionId);
+			if (regionPathCache) {
+				regionPathCache->set(fromRegionId, toRegionId, regionPath);
+			}
+		}
 		if (regionPath.size() <= 1) {
 			// Failed
 			return {};
@@ -116,7 +150,7 @@ size_t NavmeshSet::getNavMeshIdxAt(Vector2f pos, int subWorld) const
 	return std::numeric_limits<size_t>::max();
 }
 
-void NavmeshSet::linkNavmeshes()
+void NavmeshSet::linkNavmeshes(size_t landmarkCount)
 {
 	regionNodes.clear();
 	regionNodes.resize(navmeshes.size());
@@ -140,14 +174,100 @@ void NavmeshSet::linkNavmeshes()
 		
 		// Insert all edges that can be reached by these two regions as neighbours of this edge
 		const auto& dstRegion = regionNodes[portalNode.toRegion];
-		const auto curPos = portalNode.pos;
+		const auto& dstNavmesh = navmeshes[portalNode.toRegion];
 		
 		portalNode.connections.reserve(dstRegion.portals.size() - 1);
 		for (size_t i = 0; i < dstRegion.portals.size(); ++i) {
-			if (curPortalId != portalNode.toPortal) {
-				const auto dstPortalId = dstRegion.portals[i];
+			const auto dstPortalId = dstRegion.portals[i];
+			// Portal nodes are created in pairs, skip the one going straight back
+			if (dstPortalId != (curPortalId ^ 1)) {
 				const auto& other = portalNodes[dstPortalId];
-				portalNode.connections.emplace_back(dstPortalId, portalNode.toRegion, (other.pos - curPos).length());
+				const float cost = dstNavmesh.getPortalCost(portalNode.toPortal, other.fromPortal);
+				if (cost < std::numeric_limits<float>::infinity()) {
+					portalNode.connections.emplace_back(dstPortalId, portalNode.toRegion, cost);
+				}
+			}
+		}
+	}
+
+	computeLandmarks(landmarkCount);
+}
+
+void NavmeshSet::setHeuristicWeight(float weight)
+{
+	Expects(weight >= 1.0f);
+	heuristicWeight = weight;
+}
+
+void NavmeshSet::computeLandmarks(size_t count)
+{
+	numLandmarks = 0;
+	landmarkDistances.clear();
+
+	const size_t nPortals = portalNodes.size();
+	count = std::min(count, std::min(maxLandmarks, nPortals));
+	if (count == 0) {
+		return;
+	}
+
+	// Pick landmarks by farthest point sampling, starting with the portal farthest away from an arbitrary one
+	std::vector<std::vector<float>> distances;
+	std::vector<float> dist;
+	std::vector<float> closestLandmark(nPortals, std::numeric_limits<float>::infinity());
+	computeDistancesFrom(0, dist);
+	std::copy(dist.begin(), dist.end(), closestLandmark.begin());
+
+	while (distances.size() < count) {
+		std::optional<NodeId> next;
+		float bestDist = 0;
+		for (size_t i = 0; i < nPortals; ++i) {
+			const float d = closestLandmark[i];
+			if (d < std::numeric_limits<float>::infinity() && d > bestDist) {
+				bestDist = d;
+				next = static_cast<NodeId>(i);
+			}
+		}
+		if (!next) {
+			break;
+		}
+
+		computeDistancesFrom(next.value(), dist);
+		for (size_t i = 0; i < nPortals; ++i) {
+			closestLandmark[i] = std::min(closestLandmark[i], dist[i]);
+		}
+		distances.push_back(dist);
+	}
+
+	numLandmarks = distances.size();
+	landmarkDistances.resize(nPortals * numLandmarks);
+	for (size_t i = 0; i < nPortals; ++i) {
+		for (size_t l = 0; l < numLandmarks; ++l) {
+			landmarkDistances[i * numLandmarks + l] = distances[l][i];
+		}
+	}
+}
+
+void NavmeshSet::computeDistancesFrom(NodeId portalId, std::vector<float>& dist) const
+{
+	using Entry = std::pair<float, NodeId>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<>> openSet;
+
+	dist.assign(portalNodes.size(), std::numeric_limits<float>::infinity());
+	dist[portalId] = 0;
+	openSet.push(Entry(0.0f, portalId));
+
+	while (!openSet.empty()) {
+		const auto [curDist, curId] = openSet.top();
+		openSet.pop();
+		if (curDist > dist[curId]) {
+			continue;
+		}
+
+		for (const auto& conn: portalNodes[curId].connections) {
+			const float newDist = curDist + conn.cost;
+			if (newDist < dist[conn.portalId]) {
+				dist[conn.portalId] = newDist;
+				openSet.push(Entry(newDist, conn.portalId));
 			}
 		}
 	}
@@ -247,18 +367,36 @@ std::vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPo
 		return {};
 	}
 
-	// State map. Using vector for perf, trading space for CPU.
-	// TODO: measure this vs unordered_map or some other hashtable, it's not impossible that it'd perform better (compact memory)
-	std::vector<State> state(portalNodes.size(), State{});
+	// State map. Kept per thread and reused across queries, so it's never allocated or cleared in the steady state
+	thread_local PathfindingScratch<State> state;
+	state.begin(portalNodes.size());
 
 	// Open set
-	auto openSet = PriorityQueue<NodeId, NodeComparator>(NodeComparator(state));
-	openSet.reserve(std::min(static_cast<size_t>(100), portalNodes.size()));
+	thread_local PriorityQueue<NodeId, NodeComparator> openSet(NodeComparator(state.getValues()));
+	openSet.clear();
+
+	// Distance from each landmark to the closest portal into the destination (portal nodes come in pairs, so those are the partners of the ones leaving it)
+	std::array<float, maxLandmarks> landmarkToEnd;
+	for (size_t l = 0; l < numLandmarks; ++l) {
+		landmarkToEnd[l] = std::numeric_limits<float>::infinity();
+		for (const auto portalId: regionNodes[toRegionId].portals) {
+			landmarkToEnd[l] = std::min(landmarkToEnd[l], landmarkDistances[(portalId ^ 1) * numLandmarks + l]);
+		}
+	}
 
 	// Define heuristic function
-	auto h = [&] (Vector2f pos) -> float
+	// The triangle inequality gives d(node, end) >= d(landmark, end) - d(landmark, node), for every landmark
+	// Only weighted if setHeuristicWeight asked for it, otherwise it stays admissible and the path found is the cheapest
+	auto h = [&] (NodeId portalId) -> float
 	{
-		return (pos - endPos).length();
+		float result = (portalNodes[portalId].pos - endPos).length();
+		const float* dist = landmarkDistances.data() + portalId * numLandmarks;
+		for (size_t l = 0; l < numLandmarks; ++l) {
+			if (dist[l] < std::numeric_limits<float>::infinity() && landmarkToEnd[l] < std::numeric_limits<float>::infinity()) {
+				result = std::max(result, landmarkToEnd[l] - dist[l]);
+			}
+		}
+		return result * heuristicWeight;
 	};
 
 	// Initialize the query
@@ -269,7 +407,7 @@ std::vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPo
 			const auto pos = portalNodes[portalId].pos;
 			nodeState.cameFrom = std::numeric_limits<uint16_t>::max();
 			nodeState.gScore = (pos - startPos).length();
-			nodeState.fScore = h(pos);
+			nodeState.fScore = nodeState.gScore + h(portalId);
 			nodeState.inOpenSet = true;
 			openSet.push(portalId);
 		}
@@ -315,7 +453,7 @@ std::vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPo
 				if (neighScore < neighState.gScore) {
 					neighState.cameFrom = curId;
 					neighState.gScore = neighScore;
-					neighState.fScore = neighScore + h(portalNodes[nodeId].pos);
+					neighState.fScore = neighScore + h(nodeId);
 					if (!neighState.inOpenSet) {
 						neighState.inOpenSet = true;
 						openSet.push(nodeId);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Halley {
+	// Per-node search state that can be reused between searches without clearing it.
+	// Every entry is stamped with the generation of the search that last wrote it; entries from older searches read as default.
+	// Meant to be kept thread_local, so each worker thread only pays for the allocation once.
+	template <typename T>
+	class PathfindingScratch {
+	public:
+		void begin(size_t size)
+		{
+			if (values.size() < size) {
+				values.resize(size);
+				generations.resize(size, 0);
+			}
+
+			++generation;
+			if (generation == 0) {
+				// Wrapped around, so old stamps could look current
+				std::fill(generations.begin(), generations.end(), 0);
+				generation = 1;
+			}
+		}
+
+		T& operator[](size_t idx)
+		{
+			if (generations[idx] != generation) {
+				generations[idx] = generation;
+				values[idx] = T{};
+			}
+			return values[idx];
+		}
+
+		// Only valid for entries touched by the current search
+		const std::vector<T>& getValues() const
+		{
+			return values;
+		}
+
+	private:
+		std::vector<T> values;
+		std::vector<uint32_t> generations;
+		uint32_t generation = 0;
+	};
+}
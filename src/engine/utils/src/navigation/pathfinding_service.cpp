@@ -0,0 +1,88 @@
+#include "halley/navigation/pathfinding_service.h"
+
+#include "halley/concurrency/concurrent.h"
+#include "halley/support/logger.h"
+using namespace Halley;
+
+PathfindingService::PathfindingService(const NavmeshSet& navmeshSet)
+	: PathfindingService(navmeshSet, Executors::getCPU())
+{}
+
+PathfindingService::PathfindingService(const NavmeshSet& navmeshSet, ExecutionQueue& queue)
+	: navmeshSet(navmeshSet)
+	, queue(queue)
+{}
+
+void PathfindingService::newFrame()
+{
+	regionPathCache.clear();
+}
+
+Vector<Future<PathfindingService::Result>> PathfindingService::submit(Vector<NavigationQuery> queries)
+{
+	Vector<Future<Result>> futures;
+	futures.reserve(queries.size());
+
+	const size_t n = queries.size();
+	for (size_t start = 0; start < n; start += queriesPerJob) {
+		const size_t end = std::min(n, start + queriesPerJob);
+
+		std::vector<std::pair<NavigationQuery, Promise<Result>>> jobQueries;
+		jobQueries.reserve(end - start);
+		for (size_t i = start; i < end; ++i) {
+			jobQueries.emplace_back(std::move(queries[i]), Promise<Result>());
+			futures.push_back(jobQueries.back().second.getFuture());
+		}
+
+		queue.addToQueue([this, jobQueries = std::move(jobQueries)] () mutable
+		{
+			for (auto& [query, promise]: jobQueries) {
+				promise.setValue(pathfind(query));
+			}
+		});
+	}
+
+	return futures;
+}
+
+Future<PathfindingService::Result> PathfindingService::submit(NavigationQuery query)
+{
+	Vector<NavigationQuery> queries;
+	queries.push_back(std::move(query));
+	return submit(std::move(queries))[0];
+}
+
+Vector<PathfindingService::Result> PathfindingService::run(gsl::span<const NavigationQuery> queries)
+{
+	auto futures = submit(Vector<NavigationQuery>(queries.begin(), queries.end()));
+
+	auto all = Concurrent::whenAll(futures.begin(), futures.end());
+	while (!all.isReady()) {
+		if (!queue.tryRunOne()) {
+			std::this_thread::yield();
+		}
+	}
+
+	Vector<Result> results;
+	results.reserve(futures.size());
+	for (auto& future: futures) {
+		results.push_back(future.get());
+	}
+	return results;
+}
+
+void PathfindingService::setQueriesPerJob(size_t n)
+{
+	queriesPerJob = std::max(n, static_cast<size_t>(1));
+}
+
+PathfindingService::Result PathfindingService::pathfind(const NavigationQuery& query)
+{
+	try {
+		return navmeshSet.pathfind(query, &regionPathCache);
+	} catch (const std::exception& e) {
+		// Failing the query is better than leaving its future hanging forever
+		Logger::logException(e);
+		return {};
+	}
+}
@@ -40,6 +40,11 @@ void Resource::reload(Resource&& resource)
 {
 }
 
+Vector<std::pair<AssetType, String>> Resource::getDependencies() const
+{
+	return {};
+}
+
 ResourceObserver::ResourceObserver()
 {
 }
@@ -129,3 +134,8 @@ bool AsyncResource::isLoaded() const
 {
 	return !loading;
 }
+
+bool AsyncResource::hasFailed() const
+{
+	return failed;
+}
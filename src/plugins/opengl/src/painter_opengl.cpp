@@ -5,6 +5,7 @@
 #include "constant_buffer_opengl.h"
 #include "halley/core/graphics/material/material_parameter.h"
 #include "texture_opengl.h"
+#include "retained_vertex_buffer_opengl.h"
 
 using namespace Halley;
 
@@ -160,14 +161,7 @@ void PainterOpenGL::setVertices(const MaterialDefinition& material, size_t numVe
 
 	// Load indices into VBO
 	if (standardQuadsOnly) {
-		if (stdQuadElementBuffer.getSize() < numIndices * sizeof(unsigned short)) {
-			size_t indicesToAllocate = nextPowerOf2(numIndices);
-			std::vector<unsigned short> tmp(indicesToAllocate);
-			generateQuadIndices(0, indicesToAllocate / 6, tmp.data());
-			stdQuadElementBuffer.setData(gsl::as_bytes(gsl::span<unsigned short>(tmp)));
-		} else {
-			stdQuadElementBuffer.bind();
-		}
+		bindStandardQuadIndices(numIndices);
 	} else {
 		elementBuffer.setData(gsl::as_bytes(gsl::span<unsigned short>(indices, numIndices)));
 	}
@@ -180,6 +174,28 @@ void PainterOpenGL::setVertices(const MaterialDefinition& material, size_t numVe
 	setupVertexAttributes(material);
 }
 
+void PainterOpenGL::setRetainedVertices(const MaterialDefinition& material, RetainedVertexBuffer& buffer, size_t numVertices)
+{
+	Expects(numVertices > 0);
+	Expects(numVertices % 4 == 0);
+
+	bindStandardQuadIndices(numVertices * 3 / 2);
+	static_cast<RetainedVertexBufferOpenGL&>(buffer).bind();
+	setupVertexAttributes(material);
+}
+
+void PainterOpenGL::bindStandardQuadIndices(size_t numIndices)
+{
+	if (stdQuadElementBuffer.getSize() < numIndices * sizeof(unsigned short)) {
+		size_t indicesToAllocate = nextPowerOf2(numIndices);
+		std::vector<unsigned short> tmp(indicesToAllocate);
+		generateQuadIndices(0, indicesToAllocate / 6, tmp.data());
+		stdQuadElementBuffer.setData(gsl::as_bytes(gsl::span<unsigned short>(tmp)));
+	} else {
+		stdQuadElementBuffer.bind();
+	}
+}
+
 void PainterOpenGL::setupVertexAttributes(const MaterialDefinition& material)
 {
 	// Set vertex attribute pointers in VBO
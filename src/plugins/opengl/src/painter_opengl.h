@@ -26,6 +26,7 @@ namespace Halley
 
 	protected:
 		void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, unsigned short* indices, bool standardQuadsOnly) override;
+		void setRetainedVertices(const MaterialDefinition& material, RetainedVertexBuffer& buffer, size_t numVertices) override;
 		void drawTriangles(size_t numIndices) override;
 		void setViewPort(Rect4i rect) override;
 		void onUpdateProjection(Material& material, bool hashChanged) override;
@@ -40,5 +41,6 @@ namespace Halley
 		std::unique_ptr<GLUtils> glUtils;
 
 		void setupVertexAttributes(const MaterialDefinition& material);
+		void bindStandardQuadIndices(size_t numIndices);
 	};
 }
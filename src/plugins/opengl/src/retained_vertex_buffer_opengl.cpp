@@ -0,0 +1,18 @@
+#include "retained_vertex_buffer_opengl.h"
+
+using namespace Halley;
+
+RetainedVertexBufferOpenGL::RetainedVertexBufferOpenGL()
+{
+	buffer.init(GL_ARRAY_BUFFER, GL_STATIC_DRAW);
+}
+
+void RetainedVertexBufferOpenGL::update(gsl::span<const gsl::byte> data)
+{
+	buffer.setData(data);
+}
+
+void RetainedVertexBufferOpenGL::bind()
+{
+	buffer.bind();
+}
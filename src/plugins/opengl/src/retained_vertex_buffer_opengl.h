@@ -0,0 +1,17 @@
+#pragma once
+#include "halley/core/api/video_api.h"
+#include "gl_buffer.h"
+
+namespace Halley
+{
+	class RetainedVertexBufferOpenGL : public RetainedVertexBuffer
+	{
+	public:
+		RetainedVertexBufferOpenGL();
+		void update(gsl::span<const gsl::byte> data) override;
+		void bind();
+
+	private:
+		GLBuffer buffer;
+	};
+}
@@ -10,6 +10,7 @@
 #include <halley/core/graphics/window.h>
 #include "halley/text/string_converter.h"
 #include "constant_buffer_opengl.h"
+#include "retained_vertex_buffer_opengl.h"
 #include "halley/core/graphics/material/uniform_type.h"
 using namespace Halley;
 
@@ -259,6 +260,11 @@ std::unique_ptr<MaterialConstantBuffer> VideoOpenGL::createConstantBuffer()
 	return std::make_unique<ConstantBufferOpenGL>();
 }
 
+std::unique_ptr<RetainedVertexBuffer> VideoOpenGL::createRetainedVertexBuffer()
+{
+	return std::make_unique<RetainedVertexBufferOpenGL>();
+}
+
 String VideoOpenGL::getShaderLanguage()
 {
 	return "glsl";
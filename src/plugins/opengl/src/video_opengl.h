@@ -29,6 +29,7 @@ namespace Halley {
 		std::unique_ptr<TextureRenderTarget> createTextureRenderTarget() override;
 		std::unique_ptr<ScreenRenderTarget> createScreenRenderTarget() override;
 		std::unique_ptr<MaterialConstantBuffer> createConstantBuffer() override;
+		std::unique_ptr<RetainedVertexBuffer> createRetainedVertexBuffer() override;
 
 		String getShaderLanguage() override;
 		bool isColumnMajor() const override;
@@ -0,0 +1,142 @@
+// Measures throughput of each AudioMixer kernel, for every instruction set supported by this CPU
+// Usage: halley-audio-mixer-benchmark [voices] [packsPerBuffer] [iterations]
+
+#include "audio_mixer.h"
+#include <halley/maths/random.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using namespace Halley;
+
+namespace {
+	const char* getName(AudioMixerISA isa)
+	{
+		switch (isa) {
+		case AudioMixerISA::Scalar:
+			return "Scalar";
+		case AudioMixerISA::SSE:
+			return "SSE";
+		case AudioMixerISA::AVX2:
+			return "AVX2";
+		}
+		return "?";
+	}
+
+	void fill(std::vector<AudioSamplePack>& packs, Random& rng)
+	{
+		for (auto& p: packs) {
+			for (auto& s: p.samples) {
+				s = rng.getFloat(-1.0f, 1.0f);
+			}
+		}
+	}
+
+	float maxDifference(const std::vector<AudioSamplePack>& a, const std::vector<AudioSamplePack>& b)
+	{
+		float result = 0;
+		for (size_t i = 0; i < a.size(); ++i) {
+			for (size_t j = 0; j < AudioSamplePack::NumSamples; ++j) {
+				result = std::max(result, std::abs(a[i].samples[j] - b[i].samples[j]));
+			}
+		}
+		return result;
+	}
+
+	void report(const char* isa, const char* kernel, size_t samplesPerRun, size_t iterations, const std::function<void()>& f)
+	{
+		f(); // Warm up
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i) {
+			f();
+		}
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double samplesPerSecond = double(samplesPerRun) * double(iterations) / elapsed;
+		std::printf("%-8s %-22s %10.1f Msamples/s\n", isa, kernel, samplesPerSecond / 1000000.0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t nVoices = argc > 1 ? size_t(std::atoi(argv[1])) : 256;
+	const size_t nPacks = argc > 2 ? size_t(std::atoi(argv[2])) : 64;
+	const size_t iterations = argc > 3 ? size_t(std::atoi(argv[3])) : 200;
+	const size_t nSamples = nPacks * AudioSamplePack::NumSamples;
+
+	std::printf("%zu voices, %zu samples per buffer, %zu iterations\n", nVoices, nSamples, iterations);
+
+	Random rng(uint32_t(1234));
+	std::vector<std::vector<AudioSamplePack>> voices(nVoices, std::vector<AudioSamplePack>(nPacks));
+	for (auto& v: voices) {
+		fill(v, rng);
+	}
+	AudioBuffer left;
+	AudioBuffer right;
+	left.packs.resize(nPacks);
+	right.packs.resize(nPacks);
+	fill(left.packs, rng);
+	fill(right.packs, rng);
+	AudioBuffer* channels[] = { &left, &right };
+
+	std::vector<AudioSamplePack> reference(nPacks);
+	std::vector<AudioSamplePack> mixed(nPacks);
+	std::vector<AudioSamplePack> stereo(nPacks * 2);
+	std::vector<AudioSamplePack> referenceStereo(nPacks * 2);
+
+	for (auto isa: { AudioMixerISA::Scalar, AudioMixerISA::SSE, AudioMixerISA::AVX2 }) {
+		if (!AudioMixer::isSupported(isa)) {
+			std::printf("%-8s not supported\n", getName(isa));
+			continue;
+		}
+		auto mixer = AudioMixer::makeMixer(isa);
+		const char* name = getName(isa);
+
+		report(name, "mixAudio", nSamples * nVoices, iterations, [&] ()
+		{
+			std::fill(mixed.begin(), mixed.end(), AudioSamplePack{});
+			for (auto& v: voices) {
+				mixer->mixAudio(v, mixed, 0.5f, 0.5f);
+			}
+		});
+
+		report(name, "mixAudio (gain ramp)", nSamples * nVoices, iterations, [&] ()
+		{
+			std::fill(mixed.begin(), mixed.end(), AudioSamplePack{});
+			for (auto& v: voices) {
+				mixer->mixAudio(v, mixed, 0.2f, 0.8f);
+			}
+		});
+
+		// Check against the scalar version
+		if (isa == AudioMixerISA::Scalar) {
+			reference = mixed;
+		} else {
+			std::printf("%-8s %-22s %10g max error\n", name, "mixAudio (gain ramp)", maxDifference(reference, mixed));
+		}
+
+		report(name, "interleaveChannels", nSamples * 2, iterations * nVoices, [&] ()
+		{
+			mixer->interleaveChannels(stereo, channels);
+		});
+
+		if (isa == AudioMixerISA::Scalar) {
+			referenceStereo = stereo;
+		} else {
+			std::printf("%-8s %-22s %10g max error\n", name, "interleaveChannels", maxDifference(referenceStereo, stereo));
+		}
+
+		report(name, "concatenateChannels", nSamples * 2, iterations * nVoices, [&] ()
+		{
+			mixer->concatenateChannels(stereo, channels);
+		});
+
+		report(name, "compressRange", nSamples * 2, iterations * nVoices, [&] ()
+		{
+			mixer->compressRange(stereo);
+		});
+	}
+
+	return 0;
+}
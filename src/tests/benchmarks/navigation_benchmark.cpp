@@ -0,0 +1,165 @@
+// Compares long distance queries on a single flat navmesh against the hierarchical (region and portal graph) search, with and without landmarks,
+// and a crowd sharing one destination with per-agent queries against a single flow field
+// Usage: halley-navigation-benchmark [queries] [regionsPerSide] [obstacles]
+
+#include <halley/navigation/navigation_flow_field.h>
+#include <halley/navigation/navmesh_generator.h>
+#include <halley/navigation/navmesh_set.h>
+#include <halley/maths/random.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using namespace Halley;
+
+namespace {
+	constexpr float worldSize = 3000.0f;
+
+	Polygon makeBox(Vector2f a, Vector2f b)
+	{
+		return Polygon(VertexList{{ Vector2f(b.x, a.y), b, Vector2f(a.x, b.y), a }});
+	}
+
+	NavmeshSet generate(gsl::span<const Polygon> obstacles, gsl::span<const Polygon> regions)
+	{
+		NavmeshGenerator::Params params{ NavmeshBounds(Vector2f(), Vector2f(worldSize, 0), Vector2f(0, worldSize), 30, 30, Vector2f(1, 1)) };
+		params.obstacles = obstacles;
+		params.regions = regions;
+		params.agentSize = 4.0f;
+		return NavmeshGenerator::generate(params);
+	}
+
+	void report(const char* name, size_t queries, const std::function<size_t()>& f)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const size_t found = f();
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("%-36s %10.2f us/query  (%zu/%zu found)\n", name, elapsed * 1000000.0 / double(queries), found, queries);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t nQueries = argc > 1 ? size_t(std::atoi(argv[1])) : 500;
+	const int regionsPerSide = argc > 2 ? std::atoi(argv[2]) : 6;
+	const int nObstacles = argc > 3 ? std::atoi(argv[3]) : 3000;
+
+	Random rng(uint32_t(12345));
+	std::vector<Polygon> obstacles;
+	for (int i = 0; i < nObstacles; ++i) {
+		const auto pos = Vector2f(rng.getFloat(0.0f, worldSize), rng.getFloat(0.0f, worldSize));
+		const auto size = Vector2f(rng.getFloat(5.0f, 30.0f), rng.getFloat(5.0f, 30.0f));
+		obstacles.push_back(makeBox(pos, pos + size));
+	}
+
+	std::vector<Polygon> regions;
+	const float regionSize = worldSize / float(regionsPerSide);
+	for (int y = 0; y < regionsPerSide; ++y) {
+		for (int x = 0; x < regionsPerSide; ++x) {
+			const auto pos = Vector2f(float(x), float(y)) * regionSize;
+			regions.push_back(makeBox(pos, pos + Vector2f(regionSize, regionSize)));
+		}
+	}
+
+	auto flat = generate(obstacles, {});
+	flat.linkNavmeshes();
+	auto hierarchical = generate(obstacles, regions);
+	auto hierarchicalNoLandmarks = hierarchical;
+	hierarchical.linkNavmeshes(8);
+	hierarchicalNoLandmarks.linkNavmeshes();
+	size_t nFlatNodes = 0;
+	for (const auto& navmesh: flat.getNavmeshes()) {
+		nFlatNodes += navmesh.getNumNodes();
+	}
+	size_t nPortals = 0;
+	for (const auto& navmesh: hierarchical.getNavmeshes()) {
+		nPortals += navmesh.getPortals().size();
+	}
+	std::printf("Flat: %zu nodes, hierarchical: %zu navmeshes with %zu portals\n", nFlatNodes, hierarchical.getNavmeshes().size(), nPortals);
+
+	// Long queries, from one side of the world to the other
+	std::vector<NavigationQuery> queries;
+	while (queries.size() < nQueries) {
+		const auto from = Vector2f(rng.getFloat(0.0f, 0.2f), rng.getFloat(0.0f, 1.0f)) * worldSize;
+		const auto to = Vector2f(rng.getFloat(0.8f, 1.0f), rng.getFloat(0.0f, 1.0f)) * worldSize;
+		if (flat.getNavMeshAt(from, 0) && flat.getNavMeshAt(to, 0) && hierarchical.getNavMeshAt(from, 0) && hierarchical.getNavMeshAt(to, 0)) {
+			queries.emplace_back(from, 0, to, 0, NavigationQuery::PostProcessingType::None);
+		}
+	}
+
+	report("Flat A*", queries.size(), [&] ()
+	{
+		size_t found = 0;
+		for (const auto& q: queries) {
+			found += flat.pathfind(q) ? 1 : 0;
+		}
+		return found;
+	});
+
+	report("Portal graph", queries.size(), [&] ()
+	{
+		size_t found = 0;
+		for (const auto& q: queries) {
+			found += hierarchicalNoLandmarks.pathfind(q) ? 1 : 0;
+		}
+		return found;
+	});
+
+	report("Portal graph + landmarks", queries.size(), [&] ()
+	{
+		size_t found = 0;
+		for (const auto& q: queries) {
+			found += hierarchical.pathfind(q) ? 1 : 0;
+		}
+		return found;
+	});
+
+	// What NavigationPathFollower ends up doing over the whole trip, refining each region as it gets there
+	report("Portal graph + landmarks, all legs", queries.size(), [&] ()
+	{
+		size_t found = 0;
+		for (const auto& q: queries) {
+			const auto path = hierarchical.pathfind(q);
+			if (!path) {
+				continue;
+			}
+			bool ok = true;
+			auto pos = q.from;
+			for (size_t i = 0; i < path->regions.size() && ok; ++i) {
+				const auto& region = path->regions[i];
+				const auto& navmesh = hierarchical.getNavmeshes()[region.regionNodeId];
+				const bool isLast = i + 1 == path->regions.size();
+				const auto endPos = isLast ? q.to : navmesh.getPortals()[region.exitEdgeId].pos;
+				ok = hierarchical.pathfindInRegion(NavigationQuery(pos, 0, endPos, 0, q.postProcessingType), region.regionNodeId).has_value();
+				pos = endPos;
+			}
+			found += ok ? 1 : 0;
+		}
+		return found;
+	});
+
+	// Everyone heading to the same place
+	const auto goal = queries[0].to;
+	report("Shared goal, query per agent", queries.size(), [&] ()
+	{
+		size_t found = 0;
+		for (const auto& q: queries) {
+			found += hierarchical.pathfind(NavigationQuery(q.from, 0, goal, 0, q.postProcessingType)) ? 1 : 0;
+		}
+		return found;
+	});
+
+	report("Shared goal, flow field", queries.size(), [&] ()
+	{
+		const auto field = NavigationFlowField(hierarchical, goal, 0);
+		size_t found = 0;
+		for (const auto& q: queries) {
+			found += field.sample(q.from, 0) ? 1 : 0;
+		}
+		return found;
+	});
+
+	return 0;
+}
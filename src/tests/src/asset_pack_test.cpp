@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	Bytes readAsset(AssetPack& pack, const String& name, AssetType type)
+	{
+		auto data = pack.getData(name, type, false);
+		const auto span = dynamic_cast<ResourceDataStatic&>(*data).getSpan();
+		const auto* bytes = reinterpret_cast<const Byte*>(span.data());
+		return Bytes(bytes, bytes + span.size());
+	}
+
+	gsl::span<const gsl::byte> asSpan(const Bytes& bytes)
+	{
+		return gsl::as_bytes(gsl::span<const Byte>(bytes));
+	}
+}
+
+TEST(HalleyAssetPack, AssetsCanBeReadWhileBuilding)
+{
+	const auto compressible = Bytes(1000, 7);
+	const auto raw = Bytes{ 1, 2, 3, 4, 5 };
+
+	AssetPack pack;
+	pack.addAsset(AssetType::BinaryFile, "compressible", asSpan(compressible), Metadata(), AssetPackCompression::LZ4);
+	pack.addAsset(AssetType::TextFile, "raw", asSpan(raw), Metadata(), AssetPackCompression::None);
+	EXPECT_EQ(pack.getIndex().getEntries().size(), 2);
+	EXPECT_EQ(readAsset(pack, "compressible", AssetType::BinaryFile), compressible);
+	EXPECT_EQ(readAsset(pack, "raw", AssetType::TextFile), raw);
+	EXPECT_THROW(readAsset(pack, "raw", AssetType::BinaryFile), Exception);
+
+	// Assets added after a lookup show up too
+	const auto late = Bytes{ 9, 8, 7 };
+	pack.addAsset(AssetType::BinaryFile, "late", asSpan(late), Metadata(), AssetPackCompression::None);
+	EXPECT_EQ(readAsset(pack, "late", AssetType::BinaryFile), late);
+
+	// And the written pack reads back the same
+	AssetPack loaded(std::make_unique<PackDataReader>(pack.writeOut()));
+	EXPECT_EQ(loaded.getIndex().getEntries().size(), 3);
+	EXPECT_EQ(readAsset(loaded, "compressible", AssetType::BinaryFile), compressible);
+	EXPECT_EQ(readAsset(loaded, "raw", AssetType::TextFile), raw);
+	EXPECT_EQ(readAsset(loaded, "late", AssetType::BinaryFile), late);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/audio/audio_filter_biquad.h>
+#include <cmath>
+#include <complex>
+using namespace Halley;
+
+namespace {
+	// Ratio between output and input amplitude for a sine at the given frequency, once the filter has settled
+	float measureGain(const AudioFilterConfig& config, float frequency)
+	{
+		constexpr float sampleRate = float(AudioConfig::sampleRate);
+		constexpr size_t settleSamples = 4800;
+		constexpr size_t measureSamples = 48000;
+		constexpr size_t blockSize = 256;
+
+		AudioFilterBiquad filter;
+		filter.setParameters(config, sampleRate);
+
+		std::vector<float> block(blockSize);
+		double inEnergy = 0;
+		double outEnergy = 0;
+		for (size_t start = 0; start < settleSamples + measureSamples; start += blockSize) {
+			for (size_t i = 0; i < blockSize; ++i) {
+				block[i] = std::sin(2.0f * pif() * frequency * float(start + i) / sampleRate);
+			}
+			if (start >= settleSamples) {
+				for (const float x: block) {
+					inEnergy += x * x;
+				}
+			}
+
+			filter.process(block, 0);
+
+			if (start >= settleSamples) {
+				for (const float y: block) {
+					outEnergy += y * y;
+				}
+			}
+		}
+
+		return float(std::sqrt(outEnergy / inEnergy));
+	}
+
+	// |H(e^jw)| for the cookbook coefficients, to check the filter against
+	float expectedGain(const AudioFilterConfig& config, float frequency)
+	{
+		constexpr double sampleRate = AudioConfig::sampleRate;
+		const double w0 = 2.0 * pi() * config.frequency / sampleRate;
+		const double alpha = std::sin(w0) / (2.0 * config.q);
+		const double c = std::cos(w0);
+
+		double b0, b1, b2;
+		switch (config.type) {
+		case AudioFilterType::LowPass:
+			b0 = (1 - c) / 2; b1 = 1 - c; b2 = b0;
+			break;
+		case AudioFilterType::HighPass:
+			b0 = (1 + c) / 2; b1 = -(1 + c); b2 = b0;
+			break;
+		case AudioFilterType::BandPass:
+			b0 = alpha; b1 = 0; b2 = -alpha;
+			break;
+		default:
+			b0 = 1; b1 = -2 * c; b2 = 1;
+			break;
+		}
+		const double a0 = 1 + alpha;
+		const double a1 = -2 * c;
+		const double a2 = 1 - alpha;
+
+		const double w = 2.0 * pi() * frequency / sampleRate;
+		const auto num = std::complex<double>(b0) + b1 * std::polar(1.0, -w) + b2 * std::polar(1.0, -2 * w);
+		const auto den = std::complex<double>(a0) + a1 * std::polar(1.0, -w) + a2 * std::polar(1.0, -2 * w);
+		return float(std::abs(num / den));
+	}
+}
+
+TEST(HalleyAudioFilter, LowPassResponse)
+{
+	const AudioFilterConfig config(AudioFilterType::LowPass, 1000.0f);
+	EXPECT_NEAR(measureGain(config, 100.0f), 1.0f, 0.01f);
+	EXPECT_NEAR(measureGain(config, 1000.0f), 0.7071f, 0.01f);
+	EXPECT_LT(measureGain(config, 10000.0f), 0.02f);
+
+	for (const float f: { 50.0f, 500.0f, 2000.0f, 5000.0f }) {
+		EXPECT_NEAR(measureGain(config, f), expectedGain(config, f), 0.01f) << f << " Hz";
+	}
+}
+
+TEST(HalleyAudioFilter, HighPassResponse)
+{
+	const AudioFilterConfig config(AudioFilterType::HighPass, 1000.0f);
+	EXPECT_LT(measureGain(config, 100.0f), 0.02f);
+	EXPECT_NEAR(measureGain(config, 1000.0f), 0.7071f, 0.01f);
+	EXPECT_NEAR(measureGain(config, 10000.0f), 1.0f, 0.01f);
+
+	for (const float f: { 200.0f, 500.0f, 2000.0f, 5000.0f }) {
+		EXPECT_NEAR(measureGain(config, f), expectedGain(config, f), 0.01f) << f << " Hz";
+	}
+}
+
+TEST(HalleyAudioFilter, BandPassAndNotchResponse)
+{
+	const AudioFilterConfig bandPass(AudioFilterType::BandPass, 2000.0f, 2.0f);
+	EXPECT_NEAR(measureGain(bandPass, 2000.0f), 1.0f, 0.01f);
+	EXPECT_LT(measureGain(bandPass, 200.0f), 0.1f);
+	EXPECT_LT(measureGain(bandPass, 15000.0f), 0.1f);
+
+	const AudioFilterConfig notch(AudioFilterType::Notch, 2000.0f, 2.0f);
+	EXPECT_LT(measureGain(notch, 2000.0f), 0.01f);
+	EXPECT_NEAR(measureGain(notch, 200.0f), 1.0f, 0.01f);
+	EXPECT_NEAR(measureGain(notch, 15000.0f), 1.0f, 0.01f);
+}
+
+TEST(HalleyAudioFilter, ChannelsKeepSeparateState)
+{
+	AudioFilterBiquad filter;
+	filter.setParameters(AudioFilterConfig(AudioFilterType::LowPass, 500.0f));
+
+	std::vector<float> a(64, 0.0f);
+	a[0] = 1.0f;
+	filter.process(a, 0);
+
+	// Processing another channel in between mustn't affect where channel 0 left off
+	std::vector<float> noise(64, 0.5f);
+	filter.process(noise, 1);
+
+	std::vector<float> tail0(64, 0.0f);
+	filter.process(tail0, 0);
+
+	filter.reset();
+	std::vector<float> reference(128, 0.0f);
+	reference[0] = 1.0f;
+	filter.process(reference, 0);
+
+	for (size_t i = 0; i < 64; ++i) {
+		EXPECT_FLOAT_EQ(a[i], reference[i]);
+		EXPECT_NEAR(tail0[i], reference[64 + i], 1e-6f);
+	}
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	Bytes makeTestData(size_t size, uint32_t seed)
+	{
+		Random rng(seed);
+		Bytes result(size);
+		for (size_t i = 0; i < size; ++i) {
+			// Mix of repeats and noise, so both matches and literal runs get exercised
+			result[i] = i > 16 && rng.getInt(0, 3) != 0 ? result[i - size_t(rng.getInt(1, 16))] : Byte(rng.getInt(0, 255));
+		}
+		return result;
+	}
+}
+
+TEST(HalleyCompression, LZ4RoundTrip)
+{
+	for (size_t size: { 0, 1, 12, 13, 100, 4096, 100000 }) {
+		const auto data = makeTestData(size, uint32_t(size));
+		const auto compressed = Compression::compressLZ4(gsl::as_bytes(gsl::span<const Byte>(data)));
+		const auto decompressed = Compression::decompressLZ4(gsl::as_bytes(gsl::span<const Byte>(compressed)));
+		EXPECT_EQ(data, decompressed);
+	}
+}
+
+TEST(HalleyCompression, LZ4Compresses)
+{
+	const auto data = Bytes(10000, 42);
+	const auto compressed = Compression::compressLZ4(gsl::as_bytes(gsl::span<const Byte>(data)));
+	EXPECT_LT(compressed.size(), size_t(100));
+	EXPECT_EQ(data, Compression::decompressLZ4(gsl::as_bytes(gsl::span<const Byte>(compressed))));
+}
+
+TEST(HalleyCompression, LZ4RejectsCorruptData)
+{
+	const auto data = makeTestData(4096, 1);
+	auto compressed = Compression::compressLZ4(gsl::as_bytes(gsl::span<const Byte>(data)));
+	compressed.resize(compressed.size() / 2);
+	EXPECT_THROW(Compression::decompressLZ4(gsl::as_bytes(gsl::span<const Byte>(compressed))), Exception);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <thread>
+using namespace Halley;
+
+namespace {
+	std::thread makeThread(String, std::function<void()> f)
+	{
+		return std::thread(std::move(f));
+	}
+}
+
+TEST(HalleyConcurrency, WorkerJobsRunOnceEach)
+{
+	Executors executors;
+	Executors::setInstance(executors);
+	auto& cpu = Executors::getCPU();
+	ThreadPool pool("test", cpu, 4, makeThread);
+
+	// Jobs queued from a worker go into its own deque, overflowing into the shared queue once that's full
+	constexpr size_t n = 20000;
+	for (int round = 0; round < 5; ++round) {
+		std::vector<std::atomic<int>> taken(n);
+		for (auto& t: taken) {
+			t = 0;
+		}
+		std::atomic<size_t> done { 0 };
+
+		// The worker takes some of its own jobs back as it goes, racing the other workers stealing them
+		Concurrent::execute(cpu, [&] ()
+		{
+			for (size_t i = 0; i < n; ++i) {
+				cpu.addToQueue([&, i] ()
+				{
+					++taken[i];
+					++done;
+				});
+				if (i % 3 == 0) {
+					cpu.tryRunOne();
+				}
+			}
+		}).wait();
+
+		while (done < n) {
+			if (!cpu.tryRunOne()) {
+				std::this_thread::yield();
+			}
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			ASSERT_EQ(taken[i].load(), 1) << "job " << i << " in round " << round;
+		}
+	}
+}
+
+TEST(HalleyConcurrency, ExecutionQueueRunsEveryTask)
+{
+	Executors executors;
+	Executors::setInstance(executors);
+	auto& cpu = Executors::getCPU();
+	ThreadPool pool("test", cpu, 4, makeThread);
+
+	// Several rounds, so jobs released on the workers get handed back to this thread and reused
+	for (int round = 0; round < 20; ++round) {
+		std::atomic<int> sum { 0 };
+		Vector<Future<int>> futures;
+		for (int i = 0; i < 500; ++i) {
+			futures.push_back(Concurrent::execute(cpu, [&sum, i] ()
+			{
+				sum += i;
+				return i;
+			}));
+		}
+
+		int total = 0;
+		for (auto& f: futures) {
+			total += f.get();
+		}
+		EXPECT_EQ(total, 500 * 499 / 2);
+		EXPECT_EQ(sum.load(), 500 * 499 / 2);
+	}
+}
+
+TEST(HalleyConcurrency, NestedParallelForCoversRange)
+{
+	Executors executors;
+	Executors::setInstance(executors);
+	auto& cpu = Executors::getCPU();
+	ThreadPool pool("test", cpu, 4, makeThread);
+
+	constexpr size_t outer = 64;
+	constexpr size_t inner = 1000;
+	std::vector<std::atomic<int>> hits(outer * inner);
+	for (auto& h: hits) {
+		h = 0;
+	}
+
+	// Every outer iteration forks its own loop, which would deadlock if workers blocked waiting on them
+	Concurrent::parallelFor(cpu, 0, outer, [&] (size_t i)
+	{
+		Concurrent::parallelFor(cpu, 0, inner, [&] (size_t j)
+		{
+			++hits[i * inner + j];
+		});
+	});
+
+	for (size_t i = 0; i < hits.size(); ++i) {
+		ASSERT_EQ(hits[i].load(), 1) << "index " << i;
+	}
+
+	EXPECT_THROW(Concurrent::parallelFor(cpu, 0, 100, [] (size_t i)
+	{
+		if (i == 42) {
+			throw Exception("test", HalleyExceptions::Concurrency);
+		}
+	}), Exception);
+}
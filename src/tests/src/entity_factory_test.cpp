@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "components/sprite_component.h"
+#include "halley/entity/components/transform_2d_component.h"
+using namespace Halley;
+
+namespace {
+	// Resources only needs a locator to fall back on, every asset used here is set directly
+	class NullSystemAPI : public SystemAPI {
+	public:
+		Path getAssetsPath(const Path& gamePath) const override { return gamePath; }
+		Path getUnpackedAssetsPath(const Path& gamePath) const override { return gamePath; }
+		std::unique_ptr<ResourceDataReader> getDataReader(String path, int64_t start, int64_t end) override { return {}; }
+		std::unique_ptr<GLContext> createGLContext() override { return {}; }
+		std::shared_ptr<Window> createWindow(const WindowDefinition& window) override { return {}; }
+		void destroyWindow(std::shared_ptr<Window> window) override {}
+		Vector2i getScreenSize(int n) const override { return {}; }
+		Rect4i getDisplayRect(int screen) const override { return {}; }
+		void showCursor(bool show) override {}
+		std::shared_ptr<ISaveData> getStorageContainer(SaveDataType type, const String& containerName) override { return {}; }
+
+	private:
+		bool generateEvents(VideoAPI* video, InputAPI* input) override { return false; }
+	};
+
+	CreateComponentFunctionResult createTestComponent(const EntityFactoryContext& context, const String& componentName, EntityRef& entity, const ConfigNode& componentData)
+	{
+		CreateComponentFunctionResult result;
+		if (componentName == SpriteComponent::componentName) {
+			// Each sprite gets its own material, the same way deserializing one does
+			Sprite sprite;
+			sprite.setMaterial(std::make_shared<Material>(std::make_shared<MaterialDefinition>()), false);
+			entity.addComponent<SpriteComponent>(SpriteComponent(std::move(sprite), 0, {}));
+			result.componentId = SpriteComponent::componentIndex;
+			result.created = true;
+		} else if (componentName == Transform2DComponent::componentName) {
+			result = context.createComponent<Transform2DComponent>(entity, componentData);
+		}
+		return result;
+	}
+}
+
+namespace Halley {
+	// Stands in for the registry the codegen would generate for a game
+	ComponentReflector& getComponentReflector(int componentId)
+	{
+		static ComponentReflectorImpl<SpriteComponent> spriteReflector;
+		static ComponentReflectorImpl<Transform2DComponent> transformReflector;
+		if (componentId == SpriteComponent::componentIndex) {
+			return spriteReflector;
+		} else if (componentId == Transform2DComponent::componentIndex) {
+			return transformReflector;
+		}
+		throw Exception("Unexpected component " + toString(componentId), HalleyExceptions::Entity);
+	}
+}
+
+TEST(HalleyEntityFactory, CreatedEntitiesDontShareMaterials)
+{
+	NullSystemAPI system;
+	HalleyAPI api{};
+	api.system = &system;
+	Resources resources(std::make_unique<ResourceLocator>(system), api, ResourceOptions());
+	resources.init<Prefab>();
+
+	ConfigNode spriteNode = ConfigNode::MapType();
+	spriteNode["Sprite"] = ConfigNode::MapType();
+	ConfigNode entityNode = ConfigNode::MapType();
+	entityNode["name"] = "spriteEntity";
+	entityNode["components"] = ConfigNode::SequenceType{ std::move(spriteNode) };
+	ConfigNode prefabNode = ConfigNode::MapType();
+	prefabNode["entity"] = std::move(entityNode);
+
+	auto prefab = std::make_shared<Prefab>();
+	prefab->parseConfigNode(std::move(prefabNode));
+	prefab->setAssetId("spriteEntity");
+	resources.of<Prefab>().setResource(0, "spriteEntity", prefab);
+
+	World world(api, resources, createTestComponent);
+	EntityFactory factory(world, resources);
+
+	// The first one is built as usual and becomes the blueprint, the others are copied from it
+	auto entities = factory.createEntities("spriteEntity", 3);
+	ASSERT_EQ(entities.size(), 3);
+
+	auto getMaterial = [&] (size_t i) -> const Material&
+	{
+		return entities[i].getComponent<SpriteComponent>().sprite.getMaterial();
+	};
+	EXPECT_NE(&getMaterial(0), &getMaterial(1));
+	EXPECT_NE(&getMaterial(1), &getMaterial(2));
+
+	entities[1].getComponent<SpriteComponent>().sprite.getMutableMaterial().setStencilReferenceOverride(uint8_t(1));
+	EXPECT_EQ(getMaterial(1).getStencilReferenceOverride(), std::optional<uint8_t>(1));
+	EXPECT_EQ(getMaterial(0).getStencilReferenceOverride(), std::nullopt);
+	EXPECT_EQ(getMaterial(2).getStencilReferenceOverride(), std::nullopt);
+
+	// Changing the instance the blueprint was made from mustn't leak into later copies either
+	entities[0].getComponent<SpriteComponent>().sprite.getMutableMaterial().setStencilReferenceOverride(uint8_t(2));
+	auto more = factory.createEntities("spriteEntity", 1);
+	ASSERT_EQ(more.size(), 1);
+	EXPECT_EQ(more[0].getComponent<SpriteComponent>().sprite.getMaterial().getStencilReferenceOverride(), std::nullopt);
+	EXPECT_EQ(getMaterial(2).getStencilReferenceOverride(), std::nullopt);
+}
+
+TEST(HalleyEntityFactory, CopiedTransformsKeepTheirHierarchy)
+{
+	NullSystemAPI system;
+	HalleyAPI api{};
+	api.system = &system;
+	Resources resources(std::make_unique<ResourceLocator>(system), api, ResourceOptions());
+	resources.init<Prefab>();
+
+	auto makeEntityNode = [] (const String& name, Vector2f position)
+	{
+		ConfigNode transformNode = ConfigNode::MapType();
+		transformNode["position"] = position;
+		ConfigNode componentNode = ConfigNode::MapType();
+		componentNode["Transform2D"] = std::move(transformNode);
+		ConfigNode entityNode = ConfigNode::MapType();
+		entityNode["name"] = name;
+		entityNode["uuid"] = UUID::generate().toString();
+		entityNode["components"] = ConfigNode::SequenceType{ std::move(componentNode) };
+		return entityNode;
+	};
+
+	auto childNode = makeEntityNode("child", Vector2f(1, 2));
+	childNode["children"] = ConfigNode::SequenceType{ makeEntityNode("grandchild", Vector2f(100, 200)) };
+	auto rootNode = makeEntityNode("root", Vector2f(10, 20));
+	rootNode["children"] = ConfigNode::SequenceType{ std::move(childNode) };
+	ConfigNode prefabNode = ConfigNode::MapType();
+	prefabNode["entity"] = std::move(rootNode);
+
+	auto prefab = std::make_shared<Prefab>();
+	prefab->parseConfigNode(std::move(prefabNode));
+	prefab->setAssetId("hierarchy");
+	resources.of<Prefab>().setResource(0, "hierarchy", prefab);
+
+	World world(api, resources, createTestComponent);
+	auto factory = std::make_unique<EntityFactory>(world, resources);
+
+	auto getGlobalPositions = [] (EntityRef root)
+	{
+		auto child = *root.getChildren().begin();
+		auto grandchild = *child.getChildren().begin();
+		return std::array<Vector2f, 3>{
+			root.getComponent<Transform2DComponent>().getGlobalPosition(),
+			child.getComponent<Transform2DComponent>().getGlobalPosition(),
+			grandchild.getComponent<Transform2DComponent>().getGlobalPosition()
+		};
+	};
+	const auto expected = std::array<Vector2f, 3>{ Vector2f(10, 20), Vector2f(11, 22), Vector2f(111, 222) };
+
+	// The first instance is the template the blueprint copies from, the second is made from those copies
+	const auto first = factory->createEntities("hierarchy", 1);
+	auto second = factory->createEntities("hierarchy", 1);
+	ASSERT_EQ(first.size(), 1);
+	ASSERT_EQ(second.size(), 1);
+	EXPECT_EQ(getGlobalPositions(first[0]), expected);
+	EXPECT_EQ(getGlobalPositions(second[0]), expected);
+
+	// Each copy follows its own parent
+	second[0].getComponent<Transform2DComponent>().setLocalPosition(Vector2f(0, 0));
+	EXPECT_EQ(getGlobalPositions(first[0]), expected);
+	EXPECT_EQ(getGlobalPositions(second[0])[2], Vector2f(101, 202));
+
+	// Dropping the blueprint after its template is gone mustn't touch either hierarchy
+	world.destroyEntity(first[0]);
+	world.spawnPending();
+	factory.reset();
+	EXPECT_EQ(getGlobalPositions(second[0])[2], Vector2f(101, 202));
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "components/camera_component.h"
+using namespace Halley;
+
+namespace {
+	int liveMessages = 0;
+
+	class PingMessage final : public Message {
+	public:
+		static constexpr int messageIndex{ 1 };
+
+		int value = 0;
+
+		PingMessage(int value) : value(value) { ++liveMessages; }
+		PingMessage(const PingMessage& other) : value(other.value) { ++liveMessages; }
+		PingMessage(PingMessage&& other) noexcept : value(other.value) { ++liveMessages; }
+		~PingMessage() { --liveMessages; }
+
+		size_t getSize() const override { return sizeof(PingMessage); }
+	};
+
+	class CameraFamily : public FamilyBaseOf<CameraFamily> {
+	public:
+		CameraComponent& camera;
+
+		using Type = FamilyType<CameraComponent>;
+
+	protected:
+		CameraFamily(CameraComponent& camera) : camera(camera) {}
+	};
+
+	class SenderSystem final : public System {
+	public:
+		Vector<EntityId> targets;
+		int frame = 0;
+
+		SenderSystem() : System({}, {}, { PingMessage::messageIndex }) {}
+
+	protected:
+		void updateBase(Time) override
+		{
+			++frame;
+			for (size_t i = 0; i < targets.size(); ++i) {
+				sendMessageGeneric(targets[i], PingMessage(frame * 100 + int(i)));
+			}
+		}
+	};
+
+	class ReceiverSystem final : public System {
+	public:
+		struct Received {
+			int value;
+			float zoom;
+			const Message* msg;
+
+			bool operator==(const Received& other) const { return value == other.value && zoom == other.zoom; }
+		};
+
+		FamilyBinding<CameraFamily> cameraFamily;
+		Vector<Received> received;
+
+		ReceiverSystem() : System({ &cameraFamily }, { PingMessage::messageIndex }) {}
+
+	protected:
+		void onMessagesReceived(int msgIndex, Message** msgs, size_t* idx, size_t n) override
+		{
+			EXPECT_EQ(msgIndex, PingMessage::messageIndex);
+			for (size_t i = 0; i < n; ++i) {
+				received.push_back(Received{ static_cast<PingMessage*>(msgs[i])->value, cameraFamily[idx[i]].camera.zoom, msgs[i] });
+			}
+		}
+	};
+
+	Vector<int> getValues(const ReceiverSystem& system)
+	{
+		Vector<int> result;
+		for (const auto& r: system.received) {
+			result.push_back(r.value);
+		}
+		return result;
+	}
+}
+
+TEST(HalleyEntityMessages, SendReceiveAndResetAcrossFrames)
+{
+	liveMessages = 0;
+	{
+		HalleyAPI api{};
+		Resources resources(std::unique_ptr<ResourceLocator>(), api, ResourceOptions());
+		World world(api, resources, {});
+
+		// One receiver runs before the sender, so it only sees each frame's messages on the next one
+		auto& early = static_cast<ReceiverSystem&>(world.addSystem(std::make_unique<ReceiverSystem>(), TimeLine::FixedUpdate));
+		auto& sender = static_cast<SenderSystem&>(world.addSystem(std::make_unique<SenderSystem>(), TimeLine::FixedUpdate));
+		auto& late = static_cast<ReceiverSystem&>(world.addSystem(std::make_unique<ReceiverSystem>(), TimeLine::FixedUpdate));
+		EXPECT_EQ(world.getMessageReceivers(PingMessage::messageIndex), Vector<System*>({ &early, &late }));
+
+		const auto a = world.createEntity().addComponent(CameraComponent(1, "")).getEntityId();
+		const auto b = world.createEntity().addComponent(CameraComponent(2, "")).getEntityId();
+		const auto notInFamily = world.createEntity().getEntityId();
+		sender.targets = { a, b, notInFamily };
+
+		// Frame 1: only the receiver after the sender gets them, and only for entities in its family
+		world.step(TimeLine::FixedUpdate, 0.1);
+		EXPECT_TRUE(early.received.empty());
+		EXPECT_EQ(late.received, Vector<ReceiverSystem::Received>({ { 100, 1, nullptr }, { 101, 2, nullptr } }));
+		EXPECT_EQ(liveMessages, 3);
+		const auto firstFrameSlot = late.received[0].msg;
+
+		// Frame 2: the early receiver gets frame 1's messages before the sender's arena is reset, and the reset reuses the same slots
+		world.step(TimeLine::FixedUpdate, 0.1);
+		EXPECT_EQ(getValues(early), Vector<int>({ 100, 101 }));
+		EXPECT_EQ(getValues(late), Vector<int>({ 100, 101, 200, 201 }));
+		EXPECT_EQ(late.received[2].msg, firstFrameSlot);
+		EXPECT_EQ(liveMessages, 3);
+
+		// Messages to destroyed entities aren't delivered (even if they were queued before), but are still owned by the arena
+		world.destroyEntity(b);
+		world.spawnPending();
+		early.received.clear();
+		late.received.clear();
+		world.step(TimeLine::FixedUpdate, 0.1);
+		EXPECT_EQ(getValues(early), Vector<int>({ 200 }));
+		EXPECT_EQ(getValues(late), Vector<int>({ 300 }));
+		EXPECT_EQ(liveMessages, 3);
+
+		// Removing the sender drops what the early receiver hasn't read yet
+		world.removeSystem(sender);
+		EXPECT_EQ(liveMessages, 0);
+		early.received.clear();
+		world.step(TimeLine::FixedUpdate, 0.1);
+		EXPECT_TRUE(early.received.empty());
+	}
+	EXPECT_EQ(liveMessages, 0);
+}
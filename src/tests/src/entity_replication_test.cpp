@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <deque>
+#include <thread>
+using namespace Halley;
+
+namespace {
+	using PacketQueue = std::deque<Bytes>;
+
+	class LoopbackConnection : public IConnection {
+	public:
+		LoopbackConnection(std::shared_ptr<PacketQueue> inbox, std::shared_ptr<PacketQueue> outbox)
+			: inbox(std::move(inbox))
+			, outbox(std::move(outbox))
+		{}
+
+		void close() override { status = ConnectionStatus::Closed; }
+		ConnectionStatus getStatus() const override { return status; }
+
+		void send(OutboundNetworkPacket packet) override
+		{
+			Bytes bytes(packet.getSize());
+			packet.copyTo(gsl::as_writable_bytes(gsl::span<Byte>(bytes)));
+			maxPacketSize = std::max(maxPacketSize, bytes.size());
+			++packetsSent;
+			outbox->push_back(std::move(bytes));
+		}
+
+		bool receive(InboundNetworkPacket& packet) override
+		{
+			if (inbox->empty()) {
+				return false;
+			}
+			packet = InboundNetworkPacket(gsl::as_bytes(gsl::span<const Byte>(inbox->front())));
+			inbox->pop_front();
+			return true;
+		}
+
+		size_t maxPacketSize = 0;
+		size_t packetsSent = 0;
+
+	private:
+		std::shared_ptr<PacketQueue> inbox;
+		std::shared_ptr<PacketQueue> outbox;
+		ConnectionStatus status = ConnectionStatus::Connected;
+	};
+
+	struct TestEntity {
+		Vector2f pos;
+		int hp = 0;
+		std::optional<int> shield;
+		std::vector<int> payload;
+
+		bool operator==(const TestEntity& other) const { return pos == other.pos && hp == other.hp && shield == other.shield && payload == other.payload; }
+	};
+
+	class TestSource : public IEntityReplicationSource {
+	public:
+		std::map<ReplicatedEntityId, TestEntity> entities;
+		float viewMin = 0;
+		float viewMax = 0;
+
+		bool isRelevant(const TestEntity& e) const
+		{
+			return e.pos.x >= viewMin && e.pos.x < viewMax;
+		}
+
+		void getRelevantEntities(int peerId, Vector<ReplicationInterest>& result) override
+		{
+			for (const auto& [id, e]: entities) {
+				if (isRelevant(e)) {
+					result.push_back(ReplicationInterest{ id, 1.0f });
+				}
+			}
+		}
+
+		void serializeEntity(ReplicatedEntityId id, ReplicatedEntityState& state) override
+		{
+			const auto& e = entities.at(id);
+			state.set(0, e.pos);
+			state.set(1, e.hp);
+			if (e.shield) {
+				state.set(2, *e.shield);
+			}
+			if (!e.payload.empty()) {
+				state.set(3, e.payload);
+			}
+		}
+	};
+
+	class TestSink : public IEntityReplicationSink {
+	public:
+		std::map<ReplicatedEntityId, TestEntity> entities;
+
+		void onEntityUpdated(ReplicatedEntityId id, const ReplicatedEntityState& state, uint32_t changedMask) override
+		{
+			auto& e = entities[id];
+			state.get(0, e.pos);
+			state.get(1, e.hp);
+			int shield;
+			e.shield = state.get(2, shield) ? std::optional<int>(shield) : std::nullopt;
+			if (!state.get(3, e.payload)) {
+				e.payload.clear();
+			}
+		}
+
+		void onEntityRemoved(ReplicatedEntityId id) override
+		{
+			entities.erase(id);
+		}
+	};
+}
+
+TEST(HalleyEntityReplication, ConvergesOverLossyConnection)
+{
+	auto toClient = std::make_shared<PacketQueue>();
+	auto toServer = std::make_shared<PacketQueue>();
+	auto serverLoopback = std::make_shared<LoopbackConnection>(toServer, toClient);
+	auto clientLoopback = std::make_shared<LoopbackConnection>(toClient, toServer);
+	auto serverConnection = std::make_shared<ReliableConnection>(std::make_shared<InstabilitySimulator>(serverLoopback, 0.005f, 0.004f, 0.2f, 0.1f));
+	auto clientConnection = std::make_shared<ReliableConnection>(std::make_shared<InstabilitySimulator>(clientLoopback, 0.005f, 0.004f, 0.2f, 0.1f));
+
+	TestSource source;
+	TestSink sink;
+	EntityReplicationServer server(source);
+	EntityReplicationClient client(clientConnection, sink);
+	server.addPeer(1, serverConnection);
+	constexpr size_t maxPacketSize = 512;
+	server.setMaxPacketSize(maxPacketSize);
+
+	Random rng(uint32_t(42));
+	for (ReplicatedEntityId id = 1; id <= 400; ++id) {
+		auto& e = source.entities[id];
+		e.pos = Vector2f(rng.getFloat(0.0f, 1000.0f), rng.getFloat(0.0f, 1000.0f));
+		e.hp = rng.getInt(1, 100);
+	}
+
+	for (int step = 0; step < 200; ++step) {
+		source.viewMin = float(step);
+		source.viewMax = float(step) + 500.0f;
+
+		for (int i = 0; i < 20; ++i) {
+			auto& e = source.entities[rng.getInt(ReplicatedEntityId(1), ReplicatedEntityId(400))];
+			e.pos += Vector2f(rng.getFloat(-5.0f, 5.0f), rng.getFloat(-5.0f, 5.0f));
+			e.hp = rng.getInt(1, 100);
+			if (rng.getInt(0, 3) == 0) {
+				e.shield = e.shield ? std::nullopt : std::optional<int>(rng.getInt(1, 10));
+			}
+		}
+
+		server.update();
+		client.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	std::map<ReplicatedEntityId, TestEntity> expected;
+	for (const auto& [id, e]: source.entities) {
+		if (source.isRelevant(e)) {
+			expected[id] = e;
+		}
+	}
+
+	// Nothing changes from here on, so the server should go quiet once everything is acked
+	bool converged = false;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!converged && std::chrono::steady_clock::now() < deadline) {
+		const auto sentBefore = serverLoopback->packetsSent;
+		server.update();
+		client.update();
+		converged = sink.entities == expected && serverLoopback->packetsSent == sentBefore && toClient->empty();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	EXPECT_TRUE(converged);
+	EXPECT_EQ(sink.entities.size(), expected.size());
+	EXPECT_TRUE(sink.entities == expected);
+	EXPECT_LE(serverLoopback->maxPacketSize, maxPacketSize + 16);
+	EXPECT_EQ(clientConnection->getStatus(), ConnectionStatus::Connected);
+}
+
+TEST(HalleyEntityReplication, SkipsEntitiesTooLargeForAPacket)
+{
+	auto toClient = std::make_shared<PacketQueue>();
+	auto toServer = std::make_shared<PacketQueue>();
+	auto serverLoopback = std::make_shared<LoopbackConnection>(toServer, toClient);
+	auto clientLoopback = std::make_shared<LoopbackConnection>(toClient, toServer);
+	auto serverConnection = std::make_shared<ReliableConnection>(serverLoopback);
+	auto clientConnection = std::make_shared<ReliableConnection>(clientLoopback);
+
+	TestSource source;
+	TestSink sink;
+	EntityReplicationServer server(source);
+	EntityReplicationClient client(clientConnection, sink);
+	server.addPeer(1, serverConnection);
+	server.setMaxPacketSize(256);
+	source.viewMax = 1000.0f;
+
+	source.entities[1].hp = 1;
+	source.entities[2].hp = 2;
+	source.entities[2].payload.resize(1000, 7);
+	source.entities[3].hp = 3;
+
+	for (int i = 0; i < 10; ++i) {
+		EXPECT_NO_THROW(server.update());
+		client.update();
+	}
+	EXPECT_EQ(sink.entities.size(), 2);
+	EXPECT_EQ(sink.entities.count(2), 0);
+	EXPECT_TRUE(sink.entities[1] == source.entities[1]);
+	EXPECT_TRUE(sink.entities[3] == source.entities[3]);
+
+	// Once it fits, it gets through
+	source.entities[2].payload.resize(10);
+	server.update();
+	client.update();
+	EXPECT_TRUE(sink.entities[2] == source.entities[2]);
+	EXPECT_LE(serverLoopback->maxPacketSize, size_t(256 + 16));
+
+	// Everything is acked and unchanged, so nothing else should go out
+	server.update();
+	client.update();
+	const auto sentBefore = serverLoopback->packetsSent;
+	server.update();
+	EXPECT_EQ(serverLoopback->packetsSent, sentBefore);
+}
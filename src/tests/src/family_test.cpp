@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "components/audio_listener_component.h"
+#include "components/camera_component.h"
+using namespace Halley;
+
+namespace {
+	// Laid out the same way the codegen writes families for systems
+	class CameraFamily : public FamilyBaseOf<CameraFamily> {
+	public:
+		CameraComponent& camera;
+
+		using Type = FamilyType<CameraComponent>;
+
+	protected:
+		CameraFamily(CameraComponent& camera) : camera(camera) {}
+	};
+
+	class ListenerFamily : public FamilyBaseOf<ListenerFamily> {
+	public:
+		CameraComponent& camera;
+		AudioListenerComponent& audioListener;
+
+		using Type = FamilyType<CameraComponent, AudioListenerComponent>;
+
+	protected:
+		ListenerFamily(CameraComponent& camera, AudioListenerComponent& audioListener) : camera(camera), audioListener(audioListener) {}
+	};
+
+	template <typename T, typename F>
+	Vector<float> collect(const Family& family, F f)
+	{
+		Vector<float> result;
+		for (size_t i = 0; i < family.count(); ++i) {
+			result.push_back(f(*static_cast<const T*>(family.getElement(i))));
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	Vector<float> getZooms(const Family& family)
+	{
+		return collect<CameraFamily>(family, [] (const CameraFamily& e) { return e.camera.zoom; });
+	}
+
+	void testAddRemoveIterate(bool chunked)
+	{
+		HalleyAPI api{};
+		Resources resources(std::unique_ptr<ResourceLocator>(), api, ResourceOptions());
+		World world(api, resources, {});
+		world.setChunkedComponentStorage(chunked);
+
+		auto& cameras = world.getFamily<CameraFamily>();
+		auto& listeners = world.getFamily<ListenerFamily>();
+
+		Vector<EntityId> ids;
+		for (int i = 0; i < 10; ++i) {
+			ids.push_back(world.createEntity().addComponent(CameraComponent(float(i), "")).getEntityId());
+		}
+		world.spawnPending();
+		EXPECT_EQ(getZooms(cameras), Vector<float>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+		EXPECT_EQ(listeners.count(), 0);
+
+		// Removed entities leave the others where they were, so the family still sees every survivor
+		for (int i: { 0, 4, 9 }) {
+			world.destroyEntity(ids[i]);
+		}
+		world.spawnPending();
+		EXPECT_EQ(getZooms(cameras), Vector<float>({ 1, 2, 3, 5, 6, 7, 8 }));
+
+		// Changing an entity's component set moves its components, but they keep their values
+		for (int i: { 2, 5 }) {
+			world.getEntity(ids[i]).addComponent(AudioListenerComponent(float(i * 100)));
+		}
+		world.spawnPending();
+		EXPECT_EQ(getZooms(cameras), Vector<float>({ 1, 2, 3, 5, 6, 7, 8 }));
+		EXPECT_EQ(collect<ListenerFamily>(listeners, [] (const ListenerFamily& e) { return e.camera.zoom + e.audioListener.referenceDistance; }), Vector<float>({ 202, 505 }));
+
+		// Writes through the family land on the entity
+		for (size_t i = 0; i < cameras.count(); ++i) {
+			static_cast<CameraFamily*>(cameras.getElement(i))->camera.zoom += 10;
+		}
+		EXPECT_EQ(world.getEntity(ids[5]).getComponent<CameraComponent>().zoom, 15);
+
+		world.getEntity(ids[2]).removeComponent<AudioListenerComponent>();
+		for (int i = 0; i < 2; ++i) {
+			world.createEntity().addComponent(CameraComponent(float(100 + i), ""));
+		}
+		world.spawnPending();
+		EXPECT_EQ(getZooms(cameras), Vector<float>({ 11, 12, 13, 15, 16, 17, 18, 100, 101 }));
+		EXPECT_EQ(collect<ListenerFamily>(listeners, [] (const ListenerFamily& e) { return e.camera.zoom; }), Vector<float>({ 15 }));
+
+		if (chunked) {
+			const auto* storage = world.getArchetypeStorage();
+			ASSERT_NE(storage, nullptr);
+			EXPECT_EQ(storage->getArchetypeCount(), 2);
+			EXPECT_EQ(storage->getEntityCount(), 9);
+		}
+	}
+}
+
+TEST(HalleyFamily, AddRemoveIterate)
+{
+	testAddRemoveIterate(false);
+}
+
+TEST(HalleyFamily, AddRemoveIterateChunked)
+{
+	testAddRemoveIterate(true);
+}
@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <thread>
+using namespace Halley;
+
+namespace {
+	Polygon makeBox(Vector2f a, Vector2f b)
+	{
+		return Polygon(VertexList{{ Vector2f(b.x, a.y), b, Vector2f(a.x, b.y), a }});
+	}
+
+	NavmeshGenerator::Params makeNavmeshParams(gsl::span<const Polygon> obstacles, gsl::span<const Polygon> regions)
+	{
+		NavmeshGenerator::Params params{ NavmeshBounds(Vector2f(), Vector2f(400, 0), Vector2f(0, 400), 4, 4, Vector2f(1, 1)) };
+		params.obstacles = obstacles;
+		params.regions = regions;
+		params.agentSize = 4.0f;
+		return params;
+	}
+
+	// Two regions, with a wall down the middle of the map that only leaves gaps at the top and bottom
+	const auto wallObstacles = std::vector<Polygon>{ makeBox(Vector2f(180, 60), Vector2f(220, 340)) };
+	const auto wallRegions = std::vector<Polygon>{ makeBox(Vector2f(0, 0), Vector2f(200, 400)) };
+
+	NavmeshSet makeNavmeshSet()
+	{
+		auto result = NavmeshGenerator::generate(makeNavmeshParams(wallObstacles, wallRegions));
+		result.linkNavmeshes();
+		return result;
+	}
+
+	// What the region search minimises: straight to the first portal, the precomputed costs across each region, then straight to the destination
+	float getRegionPathCost(const NavmeshSet& navmeshSet, const NavigationPath& path)
+	{
+		const auto navmeshes = navmeshSet.getNavmeshes();
+		auto getPortalPos = [&] (uint16_t region, uint16_t edge)
+		{
+			// Both directions of a portal use the position on the navmesh that was linked first
+			const auto [dstRegion, dstEdge] = navmeshSet.getPortalDestination(region, edge);
+			return region < dstRegion ? navmeshes[region].getPortals()[edge].pos : navmeshes[dstRegion].getPortals()[dstEdge].pos;
+		};
+
+		const auto& regions = path.regions;
+		float cost = (getPortalPos(regions[0].regionNodeId, regions[0].exitEdgeId) - path.query.from).length();
+		for (size_t i = 1; i + 1 < regions.size(); ++i) {
+			const auto entryEdge = navmeshSet.getPortalDestination(regions[i - 1].regionNodeId, regions[i - 1].exitEdgeId).second;
+			cost += navmeshes[regions[i].regionNodeId].getPortalCost(entryEdge, regions[i].exitEdgeId);
+		}
+		const auto& last = regions[regions.size() - 2];
+		cost += (getPortalPos(last.regionNodeId, last.exitEdgeId) - path.query.to).length();
+		return cost;
+	}
+}
+
+TEST(HalleyNavigation, PathfindingServiceMatchesDirectQueries)
+{
+	const auto navmeshSet = makeNavmeshSet();
+	ASSERT_GT(navmeshSet.getNavmeshes().size(), 1);
+
+	Random rng(uint32_t(7));
+	std::vector<NavigationQuery> queries;
+	for (int i = 0; i < 300; ++i) {
+		const auto from = Vector2f(rng.getFloat(5.0f, 395.0f), rng.getFloat(5.0f, 395.0f));
+		const auto to = Vector2f(rng.getFloat(5.0f, 395.0f), rng.getFloat(5.0f, 395.0f));
+		queries.emplace_back(from, 0, to, 0, NavigationQuery::PostProcessingType::Simple);
+	}
+
+	ExecutionQueue queue;
+	std::vector<std::unique_ptr<Executor>> executors;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 3; ++i) {
+		executors.push_back(std::make_unique<Executor>(queue));
+		threads.emplace_back([executor = executors.back().get()] () { executor->runForever(); });
+	}
+
+	PathfindingService service(navmeshSet, queue);
+	service.setQueriesPerJob(16);
+
+	for (int frame = 0; frame < 3; ++frame) {
+		service.newFrame();
+		const auto results = service.run(queries);
+		ASSERT_EQ(results.size(), queries.size());
+
+		size_t nCrossRegion = 0;
+		for (size_t i = 0; i < queries.size(); ++i) {
+			const auto expected = navmeshSet.pathfind(queries[i]);
+			ASSERT_EQ(results[i].has_value(), expected.has_value());
+			if (!expected) {
+				continue;
+			}
+
+			if (expected->regions.empty()) {
+				EXPECT_EQ(results[i]->path, expected->path);
+			} else {
+				// Region paths are shared by every query between the same two regions, so only the endpoints have to match
+				++nCrossRegion;
+				ASSERT_FALSE(results[i]->regions.empty());
+				EXPECT_EQ(results[i]->regions.front().regionNodeId, expected->regions.front().regionNodeId);
+				EXPECT_EQ(results[i]->regions.back().regionNodeId, expected->regions.back().regionNodeId);
+			}
+		}
+		EXPECT_GT(nCrossRegion, 0);
+	}
+
+	auto single = service.submit(queries[0]);
+	while (!single.isReady()) {
+		std::this_thread::yield();
+	}
+	EXPECT_EQ(single.get().has_value(), navmeshSet.pathfind(queries[0]).has_value());
+
+	for (auto& e: executors) {
+		e->stop();
+	}
+	for (auto& t: threads) {
+		t.join();
+	}
+}
+
+TEST(HalleyNavigation, LandmarksDontChangeReachability)
+{
+	auto plain = makeNavmeshSet();
+	auto withLandmarks = plain;
+	withLandmarks.linkNavmeshes(4);
+
+	constexpr float weight = 1.5f;
+	auto weighted = withLandmarks;
+	weighted.setHeuristicWeight(weight);
+
+	Random rng(uint32_t(11));
+	size_t nCrossRegion = 0;
+	for (int i = 0; i < 200; ++i) {
+		const auto from = Vector2f(rng.getFloat(5.0f, 395.0f), rng.getFloat(5.0f, 395.0f));
+		const auto to = Vector2f(rng.getFloat(5.0f, 395.0f), rng.getFloat(5.0f, 395.0f));
+		const auto query = NavigationQuery(from, 0, to, 0, NavigationQuery::PostProcessingType::None);
+
+		const auto a = plain.pathfind(query);
+		const auto b = withLandmarks.pathfind(query);
+		const auto c = weighted.pathfind(query);
+		ASSERT_EQ(a.has_value(), b.has_value());
+		ASSERT_EQ(a.has_value(), c.has_value());
+		if (a && !a->regions.empty()) {
+			++nCrossRegion;
+			ASSERT_FALSE(b->regions.empty());
+			ASSERT_FALSE(c->regions.empty());
+			EXPECT_EQ(a->regions.front().regionNodeId, b->regions.front().regionNodeId);
+			EXPECT_EQ(a->regions.back().regionNodeId, b->regions.back().regionNodeId);
+
+			// Every leg must leave through a portal that's actually linked to the next region
+			for (size_t j = 0; j + 1 < b->regions.size(); ++j) {
+				const auto dst = withLandmarks.getPortalDestination(b->regions[j].regionNodeId, b->regions[j].exitEdgeId);
+				EXPECT_EQ(dst.first, b->regions[j + 1].regionNodeId);
+			}
+
+			// Landmarks keep the heuristic admissible, so the path is still the cheapest one; weighting it only allows going over by that factor
+			const float bestCost = getRegionPathCost(plain, *a);
+			EXPECT_NEAR(getRegionPathCost(withLandmarks, *b), bestCost, bestCost * 0.001f);
+			EXPECT_LE(getRegionPathCost(weighted, *c), bestCost * weight + 0.01f);
+		}
+	}
+	EXPECT_GT(nCrossRegion, 0);
+}
+
+TEST(HalleyNavigation, DynamicNavmeshMatchesFullGeneration)
+{
+	std::vector<Polygon> obstacles = { makeBox(Vector2f(180, 60), Vector2f(220, 340)) };
+	NavmeshGenerator::Params params{ NavmeshBounds(Vector2f(), Vector2f(400, 0), Vector2f(0, 400), 4, 4, Vector2f(1, 1)) };
+	params.obstacles = obstacles;
+	params.agentSize = 4.0f;
+
+	DynamicNavmesh dynamic(params);
+	const auto query = NavigationQuery(Vector2f(100, 200), 0, Vector2f(300, 200), 0, NavigationQuery::PostProcessingType::None);
+	ASSERT_TRUE(dynamic.getNavmeshSet().pathfind(query).has_value());
+
+	// Close the gaps at the top and bottom, which cuts the map in two
+	const auto top = dynamic.addObstacle(makeBox(Vector2f(180, 0), Vector2f(220, 70)));
+	dynamic.addObstacle(makeBox(Vector2f(180, 330), Vector2f(220, 400)));
+	EXPECT_TRUE(dynamic.isDirty());
+
+	ExecutionQueue queue;
+	dynamic.rebuildAsync(queue);
+	EXPECT_TRUE(dynamic.isRebuilding());
+	EXPECT_FALSE(dynamic.update());
+	while (queue.tryRunOne()) {}
+	EXPECT_TRUE(dynamic.update());
+	EXPECT_FALSE(dynamic.isDirty());
+	EXPECT_FALSE(dynamic.getNavmeshSet().pathfind(query).has_value());
+
+	// Same result as generating it all from scratch
+	obstacles.push_back(makeBox(Vector2f(180, 0), Vector2f(220, 70)));
+	obstacles.push_back(makeBox(Vector2f(180, 330), Vector2f(220, 400)));
+	params.obstacles = obstacles;
+	const auto full = NavmeshGenerator::generate(params);
+	ASSERT_EQ(full.getNavmeshes().size(), dynamic.getNavmeshSet().getNavmeshes().size());
+	for (size_t i = 0; i < full.getNavmeshes().size(); ++i) {
+		EXPECT_EQ(full.getNavmeshes()[i].getNumNodes(), dynamic.getNavmeshSet().getNavmeshes()[i].getNumNodes());
+	}
+
+	dynamic.removeObstacle(top);
+	dynamic.rebuild();
+	EXPECT_TRUE(dynamic.getNavmeshSet().pathfind(query).has_value());
+}
+
+TEST(HalleyNavigation, DynamicNavmeshKeepsLandmarks)
+{
+	// There are few portals on this map, so fewer landmarks than asked for are picked, but linking without them would leave none
+	DynamicNavmesh dynamic(makeNavmeshParams(wallObstacles, wallRegions), 4);
+	EXPECT_GT(dynamic.getNavmeshSet().getNumLandmarks(), 0);
+
+	// Rebuilding, asynchronously or not, links the new set with them too
+	dynamic.addObstacle(makeBox(Vector2f(40, 40), Vector2f(60, 60)));
+	ExecutionQueue queue;
+	dynamic.rebuildAsync(queue);
+	while (queue.tryRunOne()) {}
+	EXPECT_TRUE(dynamic.update());
+	EXPECT_GT(dynamic.getNavmeshSet().getNumLandmarks(), 0);
+
+	dynamic.addObstacle(makeBox(Vector2f(340, 340), Vector2f(360, 360)));
+	dynamic.rebuild();
+	EXPECT_GT(dynamic.getNavmeshSet().getNumLandmarks(), 0);
+}
+
+TEST(HalleyNavigation, FlowFieldLeadsAgentsToGoal)
+{
+	const auto navmeshSet = makeNavmeshSet();
+	NavigationFlowFieldCache cache(navmeshSet);
+
+	// On the other side of the wall, and in the other region
+	const auto goal = Vector2f(350, 200);
+	const auto field = cache.get(goal, 0);
+	ASSERT_TRUE(field && field->isValid());
+	EXPECT_EQ(cache.get(goal, 0), field);
+
+	Random rng(uint32_t(3));
+	int nAgents = 0;
+	while (nAgents < 50) {
+		auto pos = Vector2f(rng.getFloat(5.0f, 195.0f), rng.getFloat(5.0f, 395.0f));
+		if (!navmeshSet.getNavMeshAt(pos, 0)) {
+			continue;
+		}
+		++nAgents;
+
+		NavigationPathFollower follower;
+		follower.setFlowField(field, goal);
+		for (int step = 0; step < 1000 && !follower.isDone(); ++step) {
+			follower.update(pos, 0, navmeshSet, 2.0f);
+			const auto delta = follower.getNextPosition() - pos;
+			ASSERT_TRUE(navmeshSet.getNavMeshAt(pos, 0));
+			pos += delta.length() > 2.0f ? delta.normalized() * 2.0f : delta;
+		}
+		EXPECT_TRUE(follower.isDone());
+		EXPECT_LT((pos - goal).length(), 2.0f);
+	}
+
+	for (int i = 0; i < 100; ++i) {
+		cache.newFrame();
+	}
+	EXPECT_NE(cache.get(goal, 0), field);
+}
+
+TEST(HalleyNavigation, FlowFieldRespectsWeights)
+{
+	const auto plain = makeNavmeshSet();
+
+	// The same map, where every node costs three times as much to cross
+	auto params = makeNavmeshParams(wallObstacles, wallRegions);
+	params.getPolygonWeightCallback = [] (int subWorld, const Polygon& polygon) { return 3.0f; };
+	auto weighted = NavmeshGenerator::generate(params);
+	weighted.linkNavmeshes();
+
+	const auto goal = Vector2f(350, 200);
+	const NavigationFlowField plainField(plain, goal, 0);
+	const NavigationFlowField weightedField(weighted, goal, 0);
+	ASSERT_TRUE(plainField.isValid());
+	ASSERT_TRUE(weightedField.isValid());
+
+	// Including from the other region, so the portal crossings have to be weighted too
+	Random rng(uint32_t(5));
+	size_t nOtherRegion = 0;
+	for (int i = 0; i < 200; ++i) {
+		const auto pos = Vector2f(rng.getFloat(5.0f, 395.0f), rng.getFloat(5.0f, 395.0f));
+		const auto a = plainField.sample(pos, 0);
+		const auto b = weightedField.sample(pos, 0);
+		ASSERT_EQ(a.has_value(), b.has_value());
+		if (a) {
+			EXPECT_NEAR(b->distance, a->distance * 3.0f, a->distance * 0.001f + 0.01f);
+			if (pos.x < 200) {
+				++nOtherRegion;
+			}
+		}
+	}
+	EXPECT_GT(nOtherRegion, 0);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	constexpr float dt = 0.125f;
+
+	// Plain per-particle version of what the SIMD kernels compute, stepping one particle at a time
+	struct ReferenceParticle {
+		Vector2f pos;
+		Vector2f vel;
+		float time = 0;
+		float scale = 1;
+		float alpha = 1;
+	};
+
+	struct ReferenceEmitter {
+		ConfigNode config;
+		Vector<ReferenceParticle> particles;
+
+		void step(size_t toSpawn)
+		{
+			const float speed = config["speed"].asFloat();
+			const float ttl = config["ttl"].asFloat();
+			const float stopTime = config["stopTime"].asFloat();
+			const float startScale = config["startScale"].asFloat();
+			const float endScale = config["endScale"].asFloat();
+			const float fadeIn = config["fadeInTime"].asFloat();
+			const float fadeOut = config["fadeOutTime"].asFloat();
+			const auto accel = config["acceleration"].asVector2f();
+			const float damping = std::exp(-config["speedDamp"].asFloat() * dt);
+			const float stopDamping = damping * std::exp(-10.0f * dt);
+
+			for (size_t i = 0; i < toSpawn; ++i) {
+				ReferenceParticle p;
+				p.vel = Vector2f(speed, Angle1f::fromDegrees(config["angle"].asFloat()));
+				particles.push_back(p);
+			}
+
+			for (auto& p: particles) {
+				p.time += dt;
+				p.vel = (p.vel + accel * dt) * (p.time + stopTime < ttl ? damping : stopDamping);
+				p.pos += p.vel * dt;
+				p.scale = startScale + (endScale - startScale) * (p.time / ttl);
+				p.alpha = std::clamp(std::min(p.time / fadeIn, (ttl - p.time) / fadeOut), 0.0f, 1.0f);
+			}
+		}
+	};
+
+	void testAgainstReference(size_t perFrame, int frames)
+	{
+		// No scatter anywhere, so the random number generator doesn't affect the result
+		ConfigNode config = ConfigNode::MapType();
+		config["spawnRate"] = float(perFrame) / dt;
+		config["ttl"] = 100.0f;
+		config["speed"] = 100.0f;
+		config["speedDamp"] = 0.5f;
+		config["acceleration"] = Vector2f(10, 50);
+		config["angle"] = 30.0f;
+		config["startScale"] = 1.0f;
+		config["endScale"] = 3.0f;
+		config["fadeInTime"] = 0.5f;
+		config["fadeOutTime"] = 99.9f;
+		config["stopTime"] = 99.5f; // Particles older than half a second switch to stop damping
+
+		HalleyAPI api{};
+		Resources resources(std::unique_ptr<ResourceLocator>(), api, ResourceOptions());
+		Particles particles(config, resources);
+		Sprite base;
+		base.setMaterial(std::make_shared<Material>(std::make_shared<MaterialDefinition>()), false);
+		particles.setSprites({ base });
+
+		ReferenceEmitter reference{ ConfigNode(config), {} };
+		for (int frame = 0; frame < frames; ++frame) {
+			particles.update(dt);
+			reference.step(perFrame);
+
+			const auto sprites = particles.getSprites();
+			ASSERT_EQ(size_t(sprites.size()), reference.particles.size());
+			for (size_t i = 0; i < reference.particles.size(); ++i) {
+				const auto& expected = reference.particles[i];
+				const auto& sprite = sprites[i];
+				EXPECT_NEAR(sprite.getPosition().x, expected.pos.x, 0.001f) << "particle " << i << " frame " << frame;
+				EXPECT_NEAR(sprite.getPosition().y, expected.pos.y, 0.001f) << "particle " << i << " frame " << frame;
+				EXPECT_NEAR(sprite.getScale().x, expected.scale, 0.0001f) << "particle " << i << " frame " << frame;
+				EXPECT_NEAR(sprite.getColour().a, expected.alpha, 0.0001f) << "particle " << i << " frame " << frame;
+			}
+		}
+	}
+}
+
+// One particle spawned per frame, so every lane of every step holds a different particle
+TEST(HalleyParticles, MatchesScalarReference)
+{
+	testAgainstReference(1, 13);
+}
+
+// Counts that end partway through a 4 or 8 wide step, and more than one cache block
+TEST(HalleyParticles, MatchesScalarReferenceWithPartialSteps)
+{
+	testAgainstReference(3, 13);
+	testAgainstReference(37, 9);
+}
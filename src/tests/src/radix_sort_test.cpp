@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/utils/radix_sort.h>
+using namespace Halley;
+
+TEST(HalleyRadixSort, MatchesStableSort)
+{
+	Random rng(uint32_t(1234));
+	Vector<uint64_t> keys;
+	for (int i = 0; i < 5000; ++i) {
+		// Few distinct values, so stability matters
+		const auto layer = rng.getInt(int32_t(-3), int32_t(3));
+		const auto y = float(rng.getInt(int32_t(-50), int32_t(50))) * 0.5f;
+		keys.push_back((uint64_t(toRadixKey(int32_t(layer))) << 32) | toRadixKey(y));
+	}
+
+	Vector<uint32_t> order;
+	Vector<uint32_t> scratch;
+	radixSortIndices<uint64_t>(keys, order, scratch);
+
+	Vector<uint32_t> expected(keys.size());
+	std::iota(expected.begin(), expected.end(), 0);
+	std::stable_sort(expected.begin(), expected.end(), [&] (uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+	EXPECT_EQ(order, expected);
+}
+
+TEST(HalleyRadixSort, KeyOrder)
+{
+	const float values[] = { -1e10f, -2.5f, -1.0f, -0.0f, 0.0f, 1e-20f, 1.0f, 3.5f, 1e10f };
+	for (size_t i = 1; i < std::size(values); ++i) {
+		EXPECT_LE(toRadixKey(values[i - 1]), toRadixKey(values[i]));
+	}
+	EXPECT_EQ(toRadixKey(-0.0f), toRadixKey(0.0f));
+
+	EXPECT_LT(toRadixKey(int32_t(-5)), toRadixKey(int32_t(-1)));
+	EXPECT_LT(toRadixKey(int32_t(-1)), toRadixKey(int32_t(0)));
+	EXPECT_LT(toRadixKey(int32_t(0)), toRadixKey(int32_t(7)));
+}
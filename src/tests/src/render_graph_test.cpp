@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <thread>
+using namespace Halley;
+
+namespace {
+	std::thread makeThread(String, std::function<void()> f)
+	{
+		return std::thread(std::move(f));
+	}
+
+	// Resources only needs a locator to fall back on, every asset used here is set directly
+	class NullSystemAPI : public SystemAPI {
+	public:
+		Path getAssetsPath(const Path& gamePath) const override { return gamePath; }
+		Path getUnpackedAssetsPath(const Path& gamePath) const override { return gamePath; }
+		std::unique_ptr<ResourceDataReader> getDataReader(String path, int64_t start, int64_t end) override { return {}; }
+		std::unique_ptr<GLContext> createGLContext() override { return {}; }
+		std::shared_ptr<Window> createWindow(const WindowDefinition& window) override { return {}; }
+		void destroyWindow(std::shared_ptr<Window> window) override {}
+		Vector2i getScreenSize(int n) const override { return {}; }
+		Rect4i getDisplayRect(int screen) const override { return {}; }
+		void showCursor(bool show) override {}
+		std::shared_ptr<ISaveData> getStorageContainer(SaveDataType type, const String& containerName) override { return {}; }
+
+	private:
+		bool generateEvents(VideoAPI* video, InputAPI* input) override { return false; }
+	};
+
+	// Everything that reaches the backend, in order
+	using Log = Vector<String>;
+
+	class LoggingTexture : public Texture {
+	public:
+		LoggingTexture(Vector2i size, Log& log) : Texture(size), log(log) {}
+
+	protected:
+		void doLoad(TextureDescriptor& descriptor) override { doneLoading(); }
+		void doCopyToImage(Painter& painter, Image& image) const override { log.push_back("copy to image"); }
+
+	private:
+		Log& log;
+	};
+
+	class NullConstantBuffer : public MaterialConstantBuffer {
+	public:
+		void update(gsl::span<const gsl::byte> data) override {}
+	};
+
+	// Same as the dummy video plugin, but its textures log what's done with them
+	class LoggingVideoAPI : public VideoAPI {
+	public:
+		Log log;
+
+		void startRender() override {}
+		void finishRender() override {}
+		void setWindow(WindowDefinition&& windowDescriptor) override {}
+		Window& getWindow() const override { throw Exception("No window", HalleyExceptions::VideoPlugin); }
+		bool hasWindow() const override { return false; }
+		std::unique_ptr<Texture> createTexture(Vector2i size) override { return std::make_unique<LoggingTexture>(size, log); }
+		std::unique_ptr<Shader> createShader(const ShaderDefinition& definition) override { return {}; }
+		std::unique_ptr<TextureRenderTarget> createTextureRenderTarget() override { return std::make_unique<TextureRenderTarget>(); }
+		std::unique_ptr<ScreenRenderTarget> createScreenRenderTarget() override { return {}; }
+		std::unique_ptr<MaterialConstantBuffer> createConstantBuffer() override { return std::make_unique<NullConstantBuffer>(); }
+		String getShaderLanguage() override { return "glsl"; }
+	};
+
+	class LoggingPainter : public Painter {
+	public:
+		LoggingPainter(LoggingVideoAPI& video, Resources& resources)
+			: Painter(video, resources)
+			, log(video.log)
+		{}
+
+		void clear(std::optional<Colour> colour, std::optional<float> depth, std::optional<uint8_t> stencil) override
+		{
+			// Nodes clear without a colour before painting, only the paint methods themselves pass one
+			if (colour) {
+				log.push_back("paint " + toString(int(colour->r * 10 + 0.5f)));
+			}
+		}
+
+		void setMaterialPass(const Material& material, int pass) override {}
+		void setMaterialData(const Material& material) override {}
+
+	protected:
+		void doStartRender() override {}
+		void doEndRender() override {}
+		void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, IndexType* indices, bool standardQuadsOnly) override
+		{
+			if (material.getName() == "Halley/Blit") {
+				log.push_back("blit");
+			}
+		}
+
+		void drawTriangles(size_t numIndices) override {}
+		void setViewPort(Rect4i rect) override {}
+		void setClip(Rect4i clip, bool enable) override {}
+		void onUpdateProjection(Material& material, bool hashChanged) override {}
+
+	private:
+		Log& log;
+	};
+
+	std::shared_ptr<MaterialDefinition> makeMaterialDefinition(const String& name, ConfigNode root, int passes)
+	{
+		root["name"] = name;
+		auto definition = std::make_shared<MaterialDefinition>();
+		definition->load(root);
+		for (int i = 0; i < passes; ++i) {
+			definition->addPass(MaterialPass());
+		}
+		return definition;
+	}
+
+	void addPainterMaterials(Resources& resources)
+	{
+		resources.init<MaterialDefinition>();
+		auto& materials = resources.of<MaterialDefinition>();
+
+		ConfigNode uniform = ConfigNode::MapType();
+		uniform["u_mvp"] = "mat4";
+		ConfigNode viewPort = ConfigNode::MapType();
+		viewPort["u_viewPortSize"] = "vec2";
+		ConfigNode block = ConfigNode::MapType();
+		block["HalleyBlock"] = ConfigNode::SequenceType{ std::move(uniform), std::move(viewPort) };
+		ConfigNode base = ConfigNode::MapType();
+		base["uniforms"] = ConfigNode::SequenceType{ std::move(block) };
+		materials.setResource(0, "Halley/MaterialBase", makeMaterialDefinition("Halley/MaterialBase", std::move(base), 0));
+
+		// Blits need a texture slot, but no passes, as those would need a real shader to look the slot up in
+		auto attrib = [] (const char* name, const char* special) {
+			ConfigNode node = ConfigNode::MapType();
+			node["name"] = name;
+			node["type"] = "vec4";
+			node["semantic"] = "TEXCOORD";
+			node["special"] = special;
+			return node;
+		};
+		ConfigNode texture = ConfigNode::MapType();
+		texture["tex0"] = "sampler2D";
+		ConfigNode blit = ConfigNode::MapType();
+		blit["attributes"] = ConfigNode::SequenceType{ attrib("a_vertPos", "vertPos"), attrib("a_texCoord0", "") };
+		blit["textures"] = ConfigNode::SequenceType{ std::move(texture) };
+		materials.setResource(0, "Halley/Blit", makeMaterialDefinition("Halley/Blit", std::move(blit), 0));
+
+		for (const char* name: { "Halley/SolidLine", "Halley/SolidPolygon" }) {
+			materials.setResource(0, name, makeMaterialDefinition(name, ConfigNode::MapType(), 0));
+		}
+	}
+
+	ConfigNode makeNode(const char* id, const char* method, const char* paintId = nullptr)
+	{
+		ConfigNode node = ConfigNode::MapType();
+		node["id"] = id;
+		node["method"] = method;
+		ConfigNode pars = ConfigNode::MapType();
+		if (paintId) {
+			pars["paintId"] = paintId;
+			pars["cameraId"] = "camera";
+		}
+		node["methodParameters"] = std::move(pars);
+		return node;
+	}
+
+	ConfigNode makeConnection(const char* from, const char* to, int toPin = 0)
+	{
+		ConfigNode fromNode = ConfigNode::MapType();
+		fromNode["node"] = from;
+		fromNode["pin"] = 0;
+		ConfigNode toNode = ConfigNode::MapType();
+		toNode["node"] = to;
+		toNode["pin"] = toPin;
+		ConfigNode connection = ConfigNode::MapType();
+		connection["from"] = std::move(fromNode);
+		connection["to"] = std::move(toNode);
+		return connection;
+	}
+
+	// Waves: [a, b], then [c, d, imageA, imageB], then [output, imageD]
+	// a has several outputs and b/d feed image outputs, so they get their own targets; c doesn't, so it blits a's colour before painting
+	std::shared_ptr<RenderGraphDefinition> makeGraphDefinition()
+	{
+		ConfigNode config = ConfigNode::MapType();
+		config["nodes"] = ConfigNode::SequenceType{
+			makeNode("a", "paint", "a"), makeNode("b", "paint", "b"), makeNode("c", "paint", "c"), makeNode("d", "paint", "d"),
+			makeNode("output", "output"), makeNode("imageA", "imageOutput"), makeNode("imageB", "imageOutput"), makeNode("imageD", "imageOutput")
+		};
+		config["connections"] = ConfigNode::SequenceType{
+			makeConnection("a", "c"), makeConnection("a", "d"), makeConnection("a", "imageA"), makeConnection("b", "imageB"),
+			makeConnection("c", "output"), makeConnection("d", "imageD")
+		};
+		return std::make_shared<RenderGraphDefinition>(config);
+	}
+
+	Log renderGraph(bool parallel, int& recordedPaints)
+	{
+		NullSystemAPI system;
+		LoggingVideoAPI video;
+		HalleyAPI api{};
+		api.system = &system;
+		api.video = &video;
+		Resources resources(std::make_unique<ResourceLocator>(system), api, ResourceOptions());
+		addPainterMaterials(resources);
+		LoggingPainter painter(video, resources);
+
+		RenderGraph graph(makeGraphDefinition());
+		graph.setParallelRecording(parallel);
+		graph.setCamera("camera", Camera(Vector2f(100, 100)));
+
+		std::atomic<int> recorded { 0 };
+		int paintIdx = 0;
+		for (const char* id: { "a", "b", "c", "d" }) {
+			const float colour = float(++paintIdx) / 10.0f;
+			graph.setPaintMethod(id, [colour, &recorded] (Painter& p)
+			{
+				if (dynamic_cast<RecordingPainter*>(&p)) {
+					++recorded;
+				}
+				p.clear(Colour4f(colour, 0, 0, 1));
+			});
+		}
+		for (const char* id: { "imageA", "imageB", "imageD" }) {
+			graph.setImageOutputCallback(id, [&video, id] (Image&) { video.log.push_back(String("notify ") + id); });
+		}
+
+		ScreenRenderTarget screen(Rect4i(0, 0, 200, 200));
+		const auto camera = Camera(Vector2f(100, 100));
+		graph.render(RenderContext(painter, camera, screen), video);
+
+		recordedPaints = recorded;
+		return video.log;
+	}
+}
+
+TEST(HalleyRenderGraph, SequentialRenderOrder)
+{
+	Executors executors;
+	Executors::setInstance(executors);
+
+	int recorded = 0;
+	const auto log = renderGraph(false, recorded);
+
+	EXPECT_EQ(recorded, 0);
+	EXPECT_EQ(log, Log({
+		"paint 1", "paint 2",
+		"blit", "paint 3", "paint 4", "copy to image", "notify imageA", "copy to image", "notify imageB",
+		"copy to image", "notify imageD"
+	}));
+}
+
+TEST(HalleyRenderGraph, ParallelRecordingKeepsTheOrder)
+{
+	Executors executors;
+	Executors::setInstance(executors);
+	ThreadPool pool("test", Executors::getCPU(), 4, makeThread);
+
+	int sequentialRecorded = 0;
+	int parallelRecorded = 0;
+	const auto sequential = renderGraph(false, sequentialRecorded);
+	const auto parallel = renderGraph(true, parallelRecorded);
+
+	// Both waves with more than one paint node get recorded, and c's blit still lands before what it painted
+	EXPECT_EQ(parallelRecorded, 4);
+	EXPECT_EQ(parallel, sequential);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <halley.hpp>
+#include "halley/entity/components/transform_2d_component.h"
 using namespace Halley;
 
 static int convertBackAndForth(int v)
@@ -26,4 +27,173 @@ TEST(Serializer, IntConversion)
 			EXPECT_EQ(value, convertBackAndForth(value));
 		}
 	}
-}
\ No newline at end of file
+}
+
+namespace {
+	struct SerializerTestData {
+		std::vector<float> floats;
+		std::vector<int> ints;
+		std::vector<Vector2f> points;
+		std::vector<String> names;
+
+		void serialize(Serializer& s) const
+		{
+			s << floats << ints << points << names;
+		}
+
+		void deserialize(Deserializer& s)
+		{
+			s >> floats >> ints >> points >> names;
+		}
+
+		bool operator==(const SerializerTestData& other) const
+		{
+			return floats == other.floats && ints == other.ints && points == other.points && names == other.names;
+		}
+	};
+
+	// Writes each element on its own, as the bulk copies for vectors of numbers must produce the same bytes
+	template <typename T>
+	void serializeElementwise(Serializer& s, const std::vector<T>& values)
+	{
+		s << static_cast<unsigned int>(values.size());
+		for (const auto& v: values) {
+			s << v;
+		}
+	}
+
+	Bytes serializeElementwise(const SerializerTestData& data, SerializerOptions options)
+	{
+		return Serializer::toBytes([&] (Serializer& s)
+		{
+			serializeElementwise(s, data.floats);
+			serializeElementwise(s, data.ints);
+			serializeElementwise(s, data.points);
+			serializeElementwise(s, data.names);
+		}, options);
+	}
+
+	SerializerTestData makeSerializerTestData()
+	{
+		SerializerTestData data;
+		for (int i = 0; i < 3000; ++i) {
+			data.floats.push_back(float(i) * 0.5f);
+			data.ints.push_back(i * (i % 2 == 0 ? 1 : -1000));
+			data.points.emplace_back(float(i), float(-i));
+		}
+		data.names = { "foo", "bar", String(std::string(10000, 'x')) };
+		return data;
+	}
+}
+
+TEST(Serializer, WritingModesProduceSameBytes)
+{
+	const auto data = makeSerializerTestData();
+
+	for (int version = 0; version <= SerializerOptions::maxVersion; ++version) {
+		const auto options = SerializerOptions(version);
+
+		auto dry = Serializer(options);
+		dry << data;
+		Bytes fixed(dry.getSize());
+		auto s = Serializer(gsl::as_writable_bytes(gsl::span<Byte>(fixed)), options);
+		s << data;
+
+		const auto elementwise = serializeElementwise(data, options);
+		EXPECT_EQ(fixed, elementwise);
+
+		const auto growable = Serializer::toBytes(data, options);
+		EXPECT_EQ(growable, elementwise);
+
+		Bytes sunk;
+		size_t nChunks = 0;
+		Serializer::toSink(data, [&] (gsl::span<const gsl::byte> chunk)
+		{
+			const auto* bytes = reinterpret_cast<const Byte*>(chunk.data());
+			sunk.insert(sunk.end(), bytes, bytes + chunk.size());
+			++nChunks;
+		}, options);
+		EXPECT_EQ(sunk, elementwise);
+		EXPECT_GT(nChunks, 1);
+
+		EXPECT_EQ(Deserializer::fromBytes<SerializerTestData>(growable, options), data);
+	}
+}
+
+TEST(Serializer, VectorsKeepTheirFormat)
+{
+	SerializerTestData data;
+	data.floats = { 0.5f, -2.0f };
+	data.ints = { 1, -300 };
+	data.points = { Vector2f(1.0f, -1.0f) };
+	data.names = { "ab" };
+
+	// Version 0 writes fixed length integers, later versions variable length ones; floats are written as they are in memory in both
+	const auto expected = std::array<Bytes, SerializerOptions::maxVersion + 1>{
+		Bytes{ 2, 0, 0, 0, 0, 0, 0, 63, 0, 0, 0, 192, 2, 0, 0, 0, 1, 0, 0, 0, 212, 254, 255, 255, 1, 0, 0, 0, 0, 0, 128, 63, 0, 0, 128, 191, 1, 0, 0, 0, 2, 0, 0, 0, 97, 98 },
+		Bytes{ 2, 0, 0, 0, 63, 0, 0, 0, 192, 2, 1, 171, 132, 1, 0, 0, 128, 63, 0, 0, 128, 191, 1, 2, 97, 98 }
+	};
+
+	for (int version = 0; version <= SerializerOptions::maxVersion; ++version) {
+		const auto options = SerializerOptions(version);
+		EXPECT_EQ(Serializer::toBytes(data, options), expected[version]) << "version " << version;
+		EXPECT_EQ(serializeElementwise(data, options), expected[version]) << "version " << version;
+		EXPECT_EQ(Deserializer::fromBytes<SerializerTestData>(expected[version], options), data) << "version " << version;
+	}
+}
+
+TEST(Serializer, FixedBufferOverflowThrows)
+{
+	std::array<gsl::byte, 4> bytes;
+	auto s = Serializer(gsl::span<gsl::byte>(bytes), SerializerOptions());
+	s << 1;
+	EXPECT_THROW(s << 2, Exception);
+}
+
+TEST(ConfigNodeSerializer, FindFieldsInOnePass)
+{
+	ConfigNode node = ConfigNode::MapType();
+	node["a"] = 1;
+	node["c"] = 3;
+	node["d"] = 4;
+	node["zz"] = 5;
+
+	// Names must be sorted, and can include fields that aren't there, before, between or after the ones that are
+	static constexpr std::array<const char*, 5> names{ "0", "b", "c", "d", "z" };
+	const auto fields = findConfigNodeFields(node, names);
+	EXPECT_EQ(fields[0], nullptr);
+	EXPECT_EQ(fields[1], nullptr);
+	ASSERT_NE(fields[2], nullptr);
+	EXPECT_EQ(fields[2]->asInt(), 3);
+	ASSERT_NE(fields[3], nullptr);
+	EXPECT_EQ(fields[3]->asInt(), 4);
+	EXPECT_EQ(fields[4], nullptr);
+
+	const auto none = findConfigNodeFields(ConfigNode(42), names);
+	for (const auto* f: none) {
+		EXPECT_EQ(f, nullptr);
+	}
+}
+
+TEST(ConfigNodeSerializer, GeneratedDeserializeHandlesMissingFields)
+{
+	const ConfigNodeSerializationContext context;
+
+	ConfigNode full = ConfigNode::MapType();
+	full["position"] = Vector2f(1, 2);
+	full["scale"] = Vector2f(3, 4);
+
+	Transform2DComponent transform;
+	transform.setLocalRotation(Angle1f::fromDegrees(90));
+	transform.deserialize(context, full);
+	EXPECT_EQ(transform.getLocalPosition(), Vector2f(1, 2));
+	EXPECT_EQ(transform.getLocalScale(), Vector2f(3, 4));
+	EXPECT_EQ(transform.getLocalRotation(), Angle1f()); // Missing from a full node, so back to its default
+
+	// Fields missing from a delta are left as they are
+	auto moved = ConfigNode(full);
+	moved["position"] = Vector2f(5, 6);
+	transform.deserialize(context, ConfigNode::createDelta(full, moved));
+	EXPECT_EQ(transform.getLocalPosition(), Vector2f(5, 6));
+	EXPECT_EQ(transform.getLocalScale(), Vector2f(3, 4));
+}
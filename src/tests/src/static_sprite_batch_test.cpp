@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	// Resources only needs a locator to fall back on, every asset used here is set directly
+	class NullSystemAPI : public SystemAPI {
+	public:
+		Path getAssetsPath(const Path& gamePath) const override { return gamePath; }
+		Path getUnpackedAssetsPath(const Path& gamePath) const override { return gamePath; }
+		std::unique_ptr<ResourceDataReader> getDataReader(String path, int64_t start, int64_t end) override { return {}; }
+		std::unique_ptr<GLContext> createGLContext() override { return {}; }
+		std::shared_ptr<Window> createWindow(const WindowDefinition& window) override { return {}; }
+		void destroyWindow(std::shared_ptr<Window> window) override {}
+		Vector2i getScreenSize(int n) const override { return {}; }
+		Rect4i getDisplayRect(int screen) const override { return {}; }
+		void showCursor(bool show) override {}
+		std::shared_ptr<ISaveData> getStorageContainer(SaveDataType type, const String& containerName) override { return {}; }
+
+	private:
+		bool generateEvents(VideoAPI* video, InputAPI* input) override { return false; }
+	};
+
+	class CountingVertexBuffer : public RetainedVertexBuffer {
+	public:
+		explicit CountingVertexBuffer(int& updates) : updates(updates) {}
+		void update(gsl::span<const gsl::byte> data) override { ++updates; }
+
+	private:
+		int& updates;
+	};
+
+	// Same as the dummy video plugin, but keeps retained buffers and counts what reaches the backend
+	class CountingVideoAPI : public VideoAPI {
+	public:
+		int bufferUpdates = 0;
+
+		void startRender() override {}
+		void finishRender() override {}
+		void setWindow(WindowDefinition&& windowDescriptor) override {}
+		Window& getWindow() const override { throw Exception("No window", HalleyExceptions::VideoPlugin); }
+		bool hasWindow() const override { return false; }
+		std::unique_ptr<Texture> createTexture(Vector2i size) override { return {}; }
+		std::unique_ptr<Shader> createShader(const ShaderDefinition& definition) override { return {}; }
+		std::unique_ptr<TextureRenderTarget> createTextureRenderTarget() override { return {}; }
+		std::unique_ptr<ScreenRenderTarget> createScreenRenderTarget() override { return {}; }
+		std::unique_ptr<MaterialConstantBuffer> createConstantBuffer() override { return {}; }
+		std::unique_ptr<RetainedVertexBuffer> createRetainedVertexBuffer() override { return std::make_unique<CountingVertexBuffer>(bufferUpdates); }
+		String getShaderLanguage() override { return "glsl"; }
+	};
+
+	class CountingPainter : public Painter {
+	public:
+		int materialPassBinds = 0;
+		int retainedDraws = 0;
+
+		CountingPainter(VideoAPI& video, Resources& resources)
+			: Painter(video, resources)
+			, renderTarget(Rect4i(0, 0, 200, 200))
+		{}
+
+		void begin() { bind(Camera(Vector2f()), renderTarget, true); }
+		void end() { unbind(true); }
+
+		void clear(std::optional<Colour> colour, std::optional<float> depth, std::optional<uint8_t> stencil) override {}
+		void setMaterialPass(const Material& material, int pass) override { ++materialPassBinds; }
+		void setMaterialData(const Material& material) override {}
+
+	protected:
+		void doStartRender() override {}
+		void doEndRender() override {}
+		void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, IndexType* indices, bool standardQuadsOnly) override {}
+		void setRetainedVertices(const MaterialDefinition& material, RetainedVertexBuffer& buffer, size_t numVertices) override { ++retainedDraws; }
+		void drawTriangles(size_t numIndices) override {}
+		void setViewPort(Rect4i rect) override {}
+		void setClip(Rect4i clip, bool enable) override {}
+		void onUpdateProjection(Material& material, bool hashChanged) override {}
+
+	private:
+		ScreenRenderTarget renderTarget;
+	};
+
+	std::shared_ptr<MaterialDefinition> makeMaterialDefinition(const String& name, ConfigNode root, int passes)
+	{
+		root["name"] = name;
+		auto definition = std::make_shared<MaterialDefinition>();
+		definition->load(root);
+		for (int i = 0; i < passes; ++i) {
+			definition->addPass(MaterialPass());
+		}
+		return definition;
+	}
+
+	// Attributes laid out exactly like SpriteVertexAttrib, so it can be retained
+	std::shared_ptr<MaterialDefinition> makeSpriteMaterialDefinition()
+	{
+		auto attrib = [] (const char* name, const char* type, const char* special = "") {
+			ConfigNode node = ConfigNode::MapType();
+			node["name"] = name;
+			node["type"] = type;
+			node["semantic"] = "TEXCOORD";
+			node["special"] = special;
+			return node;
+		};
+
+		ConfigNode root = ConfigNode::MapType();
+		root["attributes"] = ConfigNode::SequenceType{
+			attrib("a_vertPos", "vec4", "vertPos"), attrib("a_position", "vec2"), attrib("a_pivot", "vec2"), attrib("a_size", "vec2"), attrib("a_scale", "vec2"),
+			attrib("a_colour", "vec4"), attrib("a_texCoord0", "vec4"), attrib("a_texCoord1", "vec4"),
+			attrib("a_custom0", "vec4"), attrib("a_custom1", "vec4"), attrib("a_custom2", "vec4"),
+			attrib("a_rotation", "float"), attrib("a_textureRotation", "float")
+		};
+		return makeMaterialDefinition("Test/Sprite", std::move(root), 1);
+	}
+
+	struct RetainedTestContext {
+		NullSystemAPI system;
+		CountingVideoAPI video;
+		HalleyAPI api{};
+		std::unique_ptr<Resources> resources;
+		std::unique_ptr<CountingPainter> painter;
+		std::shared_ptr<Material> material;
+
+		RetainedTestContext()
+		{
+			api.system = &system;
+			api.video = &video;
+			resources = std::make_unique<Resources>(std::make_unique<ResourceLocator>(system), api, ResourceOptions());
+			resources->init<MaterialDefinition>();
+
+			// The Painter only needs the global block from MaterialBase, the others are never drawn here
+			ConfigNode uniform = ConfigNode::MapType();
+			uniform["u_mvp"] = "mat4";
+			ConfigNode viewPort = ConfigNode::MapType();
+			viewPort["u_viewPortSize"] = "vec2";
+			ConfigNode block = ConfigNode::MapType();
+			block["HalleyBlock"] = ConfigNode::SequenceType{ std::move(uniform), std::move(viewPort) };
+			ConfigNode base = ConfigNode::MapType();
+			base["uniforms"] = ConfigNode::SequenceType{ std::move(block) };
+
+			auto& materials = resources->of<MaterialDefinition>();
+			materials.setResource(0, "Halley/MaterialBase", makeMaterialDefinition("Halley/MaterialBase", std::move(base), 0));
+			for (const char* name: { "Halley/SolidLine", "Halley/SolidPolygon", "Halley/Blit" }) {
+				materials.setResource(0, name, makeMaterialDefinition(name, ConfigNode::MapType(), 0));
+			}
+
+			painter = std::make_unique<CountingPainter>(video, *resources);
+			material = std::make_shared<Material>(makeSpriteMaterialDefinition());
+		}
+
+		Sprite makeSprite(Vector2f pos) const
+		{
+			Sprite sprite;
+			sprite.setMaterial(material).setPosition(pos).setSize(Vector2f(10, 10));
+			return sprite;
+		}
+
+		void draw(StaticSpriteBatch& batch)
+		{
+			painter->begin();
+			batch.draw(*painter);
+			painter->end();
+		}
+	};
+}
+
+TEST(HalleyStaticSpriteBatch, UnchangedBatchIsOnlyUploadedOnce)
+{
+	RetainedTestContext ctx;
+	StaticSpriteBatch batch(Vector<Sprite>{ ctx.makeSprite(Vector2f(0, 0)), ctx.makeSprite(Vector2f(20, 0)) });
+
+	for (int i = 0; i < 3; ++i) {
+		ctx.draw(batch);
+	}
+
+	// Both sprites share a material, so that's one retained run drawn every frame but uploaded once
+	EXPECT_EQ(ctx.video.bufferUpdates, 1);
+	EXPECT_EQ(ctx.painter->retainedDraws, 3);
+}
+
+TEST(HalleyStaticSpriteBatch, ChangesRebuildTheBatch)
+{
+	RetainedTestContext ctx;
+	StaticSpriteBatch batch(Vector<Sprite>{ ctx.makeSprite(Vector2f(0, 0)) });
+	ctx.draw(batch);
+	ASSERT_EQ(ctx.video.bufferUpdates, 1);
+
+	batch.getMutableSprite(0).setPosition(Vector2f(5, 5));
+	ctx.draw(batch);
+	EXPECT_EQ(ctx.video.bufferUpdates, 2);
+
+	batch.add(ctx.makeSprite(Vector2f(20, 20)));
+	ctx.draw(batch);
+	EXPECT_EQ(ctx.video.bufferUpdates, 3);
+
+	// Reading a sprite doesn't invalidate anything
+	EXPECT_EQ(batch.getSprite(1).getPosition(), Vector2f(20, 20));
+	ctx.draw(batch);
+	EXPECT_EQ(ctx.video.bufferUpdates, 3);
+
+	// Changes the batch can't see (e.g. through a shared material) need an explicit invalidation
+	batch.setDirty();
+	ctx.draw(batch);
+	EXPECT_EQ(ctx.video.bufferUpdates, 4);
+}
+
+TEST(HalleyStaticSpriteBatch, BatchesOutsideTheCameraArentDrawn)
+{
+	RetainedTestContext ctx;
+	StaticSpriteBatch batch(Vector<Sprite>{ ctx.makeSprite(Vector2f(1000, 1000)) });
+	ctx.draw(batch);
+
+	EXPECT_EQ(ctx.video.bufferUpdates, 0);
+	EXPECT_EQ(ctx.painter->retainedDraws, 0);
+}
+
+TEST(HalleyStaticSpriteBatch, RetainedDrawsRebindTheirMaterial)
+{
+	RetainedTestContext ctx;
+	StaticSpriteBatch first(Vector<Sprite>{ ctx.makeSprite(Vector2f(0, 0)) });
+	StaticSpriteBatch second(Vector<Sprite>{ ctx.makeSprite(Vector2f(20, 0)) });
+
+	ctx.painter->begin();
+	first.draw(*ctx.painter);
+	second.draw(*ctx.painter);
+	ctx.painter->end();
+
+	// Each retained draw binds its own vertex buffer, so the pass has to be set again even though the material didn't change
+	EXPECT_EQ(ctx.painter->retainedDraws, 2);
+	EXPECT_EQ(ctx.painter->materialPassBinds, 2);
+}
@@ -84,6 +84,7 @@ namespace Halley
 		CodegenLanguage language = CodegenLanguage::CPlusPlus;
 		int smearing = 0;
 		bool generate = false;
+		bool concurrent = false;
 
 		HashSet<String> includeFiles;
 
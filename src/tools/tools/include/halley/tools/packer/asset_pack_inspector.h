@@ -4,6 +4,7 @@
 #include "halley/tools/cli_tool.h"
 #include "halley/bytes/byte_serializer.h"
 #include "halley/core/resources/asset_database.h"
+#include "halley/core/resources/asset_pack_index.h"
 
 namespace Halley {
     class AssetPackInspector {
@@ -14,10 +15,17 @@ namespace Halley {
 
     private:
 		String name;
+		size_t indexSize;
+		AssetPackIndex index;
+		bool encrypted = false;
 		size_t rawTableSize;
 		size_t tableSize;
 		uint64_t totalHash;
 	    uint64_t dataStartPos;
+		size_t totalStoredSize = 0;
+		size_t totalRawSize = 0;
+		size_t decodedSize = 0;
+		double decodeTime = 0;
 
 	    struct Entry
 		{
@@ -25,6 +33,10 @@ namespace Halley {
 			uint64_t hash;
 			String key;
 			AssetDatabase::Entry entry;
+			AssetPackCompression compression = AssetPackCompression::None;
+			size_t pos = 0;
+			size_t storedSize = 0;
+			size_t rawSize = 0;
 
 			Entry(int assetType, uint64_t hash, String key, AssetDatabase::Entry entry);
 		};
@@ -34,6 +46,7 @@ namespace Halley {
 		void parseTable(Deserializer s, const Bytes& packBytes);
 	    void parseTypedDB(Deserializer& s, const Bytes& packBytes);
 		void computeHash();
+		void measureDecoding(const Bytes& packBytes);
     };
 
 	class AssetPackInspectorTool : public CommandLineTool
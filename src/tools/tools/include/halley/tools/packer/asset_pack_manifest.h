@@ -2,6 +2,7 @@
 #include "halley/text/halleystring.h"
 #include "halley/data_structures/maybe.h"
 #include "halley/utils/utils.h"
+#include "halley/core/resources/asset_pack_index.h"
 
 namespace Halley {
 	class ConfigNode;
@@ -16,11 +17,18 @@ namespace Halley {
 		bool checkMatch(const String& asset) const;
 		bool isEncrypted() const;
 		const String& getEncryptionKey() const;
+		AssetPackCompression getCompression(const String& asset) const;
 
 	private:
+		struct CompressionRule {
+			std::vector<String> matches; // Empty matches everything
+			AssetPackCompression compression;
+		};
+
 		String name;
 		String encryptionKey;
 		std::vector<String> matches;
+		std::vector<CompressionRule> compressionRules;
 	};
 
 	class AssetPackManifest {
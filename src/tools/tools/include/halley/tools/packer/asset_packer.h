@@ -3,6 +3,7 @@
 #include "halley/text/halleystring.h"
 #include "halley/resources/resource.h"
 #include "halley/core/resources/asset_database.h"
+#include "halley/core/resources/asset_pack_index.h"
 #include "halley/data_structures/maybe.h"
 #include <set>
 
@@ -18,6 +19,7 @@ namespace Halley {
 			String name;
 			String path;
 			Metadata metadata;
+			AssetPackCompression compression;
 
 			bool operator<(const Entry& other) const;
 		};
@@ -25,7 +27,7 @@ namespace Halley {
 		AssetPackListing();
 		AssetPackListing(String name, String encryptionKey);
 		
-		void addFile(AssetType type, const String& name, const AssetDatabase::Entry& entry);
+		void addFile(AssetType type, const String& name, const AssetDatabase::Entry& entry, AssetPackCompression compression);
 		const std::vector<Entry>& getEntries() const;
 		const String& getEncryptionKey() const;
 		
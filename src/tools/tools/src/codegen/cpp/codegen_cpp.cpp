@@ -151,6 +151,34 @@ CodeGenResult CodegenCPP::generateRegistry(const Vector<ComponentSchema>& compon
 		"}"
 	});
 
+	// Component asset dependencies, going by the declared type of each field
+	registryCpp.insert(registryCpp.end(), {
+		"",
+		"",
+		"using ComponentDependenciesPtr = void (*)(const ConfigNode&, Vector<std::pair<AssetType, String>>&);",
+		"using ComponentDependenciesMap = HashMap<String, ComponentDependenciesPtr>;",
+		"",
+		"static ComponentDependenciesMap makeComponentDependencies() {",
+		"	ComponentDependenciesMap result;"
+	});
+
+	for (auto& comp : components) {
+		Vector<String> fields;
+		for (auto& member : comp.members) {
+			if (member.canEdit) {
+				fields.push_back("ConfigNodeAssetDependencies<" + member.type.name + ">::collect(node[\"" + member.name + "\"], deps);");
+			}
+		}
+		if (!fields.empty()) {
+			registryCpp.push_back("	result[\"" + comp.name + "\"] = [] (const ConfigNode& node, Vector<std::pair<AssetType, String>>& deps) { " + String::concatList(fields, " ") + " };");
+		}
+	}
+
+	registryCpp.insert(registryCpp.end(), {
+		"	return result;",
+		"}"
+	});
+
 	// Create system and component methods
 	registryCpp.insert(registryCpp.end(), {
 		"",
@@ -177,6 +205,14 @@ CodeGenResult CodegenCPP::generateRegistry(const Vector<ComponentSchema>& compon
 		"		static ComponentReflectorList reflectors = makeComponentReflectors();",
 		"		return *reflectors.at(componentId);",
 		"	}",
+		"",
+		"	void getComponentAssetDependencies(const String& name, const ConfigNode& componentData, Vector<std::pair<AssetType, String>>& result) {",
+		"		static ComponentDependenciesMap dependencies = makeComponentDependencies();",
+		"		auto iter = dependencies.find(name);",
+		"		if (iter != dependencies.end() && componentData.getType() == ConfigNodeType::Map) {",
+		"			iter->second(componentData, result);",
+		"		}",
+		"	}",
 		"}"
 	});
 
@@ -214,6 +250,24 @@ Vector<String> CodegenCPP::generateComponentHeader(ComponentSchema component)
 	const String lineBreak = getPlatform() == GamePlatform::Windows ? "\r\n\t\t" : "\n\t\t";
 	String serializeBody = "using namespace Halley::EntitySerialization;" + lineBreak + "Halley::ConfigNode node = Halley::ConfigNode::MapType();" + lineBreak;
 	String deserializeBody = "using namespace Halley::EntitySerialization;" + lineBreak;
+
+	// Deserialization fetches all fields in one ordered pass over the node, so it needs the names sorted
+	Vector<String> fieldNames;
+	for (auto& member: component.members) {
+		if (member.canEdit || member.canSave) {
+			fieldNames.push_back(member.name);
+		}
+	}
+	std::sort(fieldNames.begin(), fieldNames.end());
+	if (!fieldNames.empty()) {
+		Vector<String> quotedNames;
+		for (auto& name: fieldNames) {
+			quotedNames.push_back("\"" + name + "\"");
+		}
+		deserializeBody += "static constexpr std::array<const char*, " + toString(fieldNames.size()) + "> fieldNames{ " + String::concatList(quotedNames, ", ") + " };" + lineBreak;
+		deserializeBody += "const auto fields = Halley::findConfigNodeFields(node, fieldNames);" + lineBreak;
+	}
+
 	bool first = true;
 	for (auto& member: component.members) {
 		std::vector<String> serializationTypes;
@@ -226,6 +280,7 @@ Vector<String> CodegenCPP::generateComponentHeader(ComponentSchema component)
 		if (serializationTypes.empty()) {
 			continue;
 		}
+		const auto fieldIndex = std::find(fieldNames.begin(), fieldNames.end(), member.name) - fieldNames.begin();
 		String mask = "makeMask(" + String::concatList(serializationTypes, ", ") + ")";
 		
 		if (first) {
@@ -236,10 +291,15 @@ Vector<String> CodegenCPP::generateComponentHeader(ComponentSchema component)
 		}
 
 		serializeBody += "Halley::EntityConfigNodeSerializer<decltype(" + member.name + ")>::serialize(" + member.name + ", " + CPPClassGenerator::getAnonString(member) + ", context, node, \"" + member.name + "\", " + mask + ");";
-		deserializeBody += "Halley::EntityConfigNodeSerializer<decltype(" + member.name + ")>::deserialize(" + member.name + ", " + CPPClassGenerator::getAnonString(member) + ", context, node, \"" + member.name + "\", " + mask + ");";
+		deserializeBody += "Halley::EntityConfigNodeSerializer<decltype(" + member.name + ")>::deserialize(" + member.name + ", " + CPPClassGenerator::getAnonString(member) + ", context, node, fields[" + toString(fieldIndex) + "], " + mask + ");";
 	}
 	serializeBody += lineBreak + "return node;";
 
+	Vector<String> detachCopyBody;
+	for (auto& member: component.members) {
+		detachCopyBody.push_back("Halley::DetachedCopy<decltype(" + member.name + ")>::detach(" + member.name + ");");
+	}
+
 	gen
 		.setAccessLevel(MemberAccess::Public)
 		.addMember(MemberSchema(TypeSchema("int", false, true, true), "componentIndex", toString(component.id)))
@@ -268,6 +328,8 @@ Vector<String> CodegenCPP::generateComponentHeader(ComponentSchema component)
 		.addMethodDefinition(MethodSchema(TypeSchema("void"), {
 			VariableSchema(TypeSchema("Halley::ConfigNodeSerializationContext&", true), "context"), VariableSchema(TypeSchema("Halley::ConfigNode&", true), "node")
 		}, "deserialize"), deserializeBody)
+		.addBlankLine()
+		.addMethodDefinition(MethodSchema(TypeSchema("void"), {}, "detachCopy"), detachCopyBody)
 		.addBlankLine();
 
 	gen.finish()
@@ -386,15 +448,19 @@ Vector<String> CodegenCPP::generateSystemHeader(SystemSchema& system, const Hash
 			return MemberSchema(TypeSchema(type, !comp.write), lowerFirst(comp.name));
 		});
 
+		// Read-only components are only const for concurrent systems, so existing systems keep compiling
+		Vector<String> familyTypes;
+		for (auto& comp : fam.components) {
+			const String type = String(system.concurrent && !comp.write ? "const " : "") + comp.name + "Component";
+			familyTypes.push_back(comp.optional ? "Halley::MaybeRef<" + type + ">" : type);
+		}
+
 		sysClassGen
 			.addClass(CPPClassGenerator(upperFirst(fam.name) + "Family", "Halley::FamilyBaseOf<" + upperFirst(fam.name) + "Family>")
 				.setAccessLevel(MemberAccess::Public)
 				.addMembers(members)
 				.addBlankLine()
-				.addTypeDefinition("Type", "Halley::FamilyType<" + String::concatList(convert<ComponentReferenceSchema, String>(fam.components, [](auto& comp)
-				{
-					return comp.optional ? "Halley::MaybeRef<" + comp.name + "Component>" : comp.name + "Component";
-				}), ", ") + ">")
+				.addTypeDefinition("Type", "Halley::FamilyType<" + String::concatList(familyTypes, ", ") + ">")
 				.addBlankLine()
 				.setAccessLevel(MemberAccess::Protected)
 				.addConstructor(MemberSchema::toVariableSchema(members), false)
@@ -417,8 +483,10 @@ Vector<String> CodegenCPP::generateSystemHeader(SystemSchema& system, const Hash
 	// Entity messages
 	bool hasReceiveEntityMessage = false;
 	Vector<String> entityMsgsReceived;
+	Vector<String> entityMsgsSent;
 	for (auto& msg : system.messages) {
 		if (msg.send) {
+			entityMsgsSent.push_back(msg.name + "Message::messageIndex");
 			sysClassGen.addMethodDefinition(MethodSchema(TypeSchema("void"), { VariableSchema(TypeSchema("Halley::EntityId"), "entityId"), VariableSchema(TypeSchema(msg.name + "Message"), "msg") }, "sendMessage"), "sendMessageGeneric(entityId, std::move(msg));");
 		}
 		if (msg.receive) {
@@ -429,9 +497,11 @@ Vector<String> CodegenCPP::generateSystemHeader(SystemSchema& system, const Hash
 
 	// System messages
 	bool hasReceiveSystemMessage = false;
+	bool hasSendSystemMessage = false;
 	Vector<String> systemMsgsReceived;
 	for (auto& msg : system.systemMessages) {
 		if (msg.send) {
+			hasSendSystemMessage = true;
 			auto iter = systemMessages.find(msg.name);
 			if (iter != systemMessages.end()) {
 				const auto& sysMsg = iter->second;
@@ -609,10 +679,22 @@ Vector<String> CodegenCPP::generateSystemHeader(SystemSchema& system, const Hash
 			}, "canHandleSystemMessage", true, false, true, true), canReceiveBody);
 	}
 
+	// Only systems that opted in and are confined to their own families and messages can be scheduled alongside others
+	// Parallel systems are excluded, as they already spread their work across the CPU executors
+	const bool canRunConcurrently = system.concurrent
+		&& system.method == SystemMethod::Update
+		&& system.strategy != SystemStrategy::Parallel
+		&& (int(system.access) & (int(SystemAccess::API) | int(SystemAccess::World))) == 0
+		&& system.services.empty()
+		&& !hasSendSystemMessage;
+
 	sysClassGen
 		.setAccessLevel(MemberAccess::Public)
 		.addCustomConstructor({}, {
-			VariableSchema(TypeSchema(""), "System", "{" + String::concatList(convert<FamilySchema, String>(system.families, [](auto& fam) { return "&" + fam.name + "Family"; }), ", ") + "}, {" + String::concatList(entityMsgsReceived, ", ") + "}")
+			VariableSchema(TypeSchema(""), "System", "{" + String::concatList(convert<FamilySchema, String>(system.families, [](auto& fam) { return "&" + fam.name + "Family"; }), ", ") + "}, {"
+				+ String::concatList(entityMsgsReceived, ", ") + "}, {"
+				+ String::concatList(entityMsgsSent, ", ") + "}, "
+				+ (canRunConcurrently ? "true" : "false"))
 		}, { "static_assert(std::is_final_v<T>, \"System must be final.\");" })
 		.finish()
 		.writeTo(contents);
@@ -88,6 +88,7 @@ SystemSchema::SystemSchema(YAML::Node node, bool generate)
 	}
 
 	smearing = node["smearing"].as<int>(1);
+	concurrent = node["concurrent"].as<bool>(false);
 
 	if (node["access"].IsDefined()) {
 		int accessValue = 0;
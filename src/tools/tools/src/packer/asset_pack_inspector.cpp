@@ -7,6 +7,7 @@
 #include "halley/support/console.h"
 #include "halley/core/resources/asset_database.h"
 #include "halley/utils/hash.h"
+#include <chrono>
 
 using namespace Halley;
 
@@ -23,6 +24,15 @@ void AssetPackInspector::parse(const Bytes& bytes)
 	auto headerSpan = gsl::as_writable_bytes(gsl::span<AssetPackHeader>(&header, 1));
 	s >> headerSpan;
 	dataStartPos = header.dataStartPos;
+	encrypted = std::any_of(header.iv.begin(), header.iv.end(), [] (char c) { return c != 0; });
+
+	Bytes indexData(header.assetDbStartPos - sizeof(AssetPackHeader));
+	auto indexSpan = gsl::as_writable_bytes(gsl::span<Byte>(indexData.data(), indexData.size()));
+	s >> indexSpan;
+	indexSize = indexData.size();
+	if (!indexData.empty()) {
+		index.load(std::move(indexData));
+	}
 
 	Bytes tableData(header.dataStartPos - header.assetDbStartPos);
 	auto tableSpan = gsl::as_writable_bytes(gsl::span<Byte>(tableData.data(), tableData.size()));
@@ -44,6 +54,7 @@ void AssetPackInspector::parse(const Bytes& bytes)
 	});
 
 	computeHash();
+	measureDecoding(bytes);
 }
 
 void AssetPackInspector::parseTable(Deserializer s, const Bytes& packBytes)
@@ -74,9 +85,22 @@ void AssetPackInspector::parseTypedDB(Deserializer& s, const Bytes& packBytes)
 		auto splitPath = entry.path.split(':');
 		size_t pos = splitPath.at(0).toInteger64();
 		size_t size = splitPath.at(1).toInteger64();
-		auto hash = Hash::hash(gsl::as_bytes(gsl::span<const Byte>(packBytes.data() + pos + dataStartPos, size)));
-
-		entries.emplace_back(curAssetType, hash, std::move(key), std::move(entry));
+		auto stored = gsl::as_bytes(gsl::span<const Byte>(packBytes.data() + pos + dataStartPos, size));
+		auto hash = Hash::hash(stored);
+
+		const auto* indexEntry = index.find(AssetType(curAssetType), key);
+		auto& e = entries.emplace_back(curAssetType, hash, std::move(key), std::move(entry));
+		e.pos = pos;
+		e.storedSize = size;
+		e.rawSize = size;
+		if (indexEntry && indexEntry->isCompressed()) {
+			e.compression = indexEntry->compression;
+			if (!encrypted) {
+				e.rawSize = AssetPack::getUncompressedSize(stored);
+			}
+		}
+		totalStoredSize += e.storedSize;
+		totalRawSize += e.rawSize;
 	}
 }
 
@@ -92,13 +116,45 @@ void AssetPackInspector::computeHash()
 	totalHash = hasher.digest();
 }
 
+void AssetPackInspector::measureDecoding(const Bytes& packBytes)
+{
+	if (encrypted) {
+		return;
+	}
+
+	for (auto& entry: entries) {
+		if (entry.compression == AssetPackCompression::None) {
+			continue;
+		}
+
+		auto stored = gsl::as_bytes(gsl::span<const Byte>(packBytes.data() + entry.pos + dataStartPos, entry.storedSize));
+		Bytes dst(entry.rawSize);
+		const auto start = std::chrono::steady_clock::now();
+		AssetPack::decompress(entry.compression, stored, gsl::as_writable_bytes(gsl::span<Byte>(dst)));
+		const auto end = std::chrono::steady_clock::now();
+
+		decodeTime += std::chrono::duration<double>(end - start).count();
+		decodedSize += entry.rawSize;
+	}
+}
+
 void AssetPackInspector::printData() const
 {
 	auto stdCol = ConsoleColour();
 	auto infoCol = ConsoleColour(Console::MAGENTA);
 	auto strCol = ConsoleColour(Console::DARK_GREY);
 	std::cout << "Pack " << strCol << name << stdCol << "\n";
+	std::cout << "  Index size: " << infoCol << indexSize << stdCol << " (" << infoCol << index.getEntries().size() << stdCol << " entries)\n";
 	std::cout << "  Table size: " << infoCol << rawTableSize << stdCol << " -> " << infoCol << tableSize << stdCol << "\n";
+	if (encrypted) {
+		std::cout << "  Data size: " << infoCol << totalStoredSize << stdCol << " (encrypted)\n";
+	} else {
+		const float ratio = totalRawSize > 0 ? float(totalStoredSize) / float(totalRawSize) : 1.0f;
+		std::cout << "  Data size: " << infoCol << totalStoredSize << stdCol << " -> " << infoCol << totalRawSize << stdCol << " (" << infoCol << toString(ratio * 100.0f, 1) << "%" << stdCol << ")\n";
+		if (decodedSize > 0 && decodeTime > 0) {
+			std::cout << "  Decode throughput: " << infoCol << String::prettySize(size_t(double(decodedSize) / decodeTime)) << "/s" << stdCol << "\n";
+		}
+	}
 
 	int lastType = -1;
 	int i = -1;
@@ -111,7 +167,11 @@ void AssetPackInspector::printData() const
 		}
 
 		auto splitPath = entry.entry.path.split(':');
-		std::cout << "    [" << i << "] " << strCol << entry.key << stdCol << " [" << infoCol << toString(entry.hash, 16) << stdCol << "]: at " << infoCol << splitPath.at(0) << stdCol << ", " << infoCol << splitPath.at(1) << stdCol << " bytes, " << strCol << toString(entry.entry.meta) <<  stdCol << "\n";
+		std::cout << "    [" << i << "] " << strCol << entry.key << stdCol << " [" << infoCol << toString(entry.hash, 16) << stdCol << "]: at " << infoCol << splitPath.at(0) << stdCol << ", " << infoCol << splitPath.at(1) << stdCol << " bytes, ";
+		if (entry.compression != AssetPackCompression::None) {
+			std::cout << infoCol << toString(entry.compression) << stdCol << " from " << infoCol << entry.rawSize << stdCol << " bytes, ";
+		}
+		std::cout << strCol << toString(entry.entry.meta) << stdCol << "\n";
 
 		++i;
 	}
@@ -18,6 +18,29 @@ AssetPackManifestEntry::AssetPackManifestEntry(const ConfigNode& node)
 			matches.push_back(m.asString());
 		}
 	}
+
+	// Either a single codec for the whole pack, or a list of rules where the first match wins, e.g.:
+	// compression:
+	//   - matches: ["audioClip:"]
+	//     codec: none
+	//   - codec: lz4
+	if (node.hasKey("compression")) {
+		const auto& compressionNode = node["compression"];
+		if (compressionNode.getType() == ConfigNodeType::Sequence) {
+			for (auto& r: compressionNode.asSequence()) {
+				CompressionRule rule;
+				if (r.hasKey("matches")) {
+					for (auto& m: r["matches"].asSequence()) {
+						rule.matches.push_back(m.asString());
+					}
+				}
+				rule.compression = fromString<AssetPackCompression>(r["codec"].asString());
+				compressionRules.push_back(std::move(rule));
+			}
+		} else {
+			compressionRules.push_back(CompressionRule{ {}, fromString<AssetPackCompression>(compressionNode.asString()) });
+		}
+	}
 }
 
 const String& AssetPackManifestEntry::getName() const
@@ -45,6 +68,21 @@ const String& AssetPackManifestEntry::getEncryptionKey() const
 	return encryptionKey;
 }
 
+AssetPackCompression AssetPackManifestEntry::getCompression(const String& asset) const
+{
+	for (auto& rule: compressionRules) {
+		if (rule.matches.empty()) {
+			return rule.compression;
+		}
+		for (auto& m: rule.matches) {
+			if (asset.contains(m)) {
+				return rule.compression;
+			}
+		}
+	}
+	return AssetPackCompression::None;
+}
+
 AssetPackManifest::AssetPackManifest(const Bytes& data)
 {
 	load(YAMLConvert::parseConfig(data));